@@ -0,0 +1,387 @@
+/*
+ * AffineGapAligner.cpp
+ *
+ *	This is the cpp file for the AffineGapAligner object. The
+ *  AffineGapAligner finds the highest weight path through the edit graph
+ *  for three fasta files, like the ThreeWayAligner, but scores gaps with
+ *  an affine cost: a gap of length L in one sequence of a pair costs
+ *  gapOpen + L * gapExtend instead of L * the matrix's gapCost().
+ *
+ *  The columns are scored with sum of pairs, so a column pays a gap open
+ *  for each pair of sequences where a gap starts.  Whether a gap starts
+ *  depends on the column before it, so each cell of the edit graph has
+ *  one state for each of the seven moves that can enter it, and an edge
+ *  pays gapOpen for every pair whose gap is not in the same sequence in
+ *  the state it leaves from (Gotoh's algorithm, with quasi-natural gap
+ *  costs: a pair that is gapped in both sequences does not continue an
+ *  earlier gap).  Paths can start at any cell, with weight 0.
+ *
+ *  The scores of the seven states are kept in separate planes, and only
+ *  two i planes of them are in memory.  The state each state was entered
+ *  from is kept for every cell in a PackedTraceback, so the path is
+ *  walked back without running the dynamic program again.  With
+ *  gapOpen = 0 and gapExtend = gapCost() the scores are the same
+ *  as the linear gap scores of the ThreeWayAligner.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "AffineGapAligner.h"
+#include "ThreeWayAligner.h"
+#include <sstream>
+#include <algorithm>
+using namespace std;
+
+// Class Attribute Initialization
+// ==============================================
+const int AffineGapAligner::defaultGapOpen;
+const int AffineGapAligner::defaultGapExtend;
+const int AffineGapAligner::stateCount;
+const int AffineGapAligner::unreachable;
+
+// Constuctors
+// ==============================================
+AffineGapAligner::AffineGapAligner(FastaFile* fasta1, FastaFile* fasta2, FastaFile* fasta3)
+	: encoded1(fasta1->getEncodedSequence()), encoded2(fasta2->getEncodedSequence()),
+	  encoded3(fasta3->getEncodedSequence()) {
+
+	gapChar = '-';
+	graphFileName = ThreeWayAligner::graphFileNameFor(fasta1, fasta2, fasta3);
+
+	seq1Length = fasta1->getSequenceLength();
+	seq2Length = fasta2->getSequenceLength();
+	seq3Length = fasta3->getSequenceLength();
+
+	matrix = &ScoringMatrix::blosum62();
+	gapIndex = matrix->getGapIndex();
+	gapOpen = defaultGapOpen;
+	gapExtend = defaultGapExtend;
+	highestWeight = 0;
+	pathStart.seq1Loc = pathStart.seq2Loc = pathStart.seq3Loc = 0;
+	pathEnd = pathStart;
+}
+
+// Destructor
+// =============================================
+AffineGapAligner::~AffineGapAligner() {
+}
+
+// Public Methods
+// =============================================
+
+// findHighestWeightPath()
+//  Purpose:
+//		Uses dynamic programming to find the highest weight path through
+//		the edit graph for the three sequences with affine gap costs.
+//		The cells are visited in vertex order (i, then j, then k), and the
+//		weight of each state of a cell is the max over the states of the
+//		move's start cell (and the trivial path of starting there) of the
+//		start weight + the column weight + the gap opens.
+//
+//		An edge only replaces the current best when it is strictly
+//		better, and the end of the path is the first state (in vertex
+//		order) with the highest weight.
+//  Postconditions:
+//		- highestWeight, pathStart, pathEnd and pathMoves will be set
+void AffineGapAligner::findHighestWeightPath() {
+
+	pathMoves.clear();
+	encodeSequences();
+
+	// Offsets within a plane to the start cell of each incoming edge
+	size_t seq2Step = seq3Length + 1;
+	size_t planeSize = seq2Step * (seq2Length + 1);
+	size_t moveOffset[8];
+	for (unsigned char move = 1; move <= 7; move++) {
+		moveOffset[move] =
+			((move & seq2Move) ? seq2Step : 0) +
+			((move & seq3Move) ? 1 : 0);
+	}
+
+	// Gap open cost of each move from each state, and the change to
+	// the linear column weight for the gap extend cost
+	int openCost[8][8];
+	int extendAdjustment[8];
+	for (unsigned char move = 1; move <= 7; move++) {
+		for (unsigned char fromState = 0; fromState <= 7; fromState++)
+			openCost[fromState][move] = gapOpenCount(fromState, move) * gapOpen;
+		extendAdjustment[move] = gapPairCount(move) * (gapExtend - matrix->gapCost());
+	}
+
+	// Scores for the states of the previous and current i plane, each
+	// state in its own plane: state s of cell c of plane p is at
+	// ((p * stateCount) + s - 1) * planeSize + c
+	vector<int> scores(2 * stateCount * planeSize);
+	traceback.resize((size_t) (seq1Length + 1) * (seq2Length + 1) * stateCount, seq2Step);
+	vector<unsigned char> rowFromStates(stateCount * seq2Step);
+
+	highestWeight = 0;
+	pathEnd.seq1Loc = pathEnd.seq2Loc = pathEnd.seq3Loc = 0;
+	unsigned char endState = 0;
+
+	for (int seq1Loc = 0; seq1Loc <= seq1Length; seq1Loc++) {
+		int* currentPlanes = &scores[(seq1Loc % 2) * stateCount * planeSize];
+		const int* previousPlanes = &scores[((seq1Loc + 1) % 2) * stateCount * planeSize];
+
+		for (int seq2Loc = 0; seq2Loc <= seq2Length; seq2Loc++) {
+			size_t cell = seq2Loc * seq2Step;
+			for (int seq3Loc = 0; seq3Loc <= seq3Length; seq3Loc++, cell++) {
+
+				unsigned char available =
+					((seq1Loc > 0) ? seq1Move : 0) |
+					((seq2Loc > 0) ? seq2Move : 0) |
+					((seq3Loc > 0) ? seq3Move : 0);
+
+				int weights[8];
+				cellMoveWeights(seq1Loc, seq2Loc, seq3Loc, weights);
+				for (unsigned char move = 7; move >= 1; move--) {
+					int weight = unreachable;
+					unsigned char bestFromState = 0;
+
+					if ((move & available) == move) {
+						const int* predecessorPlanes = (move & seq1Move) ? previousPlanes : currentPlanes;
+						size_t predecessor = cell - moveOffset[move];
+
+						// Start with the trivial path of starting at the start cell
+						weight = openCost[0][move];
+						for (unsigned char fromState = 1; fromState <= 7; fromState++) {
+							int pathWeight = predecessorPlanes[(fromState - 1) * planeSize + predecessor] +
+								openCost[fromState][move];
+
+							if (pathWeight > weight) {
+								weight = pathWeight;
+								bestFromState = fromState;
+							}
+						}
+						weight += weights[move] + extendAdjustment[move];
+					}
+
+					currentPlanes[(move - 1) * planeSize + cell] = weight;
+					rowFromStates[(move - 1) * seq2Step + seq3Loc] = bestFromState;
+
+					// Set the end of the highest weight path
+					if (weight > highestWeight) {
+						highestWeight = weight;
+						pathEnd.seq1Loc = seq1Loc;
+						pathEnd.seq2Loc = seq2Loc;
+						pathEnd.seq3Loc = seq3Loc;
+						endState = move;
+					}
+				}
+
+			} // seq3Loc - fasta3
+
+			// Pack the row of each state into the traceback
+			size_t row = ((size_t) seq1Loc * (seq2Length + 1) + seq2Loc) * stateCount;
+			for (int state = 1; state <= stateCount; state++)
+				traceback.setRow(row + state - 1, 0, &rowFromStates[(state - 1) * seq2Step], seq2Step);
+
+		} // seq2Loc - fasta2
+	} // seq1Loc - fasta1
+
+	// Walk backwards through the states until the path starts
+	pathStart = pathEnd;
+	unsigned char state = endState;
+	while (state != 0) {
+		pathMoves.push_back(state);
+
+		size_t row = ((size_t) pathStart.seq1Loc * (seq2Length + 1) + pathStart.seq2Loc) * stateCount;
+		unsigned char fromState = traceback.getMove(row + state - 1, pathStart.seq3Loc);
+
+		pathStart.seq1Loc -= (state & seq1Move) ? 1 : 0;
+		pathStart.seq2Loc -= (state & seq2Move) ? 1 : 0;
+		pathStart.seq3Loc -= (state & seq3Move) ? 1 : 0;
+		state = fromState;
+	}
+	reverse(pathMoves.begin(), pathMoves.end());
+}
+
+// string resultString()
+//  Purpose:
+//		Returns an XML formatted string representing the results of the
+//		findHighestWeightPath() function.
+//
+//		format:
+//			<results type="part?" file=" <<graphFileName>> ">";
+//			  <result type="gap_open"> <<cost to open a gap>> </result>
+//			  <result type="gap_extend">  <<cost for each gap char>> </result>
+//			  <result type="score"> <<highest weight path score>> </result>
+//			  <result type="beginning_vertex"> <<start vertex for path>> </result>
+//			  <result type="ending_vertex"> <<end vertex for path>> </result>
+//			  <result type="path"> << list of path edge labels in order>> </result>
+//			</results>
+//  Preconditions:
+//		findHighestWeightPath() has been run
+string AffineGapAligner::resultString() {
+	OutputBuffer out;
+	writeResult(out);
+
+	return out.str();
+}
+
+// writeResult(OutputBuffer& out)
+//  Purpose:
+//		Appends the string resultString() returns to out, without
+//		building a stream for it.
+//  Preconditions:
+//		findHighestWeightPath() has been run
+void AffineGapAligner::writeResult(OutputBuffer& out) {
+	// Results header
+	out.write("  <results type=\"part?\" file=\"");
+	out.write(graphFileName);
+	out.write("\">\n");
+
+	// Gap costs
+	out.xmlResult("gap_open", (double) gapOpen, 6);
+	out.xmlResult("gap_extend", (double) gapExtend, 6);
+
+	// Path Info
+	out.xmlResult("score", (double) highestWeight, 6);
+	out.xmlResult("beginning_vertex", cellLabel(pathStart));
+	out.xmlResult("end_vertex", cellLabel(pathEnd));
+	out.xmlResult("path", getPath());
+
+	// Results footer
+	out.write("  </results>\n");
+}
+
+// Public Accessors
+// =============================================
+int AffineGapAligner::getScore() {
+	return highestWeight;
+}
+
+void AffineGapAligner::setGapCosts(int aGapOpen, int aGapExtend) {
+	gapOpen = aGapOpen;
+	gapExtend = aGapExtend;
+}
+
+void AffineGapAligner::setScoringMatrix(const ScoringMatrix* aMatrix) {
+	matrix = (aMatrix != NULL) ? aMatrix : &ScoringMatrix::blosum62();
+}
+
+// Private Methods
+// =============================================
+
+// int gapOpenCount(unsigned char fromState, unsigned char move)
+//  Purpose:
+//		Returns the number of pairs of sequences where taking move from
+//		a cell in fromState starts a new gap.
+int AffineGapAligner::gapOpenCount(unsigned char fromState, unsigned char move) {
+	static const unsigned char pairs[3][2] = {
+		{ seq1Move, seq2Move }, { seq1Move, seq3Move }, { seq2Move, seq3Move } };
+
+	int count = 0;
+	for (int pair = 0; pair < 3; pair++) {
+		unsigned char pairMask = pairs[pair][0] | pairs[pair][1];
+
+		// Only a pair with one sequence advancing has a gap
+		unsigned char moveAdvances = move & pairMask;
+		if (moveAdvances != pairs[pair][0] && moveAdvances != pairs[pair][1])
+			continue;
+
+		// The gap continues if the state had the gap in the same sequence
+		if (fromState == 0 || (fromState & pairMask) != moveAdvances)
+			count++;
+	}
+
+	return count;
+}
+
+// int gapPairCount(unsigned char move)
+//  Purpose:
+//		Returns the number of pairs of sequences that have a residue
+//		aligned with a gap in the column for move.
+int AffineGapAligner::gapPairCount(unsigned char move) {
+	int advancing = ((move & seq1Move) ? 1 : 0) + ((move & seq2Move) ? 1 : 0) + ((move & seq3Move) ? 1 : 0);
+
+	return advancing * (3 - advancing);
+}
+
+// cellMoveWeights(int seq1Loc, int seq2Loc, int seq3Loc, int weights[8])
+//  Purpose:
+//		Sets weights[move] to the weight of the column for the edge that
+//		ends at (i,j,k) using move, without the gap opens, for moves 1 to 7
+//		(moves that would start outside the tensor get gap weights).  The
+//		index of each residue is only read from its code once.
+void AffineGapAligner::cellMoveWeights(int seq1Loc, int seq2Loc, int seq3Loc, int weights[8]) {
+	int index1 = (seq1Loc > 0) ? seq1Indexes[seq1Loc - 1] : gapIndex;
+	int index2 = (seq2Loc > 0) ? seq2Indexes[seq2Loc - 1] : gapIndex;
+	int index3 = (seq3Loc > 0) ? seq3Indexes[seq3Loc - 1] : gapIndex;
+
+	for (unsigned char move = 1; move <= 7; move++) {
+		weights[move] = matrix->sumOfPairsWeightByIndex(
+			(move & seq1Move) ? index1 : gapIndex,
+			(move & seq2Move) ? index2 : gapIndex,
+			(move & seq3Move) ? index3 : gapIndex);
+	}
+}
+
+// encodeSequences()
+//  Purpose:
+//		Looks up the matrix index of each residue code of the sequences
+//		(see EncodedSequence::MatrixIndexes), so the index of a residue is
+//		read from its code and only each code is looked up in the matrix.
+//		Throws out_of_range if a sequence has a char that is not a residue.
+//  Postconditions:
+//		seq1Indexes, seq2Indexes, seq3Indexes and gapIndex will be set
+void AffineGapAligner::encodeSequences() {
+	gapIndex = matrix->getGapIndex();
+
+	// The codes of each sequence are only looked up once in the matrix
+	seq1Indexes = EncodedSequence::MatrixIndexes(encoded1, *matrix);
+	seq2Indexes = EncodedSequence::MatrixIndexes(encoded2, *matrix);
+	seq3Indexes = EncodedSequence::MatrixIndexes(encoded3, *matrix);
+}
+
+// string cellLabel(Cell& cell)
+//  Purpose:
+//		Returns the label WDAGraphFileBuilder uses for the vertex (i,j,k)
+//			<<i>>,<<j>>,<<k>>
+string AffineGapAligner::cellLabel(Cell& cell) {
+	stringstream ss;
+	ss << cell.seq1Loc << "," << cell.seq2Loc << "," << cell.seq3Loc;
+	return ss.str();
+}
+
+// string moveLabel(unsigned char move, int seq1Loc, int seq2Loc, int seq3Loc)
+//  Purpose:
+//		Returns the label of the edge that ends at (i,j,k) using move, i.e.
+//		the column of aligned residues & gap characters for the move.
+string AffineGapAligner::moveLabel(unsigned char move, int seq1Loc, int seq2Loc, int seq3Loc) {
+	string label(3, gapChar);
+	if (move & seq1Move)
+		label[0] = encoded1.at(seq1Loc - 1);
+	if (move & seq2Move)
+		label[1] = encoded2.at(seq2Loc - 1);
+	if (move & seq3Move)
+		label[2] = encoded3.at(seq3Loc - 1);
+	return label;
+}
+
+// string getPath()
+//  Purpose:
+//		Returns a string representing the edge labels for the highest weight
+//		path in the same form as WDAGraph::getPath().
+string AffineGapAligner::getPath() {
+	stringstream ss;
+
+	// Walk path backwards and build string
+	Cell cell = pathEnd;
+	for (size_t moveIndex = pathMoves.size(); moveIndex > 0; moveIndex--) {
+		unsigned char move = pathMoves[moveIndex - 1];
+
+		// Add the label for the move to the string stream
+		ss << moveLabel(move, cell.seq1Loc, cell.seq2Loc, cell.seq3Loc) << "\n";
+
+		// Walk backwards one cell
+		cell.seq1Loc -= (move & seq1Move) ? 1 : 0;
+		cell.seq2Loc -= (move & seq2Move) ? 1 : 0;
+		cell.seq3Loc -= (move & seq3Move) ? 1 : 0;
+	}
+
+	// Return reverse of stringstream (since we built the string backwards)
+	string reversePath = ss.str();
+	return string(reversePath.rbegin(), reversePath.rend());
+}
@@ -0,0 +1,214 @@
+/*
+ * AffineGapAligner.h
+ *
+ *	This is the header file for the AffineGapAligner object. The
+ *  AffineGapAligner finds the highest weight path through the edit graph
+ *  for three fasta files, like the ThreeWayAligner, but scores gaps with
+ *  an affine cost: a gap of length L in one sequence of a pair costs
+ *  gapOpen + L * gapExtend instead of L * the matrix's gapCost().
+ *
+ *  The columns are scored with sum of pairs, so a column pays a gap open
+ *  for each pair of sequences where a gap starts.  Whether a gap starts
+ *  depends on the column before it, so each cell of the edit graph has
+ *  one state for each of the seven moves that can enter it, and an edge
+ *  pays gapOpen for every pair whose gap is not in the same sequence in
+ *  the state it leaves from (Gotoh's algorithm, with quasi-natural gap
+ *  costs: a pair that is gapped in both sequences does not continue an
+ *  earlier gap).  Paths can start at any cell, with weight 0.
+ *
+ *  The scores of the seven states are kept in separate planes, and only
+ *  two i planes of them are in memory.  The state each state was entered
+ *  from is kept for every cell in a PackedTraceback, so the path is
+ *  walked back without running the dynamic program again.  With
+ *  gapOpen = 0 and gapExtend = gapCost() the scores are the same
+ *  as the linear gap scores of the ThreeWayAligner.
+ *
+ *  Typical Use:
+ *		AffineGapAligner aligner(fasta1, fasta2, fasta3);
+ *		aligner.setGapCosts(-11, -1);
+ *		aligner.findHighestWeightPath();
+ *		cout << aligner.resultString();
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef AFFINEGAPALIGNER_H
+#define AFFINEGAPALIGNER_H
+
+#include "FastaFile.h"
+#include "PackedTraceback.h"
+#include "ScoringMatrix.h"
+#include "OutputBuffer.h"
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <climits>
+using namespace std;
+
+class AffineGapAligner
+{
+public:
+
+	// Constuctors
+	// ==============================================
+	AffineGapAligner(FastaFile* fasta1, FastaFile* fasta2, FastaFile* fasta3);
+
+	// Destructor
+	// =============================================
+	virtual ~AffineGapAligner();
+
+	// Public Methods
+	// =============================================
+
+	// findHighestWeightPath()
+	//  Purpose:
+	//		Uses dynamic programming to find the highest weight path through
+	//		the edit graph for the three sequences with affine gap costs.
+	//		The cells are visited in vertex order (i, then j, then k), and the
+	//		weight of each state of a cell is the max over the states of the
+	//		move's start cell (and the trivial path of starting there) of the
+	//		start weight + the column weight + the gap opens.
+	//
+	//		An edge only replaces the current best when it is strictly
+	//		better, and the end of the path is the first state (in vertex
+	//		order) with the highest weight.
+	//  Postconditions:
+	//		- highestWeight, pathStart, pathEnd and pathMoves will be set
+	void findHighestWeightPath();
+
+	// string resultString()
+	//  Purpose:
+	//		Returns an XML formatted string representing the results of the
+	//		findHighestWeightPath() function.
+	//
+	//		format:
+	//			<results type="part?" file=" <<graphFileName>> ">";
+	//			  <result type="gap_open"> <<cost to open a gap>> </result>
+	//			  <result type="gap_extend">  <<cost for each gap char>> </result>
+	//			  <result type="score"> <<highest weight path score>> </result>
+	//			  <result type="beginning_vertex"> <<start vertex for path>> </result>
+	//			  <result type="ending_vertex"> <<end vertex for path>> </result>
+	//			  <result type="path"> << list of path edge labels in order>> </result>
+	//			</results>
+	//  Preconditions:
+	//		findHighestWeightPath() has been run
+	string resultString();
+
+	// writeResult(OutputBuffer& out)
+	//  Purpose:
+	//		Appends the string resultString() returns to out, without
+	//		building a stream for it.
+	//  Preconditions:
+	//		findHighestWeightPath() has been run
+	void writeResult(OutputBuffer& out);
+
+	// Public Accessors
+	// =============================================
+	int getScore();  // weight of the highest weight path
+	void setGapCosts(int aGapOpen, int aGapExtend);  // costs are added, so they are usually negative
+	void setScoringMatrix(const ScoringMatrix* aMatrix);  // substitution scores (NULL = BLOSUM62), its gap cost is not used
+
+	// Public Class Attributes
+	// =============================================
+	static const int defaultGapOpen = -11;
+	static const int defaultGapExtend = -1;
+
+private:
+
+	// Attributes
+	// =============================================
+
+	// A location in the edit graph, (i,j,k)
+	struct Cell {
+		int seq1Loc;
+		int seq2Loc;
+		int seq3Loc;
+	};
+
+	char gapChar;
+	string graphFileName;  // name reported in the results header
+	const EncodedSequence& encoded1;  // the sequences as residue codes
+	const EncodedSequence& encoded2;
+	const EncodedSequence& encoded3;
+	int seq1Length;
+	int seq2Length;
+	int seq3Length;
+	const ScoringMatrix* matrix;  // substitution scores for the columns
+	int gapIndex;  // index of the gap char in matrix
+	EncodedSequence::MatrixIndexes seq1Indexes;  // matrix index of each residue of seq1
+	EncodedSequence::MatrixIndexes seq2Indexes;
+	EncodedSequence::MatrixIndexes seq3Indexes;
+	int gapOpen;
+	int gapExtend;
+	int highestWeight;  // weight of the highest weight path
+	Cell pathStart;  // starting cell of the highest weight path
+	Cell pathEnd;  // ending cell of the highest weight path
+	vector<unsigned char> pathMoves;  // moves of the highest weight path, from start to end
+	PackedTraceback traceback;  // state each state of each cell was entered from (0 = path starts at the move's start cell)
+
+	// Moves are encoded as in the ThreeWayAligner, a bit mask of the
+	// sequences that advance (4 = fasta1, 2 = fasta2, 1 = fasta3).  The
+	// state of a cell is the move that entered it, 0 is used for the
+	// trivial path of starting at a cell.
+	static const unsigned char seq1Move = 4;
+	static const unsigned char seq2Move = 2;
+	static const unsigned char seq3Move = 1;
+	static const int stateCount = 7;
+
+	// Score used for states that can not be reached
+	static const int unreachable = INT_MIN / 2;
+
+	// Private Methods
+	// =============================================
+
+	// int gapOpenCount(unsigned char fromState, unsigned char move)
+	//  Purpose:
+	//		Returns the number of pairs of sequences where taking move from
+	//		a cell in fromState starts a new gap.
+	static int gapOpenCount(unsigned char fromState, unsigned char move);
+
+	// int gapPairCount(unsigned char move)
+	//  Purpose:
+	//		Returns the number of pairs of sequences that have a residue
+	//		aligned with a gap in the column for move.
+	static int gapPairCount(unsigned char move);
+
+	// cellMoveWeights(int seq1Loc, int seq2Loc, int seq3Loc, int weights[8])
+	//  Purpose:
+	//		Sets weights[move] to the weight of the column for the edge that
+	//		ends at (i,j,k) using move, without the gap opens, for moves 1 to 7
+	//		(moves that would start outside the tensor get gap weights).  The
+	//		index of each residue is only read from its code once.
+	void cellMoveWeights(int seq1Loc, int seq2Loc, int seq3Loc, int weights[8]);
+
+	// encodeSequences()
+	//  Purpose:
+	//		Looks up the matrix index of each residue code of the sequences
+	//		(see EncodedSequence::MatrixIndexes), so the index of a residue is
+	//		read from its code and only each code is looked up in the matrix.
+	//		Throws out_of_range if a sequence has a char that is not a residue.
+	//  Postconditions:
+	//		seq1Indexes, seq2Indexes, seq3Indexes and gapIndex will be set
+	void encodeSequences();
+
+	// string cellLabel(Cell& cell)
+	//  Purpose:
+	//		Returns the label WDAGraphFileBuilder uses for the vertex (i,j,k)
+	//			<<i>>,<<j>>,<<k>>
+	string cellLabel(Cell& cell);
+
+	// string moveLabel(unsigned char move, int seq1Loc, int seq2Loc, int seq3Loc)
+	//  Purpose:
+	//		Returns the label of the edge that ends at (i,j,k) using move, i.e.
+	//		the column of aligned residues & gap characters for the move.
+	string moveLabel(unsigned char move, int seq1Loc, int seq2Loc, int seq3Loc);
+
+	// string getPath()
+	//  Purpose:
+	//		Returns a string representing the edge labels for the highest weight
+	//		path in the same form as WDAGraph::getPath().
+	string getPath();
+};
+
+#endif // AFFINEGAPALIGNER_H
@@ -0,0 +1,296 @@
+/*
+ * AllVsAllAligner.cpp
+ *
+ *	This is the cpp file for the AllVsAllAligner object. The
+ *  AllVsAllAligner finds the global alignment score of every pair of
+ *  records of a multi-record fasta file and writes them to a binary
+ *  distance matrix file (see DistanceMatrixFormat.h).
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "AllVsAllAligner.h"
+#include "DistanceMatrixFormat.h"
+#include "FastaReader.h"
+#include "ThreadPool.h"
+#include "ScoreRowKernel.h"
+#include "StringUtilities.h"
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+using namespace std;
+
+// Class Attribute Initialization
+// ==============================================
+const int AllVsAllAligner::tileRecords;
+
+// Constuctors
+// ==============================================
+AllVsAllAligner::AllVsAllAligner(const string& aFastaFileName) {
+	fastaFileName = aFastaFileName;
+	matrix = &ScoringMatrix::blosum62();
+	threadCount = 1;
+	writeScores = false;
+	pairCount = 0;
+
+	FastaReader reader(fastaFileName);
+	FastaRecord record;
+	while (reader.nextRecord(record)) {
+		string name;
+		stringstream(record.header.substr(1)) >> name;
+		names.push_back(name);
+		sequences.push_back(record.sequence);
+	}
+}
+
+// Destructor
+// =============================================
+AllVsAllAligner::~AllVsAllAligner() {
+}
+
+// Public Methods
+// =============================================
+
+// run(const string& matrixFileName)
+//  Purpose:
+//		Aligns every pair of records and writes the distance matrix file.
+//		Throws out_of_range if a sequence has a char that is not a
+//		residue of the matrix, and runtime_error if the file can not be
+//		opened or written.
+//  Postconditions:
+//		- the file named matrixFileName holds the distance matrix
+void AllVsAllAligner::run(const string& aMatrixFileName) {
+	matrixFileName = aMatrixFileName;
+	int recordCount = sequences.size();
+	pairCount = (recordCount > 1) ? (uint64_t) recordCount * (recordCount - 1) / 2 : 0;
+
+	ThreadPool pool(threadCount);
+	vector<PairwiseAligner> aligners(pool.getThreadCount());
+	for (size_t i = 0; i < aligners.size(); i++)
+		aligners[i].setScoringMatrix(matrix);
+
+	// Encode the sequences here, so the worker threads do not throw
+	encoded.resize(recordCount);
+	for (int record = 0; record < recordCount; record++)
+		aligners[0].encode(sequences[record], encoded[record]);
+
+	selfScores.resize(recordCount);
+	pool.parallelFor(recordCount, [&](size_t record, unsigned int thread) {
+		selfScores[record] = aligners[thread].globalScore(sequences[record], sequences[record]);
+	});
+
+	// Sort the records of each column tile by length
+	tileOrder.resize(recordCount);
+	for (int record = 0; record < recordCount; record++)
+		tileOrder[record] = record;
+	for (int tileStart = 0; tileStart < recordCount; tileStart += tileRecords) {
+		int tileEnd = min(recordCount, tileStart + tileRecords);
+		stable_sort(tileOrder.begin() + tileStart, tileOrder.begin() + tileEnd, [&](int record1, int record2) {
+			return encoded[record1].size() < encoded[record2].size();
+		});
+	}
+
+	ofstream matrixFile(matrixFileName, ios::out | ios::binary | ios::trunc);
+	if (!matrixFile.is_open())
+		throw runtime_error("can not open file " + matrixFileName);
+
+	writeHeader(matrixFile);
+	checkWritten(matrixFile);
+
+	// Fill and write a strip of tiles at a time
+	vector<int> stripScores;
+	vector<uint64_t> rowOffsets;
+	for (int rowStart = 0; rowStart < recordCount; rowStart += tileRecords) {
+		int rowEnd = min(recordCount, rowStart + tileRecords);
+
+		rowOffsets.assign(1, 0);
+		for (int record = rowStart; record < rowEnd; record++)
+			rowOffsets.push_back(rowOffsets.back() + (recordCount - record - 1));
+		stripScores.resize(rowOffsets.back());
+
+		// The tile on the diagonal and every tile after it
+		int tileCount = (recordCount - rowStart + tileRecords - 1) / tileRecords;
+		pool.parallelFor(tileCount, [&](size_t tile, unsigned int thread) {
+			int columnStart = rowStart + tile * tileRecords;
+			int columnEnd = min(recordCount, columnStart + tileRecords);
+			alignTile(rowStart, rowEnd, columnStart, columnEnd, rowOffsets, stripScores, aligners[thread]);
+		});
+
+		writeStrip(matrixFile, rowStart, rowEnd, stripScores);
+		checkWritten(matrixFile);
+	}
+
+	// Closing flushes what is still buffered
+	matrixFile.close();
+	checkWritten(matrixFile);
+}
+
+// string resultString()
+//  Purpose:
+//		Returns an XML formatted string describing the results of the
+//		run() function.
+//
+//		format:
+//			<results type="all_vs_all" file=" <<fastaFileName>> ">";
+//			  <result type="sequence_count"> <<number of records>> </result>
+//			  <result type="pair_count"> <<number of pairs aligned>> </result>
+//			  <result type="instruction_set"> <<SIMD instructions used>> </result>
+//			  <result type="matrix_file"> <<file written>> </result>
+//			</results>
+//  Preconditions:
+//		run() has been run
+string AllVsAllAligner::resultString() {
+	stringstream ss;
+	// Results header
+	ss << "  <results type=\"all_vs_all\" file=\"" << fastaFileName << "\">\n";
+
+	stringstream recordCount;
+	recordCount << sequences.size();
+	stringstream pairs;
+	pairs << pairCount;
+
+	// globalScores() uses AVX2 for any of the vector instruction sets
+	ScoreRowKernel::InstructionSet instructionSet = ScoreRowKernel::getInstructionSet();
+	if (instructionSet != ScoreRowKernel::scalar)
+		instructionSet = ScoreRowKernel::avx2;
+
+	ss
+		<< StringUtilities::xmlResult("sequence_count", recordCount.str())
+		<< StringUtilities::xmlResult("pair_count", pairs.str())
+		<< StringUtilities::xmlResult("instruction_set", ScoreRowKernel::instructionSetName(instructionSet))
+		<< StringUtilities::xmlResult("matrix_file", matrixFileName);
+
+	// Results footer
+	ss << "  </results>\n";
+
+	return ss.str();
+}
+
+// Public Accessors
+// =============================================
+size_t AllVsAllAligner::getRecordCount() {
+	return sequences.size();
+}
+
+void AllVsAllAligner::setScoringMatrix(const ScoringMatrix* aMatrix) {
+	matrix = (aMatrix != NULL) ? aMatrix : &ScoringMatrix::blosum62();
+}
+
+void AllVsAllAligner::setThreadCount(unsigned int aThreadCount) {
+	threadCount = (aThreadCount > 0) ? aThreadCount : 1;
+}
+
+void AllVsAllAligner::setWriteScores(bool aWriteScores) {
+	writeScores = aWriteScores;
+}
+
+// Private Methods
+// =============================================
+
+// alignTile(int rowStart, int rowEnd, int columnStart, int columnEnd,
+//		const vector<uint64_t>& rowOffsets, vector<int>& stripScores, PairwiseAligner& aligner)
+//  Purpose:
+//		Aligns the records [rowStart, rowEnd) against the records
+//		[columnStart, columnEnd) that come after them.  The score for
+//		records i < j goes in stripScores[rowOffsets[i - rowStart] + j - i - 1].
+void AllVsAllAligner::alignTile(int rowStart, int rowEnd, int columnStart, int columnEnd,
+	const vector<uint64_t>& rowOffsets, vector<int>& stripScores, PairwiseAligner& aligner) {
+
+	const vector<unsigned char>* laneSequences[PairwiseAligner::laneCount];
+	int laneRecords[PairwiseAligner::laneCount];
+	int laneScores[PairwiseAligner::laneCount];
+
+	for (int record1 = rowStart; record1 < rowEnd; record1++) {
+		uint64_t rowOffset = rowOffsets[record1 - rowStart];
+
+		// Fill the lanes with the column records (shortest first) after record1
+		int lanes = 0;
+		for (int column = columnStart; column <= columnEnd; column++) {
+			if (column < columnEnd) {
+				int record2 = tileOrder[column];
+				if (record2 <= record1)
+					continue;
+
+				laneSequences[lanes] = &encoded[record2];
+				laneRecords[lanes] = record2;
+				lanes++;
+			}
+
+			if (lanes == PairwiseAligner::laneCount || (column == columnEnd && lanes > 0)) {
+				aligner.globalScores(encoded[record1], laneSequences, lanes, laneScores);
+				for (int lane = 0; lane < lanes; lane++)
+					stripScores[rowOffset + laneRecords[lane] - record1 - 1] = laneScores[lane];
+				lanes = 0;
+			}
+		}
+	}
+}
+
+// writeHeader(ofstream& matrixFile)
+//  Purpose:
+//		Writes the header, name pool and self scores of the file
+void AllVsAllAligner::writeHeader(ofstream& matrixFile) {
+	static const char padding[8] = { 0 };
+
+	uint64_t namePoolSize = 0;
+	for (size_t record = 0; record < names.size(); record++)
+		namePoolSize += names[record].length() + 1;
+
+	DistanceMatrixHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, distanceMatrixMagic, sizeof(header.magic));
+	header.version = distanceMatrixVersion;
+	header.valueType = writeScores ? distanceMatrixScores : distanceMatrixDistances;
+	header.recordCount = names.size();
+	header.namePoolOffset = sizeof(header);
+	header.selfScoresOffset = (header.namePoolOffset + namePoolSize + 7) & ~(uint64_t) 7;
+	header.valuesOffset = (header.selfScoresOffset + names.size() * sizeof(int32_t) + 7) & ~(uint64_t) 7;
+	header.fileSize = header.valuesOffset + pairCount * sizeof(int32_t);
+
+	matrixFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	for (size_t record = 0; record < names.size(); record++)
+		matrixFile.write(names[record].c_str(), names[record].length() + 1);
+	matrixFile.write(padding, header.selfScoresOffset - header.namePoolOffset - namePoolSize);
+
+	for (size_t record = 0; record < selfScores.size(); record++) {
+		int32_t selfScore = selfScores[record];
+		matrixFile.write(reinterpret_cast<const char*>(&selfScore), sizeof(selfScore));
+	}
+	matrixFile.write(padding, header.valuesOffset - header.selfScoresOffset - names.size() * sizeof(int32_t));
+}
+
+// checkWritten(ofstream& matrixFile)
+//  Purpose:
+//		Throws runtime_error if a write to the matrix file has failed
+void AllVsAllAligner::checkWritten(ofstream& matrixFile) {
+	if (!matrixFile)
+		throw runtime_error("can not write file " + matrixFileName);
+}
+
+// writeStrip(ofstream& matrixFile, int rowStart, int rowEnd, vector<int>& stripScores)
+//  Purpose:
+//		Writes the values for the rows of a strip
+void AllVsAllAligner::writeStrip(ofstream& matrixFile, int rowStart, int rowEnd, vector<int>& stripScores) {
+	if (writeScores) {
+		matrixFile.write(reinterpret_cast<const char*>(stripScores.data()), stripScores.size() * sizeof(int32_t));
+		return;
+	}
+
+	int recordCount = sequences.size();
+	vector<float> distances(stripScores.size());
+	size_t value = 0;
+	for (int record1 = rowStart; record1 < rowEnd; record1++) {
+		for (int record2 = record1 + 1; record2 < recordCount; record2++, value++) {
+			float distance = 1.0f;
+			int scale = min(selfScores[record1], selfScores[record2]);
+			if (scale > 0)
+				distance = max(0.0f, min(1.0f, 1.0f - (float) stripScores[value] / scale));
+
+			distances[value] = distance;
+		}
+	}
+
+	matrixFile.write(reinterpret_cast<const char*>(distances.data()), distances.size() * sizeof(float));
+}
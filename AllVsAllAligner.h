@@ -0,0 +1,143 @@
+/*
+ * AllVsAllAligner.h
+ *
+ *	This is the header file for the AllVsAllAligner object. The
+ *  AllVsAllAligner finds the global alignment (Needleman-Wunsch) score of
+ *  every pair of records of a multi-record fasta file and writes them to
+ *  a binary distance matrix file (see DistanceMatrixFormat.h), either as
+ *  scores or as distances:
+ *		distance = 1 - score / min(self score i, self score j)
+ *  clamped to [0, 1].
+ *
+ *  The upper triangle of the matrix is cut into tiles of tileRecords rows
+ *  by tileRecords columns.  A strip of tiles (tileRecords rows) is filled
+ *  at a time, its tiles spread over setThreadCount() threads, and then
+ *  written out: the rows of a strip are next to each other in the file, so
+ *  the file is written in order and only one strip is held in memory.
+ *
+ *  Within a tile, each row record is aligned against laneCount column
+ *  records at a time with PairwiseAligner::globalScores(), one pair in
+ *  each SIMD lane.  The column records of each tile are sorted by length
+ *  so the records that share the lanes have similar lengths.
+ *
+ *  Typical Use:
+ *		AllVsAllAligner allVsAll(fastaFileName);
+ *		allVsAll.setThreadCount(8);
+ *		allVsAll.run(matrixFileName);
+ *		cout << allVsAll.resultString();
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef ALLVSALLALIGNER_H
+#define ALLVSALLALIGNER_H
+
+#include "ScoringMatrix.h"
+#include "PairwiseAligner.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+using namespace std;
+
+class AllVsAllAligner
+{
+public:
+
+	// Constuctors
+	// ==============================================
+
+	// Reads the records of the fasta file, each record is named by the
+	// first word of its header
+	AllVsAllAligner(const string& aFastaFileName);
+
+	// Destructor
+	// =============================================
+	virtual ~AllVsAllAligner();
+
+	// Public Methods
+	// =============================================
+
+	// run(const string& matrixFileName)
+	//  Purpose:
+	//		Aligns every pair of records and writes the distance matrix file.
+	//		Throws out_of_range if a sequence has a char that is not a
+	//		residue of the matrix, and runtime_error if the file can not be
+	//		opened or written.
+	//  Postconditions:
+	//		- the file named matrixFileName holds the distance matrix
+	void run(const string& matrixFileName);
+
+	// string resultString()
+	//  Purpose:
+	//		Returns an XML formatted string describing the results of the
+	//		run() function.
+	//
+	//		format:
+	//			<results type="all_vs_all" file=" <<fastaFileName>> ">";
+	//			  <result type="sequence_count"> <<number of records>> </result>
+	//			  <result type="pair_count"> <<number of pairs aligned>> </result>
+	//			  <result type="instruction_set"> <<SIMD instructions used>> </result>
+	//			  <result type="matrix_file"> <<file written>> </result>
+	//			</results>
+	//  Preconditions:
+	//		run() has been run
+	string resultString();
+
+	// Public Accessors
+	// =============================================
+	size_t getRecordCount();
+	void setScoringMatrix(const ScoringMatrix* aMatrix);  // matrix to score with (NULL = BLOSUM62)
+	void setThreadCount(unsigned int aThreadCount);  // threads the tiles of a strip are spread over
+	void setWriteScores(bool aWriteScores);  // write the scores instead of distances
+
+	// Public Class Attributes
+	// =============================================
+	static const int tileRecords = 64;  // rows and columns of a tile
+
+private:
+
+	// Attributes
+	// =============================================
+	string fastaFileName;
+	string matrixFileName;
+	vector<string> names;
+	vector<string> sequences;
+	vector<vector<unsigned char> > encoded;  // matrix indexes of each sequence
+	vector<int> selfScores;
+	vector<int> tileOrder;  // the records of each column tile, sorted by length
+	const ScoringMatrix* matrix;
+	unsigned int threadCount;
+	bool writeScores;
+	uint64_t pairCount;
+
+	// Private Methods
+	// =============================================
+
+	// alignTile(int rowStart, int rowEnd, int columnStart, int columnEnd,
+	//		const vector<uint64_t>& rowOffsets, vector<int>& stripScores, PairwiseAligner& aligner)
+	//  Purpose:
+	//		Aligns the records [rowStart, rowEnd) against the records
+	//		[columnStart, columnEnd) that come after them.  The score for
+	//		records i < j goes in stripScores[rowOffsets[i - rowStart] + j - i - 1].
+	void alignTile(int rowStart, int rowEnd, int columnStart, int columnEnd,
+		const vector<uint64_t>& rowOffsets, vector<int>& stripScores, PairwiseAligner& aligner);
+
+	// writeHeader(ofstream& matrixFile)
+	//  Purpose:
+	//		Writes the header, name pool and self scores of the file
+	void writeHeader(ofstream& matrixFile);
+
+	// checkWritten(ofstream& matrixFile)
+	//  Purpose:
+	//		Throws runtime_error if a write to the matrix file has failed
+	void checkWritten(ofstream& matrixFile);
+
+	// writeStrip(ofstream& matrixFile, int rowStart, int rowEnd, vector<int>& stripScores)
+	//  Purpose:
+	//		Writes the values for the rows of a strip
+	void writeStrip(ofstream& matrixFile, int rowStart, int rowEnd, vector<int>& stripScores);
+};
+
+#endif // ALLVSALLALIGNER_H
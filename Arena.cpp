@@ -0,0 +1,115 @@
+/*
+ * Arena.cpp
+ *
+ *	This is the cpp file for the Arena object. The Arena is a bump
+ *  allocator: memory is handed out from large blocks by moving a pointer
+ *  forward, and is only given back when the whole arena is released.
+ *
+ *  It is meant for objects that are created in large numbers and all go
+ *  away at the same time (e.g. the vertices and edges of a WDAGraph).
+ *  Destructors are NOT run for objects placed in the arena, so it should
+ *  only be used for plain data.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "Arena.h"
+#include "Instrumentation.h"
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <new>
+using namespace std;
+
+// Constuctors
+// ==============================================
+Arena::Arena() {
+	blockSize = 1 << 20;
+	bytesReserved = 0;
+}
+
+Arena::Arena(size_t aBlockSize) {
+	blockSize = aBlockSize;
+	bytesReserved = 0;
+}
+
+// Destructor
+// =============================================
+Arena::~Arena() {
+	release();
+}
+
+// Public Methods
+// =============================================
+
+// void* allocate(size_t size, size_t alignment)
+//  Purpose:
+//		Returns size bytes of memory aligned to alignment (a power of 2).
+//		The memory stays valid until the arena is released.
+void* Arena::allocate(size_t size, size_t alignment) {
+
+	// Try the current block first
+	if (!blocks.empty()) {
+		Block& block = blocks.back();
+		size_t start = (block.used + alignment - 1) & ~(alignment - 1);
+		if (start + size <= block.size) {
+			block.used = start + size;
+			return block.data + start;
+		}
+	}
+
+	// Start a new block (malloc memory is aligned for any standard type)
+	addBlock(size + alignment);
+	Block& block = blocks.back();
+	size_t start = ((size_t) -(uintptr_t) block.data) & (alignment - 1);
+	block.used = start + size;
+	return block.data + start;
+}
+
+// const char* copyString(const char* chars, size_t length)
+//  Purpose:
+//		Copies length chars into the arena and adds a terminating
+//		null char.  Returns the copy.
+const char* Arena::copyString(const char* chars, size_t length) {
+	char* copy = static_cast<char*>(allocate(length + 1, 1));
+	memcpy(copy, chars, length);
+	copy[length] = '\0';
+	return copy;
+}
+
+// release()
+//  Purpose:
+//		Frees all of the memory handed out by the arena in one step.
+void Arena::release() {
+	for (Block& block : blocks)
+		free(block.data);
+
+	blocks.clear();
+	bytesReserved = 0;
+}
+
+// Public Accessors
+// =============================================
+size_t Arena::getBytesReserved() {
+	return bytesReserved;
+}
+
+// Private Methods
+// =============================================
+
+// addBlock(size_t minimumSize)
+//  Purpose:
+//		Adds a new block with room for at least minimumSize bytes
+void Arena::addBlock(size_t minimumSize) {
+	Block block;
+	block.size = (minimumSize > blockSize) ? minimumSize : blockSize;
+	block.data = static_cast<char*>(malloc(block.size));
+	if (block.data == NULL)
+		throw bad_alloc();
+	block.used = 0;
+
+	blocks.push_back(block);
+	bytesReserved += block.size;
+	INSTRUMENT_PEAK(peakArenaBytes, bytesReserved);
+}
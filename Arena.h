@@ -0,0 +1,105 @@
+/*
+ * Arena.h
+ *
+ *	This is the header file for the Arena object. The Arena is a bump
+ *  allocator: memory is handed out from large blocks by moving a pointer
+ *  forward, and is only given back when the whole arena is released.
+ *
+ *  It is meant for objects that are created in large numbers and all go
+ *  away at the same time (e.g. the vertices and edges of a WDAGraph).
+ *  Destructors are NOT run for objects placed in the arena, so it should
+ *  only be used for plain data.
+ *
+ *  Typical Use:
+ *		Arena arena;
+ *		Edge* edges = arena.allocateArray<Edge>(edgeCount);
+ *		const char* label = arena.copyString(text, length);
+ *		...
+ *		arena.release();  // or let the arena go out of scope
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <vector>
+#include <cstddef>
+using namespace std;
+
+class Arena
+{
+public:
+
+	// Constuctors
+	// ==============================================
+	Arena();
+	Arena(size_t aBlockSize);
+
+	// Destructor
+	// =============================================
+	~Arena();
+
+	// Public Methods
+	// =============================================
+
+	// void* allocate(size_t size, size_t alignment)
+	//  Purpose:
+	//		Returns size bytes of memory aligned to alignment (a power of 2).
+	//		The memory stays valid until the arena is released.
+	void* allocate(size_t size, size_t alignment);
+
+	// T* allocateArray<T>(size_t count)
+	//  Purpose:
+	//		Returns uninitialized memory for count objects of type T.
+	template <class T>
+	T* allocateArray(size_t count) {
+		return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+	}
+
+	// const char* copyString(const char* chars, size_t length)
+	//  Purpose:
+	//		Copies length chars into the arena and adds a terminating
+	//		null char.  Returns the copy.
+	const char* copyString(const char* chars, size_t length);
+
+	// release()
+	//  Purpose:
+	//		Frees all of the memory handed out by the arena in one step.
+	void release();
+
+	// Public Accessors
+	// =============================================
+	size_t getBytesReserved();  // bytes of the blocks currently held
+
+private:
+
+	// Attributes
+	// =============================================
+
+	// A block of memory that allocations are carved out of
+	struct Block {
+		char* data;
+		size_t size;
+		size_t used;
+	};
+
+	vector<Block> blocks;
+	size_t blockSize;  // size of a standard block
+	size_t bytesReserved;
+
+	// The arena owns its blocks, so it can not be copied
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	// Private Methods
+	// =============================================
+
+	// addBlock(size_t minimumSize)
+	//  Purpose:
+	//		Adds a new block with room for at least minimumSize bytes
+	void addBlock(size_t minimumSize);
+};
+
+#endif // ARENA_H
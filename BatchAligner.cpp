@@ -0,0 +1,413 @@
+/*
+ * BatchAligner.cpp
+ *
+ *	This is the cpp file for the BatchAligner object. The BatchAligner
+ *  aligns many triples of sequences in one process with the
+ *  ThreeWayAligner, spreading the triples over a fixed pool of worker
+ *  threads.
+ *
+ *  run() makes inFlightCount jobs and puts them all on the free queue.
+ *  A job goes around the pipeline: a loader takes it from the free queue
+ *  and reads the next triple into it, a worker aligns it, and the writer
+ *  writes its result (once the results before it are written) and puts it
+ *  back on the free queue.  The loaders can only get as far ahead of the
+ *  writer as there are jobs, and every queue can hold all of the jobs, so
+ *  only the loaders ever wait on a full pipeline.  The writer keeps the
+ *  jobs that finished early until their turn, so only their results are
+ *  held in memory.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "BatchAligner.h"
+#include "FastaReader.h"
+#include "StringUtilities.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <map>
+#include <memory>
+#include <stdexcept>
+using namespace std;
+
+// Constuctors
+// ==============================================
+BatchAligner::BatchAligner(unsigned int aThreadCount) {
+	threadCount = (aThreadCount > 0) ? aThreadCount : 1;
+	loadThreadCount = 1;
+	inFlightCount = 0;
+	linearSpace = false;
+	scoreOnly = false;
+	packedSequences = false;
+	matrix = NULL;
+	cache = NULL;
+	bandWidth = 0;
+	xDrop = 0;
+}
+
+// Destructor
+// =============================================
+BatchAligner::~BatchAligner() {
+	for (size_t i = 0; i < records.size(); i++)
+		delete records[i];
+}
+
+// Public Methods
+// =============================================
+
+// addTriple(const string& fileName1, const string& fileName2, const string& fileName3)
+//  Purpose:
+//		Adds a triple of fasta files to align
+void BatchAligner::addTriple(const string& fileName1, const string& fileName2, const string& fileName3) {
+	Triple triple;
+	triple.fileNames[0] = fileName1;
+	triple.fileNames[1] = fileName2;
+	triple.fileNames[2] = fileName3;
+	triple.fromRecords = false;
+
+	triples.push_back(triple);
+}
+
+// readManifest(const string& manifestFileName)
+//  Purpose:
+//		Adds the triples listed in a manifest file (see the class header).
+//		Throws runtime_error if the file can not be read, and out_of_range
+//		(with the line number) for a line with fewer than three names.
+void BatchAligner::readManifest(const string& manifestFileName) {
+	ifstream manifestFile(manifestFileName);
+	if (!manifestFile.is_open())
+		throw runtime_error("can not open manifest file " + manifestFileName);
+
+	string line;
+	size_t lineNumber = 0;
+	while (getline(manifestFile, line)) {
+		lineNumber++;
+		stringstream ss(line);
+		string fileName1, fileName2, fileName3;
+
+		if (!(ss >> fileName1) || fileName1[0] == '#')
+			continue;
+
+		if (!(ss >> fileName2 >> fileName3)) {
+			stringstream error;
+			error << "fewer than three fasta files on line " << lineNumber << " of manifest file " << manifestFileName;
+			throw out_of_range(error.str());
+		}
+
+		addTriple(fileName1, fileName2, fileName3);
+	}
+
+	if (manifestFile.bad())
+		throw runtime_error("can not read manifest file " + manifestFileName);
+
+	manifestFile.close();
+}
+
+// readCombinations(const string& fastaFileName)
+//  Purpose:
+//		Reads the records of a multi-record fasta file and adds every
+//		combination of three different records as a triple.  The records
+//		are named by the first word of their header.  Throws runtime_error
+//		if the file can not be read.
+void BatchAligner::readCombinations(const string& fastaFileName) {
+	size_t firstRecord = records.size();
+
+	FastaReader reader(fastaFileName);
+	if (!reader.isOpen())
+		throw runtime_error("can not open fasta file " + fastaFileName);
+
+	FastaRecord record;
+	while (reader.nextRecord(record)) {
+		string name;
+		stringstream(record.header.substr(1)) >> name;
+		records.push_back(new FastaFile(name, record, false));
+		if (packedSequences)
+			records.back()->packSequence();
+	}
+
+	for (size_t record1 = firstRecord; record1 < records.size(); record1++) {
+		for (size_t record2 = record1 + 1; record2 < records.size(); record2++) {
+			for (size_t record3 = record2 + 1; record3 < records.size(); record3++) {
+				Triple triple;
+				triple.records[0] = record1;
+				triple.records[1] = record2;
+				triple.records[2] = record3;
+				triple.fromRecords = true;
+
+				triples.push_back(triple);
+			}
+		}
+	}
+}
+
+// run(OutputBuffer& out)
+//  Purpose:
+//		Aligns all of the triples and writes their result strings to
+//		out, in the order the triples were added.  out is flushed as
+//		results are added, so a buffer with a file descriptor only
+//		holds the results that have not been written yet.
+void BatchAligner::run(OutputBuffer& out) {
+	size_t jobCount = (inFlightCount > 0) ? inFlightCount : 2 * threadCount + loadThreadCount;
+
+	vector<unique_ptr<Job>> jobs(jobCount);
+	Pipeline pipeline(jobCount);
+	for (size_t job = 0; job < jobCount; job++) {
+		jobs[job].reset(new Job());
+		pipeline.freeJobs.push(jobs[job].get());
+	}
+	pipeline.nextTriple = 0;
+	pipeline.runningLoaders = loadThreadCount;
+	pipeline.runningWorkers = threadCount;
+	pipeline.stopped = false;
+
+	// Start the stages, the calling thread is the writer
+	vector<ThreeWayAligner::Workspace> workspaces(threadCount);
+	vector<OutputBuffer> buffers(threadCount);
+	vector<thread> threads;
+	for (unsigned int loader = 0; loader < loadThreadCount; loader++)
+		threads.push_back(thread(&BatchAligner::loadStage, this, ref(pipeline)));
+	for (unsigned int worker = 0; worker < threadCount; worker++)
+		threads.push_back(thread(&BatchAligner::computeStage, this, ref(pipeline), ref(workspaces[worker]), ref(buffers[worker])));
+
+	writeStage(pipeline, out);
+
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+
+	if (pipeline.writeError)
+		rethrow_exception(pipeline.writeError);
+
+	out.flush();
+}
+
+// Public Accessors
+// =============================================
+size_t BatchAligner::getTripleCount() {
+	return triples.size();
+}
+
+void BatchAligner::setLinearSpace(bool aLinearSpace) {
+	linearSpace = aLinearSpace;
+}
+
+void BatchAligner::setBandWidth(int aBandWidth) {
+	bandWidth = aBandWidth;
+}
+
+void BatchAligner::setXDrop(int anXDrop) {
+	xDrop = anXDrop;
+}
+
+void BatchAligner::setScoreOnly(bool aScoreOnly) {
+	scoreOnly = aScoreOnly;
+}
+
+void BatchAligner::setScoringMatrix(const ScoringMatrix* aMatrix) {
+	matrix = aMatrix;
+}
+
+void BatchAligner::setResultCache(ResultCache* aCache) {
+	cache = aCache;
+}
+
+void BatchAligner::setLoadThreadCount(unsigned int aLoadThreadCount) {
+	loadThreadCount = (aLoadThreadCount > 0) ? aLoadThreadCount : 1;
+}
+
+void BatchAligner::setInFlightCount(unsigned int anInFlightCount) {
+	inFlightCount = anInFlightCount;
+}
+
+void BatchAligner::setPackedSequences(bool aPackedSequences) {
+	packedSequences = aPackedSequences;
+}
+
+// Private Methods
+// =============================================
+
+// loadStage(Pipeline& pipeline)
+//  Purpose:
+//		Body of each loader thread: takes free jobs, reads the fasta
+//		files of the next triple into them and passes them on to the
+//		workers, until every triple has been taken.
+void BatchAligner::loadStage(Pipeline& pipeline) {
+	Job* job;
+	while (pipeline.freeJobs.pop(job)) {
+		size_t tripleIndex = pipeline.stopped ? triples.size() : pipeline.nextTriple++;
+		if (tripleIndex >= triples.size()) {
+			// Let any other loader waiting for a job see that it is done too
+			pipeline.freeJobs.push(job);
+			break;
+		}
+
+		Triple& triple = triples[tripleIndex];
+		job->triple = tripleIndex;
+		job->error.clear();
+		for (int i = 0; i < 3; i++)
+			job->fastaFiles[i] = NULL;
+
+		// A triple that can not be loaded is passed on with its error
+		try {
+			for (int i = 0; i < 3; i++) {
+				if (triple.fromRecords)
+					job->fastaFiles[i] = records[triple.records[i]];
+				else {
+					job->fastaFiles[i] = new FastaFile(triple.fileNames[i], false);
+					if (packedSequences)
+						job->fastaFiles[i]->packSequence();
+				}
+			}
+		}
+		catch (const exception& e) {
+			job->error = e.what();
+		}
+
+		pipeline.loadedJobs.push(job);
+	}
+
+	if (--pipeline.runningLoaders == 0)
+		pipeline.loadedJobs.close();
+}
+
+// computeStage(Pipeline& pipeline, ThreeWayAligner::Workspace& workspace, OutputBuffer& buffer)
+//  Purpose:
+//		Body of each worker thread: aligns loaded jobs and passes them on
+//		to the writer, until there are no more loaded jobs.  A triple that
+//		throws gets an error result, so the other triples still run.
+void BatchAligner::computeStage(Pipeline& pipeline, ThreeWayAligner::Workspace& workspace, OutputBuffer& buffer) {
+	Job* job;
+	while (pipeline.loadedJobs.pop(job)) {
+		if (job->error.empty() && !pipeline.stopped) {
+			try {
+				align(*job, workspace, buffer);
+			}
+			catch (const exception& e) {
+				job->error = e.what();
+			}
+		}
+		releaseFastaFiles(*job);
+
+		if (!job->error.empty())
+			job->result = errorResult(*job);
+
+		pipeline.alignedJobs.push(job);
+	}
+
+	if (--pipeline.runningWorkers == 0)
+		pipeline.alignedJobs.close();
+}
+
+// writeStage(Pipeline& pipeline, OutputBuffer& out)
+//  Purpose:
+//		Writes the results of the aligned jobs to out in the order of
+//		the triples, handing each job back to the loaders once its
+//		result is written.  If out throws, the other stages are stopped
+//		and the jobs still in flight are drained, so no stage is left
+//		waiting, and the exception is kept for run().
+void BatchAligner::writeStage(Pipeline& pipeline, OutputBuffer& out) {
+	map<size_t, Job*> finished;  // aligned jobs waiting for the jobs before them
+	size_t nextToWrite = 0;
+
+	Job* job;
+	while (pipeline.alignedJobs.pop(job)) {
+		if (pipeline.stopped) {
+			pipeline.freeJobs.push(job);
+			continue;
+		}
+
+		finished[job->triple] = job;
+		try {
+			writeInOrder(pipeline, out, finished, nextToWrite);
+		}
+		catch (...) {
+			pipeline.writeError = current_exception();
+			pipeline.stopped = true;
+
+			for (map<size_t, Job*>::iterator waiting = finished.begin(); waiting != finished.end(); waiting++)
+				pipeline.freeJobs.push(waiting->second);
+			finished.clear();
+		}
+	}
+}
+
+// writeInOrder(Pipeline& pipeline, OutputBuffer& out, map<size_t, Job*>& finished, size_t& nextToWrite)
+//  Purpose:
+//		Writes out the results of the finished jobs that are next in
+//		order and hands the jobs back to the loaders.  A job stays in
+//		finished until its result has been written.
+void BatchAligner::writeInOrder(Pipeline& pipeline, OutputBuffer& out, map<size_t, Job*>& finished, size_t& nextToWrite) {
+	size_t firstToWrite = nextToWrite;
+	map<size_t, Job*>::iterator next;
+	while ((next = finished.find(nextToWrite)) != finished.end()) {
+		Job* nextJob = next->second;
+
+		out.write(nextJob->result);
+		nextJob->result.clear();
+		finished.erase(next);
+		pipeline.freeJobs.push(nextJob);
+		nextToWrite++;
+	}
+
+	if (nextToWrite > firstToWrite)
+		out.flush();
+}
+
+// align(Job& job, ThreeWayAligner::Workspace& workspace, OutputBuffer& buffer)
+//  Purpose:
+//		Aligns the triple of a loaded job and sets its result string,
+//		which is built in buffer
+void BatchAligner::align(Job& job, ThreeWayAligner::Workspace& workspace, OutputBuffer& buffer) {
+	FastaFile** fastaFiles = job.fastaFiles;
+
+	// The pipeline runs one triple per worker, so each alignment is single threaded
+	ThreeWayAligner aligner(fastaFiles[0], fastaFiles[1], fastaFiles[2]);
+	aligner.setWorkspace(&workspace);
+	aligner.setLinearSpace(linearSpace);
+	aligner.setBandWidth(bandWidth);
+	aligner.setXDrop(xDrop);
+	aligner.setScoreOnly(scoreOnly);
+	aligner.setScoringMatrix(matrix);
+	aligner.setResultCache(cache);
+	aligner.findHighestWeightPath();
+
+	buffer.clear();
+	aligner.writeResult(buffer);
+	string_view result = buffer.getView();
+	job.result.assign(result.data(), result.length());
+}
+
+// releaseFastaFiles(Job& job)
+//  Purpose:
+//		Deletes the fasta files the job loaded (records are kept)
+void BatchAligner::releaseFastaFiles(Job& job) {
+	if (!triples[job.triple].fromRecords) {
+		for (int i = 0; i < 3; i++)
+			delete job.fastaFiles[i];
+	}
+
+	for (int i = 0; i < 3; i++)
+		job.fastaFiles[i] = NULL;
+}
+
+// string errorResult(Job& job)
+//  Purpose:
+//		Returns the error result written in place of the results of a
+//		triple that could not be loaded or aligned (see the class header).
+//		The file names and the message are XML escaped.
+string BatchAligner::errorResult(Job& job) {
+	Triple& triple = triples[job.triple];
+
+	string fileName;
+	for (int i = 0; i < 3; i++) {
+		fileName += (triple.fromRecords ? records[triple.records[i]]->getFileName() : triple.fileNames[i]);
+		fileName += ((i < 2) ? "_" : ".graph.txt");
+	}
+
+	stringstream ss;
+	ss << "  <results type=\"error\" file=\"" << StringUtilities::xmlEscape(fileName) << "\">\n";
+	ss << StringUtilities::xmlResult("error", StringUtilities::xmlEscape(job.error));
+	ss << "  </results>\n";
+
+	return ss.str();
+}
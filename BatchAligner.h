@@ -0,0 +1,243 @@
+/*
+ * BatchAligner.h
+ *
+ *	This is the header file for the BatchAligner object. The BatchAligner
+ *  aligns many triples of sequences in one process with the
+ *  ThreeWayAligner, spreading the triples over a fixed pool of worker
+ *  threads.
+ *
+ *  The triples come from either:
+ *
+ *	  1. A manifest file, with the names of the three fasta files of a
+ *		 triple on each line (separated by white space).  Empty lines and
+ *		 lines starting with '#' are skipped, any other line with fewer
+ *		 than three names is an error.
+ *
+ *	  2. A multi-record fasta file, in which case every combination of
+ *		 three different records is aligned.  The records are read once
+ *		 and shared by all of the alignments.
+ *
+ *  The triples are run as a pipeline of three stages, connected by
+ *  BoundedQueues, so reading the fasta files of the next triples and
+ *  writing the results of earlier ones overlap with the alignments:
+ *
+ *	  1. load: loader threads (setLoadThreadCount(), default 1) read the
+ *		 fasta files of the triples ahead of the workers.
+ *	  2. compute: the worker threads align the loaded triples.
+ *	  3. write: the calling thread writes the result strings out in the
+ *		 order of the triples, as soon as all of the triples before them
+ *		 are done.
+ *
+ *  At most setInFlightCount() triples (default twice the number of
+ *  workers, plus the loaders) are between being loaded and being written
+ *  at any time, which bounds the memory held by loaded sequences and
+ *  results waiting for their turn.  With setPackedSequences(), the
+ *  loaded sequences only keep their packed residue codes (see
+ *  FastaFile::packSequence()).
+ *
+ *  Each worker keeps its own ThreeWayAligner::Workspace, so the score
+ *  tensor is only allocated once per worker.  Each worker also keeps an
+ *  OutputBuffer that its result strings are built in.  With a ResultCache
+ *  (setResultCache()), triples that have been aligned before are not
+ *  aligned again.
+ *
+ *  A triple that can not be loaded or aligned (e.g. a sequence with a
+ *  residue the matrix does not have) does not stop the batch: its place
+ *  in the output gets an error result with the message of the exception
+ *  (XML escaped):
+ *
+ *		<results type="error" file="<<fileName1>>_<<fileName2>>_<<fileName3>>.graph.txt">
+ *		  <result type ="error">message</result>
+ *		</results>
+ *
+ *  If writing the output fails, the stages stop and run() throws the
+ *  exception once the threads are done.
+ *
+ *  Typical Use:
+ *		BatchAligner batch(8);
+ *		batch.readManifest(manifestFileName);
+ *		OutputBuffer out(STDOUT_FILENO);
+ *		batch.run(out);
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef BATCHALIGNER_H
+#define BATCHALIGNER_H
+
+#include "FastaFile.h"
+#include "ThreeWayAligner.h"
+#include "OutputBuffer.h"
+#include "ResultCache.h"
+#include "BoundedQueue.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <exception>
+#include <cstddef>
+using namespace std;
+
+class BatchAligner
+{
+public:
+
+	// Constuctors
+	// ==============================================
+	BatchAligner(unsigned int aThreadCount);
+
+	// Destructor
+	// =============================================
+	virtual ~BatchAligner();
+
+	// Public Methods
+	// =============================================
+
+	// addTriple(const string& fileName1, const string& fileName2, const string& fileName3)
+	//  Purpose:
+	//		Adds a triple of fasta files to align
+	void addTriple(const string& fileName1, const string& fileName2, const string& fileName3);
+
+	// readManifest(const string& manifestFileName)
+	//  Purpose:
+	//		Adds the triples listed in a manifest file (see the class header).
+	//		Throws runtime_error if the file can not be read, and out_of_range
+	//		(with the line number) for a line with fewer than three names.
+	void readManifest(const string& manifestFileName);
+
+	// readCombinations(const string& fastaFileName)
+	//  Purpose:
+	//		Reads the records of a multi-record fasta file and adds every
+	//		combination of three different records as a triple.  The records
+	//		are named by the first word of their header.  Throws runtime_error
+	//		if the file can not be read.
+	void readCombinations(const string& fastaFileName);
+
+	// run(OutputBuffer& out)
+	//  Purpose:
+	//		Aligns all of the triples and writes their result strings to
+	//		out, in the order the triples were added.  out is flushed as
+	//		results are added, so a buffer with a file descriptor only
+	//		holds the results that have not been written yet.  out is only
+	//		used by the calling thread.  Throws the exception out threw if
+	//		the results can not be written.
+	void run(OutputBuffer& out);
+
+	// Public Accessors
+	// =============================================
+	size_t getTripleCount();
+	void setLinearSpace(bool aLinearSpace);  // options passed to each ThreeWayAligner
+	void setBandWidth(int aBandWidth);
+	void setXDrop(int anXDrop);
+	void setScoreOnly(bool aScoreOnly);
+	void setScoringMatrix(const ScoringMatrix* aMatrix);  // NULL = BLOSUM62
+	void setResultCache(ResultCache* aCache);  // cache shared by the alignments (NULL = no cache)
+	void setLoadThreadCount(unsigned int aLoadThreadCount);  // threads reading fasta files ahead of the workers
+	void setInFlightCount(unsigned int anInFlightCount);  // most triples loaded but not written (0 = default)
+	void setPackedSequences(bool aPackedSequences);  // keep only the residue codes of the sequences (see FastaFile::packSequence())
+
+private:
+
+	// Attributes
+	// =============================================
+
+	// A triple to align, either three fasta files or three records
+	struct Triple {
+		string fileNames[3];  // names of the fasta files (if not records)
+		size_t records[3];  // index of each record in records (if fromRecords)
+		bool fromRecords;
+	};
+
+	// A triple on its way through the pipeline.  The jobs are made once and
+	// reused, so their number is the number of triples in flight.
+	struct Job {
+		size_t triple;  // index of the triple in triples
+		FastaFile* fastaFiles[3];  // deleted after the alignment if not records
+		string result;
+		string error;  // message of the exception loading or aligning the triple (empty if none)
+	};
+
+	// The state shared by the stages of run()
+	struct Pipeline {
+		Pipeline(size_t jobCount) : freeJobs(jobCount), loadedJobs(jobCount), alignedJobs(jobCount) {}
+
+		BoundedQueue<Job*> freeJobs;  // jobs waiting for a triple to load
+		BoundedQueue<Job*> loadedJobs;  // jobs waiting to be aligned
+		BoundedQueue<Job*> alignedJobs;  // jobs waiting to be written
+		atomic<size_t> nextTriple;  // next triple to load
+		atomic<unsigned int> runningLoaders;  // the last loader to finish closes loadedJobs
+		atomic<unsigned int> runningWorkers;  // the last worker to finish closes alignedJobs
+		atomic<bool> stopped;  // set if the writer failed, the other stages stop taking work
+		exception_ptr writeError;  // what the writer failed with
+	};
+
+	unsigned int threadCount;
+	unsigned int loadThreadCount;
+	unsigned int inFlightCount;  // 0 = twice threadCount plus loadThreadCount
+	bool linearSpace;
+	bool scoreOnly;
+	bool packedSequences;  // the fasta files only keep their residue codes
+	const ScoringMatrix* matrix;  // shared by all of the alignments
+	ResultCache* cache;  // shared by all of the alignments (NULL = no cache)
+	int bandWidth;
+	int xDrop;
+	vector<Triple> triples;
+	vector<FastaFile*> records;  // records read by readCombinations()
+
+	// The batch owns its records, so it can not be copied
+	BatchAligner(const BatchAligner&) = delete;
+	BatchAligner& operator=(const BatchAligner&) = delete;
+
+	// Private Methods
+	// =============================================
+
+	// loadStage(Pipeline& pipeline)
+	//  Purpose:
+	//		Body of each loader thread: takes free jobs, reads the fasta
+	//		files of the next triple into them and passes them on to the
+	//		workers, until every triple has been taken.
+	void loadStage(Pipeline& pipeline);
+
+	// computeStage(Pipeline& pipeline, ThreeWayAligner::Workspace& workspace, OutputBuffer& buffer)
+	//  Purpose:
+	//		Body of each worker thread: aligns loaded jobs and passes them on
+	//		to the writer, until there are no more loaded jobs.
+	void computeStage(Pipeline& pipeline, ThreeWayAligner::Workspace& workspace, OutputBuffer& buffer);
+
+	// writeStage(Pipeline& pipeline, OutputBuffer& out)
+	//  Purpose:
+	//		Writes the results of the aligned jobs to out in the order of
+	//		the triples, handing each job back to the loaders once its
+	//		result is written.  If out throws, the other stages are stopped
+	//		and the jobs still in flight are drained, so no stage is left
+	//		waiting, and the exception is kept for run().
+	void writeStage(Pipeline& pipeline, OutputBuffer& out);
+
+	// writeInOrder(Pipeline& pipeline, OutputBuffer& out, map<size_t, Job*>& finished, size_t& nextToWrite)
+	//  Purpose:
+	//		Writes out the results of the finished jobs that are next in
+	//		order and hands the jobs back to the loaders.  A job stays in
+	//		finished until its result has been written.
+	void writeInOrder(Pipeline& pipeline, OutputBuffer& out, map<size_t, Job*>& finished, size_t& nextToWrite);
+
+	// align(Job& job, ThreeWayAligner::Workspace& workspace, OutputBuffer& buffer)
+	//  Purpose:
+	//		Aligns the triple of a loaded job and sets its result string,
+	//		which is built in buffer
+	void align(Job& job, ThreeWayAligner::Workspace& workspace, OutputBuffer& buffer);
+
+	// releaseFastaFiles(Job& job)
+	//  Purpose:
+	//		Deletes the fasta files the job loaded (records are kept)
+	void releaseFastaFiles(Job& job);
+
+	// string errorResult(Job& job)
+	//  Purpose:
+	//		Returns the error result written in place of the results of a
+	//		triple that could not be loaded or aligned (see the class header).
+	//		The file names and the message are XML escaped.
+	string errorResult(Job& job);
+};
+
+#endif // BATCHALIGNER_H
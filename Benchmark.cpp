@@ -0,0 +1,300 @@
+/*
+ * Benchmark.cpp
+ *
+ *	This is the cpp file for the Benchmark object. The Benchmark times
+ *  each stage of the alignment pipeline for a set of input triples and
+ *  writes the times as CSV.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "Benchmark.h"
+#include "WDAGraph.h"
+#include "WDAGraphFileBuilder.h"
+#include "ThreeWayAligner.h"
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/resource.h>
+using namespace std;
+
+// Constuctors
+// ==============================================
+Benchmark::Benchmark() {
+	repeatCount = 1;
+	threadCount = 1;
+}
+
+// Destructor
+// =============================================
+Benchmark::~Benchmark() {
+}
+
+// Public Methods
+// =============================================
+
+// addRandomTriple(int length)
+//  Purpose:
+//		Adds a random protein triple with three sequences of length
+void Benchmark::addRandomTriple(int length) {
+	Triple triple;
+	triple.randomLength = length;
+
+	stringstream name;
+	name << "random_" << length;
+	triple.name = name.str();
+
+	for (int sequence = 0; sequence < 3; sequence++) {
+		stringstream fileName;
+		fileName << "benchmark_" << length << "_" << (sequence + 1) << ".fa";
+		triple.fileNames[sequence] = fileName.str();
+	}
+
+	triples.push_back(triple);
+}
+
+// addTriple(const string& fileName1, const string& fileName2, const string& fileName3)
+//  Purpose:
+//		Adds a regression triple of fasta files
+void Benchmark::addTriple(const string& fileName1, const string& fileName2, const string& fileName3) {
+	Triple triple;
+	triple.name = fileName1 + "_" + fileName2 + "_" + fileName3;
+	triple.fileNames[0] = fileName1;
+	triple.fileNames[1] = fileName2;
+	triple.fileNames[2] = fileName3;
+	triple.randomLength = 0;
+
+	triples.push_back(triple);
+}
+
+// readManifest(const string& manifestFileName)
+//  Purpose:
+//		Adds the regression triples listed in a manifest file.  Empty
+//		lines and lines starting with '#' are skipped.
+void Benchmark::readManifest(const string& manifestFileName) {
+	ifstream manifestFile(manifestFileName);
+	string line;
+
+	while (getline(manifestFile, line)) {
+		stringstream ss(line);
+		string fileName1, fileName2, fileName3;
+
+		if (!(ss >> fileName1) || fileName1[0] == '#')
+			continue;
+
+		if (ss >> fileName2 >> fileName3)
+			addTriple(fileName1, fileName2, fileName3);
+	}
+
+	manifestFile.close();
+}
+
+// run(ostream& out)
+//  Purpose:
+//		Runs the stages for each triple and writes the CSV results to out
+void Benchmark::run(ostream& out) {
+	out << "input,stage,length1,length2,length3,cells,seconds,cells_per_second,peak_rss_kb\n";
+
+	for (size_t triple = 0; triple < triples.size(); triple++) {
+		if (triples[triple].randomLength > 0)
+			writeRandomFasta(triples[triple]);
+
+		runTriple(triples[triple], out);
+
+		if (triples[triple].randomLength > 0) {
+			for (int sequence = 0; sequence < 3; sequence++)
+				remove(triples[triple].fileNames[sequence].c_str());
+		}
+	}
+}
+
+// Public Accessors
+// =============================================
+void Benchmark::setRepeatCount(int aRepeatCount) {
+	repeatCount = (aRepeatCount > 0) ? aRepeatCount : 1;
+}
+
+void Benchmark::setThreadCount(unsigned int aThreadCount) {
+	threadCount = (aThreadCount > 0) ? aThreadCount : 1;
+}
+
+// Private Methods
+// =============================================
+
+// writeRandomFasta(Triple& triple)
+//  Purpose:
+//		Writes the three fasta files of a random triple
+void Benchmark::writeRandomFasta(Triple& triple) {
+	static const string residues = "ARNDCQEGHILKMFPSTWYV";
+
+	// The seed only depends on the length, so the triple is the same every run
+	mt19937 generator(triple.randomLength);
+	uniform_int_distribution<int> residue(0, residues.length() - 1);
+	uniform_int_distribution<int> percent(0, 99);
+
+	string base;
+	for (int loc = 0; loc < triple.randomLength; loc++)
+		base += residues[residue(generator)];
+
+	for (int sequence = 0; sequence < 3; sequence++) {
+		string mutated = base;
+		for (int loc = 0; loc < triple.randomLength; loc++) {
+			if (percent(generator) < 20)
+				mutated[loc] = residues[residue(generator)];
+		}
+
+		ofstream fastaFile(triple.fileNames[sequence]);
+		fastaFile << ">" << triple.name << "_" << (sequence + 1) << "\n";
+		for (int loc = 0; loc < triple.randomLength; loc += 60)
+			fastaFile << mutated.substr(loc, 60) << "\n";
+		fastaFile.close();
+	}
+}
+
+// runTriple(Triple& triple, ostream& out)
+//  Purpose:
+//		Runs the stages for the triple and writes their CSV lines
+void Benchmark::runTriple(Triple& triple, ostream& out) {
+	FastaFile* fastas[3] = { NULL, NULL, NULL };
+	WDAGraph* graph = NULL;
+	string graphFileName;
+	double cells = 0;
+
+	// Writes the CSV line for a stage
+	auto report = [&](const string& stage, double seconds) {
+		out
+			<< triple.name << "," << stage << ","
+			<< fastas[0]->getSequenceLength() << ","
+			<< fastas[1]->getSequenceLength() << ","
+			<< fastas[2]->getSequenceLength() << ","
+			<< (long long) cells << ","
+			<< seconds << ","
+			<< ((seconds > 0) ? cells / seconds : 0) << ","
+			<< peakResidentKb() << "\n";
+	};
+
+	auto deleteFastas = [&]() {
+		for (int sequence = 0; sequence < 3; sequence++) {
+			delete fastas[sequence];
+			fastas[sequence] = NULL;
+		}
+	};
+
+	double seconds = timeStage([&]() {
+		for (int sequence = 0; sequence < 3; sequence++)
+			fastas[sequence] = new FastaFile(triple.fileNames[sequence], false);
+	}, deleteFastas);
+
+	cells = (fastas[0]->getSequenceLength() + 1.0) *
+		(fastas[1]->getSequenceLength() + 1.0) *
+		(fastas[2]->getSequenceLength() + 1.0);
+	report("fasta_load", seconds);
+
+	graphFileName = ThreeWayAligner::graphFileNameFor(fastas[0], fastas[1], fastas[2]);
+	WDAGraphFileBuilder builder;
+	seconds = timeStage([&]() {
+		builder.buildGraphFile(fastas[0], fastas[1], fastas[2], graphFileName);
+	}, []() {});
+	report("graph_file_build", seconds);
+
+	seconds = timeStage([&]() {
+		graph = new WDAGraph(graphFileName, threadCount);
+	}, [&]() {
+		delete graph;
+		graph = NULL;
+	});
+	report("graph_load", seconds);
+
+	seconds = timeStage([&]() {
+		graph->findHighestWeightPath();
+	}, []() {});
+	report("find_path", seconds);
+
+	string result;
+	seconds = timeStage([&]() {
+		result = graph->resultString();
+	}, []() {});
+	report("result_string", seconds);
+
+	delete graph;
+	remove(graphFileName.c_str());
+
+	seconds = timeStage([&]() {
+		ThreeWayAligner aligner(fastas[0], fastas[1], fastas[2]);
+		aligner.setThreadCount(threadCount);
+		aligner.findHighestWeightPath();
+		result = aligner.resultString();
+	}, []() {});
+	report("three_way_align", seconds);
+
+	deleteFastas();
+}
+
+// double timeStage(const function<void()>& stage, const function<void()>& cleanUp)
+//  Purpose:
+//		Runs stage repeatCount times and returns the fastest time in
+//		seconds.  cleanUp is run after each run but the last (so the
+//		stage can be run again) and is not timed.  The peak resident
+//		set size is reset before the first run.
+double Benchmark::timeStage(const function<void()>& stage, const function<void()>& cleanUp) {
+	double fastest = 0;
+	resetPeakResident();
+
+	for (int run = 0; run < repeatCount; run++) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		stage();
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		if (run == 0 || seconds < fastest)
+			fastest = seconds;
+
+		if (run + 1 < repeatCount)
+			cleanUp();
+	}
+
+	return fastest;
+}
+
+// resetPeakResident()
+//  Purpose:
+//		Resets the peak resident set size of the process to its current
+//		resident set size (Linux only, elsewhere it does nothing)
+void Benchmark::resetPeakResident() {
+#ifdef __linux__
+	ofstream clearRefs("/proc/self/clear_refs");
+	clearRefs << "5";
+#endif
+}
+
+// long peakResidentKb()
+//  Purpose:
+//		Returns the peak resident set size of the process in KB since
+//		the last resetPeakResident() (since the process started where
+//		it can not be reset), or 0 where it is not known
+long Benchmark::peakResidentKb() {
+
+	// Linux keeps the peak that clear_refs resets as VmHWM
+#ifdef __linux__
+	ifstream status("/proc/self/status");
+	string line;
+	while (getline(status, line)) {
+		if (line.compare(0, 6, "VmHWM:") == 0)
+			return atol(line.c_str() + 6);
+	}
+#endif
+
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+	// Linux reports KB, macOS reports bytes
+#ifdef __APPLE__
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+}
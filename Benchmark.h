@@ -0,0 +1,147 @@
+/*
+ * Benchmark.h
+ *
+ *	This is the header file for the Benchmark object. The Benchmark times
+ *  each stage of the alignment pipeline for a set of input triples:
+ *
+ *		fasta_load		  - reading the three fasta files (FastaFile)
+ *		graph_file_build  - WDAGraphFileBuilder::buildGraphFile()
+ *		graph_load		  - reading the graph file back in (WDAGraph)
+ *		find_path		  - WDAGraph::findHighestWeightPath()
+ *		result_string	  - WDAGraph::resultString()
+ *		three_way_align	  - ThreeWayAligner::findHighestWeightPath() and
+ *							resultString(), the direct path the driver uses
+ *
+ *  The inputs are random protein triples of given lengths, and fixed
+ *  regression triples listed in a manifest file (three fasta file names on
+ *  each line, as for the BatchAligner).  The random triples are made with a
+ *  fixed seed for each length, so they are the same from run to run: a
+ *  random base sequence with 20% of its residues changed in each of the
+ *  three sequences.
+ *
+ *  Each stage is run setRepeatCount() times and the fastest time is kept.
+ *  The results are written as CSV with a header line, one line per stage:
+ *
+ *		input,stage,length1,length2,length3,cells,seconds,cells_per_second,peak_rss_kb
+ *
+ *  where cells is the number of cells of the edit graph ((n1+1)(n2+1)(n3+1),
+ *  the vertices of the graph) and peak_rss_kb is the peak resident set
+ *  size of the process during the stage.  On Linux the peak is reset
+ *  before each stage (through /proc/self/clear_refs), elsewhere it can
+ *  not be reset and is the peak of the process up to the end of the
+ *  stage.  The graph files and the random
+ *  fasta files are removed once their triple is done.
+ *
+ *  Typical Use:
+ *		Benchmark benchmark;
+ *		benchmark.addRandomTriple(40);
+ *		benchmark.readManifest(manifestFileName);
+ *		benchmark.run(cout);
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "FastaFile.h"
+#include <string>
+#include <vector>
+#include <ostream>
+#include <functional>
+using namespace std;
+
+class Benchmark
+{
+public:
+
+	// Constuctors
+	// ==============================================
+	Benchmark();
+
+	// Destructor
+	// =============================================
+	virtual ~Benchmark();
+
+	// Public Methods
+	// =============================================
+
+	// addRandomTriple(int length)
+	//  Purpose:
+	//		Adds a random protein triple with three sequences of length
+	void addRandomTriple(int length);
+
+	// addTriple(const string& fileName1, const string& fileName2, const string& fileName3)
+	//  Purpose:
+	//		Adds a regression triple of fasta files
+	void addTriple(const string& fileName1, const string& fileName2, const string& fileName3);
+
+	// readManifest(const string& manifestFileName)
+	//  Purpose:
+	//		Adds the regression triples listed in a manifest file.  Empty
+	//		lines and lines starting with '#' are skipped.
+	void readManifest(const string& manifestFileName);
+
+	// run(ostream& out)
+	//  Purpose:
+	//		Runs the stages for each triple and writes the CSV results to out
+	void run(ostream& out);
+
+	// Public Accessors
+	// =============================================
+	void setRepeatCount(int aRepeatCount);  // runs of each stage, the fastest is reported
+	void setThreadCount(unsigned int aThreadCount);  // threads for reading the graph and findHighestWeightPath()
+
+private:
+
+	// Attributes
+	// =============================================
+
+	// A triple to run, randomLength > 0 for a random triple
+	struct Triple {
+		string name;
+		string fileNames[3];
+		int randomLength;
+	};
+
+	vector<Triple> triples;
+	int repeatCount;
+	unsigned int threadCount;
+
+	// Private Methods
+	// =============================================
+
+	// writeRandomFasta(Triple& triple)
+	//  Purpose:
+	//		Writes the three fasta files of a random triple
+	void writeRandomFasta(Triple& triple);
+
+	// runTriple(Triple& triple, ostream& out)
+	//  Purpose:
+	//		Runs the stages for the triple and writes their CSV lines
+	void runTriple(Triple& triple, ostream& out);
+
+	// double timeStage(const function<void()>& stage, const function<void()>& cleanUp)
+	//  Purpose:
+	//		Runs stage repeatCount times and returns the fastest time in
+	//		seconds.  cleanUp is run after each run but the last (so the
+	//		stage can be run again) and is not timed.  The peak resident
+	//		set size is reset before the first run.
+	double timeStage(const function<void()>& stage, const function<void()>& cleanUp);
+
+	// resetPeakResident()
+	//  Purpose:
+	//		Resets the peak resident set size of the process to its current
+	//		resident set size (Linux only, elsewhere it does nothing)
+	static void resetPeakResident();
+
+	// long peakResidentKb()
+	//  Purpose:
+	//		Returns the peak resident set size of the process in KB since
+	//		the last resetPeakResident() (since the process started where
+	//		it can not be reset), or 0 where it is not known
+	static long peakResidentKb();
+};
+
+#endif // BENCHMARK_H
@@ -16,6 +16,9 @@
  *		gapCost()
  *		 - returns the cost of aligning a gap
  *
+ *  The tables used for the lookups are built at compile time by the
+ *  constexpr functions below, from the matrix and the gap cost.
+ *
  * 	Blosum62 scoring matrix
  *	#   A  R  N  D  C  Q  E  G  H  I  L  K  M  F  P  S  T  W  Y  V 
  *	 A  4 -1 -2 -2  0 -1 -1  0 -2 -1 -1 -1 -1 -2 -1  1  0 -3 -2  0 
@@ -45,9 +48,14 @@
 #include "Blosum62.h"
 #include <iostream>
 
-// Class Attribute Initialization
+// Compile Time Table Construction
 // ==============================================
-const int Blosum62::matrix[20][20] =
+namespace {
+
+constexpr char blosum62Residues[] = "ARNDCQEGHILKMFPSTWYV";
+constexpr int blosum62GapCost = -6;
+
+constexpr int blosum62Matrix[20][20] =
 	{
 		{ 4, -1, -2, -2,  0, -1, -1,  0, -2, -1, -1, -1, -1, -2, -1,  1,  0, -3, -2,  0},
 		{-1,  5,  0, -2, -3,  1,  0, -2,  0, -3, -2,  2, -1, -3, -2, -1, -1, -3, -2, -3},
@@ -71,7 +79,69 @@ const int Blosum62::matrix[20][20] =
 		{ 0, -3, -3, -3, -1, -2, -2, -3, -3,  3,  1, -2,  1, -1, -2, -2,  0, -3, -1,  4}
 	};
 
-const map<char, int> Blosum62::residueMap = Blosum62::createResidueMap();
+// Index of each char: the residues in matrix order, then the gap char
+constexpr array<signed char, 256> buildIndexTable() {
+	array<signed char, 256> table = {};
+	for (int c = 0; c < 256; c++)
+		table[c] = Blosum62::unknownIndex;
+
+	for (int index = 0; index < Blosum62::residueCount; index++)
+		table[(unsigned char) blosum62Residues[index]] = index;
+	table[(unsigned char) '-'] = Blosum62::gapIndex;
+
+	return table;
+}
+
+// Score for aligning each pair of indexes (see Blosum62::getScore())
+constexpr int pairScore(int index1, int index2) {
+	if (index1 != Blosum62::gapIndex && index2 != Blosum62::gapIndex)
+		return blosum62Matrix[index1][index2];
+
+	if (index1 != Blosum62::gapIndex || index2 != Blosum62::gapIndex)
+		return blosum62GapCost;
+
+	return 0;
+}
+
+constexpr array<int, Blosum62::indexCount * Blosum62::indexCount> buildPairTable() {
+	array<int, Blosum62::indexCount * Blosum62::indexCount> table = {};
+	for (int index1 = 0; index1 < Blosum62::indexCount; index1++) {
+		for (int index2 = 0; index2 < Blosum62::indexCount; index2++)
+			table[index1 * Blosum62::indexCount + index2] = pairScore(index1, index2);
+	}
+
+	return table;
+}
+
+// Sum of pairs score for each triple of indexes
+constexpr array<int, Blosum62::indexCount * Blosum62::indexCount * Blosum62::indexCount> buildSumOfPairsTable() {
+	array<int, Blosum62::indexCount * Blosum62::indexCount * Blosum62::indexCount> table = {};
+	for (int index1 = 0; index1 < Blosum62::indexCount; index1++) {
+		for (int index2 = 0; index2 < Blosum62::indexCount; index2++) {
+			for (int index3 = 0; index3 < Blosum62::indexCount; index3++) {
+				table[(index1 * Blosum62::indexCount + index2) * Blosum62::indexCount + index3] =
+					pairScore(index1, index2) + pairScore(index2, index3) + pairScore(index1, index3);
+			}
+		}
+	}
+
+	return table;
+}
+
+} // namespace
+
+// Class Attribute Initialization
+// ==============================================
+// The lookup tables are constant initialized, so they are ready before
+// any other static initialization runs
+const array<signed char, 256> Blosum62::indexTable = buildIndexTable();
+const array<int, Blosum62::indexCount * Blosum62::indexCount> Blosum62::pairTable = buildPairTable();
+const array<int, Blosum62::indexCount * Blosum62::indexCount * Blosum62::indexCount> Blosum62::sumOfPairsTable = buildSumOfPairsTable();
+
+const int Blosum62::residueCount;
+const int Blosum62::indexCount;
+const int Blosum62::gapIndex;
+const int Blosum62::unknownIndex;
 
 const char Blosum62::gapChar = '-';
 
@@ -90,81 +160,18 @@ const char Blosum62::gapChar = '-';
 //			and the other is a gap character
 //		  - 0 if both residue1 and residue2 are gap characters
 int Blosum62::getScore(char residue1, char residue2) {
-
-	if (residue1 != gapChar && residue2 != gapChar)
-		return matrix[getIndex(residue1)][getIndex(residue2)];
-
-	if (residue1 != gapChar || residue2 != gapChar)
-		return gapCost();
-
-	return 0;
+	return pairTable[residueIndex(residue1) * indexCount + residueIndex(residue2)];
 }
 
 // gapCost()
 //  Purpose: 
 //		Returns the score for aligning a gap with a residue.
 int Blosum62::gapCost() {
-	return -6;
-}
-
-// sumOfPairsWeight(char residue1, char residue2, char residue3)
-//  Purpose: 
-//		Returns the sum of pairs score for aligning the three residues.
-//
-//		There are 3 different unordered pairs of the residues: 
-//		(residue1, residue2), (residue1, residue3) and (residue2, residue1).
-//		The score returned is the sum of the score for each of these
-//		unordered pairs.
-int Blosum62::sumOfPairsWeight(char residue1, char residue2, char residue3) {
-	int score = 0;
-
-	score += getScore(residue1, residue2);
-	score += getScore(residue2, residue3);
-	score += getScore(residue1, residue3);
-	
-	return score;
+	return blosum62GapCost;
 }
 
-// Private Class Methods
-// =============================================
-
-// map<char, int> createResidueMap()
-//  Purpose: 
-//		Creates a map of the index location for residues in the matrix
-//		array
-map<char, int> Blosum62::createResidueMap() {
-	map<char, int> theMap;
-
-	theMap['A']= 0;
-	theMap['R']= 1;
-	theMap['N']= 2;
-	theMap['D']= 3;
-	theMap['C']= 4;
-	theMap['Q']= 5;
-	theMap['E']= 6;
-	theMap['G']= 7;
-	theMap['H']= 8;
-	theMap['I']= 9;
-	theMap['L']= 10;
-	theMap['K']= 11;
-	theMap['M']= 12;
-	theMap['F']= 13;
-	theMap['P']= 14;
-	theMap['S']= 15;
-	theMap['T']= 16;
-	theMap['W']= 17;
-	theMap['Y']= 18;
-	theMap['V']= 19;
-
-	return theMap;
-}
-
-// int getIndex(char residue)
-//  Purpose: 
-//	  Returns the index in the matrix for the residue
-int Blosum62::getIndex(char residue) {
-	return residueMap.at(residue);
-}
+// sumOfPairsWeight(), residueIndex() and sumOfPairsWeightByIndex() are
+// defined inline in Blosum62.h
 
 Blosum62::Blosum62(void){
 }
@@ -16,6 +16,18 @@
  *		gapCost()
  *		 - returns the cost of aligning a gap
  *
+ *		sumOfPairsWeightByIndex(index1, index2, index3)
+ *		 - same as sumOfPairsWeight() for residues already converted with
+ *		   residueIndex()
+ *
+ *  The scores are looked up in tables that are built at compile time:
+ *  residues (and the gap char) are turned into an index 0 to 20 with a
+ *  256 entry table, the pair scores are kept in a 21x21 table (gaps
+ *  included) and the sum of pairs scores in a 21x21x21 table, so getting
+ *  a sum of pairs score is a single table load.  As before, aligning a
+ *  character that is not one of the 20 residues or the gap char throws
+ *  out_of_range.
+ *
  * 	Blosum62 scoring matrix
  *	#   A  R  N  D  C  Q  E  G  H  I  L  K  M  F  P  S  T  W  Y  V 
  *	 A  4 -1 -2 -2  0 -1 -1  0 -2 -1 -1 -1 -1 -2 -1  1  0 -3 -2  0 
@@ -47,7 +59,8 @@
 
 #include <string>
 #include <vector>
-#include <map>
+#include <array>
+#include <stdexcept>
 using namespace std;
 
 class Blosum62
@@ -92,28 +105,70 @@ public:
 	//		unordered pairs.
 	static int sumOfPairsWeight(char residue1, char residue2, char residue3);
 
+	// residueIndex(char residue)
+	//  Purpose: 
+	//		Returns the index (0 to 20) used for the residue in the score
+	//		tables, the gap char is gapIndex.  Throws out_of_range if the
+	//		char is not a residue or the gap char.
+	static int residueIndex(char residue);
+
+	// sumOfPairsWeightByIndex(int index1, int index2, int index3)
+	//  Purpose: 
+	//		Returns the sum of pairs score for aligning the three residues
+	//		with the indexes (from residueIndex()).
+	static int sumOfPairsWeightByIndex(int index1, int index2, int index3);
+
+	// sumOfPairsRow(int index1, int index2)
+	//  Purpose: 
+	//		Returns the sum of pairs scores for index1 and index2 with each
+	//		index3, i.e. element index3 is sumOfPairsWeightByIndex(index1,
+	//		index2, index3).  Used to build the weights for a row of cells.
+	static const int* sumOfPairsRow(int index1, int index2);
+
+	// Public Class Attributes
+	// =============================================
+	static const int residueCount = 20;  // number of residues in the matrix
+	static const int indexCount = residueCount + 1;  // residues plus the gap char
+	static const int gapIndex = residueCount;  // index of the gap char
+	static const int unknownIndex = -1;  // index table entry for invalid chars
+
 private:
 
 	// Class Attributes
 	// =============================================
 	static const char gapChar;
-	static const int matrix[][20]; // scores for aligning residues
-	static const map<char, int> residueMap;  // indexing for residue locations in the matrix
+	static const array<signed char, 256> indexTable;  // index of each char (unknownIndex if not a residue)
+	static const array<int, indexCount * indexCount> pairTable;  // getScore() for each pair of indexes
+	static const array<int, indexCount * indexCount * indexCount> sumOfPairsTable;  // sumOfPairsWeight() for each triple of indexes
 
-	// Private Class Methods
-	// =============================================
+	// The BLOSUM62 ScoringMatrix uses these tables
+	friend class ScoringMatrix;
 
-	// map<char, int> createResidueMap()
-	//  Purpose: 
-	//		Creates a map of the index location for residues in the matrix
-	//		array
-	static map<char, int> createResidueMap();
+};
 
-	// int getIndex(char residue)
-	//  Purpose: 
-	//	  Returns the index in the matrix for the residue
-	static int getIndex(char residue);
+// Inline Class Methods
+// =============================================
+// These are called for every edge of the edit graph, so they are defined
+// here where the compiler can inline them.
 
-};
+inline int Blosum62::residueIndex(char residue) {
+	int index = indexTable[(unsigned char) residue];
+	if (index == unknownIndex)
+		throw out_of_range(string("Blosum62: invalid residue ") + residue);
+
+	return index;
+}
+
+inline int Blosum62::sumOfPairsWeightByIndex(int index1, int index2, int index3) {
+	return sumOfPairsTable[(index1 * indexCount + index2) * indexCount + index3];
+}
+
+inline const int* Blosum62::sumOfPairsRow(int index1, int index2) {
+	return &sumOfPairsTable[(index1 * indexCount + index2) * indexCount];
+}
+
+inline int Blosum62::sumOfPairsWeight(char residue1, char residue2, char residue3) {
+	return sumOfPairsWeightByIndex(residueIndex(residue1), residueIndex(residue2), residueIndex(residue3));
+}
 
 #endif // BLOSUM62_H
\ No newline at end of file
@@ -0,0 +1,133 @@
+/*
+ * BoundedQueue.h
+ *
+ *	This is the header file for the BoundedQueue object. The BoundedQueue
+ *  is a first in first out queue with a fixed capacity that connects the
+ *  stages of a pipeline running on different threads.  Any number of
+ *  threads may push and pop.
+ *
+ *  push() waits while the queue is full and pop() waits while it is
+ *  empty, so a stage that gets ahead of the next one stops instead of
+ *  using more memory, and a stage with nothing to do sleeps instead of
+ *  spinning.  Once close() has been called, pop() returns false when the
+ *  queue is empty, which tells the next stage there is no more work.
+ *
+ *  The items are kept in a ring of capacity slots that is allocated once.
+ *  The queue is a template, so it is all in this header.
+ *
+ *  Typical Use:
+ *		BoundedQueue<Job*> queue(16);
+ *		queue.push(job);  // producer
+ *		queue.close();  // producer, when done
+ *		while (queue.pop(job)) ...  // consumer
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+using namespace std;
+
+template <class T>
+class BoundedQueue
+{
+public:
+
+	// Constuctors
+	// ==============================================
+	BoundedQueue(size_t aCapacity) {
+		slots.resize((aCapacity > 0) ? aCapacity : 1);
+		first = 0;
+		count = 0;
+		closed = false;
+	}
+
+	// Destructor
+	// =============================================
+	virtual ~BoundedQueue() {
+	}
+
+	// Public Methods
+	// =============================================
+
+	// push(const T& item)
+	//  Purpose:
+	//		Adds item to the end of the queue, waiting while the queue is
+	//		full
+	//  Preconditions:
+	//		close() has not been called
+	void push(const T& item) {
+		unique_lock<mutex> lock(queueMutex);
+		notFull.wait(lock, [this] { return count < slots.size(); });
+
+		slots[(first + count) % slots.size()] = item;
+		count++;
+
+		lock.unlock();
+		notEmpty.notify_one();
+	}
+
+	// bool pop(T& item)
+	//  Purpose:
+	//		Removes the first item of the queue into item, waiting while
+	//		the queue is empty.  Returns false (and leaves item as it was)
+	//		if the queue is empty and closed.
+	bool pop(T& item) {
+		unique_lock<mutex> lock(queueMutex);
+		notEmpty.wait(lock, [this] { return count > 0 || closed; });
+
+		if (count == 0)
+			return false;
+
+		item = slots[first];
+		first = (first + 1) % slots.size();
+		count--;
+
+		lock.unlock();
+		notFull.notify_one();
+		return true;
+	}
+
+	// close()
+	//  Purpose:
+	//		Marks that nothing more will be pushed, so pop() stops waiting
+	//		once the queue is empty
+	void close() {
+		{
+			lock_guard<mutex> lock(queueMutex);
+			closed = true;
+		}
+		notEmpty.notify_all();
+	}
+
+	// Public Accessors
+	// =============================================
+	size_t getCapacity() {
+		return slots.size();
+	}
+
+private:
+
+	// Attributes
+	// =============================================
+	vector<T> slots;
+	size_t first;  // slot of the first item
+	size_t count;  // number of items in the queue
+	bool closed;
+
+	mutex queueMutex;
+	condition_variable notEmpty;  // signaled when an item is pushed (or the queue is closed)
+	condition_variable notFull;  // signaled when an item is popped
+
+	// The queue is shared by threads, so it can not be copied
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+};
+
+#endif // BOUNDEDQUEUE_H
@@ -0,0 +1,176 @@
+/*
+ * BufferedFileWriter.cpp
+ *
+ *	This is the cpp file for the BufferedFileWriter object. The
+ *  BufferedFileWriter writes text to a file through a fixed size buffer,
+ *  so the memory used does not depend on how much is written.  Numbers
+ *  are formatted straight into the buffer without going through a stream.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "BufferedFileWriter.h"
+#include <cstring>
+using namespace std;
+
+// Constuctors
+// ==============================================
+BufferedFileWriter::BufferedFileWriter(const string& fileName) {
+	open(fileName, 1 << 20);
+}
+
+BufferedFileWriter::BufferedFileWriter(const string& fileName, size_t bufferSize) {
+	open(fileName, bufferSize);
+}
+
+// Destructor
+// =============================================
+BufferedFileWriter::~BufferedFileWriter() {
+
+	// A destructor can not throw, callers that need to know the file was
+	// written call close() themselves
+	if (file != NULL) {
+		try {
+			close();
+		}
+		catch (const runtime_error&) {
+		}
+	}
+}
+
+// Public Methods
+// =============================================
+
+// write(...)
+//  Purpose:
+//		Appends the value to the buffer, writing the buffer out to the
+//		file whenever it fills up.  Doubles are formatted the same way as
+//		a stream with the default precision (%g).  Throws runtime_error if
+//		the buffer can not be written out.
+void BufferedFileWriter::write(const char* chars, size_t length) {
+
+	// Large writes go straight to the file
+	if (length > buffer.size()) {
+		flush();
+		if (fwrite(chars, 1, length, file) != length)
+			throw runtime_error("can not write file " + fileName);
+		bytesWritten += length;
+		return;
+	}
+
+	if (used + length > buffer.size())
+		flush();
+
+	memcpy(buffer.data() + used, chars, length);
+	used += length;
+}
+
+void BufferedFileWriter::write(const string& aString) {
+	write(aString.data(), aString.length());
+}
+
+void BufferedFileWriter::write(const char* aString) {
+	write(aString, strlen(aString));
+}
+
+void BufferedFileWriter::write(char aChar) {
+	if (used == buffer.size())
+		flush();
+
+	buffer[used++] = aChar;
+}
+
+void BufferedFileWriter::write(int value) {
+	char digits[16];
+	int length = 0;
+
+	// Build the digits backwards
+	unsigned int magnitude = (value < 0) ? 0u - (unsigned int) value : (unsigned int) value;
+	do {
+		digits[length++] = '0' + magnitude % 10;
+		magnitude /= 10;
+	} while (magnitude > 0);
+
+	if (value < 0)
+		digits[length++] = '-';
+
+	if (used + length > buffer.size())
+		flush();
+
+	while (length > 0)
+		buffer[used++] = digits[--length];
+}
+
+void BufferedFileWriter::write(double value) {
+	char digits[32];
+	int length = snprintf(digits, sizeof(digits), "%g", value);
+	write(digits, length);
+}
+
+// flush()
+//  Purpose:
+//		Writes the contents of the buffer out to the file.  Throws
+//		runtime_error if it can not be written (or the file is closed).
+void BufferedFileWriter::flush() {
+	if (file == NULL)
+		throw runtime_error("can not write closed file " + fileName);
+
+	if (used > 0 && fwrite(buffer.data(), 1, used, file) != used)
+		throw runtime_error("can not write file " + fileName);
+
+	bytesWritten += used;
+	used = 0;
+}
+
+// close()
+//  Purpose:
+//		Flushes the buffer and closes the file.  Called by the destructor
+//		if it has not been called.  Throws runtime_error if the buffer can
+//		not be written out or the file can not be closed (the file is
+//		closed either way).
+void BufferedFileWriter::close() {
+	if (file == NULL)
+		return;
+
+	bool flushed = true;
+	try {
+		flush();
+	}
+	catch (const runtime_error&) {
+		flushed = false;
+	}
+
+	bool closed = (fclose(file) == 0);
+	file = NULL;
+
+	if (!flushed || !closed)
+		throw runtime_error("can not write file " + fileName);
+}
+
+// Public Accessors
+// =============================================
+uint64_t BufferedFileWriter::getBytesWritten() {
+	return bytesWritten;
+}
+
+// Private Methods
+// =============================================
+
+// open(const string& aFileName, size_t bufferSize)
+//  Purpose:
+//		Opens the file and sets up the buffer.  Throws runtime_error if
+//		the file can not be opened.
+void BufferedFileWriter::open(const string& aFileName, size_t bufferSize) {
+	fileName = aFileName;
+	file = fopen(fileName.c_str(), "wb");
+	if (file == NULL)
+		throw runtime_error("can not open file " + fileName);
+
+	// The file is only written in whole buffers, so turn off stdio's buffer
+	setvbuf(file, NULL, _IONBF, 0);
+
+	buffer.resize(bufferSize);
+	used = 0;
+	bytesWritten = 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * BufferedFileWriter.h
+ *
+ *	This is the header file for the BufferedFileWriter object. The
+ *  BufferedFileWriter writes text to a file through a fixed size buffer,
+ *  so the memory used does not depend on how much is written.  Numbers
+ *  are formatted straight into the buffer without going through a stream.
+ *
+ *  Throws runtime_error if the file can not be opened or written.  The
+ *  destructor closes the file without reporting errors, so close() should
+ *  be called to find out that all of the file was written.
+ *
+ *  Typical Use:
+ *		BufferedFileWriter writer(fileName);
+ *		writer.write("V ");
+ *		writer.write(12);
+ *		writer.write('\n');
+ *		writer.close();
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef BUFFEREDFILEWRITER_H
+#define BUFFEREDFILEWRITER_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+using namespace std;
+
+class BufferedFileWriter
+{
+public:
+
+	// Constuctors
+	// ==============================================
+	BufferedFileWriter(const string& fileName);
+	BufferedFileWriter(const string& fileName, size_t bufferSize);
+
+	// Destructor
+	// =============================================
+	virtual ~BufferedFileWriter();
+
+	// Public Methods
+	// =============================================
+
+	// write(...)
+	//  Purpose:
+	//		Appends the value to the buffer, writing the buffer out to the
+	//		file whenever it fills up.  Doubles are formatted the same way as
+	//		a stream with the default precision (%g).  Throws runtime_error if
+	//		the buffer can not be written out.
+	void write(const char* chars, size_t length);
+	void write(const string& aString);
+	void write(const char* aString);
+	void write(char aChar);
+	void write(int value);
+	void write(double value);
+
+	// flush()
+	//  Purpose:
+	//		Writes the contents of the buffer out to the file.  Throws
+	//		runtime_error if it can not be written (or the file is closed).
+	void flush();
+
+	// close()
+	//  Purpose:
+	//		Flushes the buffer and closes the file.  Called by the destructor
+	//		if it has not been called.  Throws runtime_error if the buffer can
+	//		not be written out or the file can not be closed (the file is
+	//		closed either way).
+	void close();
+
+	// Public Accessors
+	// =============================================
+	uint64_t getBytesWritten();  // chars written to the file so far (not counting the buffer)
+
+private:
+
+	// Attributes
+	// =============================================
+	string fileName;
+	FILE* file;  // NULL once closed
+	vector<char> buffer;
+	size_t used;  // number of chars in the buffer
+	uint64_t bytesWritten;  // number of chars written out to the file
+
+	// The writer owns its file, so it can not be copied
+	BufferedFileWriter(const BufferedFileWriter&) = delete;
+	BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+	// Private Methods
+	// =============================================
+
+	// open(const string& aFileName, size_t bufferSize)
+	//  Purpose:
+	//		Opens the file and sets up the buffer.  Throws runtime_error if
+	//		the file can not be opened.
+	void open(const string& aFileName, size_t bufferSize);
+};
+
+#endif // BUFFEREDFILEWRITER_H
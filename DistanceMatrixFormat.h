@@ -0,0 +1,55 @@
+/*
+ * DistanceMatrixFormat.h
+ *
+ *	This header describes the binary distance matrix file written by the
+ *  AllVsAllAligner.  The file holds a value for every pair of records of
+ *  a multi-record fasta file: the distance between them (a float in
+ *  [0, 1]) or their global alignment score (an int).
+ *
+ *  All values are stored in the byte order of the machine that wrote the
+ *  file.  The file is made up of the following sections, each starting at
+ *  the offset given in the header (aligned to 8 bytes).
+ *
+ *	  1. Header (DistanceMatrixHeader)
+ *
+ *	  2. Name pool - the null terminated record names, in record order
+ *
+ *	  3. Self scores - recordCount int32_t values, the global alignment
+ *		 score of each record with itself
+ *
+ *	  4. Values - recordCount * (recordCount - 1) / 2 values of valueType,
+ *		 the upper triangle of the matrix row by row.  The value for
+ *		 records i < j is at
+ *			i * recordCount - i * (i + 1) / 2 + (j - i - 1)
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef DISTANCEMATRIXFORMAT_H
+#define DISTANCEMATRIXFORMAT_H
+
+#include <cstdint>
+
+// Magic bytes at the start of every distance matrix file
+static const char distanceMatrixMagic[8] = { 'W', 'D', 'A', 'D', 'I', 'S', 'T', '\0' };
+
+// Version of the format written by AllVsAllAligner
+static const uint32_t distanceMatrixVersion = 1;
+
+// Value types
+static const uint32_t distanceMatrixDistances = 1;  // float, 1 - score / min(self score i, self score j)
+static const uint32_t distanceMatrixScores = 2;  // int32_t, global alignment score
+
+struct DistanceMatrixHeader {
+	char magic[8];  // distanceMatrixMagic
+	uint32_t version;  // distanceMatrixVersion
+	uint32_t valueType;  // distanceMatrixDistances or distanceMatrixScores
+	uint64_t recordCount;
+	uint64_t namePoolOffset;
+	uint64_t selfScoresOffset;
+	uint64_t valuesOffset;
+	uint64_t fileSize;
+};
+
+#endif // DISTANCEMATRIXFORMAT_H
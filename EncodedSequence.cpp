@@ -0,0 +1,181 @@
+/*
+ * EncodedSequence.cpp
+ *
+ *	This is the cpp file for the EncodedSequence object. The
+ *  EncodedSequence holds a sequence as packed 2 bit (nucleotide) or 5 bit
+ *  (protein) residue codes.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "EncodedSequence.h"
+#include <algorithm>
+#include <cstring>
+using namespace std;
+
+// Class Attribute Initialization
+// ==============================================
+const char* const EncodedSequence::dnaAlphabet = "ACGT";
+const char* const EncodedSequence::proteinAlphabet = "ARNDCQEGHILKMFPSTWYVBZX*JUO-";
+
+// Constuctors
+// ==============================================
+EncodedSequence::EncodedSequence() {
+	length = 0;
+	bitsPerCode = 2;
+	codesPerWord = 32;
+	alphabet = dnaAlphabet;
+}
+
+EncodedSequence::EncodedSequence(const string& sequence) {
+	length = sequence.length();
+
+	// Use 2 bit codes unless more than 1 in 16 residues would be exceptions
+	size_t notNucleotides = 0;
+	for (char residue : sequence) {
+		if (strchr(dnaAlphabet, residue) == NULL || residue == '\0')
+			notNucleotides++;
+	}
+	bool nucleotides = notNucleotides * 16 <= sequence.length();
+
+	bitsPerCode = nucleotides ? 2 : 5;
+	codesPerWord = 64 / bitsPerCode;
+	alphabet = nucleotides ? dnaAlphabet : proteinAlphabet;
+
+	// Code of each char (-1 if it has none)
+	int codes[256];
+	fill(codes, codes + 256, -1);
+	for (int code = 0; alphabet[code] != '\0'; code++)
+		codes[(unsigned char) alphabet[code]] = code;
+
+	words.assign((length + codesPerWord - 1) / codesPerWord, 0);
+	for (int loc = 0; loc < length; loc++) {
+		int code = codes[(unsigned char) sequence[loc]];
+		if (code < 0) {
+			Exception exception;
+			exception.loc = loc;
+			exception.residue = sequence[loc];
+			exceptions.push_back(exception);
+			continue;
+		}
+
+		words[loc / codesPerWord] |= (uint64_t) code << ((loc % codesPerWord) * bitsPerCode);
+	}
+}
+
+EncodedSequence::MatrixIndexes::MatrixIndexes() {
+	static const EncodedSequence empty;
+	sequence = &empty;
+	fill(codeIndexes, codeIndexes + 32, 0);
+}
+
+// Public Methods
+// =============================================
+
+// char at(int loc)
+//  Purpose:
+//		Returns the residue at loc
+char EncodedSequence::at(int loc) const {
+	const Exception* exception = findException(loc);
+	if (exception != NULL)
+		return exception->residue;
+
+	return alphabet[code(loc)];
+}
+
+// string decode()
+//  Purpose:
+//		Returns the residues as chars
+string EncodedSequence::decode() const {
+	string sequence(length, ' ');
+	for (int loc = 0; loc < length; loc++)
+		sequence[loc] = alphabet[code(loc)];
+
+	for (const Exception& exception : exceptions)
+		sequence[exception.loc] = exception.residue;
+
+	return sequence;
+}
+
+// MatrixIndexes(const EncodedSequence& aSequence, const ScoringMatrix& matrix)
+//  Purpose:
+//		Looks up the codes that occur in the sequence, and its exceptions,
+//		in the matrix.  Throws out_of_range if a residue is not in the
+//		matrix.
+EncodedSequence::MatrixIndexes::MatrixIndexes(const EncodedSequence& aSequence, const ScoringMatrix& matrix) {
+	sequence = &aSequence;
+	fill(codeIndexes, codeIndexes + 32, 0);
+
+	// Only the codes that occur have to be in the matrix
+	bool used[32] = { false };
+	size_t nextException = 0;
+	for (int loc = 0; loc < sequence->length; loc++) {
+		if (nextException < sequence->exceptions.size() && sequence->exceptions[nextException].loc == loc)
+			nextException++;
+		else
+			used[sequence->code(loc)] = true;
+	}
+
+	for (int code = 0; code < 32 && sequence->alphabet[code] != '\0'; code++) {
+		if (used[code])
+			codeIndexes[code] = matrix.residueIndex(sequence->alphabet[code]);
+	}
+
+	for (const Exception& exception : sequence->exceptions)
+		exceptionIndexes.push_back(matrix.residueIndex(exception.residue));
+}
+
+// copy(int first, int count, unsigned char* indexes)
+//  Purpose:
+//		Sets indexes[t] to the matrix index of the residue at first + t,
+//		for count residues
+void EncodedSequence::MatrixIndexes::copy(int first, int count, unsigned char* indexes) const {
+	for (int t = 0; t < count; t++)
+		indexes[t] = codeIndexes[sequence->code(first + t)];
+
+	// Then the exceptions in the range
+	const vector<Exception>& exceptions = sequence->exceptions;
+	vector<Exception>::const_iterator exception = lower_bound(exceptions.begin(), exceptions.end(), first,
+		[](const Exception& anException, int aLoc) { return anException.loc < aLoc; });
+	for (; exception != exceptions.end() && exception->loc < first + count; exception++)
+		indexes[exception->loc - first] = exceptionIndexes[exception - exceptions.begin()];
+}
+
+size_t EncodedSequence::MatrixIndexes::size() const {
+	return sequence->length;
+}
+
+// Public Accessors
+// =============================================
+int EncodedSequence::getLength() const {
+	return length;
+}
+
+int EncodedSequence::getBitsPerCode() const {
+	return bitsPerCode;
+}
+
+size_t EncodedSequence::getExceptionCount() const {
+	return exceptions.size();
+}
+
+size_t EncodedSequence::getBytesUsed() const {
+	return words.size() * sizeof(uint64_t) + exceptions.size() * sizeof(Exception);
+}
+
+// Private Methods
+// =============================================
+
+// const Exception* findException(int loc)
+//  Purpose:
+//		Returns the exception at loc (NULL if the residue has a code)
+const EncodedSequence::Exception* EncodedSequence::findException(int loc) const {
+	vector<Exception>::const_iterator exception = lower_bound(exceptions.begin(), exceptions.end(), loc,
+		[](const Exception& anException, int aLoc) { return anException.loc < aLoc; });
+
+	if (exception == exceptions.end() || exception->loc != loc)
+		return NULL;
+
+	return &*exception;
+}
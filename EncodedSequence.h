@@ -0,0 +1,161 @@
+/*
+ * EncodedSequence.h
+ *
+ *	This is the header file for the EncodedSequence object. The
+ *  EncodedSequence holds a sequence as packed residue codes rather than
+ *  chars:
+ *
+ *	  - nucleotide sequences use 2 bit codes (A, C, G, T), 32 to a 64 bit
+ *		word, a quarter of the memory of the chars.  A sequence is taken
+ *		to be a nucleotide sequence if no more than 1 in 16 of its
+ *		residues are something else.
+ *	  - protein sequences use 5 bit codes (the residues of the built in
+ *		matrices, see proteinAlphabet), 12 to a 64 bit word
+ *
+ *  Chars that have no code (e.g. N in a nucleotide sequence) are kept in
+ *  an exception list of (location, char) pairs, in location order, and
+ *  have code 0 in the words.
+ *
+ *  A MatrixIndexes reads the indexes of a ScoringMatrix straight from the
+ *  codes: each code is looked up in the matrix once, when the
+ *  MatrixIndexes is made, so the aligners get the matrix offset of a
+ *  residue from its packed code without keeping a char or an index for
+ *  every residue.
+ *
+ *  Typical Use:
+ *		EncodedSequence encoded(sequence);
+ *		EncodedSequence::MatrixIndexes indexes(encoded, matrix);
+ *		int index = indexes[loc];
+ *		char residue = encoded.at(loc);
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef ENCODEDSEQUENCE_H
+#define ENCODEDSEQUENCE_H
+
+#include "ScoringMatrix.h"
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+using namespace std;
+
+class EncodedSequence
+{
+public:
+
+	// Constuctors
+	// ==============================================
+	EncodedSequence();
+
+	// Encodes the sequence with 2 bit codes if no more than 1 in 16 of its
+	// residues are not A, C, G or T, otherwise with 5 bit codes
+	EncodedSequence(const string& sequence);
+
+	// Public Methods
+	// =============================================
+
+	// char at(int loc)
+	//  Purpose:
+	//		Returns the residue at loc
+	char at(int loc) const;
+
+	// string decode()
+	//  Purpose:
+	//		Returns the residues as chars
+	string decode() const;
+
+	// Reads the matrix index (ScoringMatrix::residueIndex()) of each residue
+	// of a sequence from its codes.  The sequence has to outlive it.
+	class MatrixIndexes
+	{
+	public:
+		MatrixIndexes();
+
+		// Looks up the codes that occur in the sequence, and its
+		// exceptions, in the matrix.  Throws out_of_range if a residue is
+		// not in the matrix.
+		MatrixIndexes(const EncodedSequence& aSequence, const ScoringMatrix& matrix);
+
+		// int operator[](int loc)
+		//  Purpose:
+		//		Returns the matrix index of the residue at loc
+		int operator[](int loc) const {
+			if (!sequence->exceptions.empty()) {
+				const Exception* exception = sequence->findException(loc);
+				if (exception != NULL)
+					return exceptionIndexes[exception - sequence->exceptions.data()];
+			}
+
+			return codeIndexes[sequence->code(loc)];
+		}
+
+		// copy(int first, int count, unsigned char* indexes)
+		//  Purpose:
+		//		Sets indexes[t] to the matrix index of the residue at first + t,
+		//		for count residues
+		void copy(int first, int count, unsigned char* indexes) const;
+
+		size_t size() const;  // number of residues
+
+	private:
+		const EncodedSequence* sequence;
+		unsigned char codeIndexes[32];  // matrix index of each code that occurs
+		vector<unsigned char> exceptionIndexes;  // matrix index of each exception
+	};
+
+	// Public Accessors
+	// =============================================
+	int getLength() const;  // number of residues
+	int getBitsPerCode() const;  // 2 or 5
+	size_t getExceptionCount() const;  // residues kept as chars
+	size_t getBytesUsed() const;  // bytes of the codes and exceptions
+
+	// Public Class Attributes
+	// =============================================
+	static const char* const dnaAlphabet;  // the residue of each 2 bit code
+	static const char* const proteinAlphabet;  // the residue of each 5 bit code
+
+private:
+
+	// Attributes
+	// =============================================
+
+	// A residue that has no code
+	struct Exception {
+		int loc;
+		char residue;
+	};
+
+	int length;
+	int bitsPerCode;
+	int codesPerWord;
+	const char* alphabet;  // dnaAlphabet or proteinAlphabet
+	vector<uint64_t> words;  // codesPerWord codes in each word, the first in the low bits
+	vector<Exception> exceptions;  // in location order
+
+	// Private Methods
+	// =============================================
+
+	// int code(int loc)
+	//  Purpose:
+	//		Returns the code at loc (0 for an exception).  The aligners read
+	//		a code for every move, so the word and shift are worked out with
+	//		divisions by constants (shifts and multiplies).
+	int code(int loc) const {
+		unsigned int codeLoc = loc;
+		if (bitsPerCode == 2)
+			return (words[codeLoc / 32] >> ((codeLoc % 32) * 2)) & 3;
+
+		return (words[codeLoc / 12] >> ((codeLoc % 12) * 5)) & 31;
+	}
+
+	// const Exception* findException(int loc)
+	//  Purpose:
+	//		Returns the exception at loc (NULL if the residue has a code)
+	const Exception* findException(int loc) const;
+};
+
+#endif // ENCODEDSEQUENCE_H
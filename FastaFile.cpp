@@ -18,11 +18,18 @@
  * Typical use for the file would be to use the FastaFile(pathName, fileName)
  * constructor to create the object.  This will automatically open the
  * Fasta File specified by the pathName and fileName, and read its contents
- * storing them in the firstLine, and sequence attributes.
+ * storing them in the firstLine, and sequence attributes.  The file is read
+ * with a FastaReader, and the reverse complement of a DNA sequence is only
+ * built when getReverseComplement() is first called.  A FastaFile can also
+ * be made from one record of a multi-record file read with a FastaReader.
+ * getEncodedSequence() returns the sequence as packed residue codes, built
+ * once on first use.  After packSequence() only the codes are kept, and
+ * getSequence() decodes the chars again if something asks for them.
  *
  * buildGraphFile(graphFileName, wieghtFileName) is a convenience method that
  * will create a sequence graph file for the sequence.  See the method for
- * more details on what is created.
+ * more details on what is created.  buildBinaryGraphFile() creates the same
+ * graph in the binary graph file format.
  *
  *  Created on: 1-10-13
  *	  Modified: 1-26-13
@@ -31,15 +38,24 @@
 
 #include "FastaFile.h"
 #include "StringUtilities.h"
+#include "WDAGraphBinaryWriter.h"
+#include "BufferedFileWriter.h"
+#include "FastaReader.h"
+#include "Instrumentation.h"
 #include <sstream>
 #include <iostream>
 #include <fstream>
 #include <map>
+#include <string_view>
+#include <stdexcept>
 using namespace std;
 
 // Constuctors
 // ==============================================
 FastaFile::FastaFile() {
+	dna = true;
+	reverseComplementBuilt = false;
+	packed = false;
 }
 
 
@@ -47,6 +63,7 @@ FastaFile::FastaFile(string path, string name) {
     filePath = path;
     fileName = name;
 	dna = true;
+	packed = false;
     populate();
 }
 
@@ -54,6 +71,7 @@ FastaFile::FastaFile(string path, string name, bool isDna) {
     filePath = path;
     fileName = name;
 	dna = isDna;;
+	packed = false;
     populate();
 }
 
@@ -61,9 +79,20 @@ FastaFile::FastaFile(string name, bool isDna) {
     filePath = "./";
     fileName = name;
 	dna = isDna;;
+	packed = false;
     populate();
 }
 
+FastaFile::FastaFile(string name, const FastaRecord& record, bool isDna) {
+    filePath = "./";
+    fileName = name;
+	dna = isDna;
+	firstLine = record.header;
+	sequence = record.sequence;
+	reverseComplementBuilt = false;
+	packed = false;
+}
+
 
 // Destructor
 // ==============================================
@@ -99,46 +128,85 @@ FastaFile::~FastaFile() {
 void FastaFile::buildGraphFile(string& graphFileName, string& weightFileName) {
 
 	// Build weight map from weight file
-	map<char, double> edgeWeights;
-	ifstream weightFile(weightFileName);
-	string line;
-
-	while(getline(weightFile, line)) {
-		vector<string> tokens;
-		StringUtilities::split(line, ' ', tokens);
-
-		edgeWeights[tokens.at(0).at(0)] = atof(tokens.at(1).c_str());
+	map<char, double> edgeWeights = readWeightFile(weightFileName);
+
+	// Stream the vertices and then the edges out to the file
+	BufferedFileWriter graphFile(graphFileName);
+
+	const string& residues = getSequence();
+	int sequenceLength = residues.length();
+	for (int i = 0; i <= sequenceLength; i++) {
+		// Add vertex info to the file
+		graphFile.write("V ");
+		graphFile.write(i);
+		graphFile.write('\n');
 	}
 
-	weightFile.close();
+	for (int i = 0; i < sequenceLength; i++) {
+		// Add edge info to the file
+		char nucleotide = sequence.at(i);
+		graphFile.write("E ");
+		graphFile.write(nucleotide);
+		graphFile.write(' ');
+		graphFile.write(i);
+		graphFile.write(' ');
+		graphFile.write(i+1);
+		graphFile.write(' ');
+		graphFile.write(edgeWeights.at(nucleotide));
+		graphFile.write('\n');
+	}
 
-	// Create the vertices and edges
-	stringstream vertices;
-	stringstream edges;
+	graphFile.close();
+}
 
-	int sequenceLength = sequence.length();
-	for (int i = 0; i < sequenceLength; i++) {
-		// Add vertex info to vertices stream
-		vertices << "V " << i << "\n";
+// buildBinaryGraphFile(string& graphFileName, string& weightFileName)
+//  Purpose: 
+//		Build the same sequence graph as buildGraphFile(), written in the
+//		binary graph file format (see WDAGraphBinaryFormat.h).
+//
+//  Preconditions:
+//		Fasta File has been read and sequence has been populated
+//  Postconditions:
+//		File named aGraphFileName will be populated with the sequence graph 
+//		associated with the sequence from the fasta file.
+void FastaFile::buildBinaryGraphFile(string& graphFileName, string& weightFileName) {
 
-		// Add edge info to edges stream
-		char nucleotide = sequence.at(i);
-		edges
-			<< "E "
-			<< nucleotide << " " 
-			<< i << " "
-			<< i+1 << " "
-			<< edgeWeights.at(nucleotide) << "\n";
+	// Build weight map from weight file
+	map<char, double> edgeWeights = readWeightFile(weightFileName);
+
+	WDAGraphBinaryWriter writer(graphFileName);
+
+	// Vertex i is between nucleotide i-1 and nucleotide i, its only
+	// incoming edge is nucleotide i-1
+	const string& residues = getSequence();
+	int sequenceLength = residues.length();
+	writer.addVertex("0", 0);
+	for (int i = 1; i <= sequenceLength; i++) {
+		char nucleotide = residues.at(i - 1);
+		writer.addVertex(to_string(i), 0);
+		writer.addIncomingEdge(string(1, nucleotide), i - 1, edgeWeights.at(nucleotide));
 	}
-	// Add last vertex
-	vertices << "V " << sequenceLength << "\n";
 
-	// Write vertices and edges to file
-	ofstream graphFile(graphFileName);
-	graphFile << vertices.rdbuf();
-	graphFile << edges.rdbuf();
+	writer.close();
+}
 
-	graphFile.close();
+// packSequence()
+//  Purpose:
+//		Keeps only the packed residue codes of the sequence, freeing its
+//		chars.  The aligners read the codes directly, and getSequence()
+//		decodes the chars again on first use (e.g. for a graph file).
+//  Preconditions:
+//		The FastaFile is not yet shared by other threads
+//  Postconditions:
+//		getEncodedSequence() has been built, sequence is empty until
+//		getSequence() is called
+void FastaFile::packSequence() {
+	if (packed)
+		return;
+
+	getEncodedSequence();
+	string().swap(sequence);
+	packed = true;
 }
 
 // string firstLineResultString()
@@ -210,6 +278,9 @@ bool FastaFile::isDNA() {
 // Public Accessors
 // =============================================
 const int FastaFile::getSequenceLength() {
+	if (packed)
+		return encodedSequence.getLength();
+
 	return sequence.length();
 }
 
@@ -218,12 +289,63 @@ string& FastaFile::getFileName() {
 }
 
 string& FastaFile::getSequence() {
+	if (packed) {
+		call_once(sequenceDecoded, [this]() {
+			sequence = encodedSequence.decode();
+		});
+	}
+
 	return sequence;
 }
 
+string& FastaFile::getFirstLine() {
+	return firstLine;
+}
+
+string& FastaFile::getReverseComplement() {
+	if (!reverseComplementBuilt)
+		createReverseComplement();
+
+	return reverseComplement;
+}
+
+const EncodedSequence& FastaFile::getEncodedSequence() {
+	call_once(encodedSequenceBuilt, [this]() {
+		encodedSequence = EncodedSequence(sequence);
+	});
+
+	return encodedSequence;
+}
+
 // Private Methods
 // =============================================
 
+// map<char, double> readWeightFile(string& weightFileName)
+//  Purpose:
+//		Reads the weight for each nucleotide from the weight file.  Each
+//		line of the file has the format:
+//			<nucleotide> <weight>
+map<char, double> FastaFile::readWeightFile(string& weightFileName) {
+	map<char, double> edgeWeights;
+	ifstream weightFile(weightFileName);
+	string line;
+
+	string_view tokens[2];
+	int lineNumber = 0;
+
+	while(getline(weightFile, line)) {
+		lineNumber++;
+		if (StringUtilities::split(line, ' ', tokens, 2) < 2 || tokens[0].empty())
+			throw out_of_range("bad line " + to_string(lineNumber) + " in weight file " + weightFileName + ": \"" + line + "\"");
+
+		edgeWeights[tokens[0][0]] = StringUtilities::toDouble(tokens[1]);
+	}
+
+	weightFile.close();
+
+	return edgeWeights;
+}
+
 // populate()
 //  Purpose:
 //		Reads in the Fasta File specified by filePath and fileName and populates
@@ -233,25 +355,17 @@ string& FastaFile::getSequence() {
 //  Postconditions:
 //		firstLine - populated with first line from file
 //		sequence - populated with sequence from file
-//		reverseComplement - populated with reverse complement of sequence
 void FastaFile::populate() {
 
-    ifstream inputFile(filePath + fileName);
-	stringstream ss;
-	string line;
-
-	getline(inputFile, firstLine);
-		
-	while(getline(inputFile, line)) {
-		ss << line;
-	}
-
-	sequence = ss.str();
+	INSTRUMENT_TIMER(fastaPopulate);
 
-	inputFile.close();
+	FastaReader reader(filePath + fileName);
+	reader.readWhole(firstLine, sequence);
+	INSTRUMENT_COUNT(bytesRead, reader.getSize());
 
-	if (isDNA())
-		createReverseComplement();
+	// The reverse complement is built the first time it is asked for
+	reverseComplement.clear();
+	reverseComplementBuilt = false;
 }
 
 // createReverseComplment()
@@ -263,16 +377,15 @@ void FastaFile::populate() {
 //  Postconditions:
 //		reverseComplement - populated with reverse complement of sequence
 void FastaFile::createReverseComplement() {
-    stringstream ss;
+	const string& residues = getSequence();
+	string::size_type length = residues.length();
+	reverseComplement.resize(length);
 
-    // Append the complements in order
-    for (string::size_type i = 0; i < sequence.length(); i++) {
-            ss << complement(sequence[i]);
-    }
+	// Fill in the complements from the back
+	for (string::size_type i = 0; i < length; i++)
+		reverseComplement[length - 1 - i] = complement(residues[i]);
 
-    // Reverse the string and set it to the reverseComplement attribute
-	string complement = ss.str();
-	reverseComplement = string(complement.rbegin(), complement.rend());
+	reverseComplementBuilt = true;
 }
 
 // char complement(char aChar)
@@ -304,8 +417,9 @@ char FastaFile::complement(char aChar) {
 //			counts[3] = counts for T
 //			counts[4] = counts for other characters encountered
 void FastaFile::countBases(int counts[]) {
-	for (string::size_type i=0; i < sequence.length(); i++) {
-		char currentChar = sequence[i];
+	const string& residues = getSequence();
+	for (string::size_type i=0; i < residues.length(); i++) {
+		char currentChar = residues[i];
 		if (currentChar == 'A')
 			counts[0]++;
 		else if (currentChar == 'C')
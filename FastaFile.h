@@ -18,11 +18,20 @@
  * Typical use for the file would be to use the FastaFile(pathName, fileName)
  * constructor to create the object.  This will automatically open the
  * Fasta File specified by the pathName and fileName, and read its contents
- * storing them in the firstLine, and dnaSequence attributes.
+ * storing them in the firstLine, and dnaSequence attributes.  The file is read
+ * with a FastaReader, and the reverse complement of a DNA sequence is only
+ * built when getReverseComplement() is first called.  A FastaFile can also
+ * be made from one record of a multi-record file read with a FastaReader.
+ * getEncodedSequence() returns the sequence as packed residue codes (see
+ * EncodedSequence.h), built once on first use (from any thread) and shared
+ * by all of the aligners of the sequence.  packSequence() drops the chars
+ * and keeps only the codes (a quarter of the memory for DNA), decoding the
+ * chars again only if getSequence() is called.
  *
  * buildGraphFile(graphFileName, wieghtFileName) is a convenience method that
  * will create a sequence graph file for the dnaSequence.  See the method for
- * more details on what is created.
+ * more details on what is created.  buildBinaryGraphFile() creates the same
+ * graph in the binary graph file format.
  *
  *  Created on: 1-10-13
  *	  Modified: 1-26-13
@@ -34,6 +43,10 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <mutex>
+#include "FastaReader.h"
+#include "EncodedSequence.h"
 using namespace std;
 
 class FastaFile {
@@ -46,6 +59,7 @@ public:
 	FastaFile(string filePath, string fileName);  
 	FastaFile(string filePath, string fileName, bool isDna);  
 	FastaFile(string fileName, bool isDna);  
+	FastaFile(string fileName, const FastaRecord& record, bool isDna);  
 
 	// Destructor
 	// =============================================
@@ -79,6 +93,30 @@ public:
 	//		associated with the dnaSequence from the fasta file.
 	void buildGraphFile(string& graphFileName, string& weightFileName);
 
+	// buildBinaryGraphFile(string& graphFileName, string& weightFileName)
+	//  Purpose: 
+	//		Build the same sequence graph as buildGraphFile(), written in the
+	//		binary graph file format (see WDAGraphBinaryFormat.h).
+	//
+	//  Preconditions:
+	//		Fasta File has been read and dnaSequence has been populated
+	//  Postconditions:
+	//		File named aGraphFileName will be populated with the sequence graph 
+	//		associated with the dnaSequence from the fasta file.
+	void buildBinaryGraphFile(string& graphFileName, string& weightFileName);
+
+	// packSequence()
+	//  Purpose:
+	//		Keeps only the packed residue codes of the sequence, freeing its
+	//		chars.  The aligners read the codes directly, and getSequence()
+	//		decodes the chars again on first use (e.g. for a graph file).
+	//  Preconditions:
+	//		The FastaFile is not yet shared by other threads
+	//  Postconditions:
+	//		getEncodedSequence() has been built, sequence is empty until
+	//		getSequence() is called
+	void packSequence();
+
 	// string firstLineResultString()
 	//  Purpose:
 	//		Returns the string value of an XML element representing the first line of 
@@ -115,7 +153,10 @@ public:
 	// =============================================
 	const int getSequenceLength();  // length of dnaSequence
 	string& getFileName();
-	string& getSequence();
+	string& getSequence();  // decoded on first use after packSequence()
+	string& getFirstLine();
+	string& getReverseComplement();  // built on first use
+	const EncodedSequence& getEncodedSequence();  // packed residue codes, built on first use
 
 private:
 	// Attributes
@@ -126,10 +167,22 @@ private:
     string sequence;
 	string reverseComplement;
 	bool dna; // set to true if the sequence is a dna sequence
+	bool reverseComplementBuilt;  // set once reverseComplement has been built
+	EncodedSequence encodedSequence;  // sequence as residue codes
+	once_flag encodedSequenceBuilt;  // encodedSequence is built once, by the first thread to ask
+	bool packed;  // set once packSequence() has dropped the chars of sequence
+	once_flag sequenceDecoded;  // sequence is decoded from encodedSequence once after packing
 
 	// Private Methods
 	// =============================================
 
+	// map<char, double> readWeightFile(string& weightFileName)
+	//  Purpose:
+	//		Reads the weight for each nucleotide from the weight file.  Each
+	//		line of the file has the format:
+	//			<nucleotide> <weight>
+	map<char, double> readWeightFile(string& weightFileName);
+
 	// populate()
 	//  Purpose:
 	//		Reads in the Fasta File specified by filePath and fileName and populates
@@ -139,7 +192,6 @@ private:
 	//  Postconditions:
 	//		firstLine - populated with first line from file
 	//		dnaSequence - populated with dnaSequence from file
-	//		reverseComplement - populated with reverse complement of dnaSequence
     void populate();
 
 	// createReverseComplment()
@@ -0,0 +1,176 @@
+/*
+ * FastaReader.cpp
+ *
+ *	This is the cpp file for the FastaReader object. The FastaReader
+ *  reads the records of a Fasta file one at a time, so files with many
+ *  records (e.g. UniProt dumps) can be processed without holding all of
+ *  them in memory.
+ *
+ *  The file is memory mapped (for sequential access), and the pages of
+ *  the records already read can be dropped by the kernel as needed.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "FastaReader.h"
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+using namespace std;
+
+// Constuctors
+// ==============================================
+FastaReader::FastaReader(const string& fileName) {
+	data = NULL;
+	size = 0;
+	position = 0;
+	mappedFile = NULL;
+	open = false;
+
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	open = true;
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+		size = fileStat.st_size;
+		mappedFile = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mappedFile == MAP_FAILED) {
+			mappedFile = NULL;
+			size = 0;
+			open = false;
+		}
+		else {
+			madvise(mappedFile, size, MADV_SEQUENTIAL);
+			data = static_cast<const char*>(mappedFile);
+		}
+	}
+
+	::close(fd);
+}
+
+// Destructor
+// =============================================
+FastaReader::~FastaReader() {
+	if (mappedFile != NULL)
+		munmap(mappedFile, size);
+}
+
+// Public Methods
+// =============================================
+
+// bool nextRecord(FastaRecord& record)
+//  Purpose:
+//		Reads the next record of the file into record.  Returns false
+//		(and leaves record alone) if there are no more records.
+bool FastaReader::nextRecord(FastaRecord& record) {
+
+	// Skip to the next header line
+	while (position < size && data[position] != '>')
+		position = lineEnd(position) + 1;
+	if (position >= size)
+		return false;
+
+	// Header
+	size_t headerEnd = lineEnd(position);
+	record.header.assign(data + position, headerEnd - position);
+	position = headerEnd + 1;
+
+	// Sequence lines, up to the next header
+	record.sequence.clear();
+	position = appendLines(position, size, record.sequence, true);
+
+	return true;
+}
+
+// readWhole(string& firstLine, string& sequence)
+//  Purpose:
+//		Reads the file the way FastaFile always has: the first line, and
+//		all of the lines after it joined together as one sequence.
+void FastaReader::readWhole(string& firstLine, string& sequence) {
+	size_t firstLineEnd = lineEnd(0);
+	firstLine.assign(data, data + firstLineEnd);
+
+	sequence.clear();
+	if (firstLineEnd + 1 < size) {
+		sequence.reserve(size - firstLineEnd - 1);
+		appendLines(firstLineEnd + 1, size, sequence, false);
+	}
+
+	position = size;
+}
+
+// rewind()
+//  Purpose:
+//		Goes back to the start of the file
+void FastaReader::rewind() {
+	position = 0;
+}
+
+// Public Accessors
+// =============================================
+bool FastaReader::isOpen() {
+	return open;
+}
+
+size_t FastaReader::getSize() {
+	return size;
+}
+
+// Private Methods
+// =============================================
+
+// size_t lineEnd(size_t start)
+//  Purpose:
+//		Returns the offset of the '\n' ending the line that starts at
+//		start (size if the last line has no '\n').
+size_t FastaReader::lineEnd(size_t start) {
+	if (start >= size)
+		return size;
+
+	const char* newline = static_cast<const char*>(memchr(data + start, '\n', size - start));
+	return (newline != NULL) ? newline - data : size;
+}
+
+// appendLines(size_t start, size_t end, string& sequence, bool stopAtHeader)
+//  Purpose:
+//		Appends the lines from start up to end to sequence without their
+//		newlines.  If stopAtHeader is true, stops at the first line that
+//		starts with '>'.  Returns the offset where it stopped.
+size_t FastaReader::appendLines(size_t start, size_t end, string& sequence, bool stopAtHeader) {
+
+	// Find where the lines end first, so the sequence is only sized once
+	size_t stop = end;
+	if (stopAtHeader && start < end) {
+		if (data[start] == '>')
+			stop = start;
+		else {
+			const void* header = memmem(data + start, end - start, "\n>", 2);
+			if (header != NULL)
+				stop = static_cast<const char*>(header) - data + 1;
+		}
+	}
+
+	size_t length = sequence.length();
+	sequence.resize(length + (stop - start));
+	char* out = &sequence[0];
+
+	// Copy each line without its newline
+	size_t lineStart = start;
+	while (lineStart < stop) {
+		size_t lineStop = lineEnd(lineStart);
+		if (lineStop > stop)
+			lineStop = stop;
+
+		memcpy(out + length, data + lineStart, lineStop - lineStart);
+		length += lineStop - lineStart;
+		lineStart = lineStop + 1;
+	}
+
+	sequence.resize(length);
+	return stop;
+}
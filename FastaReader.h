@@ -0,0 +1,109 @@
+/*
+ * FastaReader.h
+ *
+ *	This is the header file for the FastaReader object. The FastaReader
+ *  reads the records of a Fasta file one at a time, so files with many
+ *  records (e.g. UniProt dumps) can be processed without holding all of
+ *  them in memory.
+ *
+ *  The file is memory mapped rather than read through a stream.  For each
+ *  record the sequence buffer is sized once for the whole record, and the
+ *  sequence lines are copied into it with memchr / memcpy, which strips
+ *  the newlines in a single pass.  As with getline, only '\n' ends a line.
+ *
+ *  A record is a header line starting with '>' followed by the lines of
+ *  its sequence.  Lines before the first header are skipped.
+ *
+ *  Typical Use:
+ *		FastaReader reader(fileName);
+ *		FastaRecord record;
+ *		while (reader.nextRecord(record)) {
+ *			... record.header, record.sequence ...
+ *		}
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef FASTAREADER_H
+#define FASTAREADER_H
+
+#include <string>
+#include <cstddef>
+using namespace std;
+
+// One record of a Fasta file
+struct FastaRecord {
+	string header;  // header line, including the '>'
+	string sequence;  // sequence lines joined together
+};
+
+class FastaReader
+{
+public:
+
+	// Constuctors
+	// ==============================================
+	FastaReader(const string& fileName);
+
+	// Destructor
+	// =============================================
+	virtual ~FastaReader();
+
+	// Public Methods
+	// =============================================
+
+	// bool nextRecord(FastaRecord& record)
+	//  Purpose:
+	//		Reads the next record of the file into record.  Returns false
+	//		(and leaves record alone) if there are no more records.
+	bool nextRecord(FastaRecord& record);
+
+	// readWhole(string& firstLine, string& sequence)
+	//  Purpose:
+	//		Reads the file the way FastaFile always has: the first line, and
+	//		all of the lines after it joined together as one sequence.
+	void readWhole(string& firstLine, string& sequence);
+
+	// rewind()
+	//  Purpose:
+	//		Goes back to the start of the file
+	void rewind();
+
+	// Public Accessors
+	// =============================================
+	bool isOpen();  // false if the file could not be opened
+	size_t getSize();  // bytes in the file
+
+private:
+
+	// Attributes
+	// =============================================
+	const char* data;  // contents of the file (NULL if empty or not open)
+	size_t size;
+	size_t position;  // offset of the next line to read
+	void* mappedFile;  // start of the mapping (NULL if not mapped)
+	bool open;
+
+	// The reader owns its mapping, so it can not be copied
+	FastaReader(const FastaReader&) = delete;
+	FastaReader& operator=(const FastaReader&) = delete;
+
+	// Private Methods
+	// =============================================
+
+	// size_t lineEnd(size_t start)
+	//  Purpose:
+	//		Returns the offset of the '\n' ending the line that starts at
+	//		start (size if the last line has no '\n').
+	size_t lineEnd(size_t start);
+
+	// appendLines(size_t start, size_t end, string& sequence, bool stopAtHeader)
+	//  Purpose:
+	//		Appends the lines from start up to end to sequence without their
+	//		newlines.  If stopAtHeader is true, stops at the first line that
+	//		starts with '>'.  Returns the offset where it stopped.
+	size_t appendLines(size_t start, size_t end, string& sequence, bool stopAtHeader);
+};
+
+#endif // FASTAREADER_H
@@ -0,0 +1,174 @@
+/*
+ * Instrumentation.cpp
+ *
+ *	This is the cpp file for the Instrumentation object. The
+ *  Instrumentation keeps counters and stage timers for the alignment
+ *  pipeline.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "Instrumentation.h"
+#include "StringUtilities.h"
+#include <sstream>
+using namespace std;
+
+// Class Attribute Initialization
+// ==============================================
+atomic<uint64_t> Instrumentation::counters[Instrumentation::counterCount];
+atomic<uint64_t> Instrumentation::timerNanoseconds[Instrumentation::timerCount];
+atomic<uint64_t> Instrumentation::timerCalls[Instrumentation::timerCount];
+
+// Constuctors
+// ==============================================
+Instrumentation::ScopedTimer::ScopedTimer(Timer aTimer) {
+	timer = aTimer;
+	start = chrono::steady_clock::now();
+}
+
+// Destructor
+// =============================================
+Instrumentation::ScopedTimer::~ScopedTimer() {
+	chrono::steady_clock::duration elapsed = chrono::steady_clock::now() - start;
+	addTime(timer, chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+}
+
+// Public Class Methods
+// =============================================
+
+// add(Counter counter, uint64_t amount)
+//  Purpose:
+//		Adds amount to the counter
+void Instrumentation::add(Counter counter, uint64_t amount) {
+	counters[counter].fetch_add(amount, memory_order_relaxed);
+}
+
+// peak(Counter counter, uint64_t value)
+//  Purpose:
+//		Sets the counter to value if value is larger than it
+void Instrumentation::peak(Counter counter, uint64_t value) {
+	uint64_t current = counters[counter].load(memory_order_relaxed);
+	while (value > current &&
+		!counters[counter].compare_exchange_weak(current, value, memory_order_relaxed))
+		;
+}
+
+// addTime(Timer timer, uint64_t nanoseconds)
+//  Purpose:
+//		Adds one call of nanoseconds to the timer
+void Instrumentation::addTime(Timer timer, uint64_t nanoseconds) {
+	timerNanoseconds[timer].fetch_add(nanoseconds, memory_order_relaxed);
+	timerCalls[timer].fetch_add(1, memory_order_relaxed);
+}
+
+// reset()
+//  Purpose:
+//		Sets all of the counters and timers back to 0
+void Instrumentation::reset() {
+	for (int counter = 0; counter < counterCount; counter++)
+		counters[counter].store(0, memory_order_relaxed);
+
+	for (int timer = 0; timer < timerCount; timer++) {
+		timerNanoseconds[timer].store(0, memory_order_relaxed);
+		timerCalls[timer].store(0, memory_order_relaxed);
+	}
+}
+
+// string jsonString()
+//  Purpose:
+//		Returns the counters and timers as a JSON object:
+//			{
+//			  "counters": { "vertices_parsed": n, ... },
+//			  "timers": { "fasta_populate": { "calls": n, "seconds": s }, ... }
+//			}
+string Instrumentation::jsonString() {
+	stringstream ss;
+	ss << "{\n  \"counters\": {";
+
+	for (int counter = 0; counter < counterCount; counter++) {
+		ss
+			<< ((counter > 0) ? "," : "") << "\n    \""
+			<< counterName((Counter) counter) << "\": "
+			<< counters[counter].load(memory_order_relaxed);
+	}
+
+	ss << "\n  },\n  \"timers\": {";
+
+	for (int timer = 0; timer < timerCount; timer++) {
+		ss
+			<< ((timer > 0) ? "," : "") << "\n    \""
+			<< timerName((Timer) timer) << "\": { \"calls\": "
+			<< timerCalls[timer].load(memory_order_relaxed) << ", \"seconds\": "
+			<< timerNanoseconds[timer].load(memory_order_relaxed) / 1e9 << " }";
+	}
+
+	ss << "\n  }\n}\n";
+
+	return ss.str();
+}
+
+// string resultString()
+//  Purpose:
+//		Returns the counters and timers as an XML result, one per line:
+//			<result type="instrumentation">
+//				<<counter name>> <<value>>
+//				<<timer name>> <<calls>> <<seconds>>
+//			</result>
+string Instrumentation::resultString() {
+	stringstream ss;
+
+	for (int counter = 0; counter < counterCount; counter++) {
+		ss
+			<< counterName((Counter) counter) << " "
+			<< counters[counter].load(memory_order_relaxed) << "\n      ";
+	}
+
+	for (int timer = 0; timer < timerCount; timer++) {
+		if (timer > 0)
+			ss << "\n      ";
+		ss
+			<< timerName((Timer) timer) << " "
+			<< timerCalls[timer].load(memory_order_relaxed) << " "
+			<< timerNanoseconds[timer].load(memory_order_relaxed) / 1e9;
+	}
+
+	return StringUtilities::xmlResultFormatted("instrumentation", ss.str());
+}
+
+// Public Class Accessors
+// =============================================
+bool Instrumentation::isEnabled() {
+#ifdef WDA_INSTRUMENTATION
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint64_t Instrumentation::getCounter(Counter counter) {
+	return counters[counter].load(memory_order_relaxed);
+}
+
+string Instrumentation::counterName(Counter counter) {
+	switch (counter) {
+		case verticesParsed: return "vertices_parsed";
+		case edgesParsed: return "edges_parsed";
+		case bytesRead: return "bytes_read";
+		case bytesWritten: return "bytes_written";
+		case cellsRelaxed: return "cells_relaxed";
+		case edgesRelaxed: return "edges_relaxed";
+		case peakArenaBytes: return "peak_arena_bytes";
+		default: return "unknown";
+	}
+}
+
+string Instrumentation::timerName(Timer timer) {
+	switch (timer) {
+		case fastaPopulate: return "fasta_populate";
+		case graphBuild: return "graph_build";
+		case findPath: return "find_path";
+		case graphFileBuild: return "graph_file_build";
+		default: return "unknown";
+	}
+}
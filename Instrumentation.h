@@ -0,0 +1,144 @@
+/*
+ * Instrumentation.h
+ *
+ *	This is the header file for the Instrumentation object. The
+ *  Instrumentation keeps counters and stage timers for the alignment
+ *  pipeline, so it can be seen where the time and memory go:
+ *
+ *		vertices_parsed	  - vertices read in by WDAGraph::buildGraph()
+ *		edges_parsed	  - edges read in by WDAGraph::buildGraph()
+ *		bytes_read		  - bytes of graph files and fasta files read
+ *		bytes_written	  - bytes of graph files written by WDAGraphFileBuilder
+ *		cells_relaxed	  - vertices relaxed by WDAGraph::findHighestWeightPath()
+ *		edges_relaxed	  - incoming edges looked at while relaxing them
+ *		peak_arena_bytes  - the most memory any one Arena has reserved
+ *
+ *  and the total time (and number of calls) of FastaFile::populate(),
+ *  WDAGraph::buildGraph(), WDAGraph::findHighestWeightPath() and
+ *  WDAGraphFileBuilder::buildGraphFile().
+ *
+ *  The counters are only updated through the INSTRUMENT_ macros below,
+ *  which compile to nothing unless WDA_INSTRUMENTATION is defined (e.g.
+ *  g++ -DWDA_INSTRUMENTATION ...).  The counters are atomic, so they can
+ *  be updated from any thread, and the hooks add whole totals at the end
+ *  of a stage rather than counting in the inner loops.
+ *
+ *  Note that this class is implemented statically, so there is no need to
+ *  instantiate it.
+ *
+ *  Typical Use:
+ *		INSTRUMENT_TIMER(graphBuild);
+ *		...
+ *		INSTRUMENT_COUNT(edgesParsed, edgeCount);
+ *		...
+ *		cout << Instrumentation::jsonString();
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+using namespace std;
+
+class Instrumentation
+{
+public:
+
+	// Counters that are kept
+	enum Counter {
+		verticesParsed, edgesParsed, bytesRead, bytesWritten,
+		cellsRelaxed, edgesRelaxed, peakArenaBytes, counterCount
+	};
+
+	// Stages that are timed
+	enum Timer { fastaPopulate, graphBuild, findPath, graphFileBuild, timerCount };
+
+	// Adds the time from its construction to its destruction to a timer
+	class ScopedTimer
+	{
+	public:
+		ScopedTimer(Timer aTimer);
+		~ScopedTimer();
+
+	private:
+		Timer timer;
+		chrono::steady_clock::time_point start;
+	};
+
+	// Public Class Methods
+	// =============================================
+
+	// add(Counter counter, uint64_t amount)
+	//  Purpose:
+	//		Adds amount to the counter
+	static void add(Counter counter, uint64_t amount);
+
+	// peak(Counter counter, uint64_t value)
+	//  Purpose:
+	//		Sets the counter to value if value is larger than it
+	static void peak(Counter counter, uint64_t value);
+
+	// addTime(Timer timer, uint64_t nanoseconds)
+	//  Purpose:
+	//		Adds one call of nanoseconds to the timer
+	static void addTime(Timer timer, uint64_t nanoseconds);
+
+	// reset()
+	//  Purpose:
+	//		Sets all of the counters and timers back to 0
+	static void reset();
+
+	// string jsonString()
+	//  Purpose:
+	//		Returns the counters and timers as a JSON object:
+	//			{
+	//			  "counters": { "vertices_parsed": n, ... },
+	//			  "timers": { "fasta_populate": { "calls": n, "seconds": s }, ... }
+	//			}
+	static string jsonString();
+
+	// string resultString()
+	//  Purpose:
+	//		Returns the counters and timers as an XML result, one per line:
+	//			<result type="instrumentation">
+	//				<<counter name>> <<value>>
+	//				<<timer name>> <<calls>> <<seconds>>
+	//			</result>
+	static string resultString();
+
+	// Public Class Accessors
+	// =============================================
+	static bool isEnabled();  // true if the hooks were compiled in
+	static uint64_t getCounter(Counter counter);
+	static string counterName(Counter counter);
+	static string timerName(Timer timer);
+
+private:
+
+	// Class Attributes
+	// =============================================
+	static atomic<uint64_t> counters[counterCount];
+	static atomic<uint64_t> timerNanoseconds[timerCount];
+	static atomic<uint64_t> timerCalls[timerCount];
+};
+
+// Hooks used by the pipeline, they compile to nothing unless
+// WDA_INSTRUMENTATION is defined.  The amounts are not evaluated when
+// disabled, sizeof only keeps them from being unused.
+#ifdef WDA_INSTRUMENTATION
+#define INSTRUMENT_COUNT(counter, amount) Instrumentation::add(Instrumentation::counter, (amount))
+#define INSTRUMENT_PEAK(counter, value) Instrumentation::peak(Instrumentation::counter, (value))
+#define INSTRUMENT_TIMER(timer) Instrumentation::ScopedTimer instrumentTimer##timer(Instrumentation::timer)
+#else
+#define INSTRUMENT_COUNT(counter, amount) ((void) sizeof(amount))
+#define INSTRUMENT_PEAK(counter, value) ((void) sizeof(value))
+#define INSTRUMENT_TIMER(timer) ((void) 0)
+#endif
+
+#endif // INSTRUMENTATION_H
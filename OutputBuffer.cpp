@@ -0,0 +1,190 @@
+/*
+ * OutputBuffer.cpp
+ *
+ *	This is the cpp file for the OutputBuffer object. The OutputBuffer
+ *  builds text in one growing buffer that can be cleared and reused, and
+ *  can write it straight to a file descriptor.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "OutputBuffer.h"
+#include <charconv>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <unistd.h>
+using namespace std;
+
+// Constuctors
+// ==============================================
+OutputBuffer::OutputBuffer() {
+	used = 0;
+	fileDescriptor = -1;
+}
+
+OutputBuffer::OutputBuffer(int aFileDescriptor) {
+	used = 0;
+	fileDescriptor = aFileDescriptor;
+}
+
+// Destructor
+// =============================================
+OutputBuffer::~OutputBuffer() {
+
+	// A destructor can not throw, callers that need to know the text was
+	// written call flush() themselves
+	if (fileDescriptor >= 0) {
+		try {
+			flush();
+		}
+		catch (const runtime_error&) {
+		}
+	}
+}
+
+// Public Methods
+// =============================================
+
+// write(...)
+//  Purpose:
+//		Appends the value to the buffer.  Integers are written in
+//		full, doubles the same way as a stream with precision
+//		precision and the default format (%g).
+void OutputBuffer::write(string_view chars) {
+	if (chars.empty())
+		return;
+
+	memcpy(reserve(chars.length()), chars.data(), chars.length());
+	used += chars.length();
+}
+
+void OutputBuffer::write(char aChar) {
+	*reserve(1) = aChar;
+	used++;
+}
+
+void OutputBuffer::write(int value) {
+	write((long long) value);
+}
+
+void OutputBuffer::write(long long value) {
+	static const size_t maxLength = 24;
+	char* first = reserve(maxLength);
+	used = to_chars(first, first + maxLength, value).ptr - buffer.data();
+}
+
+void OutputBuffer::write(double value, int precision) {
+	static const size_t maxLength = 32;
+
+	// A stream with precision 0 uses 1 for %g
+	char* first = reserve(maxLength);
+	to_chars_result result = to_chars(first, first + maxLength, value, chars_format::general, max(precision, 1));
+	if (result.ec == errc())
+		used = result.ptr - buffer.data();
+}
+
+// xmlResult(string_view type, string_view value)
+// xmlResult(string_view type, double value, int precision)
+//  Purpose:
+//		Appends an XML result the same as StringUtilities::xmlResult():
+//			<result type=" <<type>> "> <<value>> <\result>
+void OutputBuffer::xmlResult(string_view type, string_view value) {
+	beginResult(type);
+	write(value);
+	endResult();
+}
+
+void OutputBuffer::xmlResult(string_view type, double value, int precision) {
+	beginResult(type);
+	write(value, precision);
+	endResult();
+}
+
+// beginResult(string_view type) and endResult()
+//  Purpose:
+//		Append the start and end of an XML result, so the value can be
+//		written in between without building a string for it.
+void OutputBuffer::beginResult(string_view type) {
+	write("    <result type =\"");
+	write(type);
+	write("\">");
+}
+
+void OutputBuffer::endResult() {
+	write("</result>\n");
+}
+
+// reverse(size_t start)
+//  Purpose:
+//		Reverses the chars from offset start to the end of the buffer
+void OutputBuffer::reverse(size_t start) {
+	std::reverse(buffer.begin() + start, buffer.begin() + used);
+}
+
+// flush()
+//  Purpose:
+//		Writes the buffer to the file descriptor and clears it (if there
+//		is no file descriptor the text is kept).  Throws runtime_error
+//		with the error if the write fails, the buffer then only holds
+//		the text that was not written.
+void OutputBuffer::flush() {
+	if (fileDescriptor < 0)
+		return;
+
+	const char* chars = buffer.data();
+	size_t left = used;
+	while (left > 0) {
+		ssize_t written = ::write(fileDescriptor, chars, left);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+
+			// Keep the text that was not written
+			int error = errno;
+			memmove(buffer.data(), chars, left);
+			used = left;
+			throw runtime_error("can not write output: " + string(strerror(error)));
+		}
+		chars += written;
+		left -= written;
+	}
+
+	used = 0;
+}
+
+// clear()
+//  Purpose:
+//		Empties the buffer, keeping its memory for reuse
+void OutputBuffer::clear() {
+	used = 0;
+}
+
+// Public Accessors
+// =============================================
+size_t OutputBuffer::getSize() {
+	return used;
+}
+
+string_view OutputBuffer::getView() {
+	return string_view(buffer.data(), used);
+}
+
+string OutputBuffer::str() {
+	return string(buffer.data(), used);
+}
+
+// Private Methods
+// =============================================
+
+// char* reserve(size_t length)
+//  Purpose:
+//		Makes room for length more chars and returns where they go
+char* OutputBuffer::reserve(size_t length) {
+	if (used + length > buffer.size())
+		buffer.resize(max(2 * buffer.size(), max(used + length, (size_t) 256)));
+
+	return buffer.data() + used;
+}
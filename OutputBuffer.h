@@ -0,0 +1,127 @@
+/*
+ * OutputBuffer.h
+ *
+ *	This is the header file for the OutputBuffer object. The OutputBuffer
+ *  builds text (the XML result strings) in one growing buffer that can be
+ *  cleared and reused, so writing a result does not create a stream or a
+ *  string for each field.  Numbers are formatted straight into the buffer
+ *  with to_chars(), the same way a stream formats them.
+ *
+ *  An OutputBuffer made with a file descriptor writes its contents to the
+ *  file descriptor when flush() is called (and when it is destroyed).
+ *  Nothing is written until then, so the text in the buffer can still be
+ *  changed (see reverse()).  flush() does nothing for a buffer without a
+ *  file descriptor, its text is kept until clear() is called.  flush()
+ *  throws runtime_error if the file descriptor can not be written, keeping
+ *  the text that was not written (the destructor does not report it).
+ *
+ *  Typical Use:
+ *		OutputBuffer out(STDOUT_FILENO);
+ *		out.xmlResult("score", 27.0, 6);
+ *		graph->writeResult(out);
+ *		out.flush();
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef OUTPUTBUFFER_H
+#define OUTPUTBUFFER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+using namespace std;
+
+class OutputBuffer
+{
+public:
+
+	// Constuctors
+	// ==============================================
+	OutputBuffer();  // text is only kept in memory
+	OutputBuffer(int aFileDescriptor);  // flush() writes the text to the file descriptor
+
+	// Destructor
+	// =============================================
+	virtual ~OutputBuffer();
+
+	// Public Methods
+	// =============================================
+
+	// write(...)
+	//  Purpose:
+	//		Appends the value to the buffer.  Integers are written in
+	//		full, doubles the same way as a stream with precision
+	//		precision and the default format (%g).
+	void write(string_view chars);
+	void write(char aChar);
+	void write(int value);
+	void write(long long value);
+	void write(double value, int precision);
+
+	// xmlResult(string_view type, string_view value)
+	// xmlResult(string_view type, double value, int precision)
+	//  Purpose:
+	//		Appends an XML result the same as StringUtilities::xmlResult():
+	//			<result type=" <<type>> "> <<value>> <\result>
+	void xmlResult(string_view type, string_view value);
+	void xmlResult(string_view type, double value, int precision);
+
+	// beginResult(string_view type) and endResult()
+	//  Purpose:
+	//		Append the start and end of an XML result, so the value can be
+	//		written in between without building a string for it.
+	void beginResult(string_view type);
+	void endResult();
+
+	// reverse(size_t start)
+	//  Purpose:
+	//		Reverses the chars from offset start to the end of the buffer
+	//  Preconditions:
+	//		start <= getSize(), and the buffer has not been flushed since
+	//		start was taken
+	void reverse(size_t start);
+
+	// flush()
+	//  Purpose:
+	//		Writes the buffer to the file descriptor and clears it (if there
+	//		is no file descriptor the text is kept).  Throws runtime_error
+	//		with the error if the write fails, the buffer then only holds
+	//		the text that was not written.
+	void flush();
+
+	// clear()
+	//  Purpose:
+	//		Empties the buffer, keeping its memory for reuse
+	void clear();
+
+	// Public Accessors
+	// =============================================
+	size_t getSize();  // chars in the buffer
+	string_view getView();  // the chars in the buffer (valid until the next write)
+	string str();  // a copy of the chars in the buffer
+
+private:
+
+	// Attributes
+	// =============================================
+	vector<char> buffer;
+	size_t used;  // number of chars in the buffer
+	int fileDescriptor;  // -1 if the text is only kept in memory
+
+	// The buffer may own unwritten text for its file, so it can not be copied
+	OutputBuffer(const OutputBuffer&) = delete;
+	OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+	// Private Methods
+	// =============================================
+
+	// char* reserve(size_t length)
+	//  Purpose:
+	//		Makes room for length more chars and returns where they go
+	char* reserve(size_t length);
+};
+
+#endif // OUTPUTBUFFER_H
@@ -0,0 +1,109 @@
+/*
+ * PackedTraceback.cpp
+ *
+ *	This is the cpp file for the PackedTraceback object. The
+ *  PackedTraceback stores the move used to reach each cell of an edit
+ *  graph tensor in 3 bits, so the seven move types (1 to 7) and the start
+ *  of a path (0) fit in less than half a byte per cell.
+ *
+ *  The cells are stored in rows (for the 3-way aligner a row is the cells
+ *  along fasta3 for one (i,j)).  Each row is split into groups of
+ *  cellsPerGroup cells, and a group is held in three 64 bit words: word b
+ *  holds bit b of the move of each cell of the group.  Rows start on a new
+ *  group, so rows (and groups within a row) can be filled in by different
+ *  threads at the same time.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "PackedTraceback.h"
+#include <algorithm>
+using namespace std;
+
+// Class Attribute Initialization
+// ==============================================
+const size_t PackedTraceback::cellsPerGroup;
+
+// Constuctors
+// ==============================================
+PackedTraceback::PackedTraceback() {
+	rowCount = 0;
+	rowLength = 0;
+	groupsPerRow = 0;
+}
+
+// Public Methods
+// =============================================
+
+// resize(size_t aRowCount, size_t aRowLength)
+//  Purpose:
+//		Makes room for aRowCount rows of aRowLength cells.  The moves are
+//		not cleared, every cell has to be set before it is read.  The
+//		memory is kept if the traceback gets smaller.
+void PackedTraceback::resize(size_t aRowCount, size_t aRowLength) {
+	rowCount = aRowCount;
+	rowLength = aRowLength;
+	groupsPerRow = (rowLength + cellsPerGroup - 1) / cellsPerGroup;
+
+	words.resize(rowCount * groupsPerRow * 3);
+}
+
+// setRow(size_t row, size_t first, const unsigned char* moves, size_t count)
+//  Purpose:
+//		Sets the moves of count cells of a row, starting at column first.
+//  Preconditions:
+//		first is a multiple of cellsPerGroup, and the cells either fill
+//		the last group they touch or run to the end of the row
+void PackedTraceback::setRow(size_t row, size_t first, const unsigned char* moves, size_t count) {
+	uint64_t* groupWords = &words[(row * groupsPerRow + first / cellsPerGroup) * 3];
+
+	for (size_t groupStart = 0; groupStart < count; groupStart += cellsPerGroup, groupWords += 3) {
+		size_t groupCount = min(cellsPerGroup, count - groupStart);
+
+		// Build the three bit planes of the group, then store them whole
+		uint64_t bits0 = 0, bits1 = 0, bits2 = 0;
+		for (size_t t = 0; t < groupCount; t++) {
+			uint64_t move = moves[groupStart + t];
+			bits0 |= (move & 1) << t;
+			bits1 |= ((move >> 1) & 1) << t;
+			bits2 |= ((move >> 2) & 1) << t;
+		}
+
+		groupWords[0] = bits0;
+		groupWords[1] = bits1;
+		groupWords[2] = bits2;
+	}
+}
+
+// setMove(size_t row, size_t column, unsigned char move)
+//  Purpose:
+//		Sets the move of one cell
+void PackedTraceback::setMove(size_t row, size_t column, unsigned char move) {
+	uint64_t* groupWords = &words[(row * groupsPerRow + column / cellsPerGroup) * 3];
+	size_t t = column % cellsPerGroup;
+
+	for (int bit = 0; bit < 3; bit++) {
+		groupWords[bit] &= ~((uint64_t) 1 << t);
+		groupWords[bit] |= (uint64_t) ((move >> bit) & 1) << t;
+	}
+}
+
+// unsigned char getMove(size_t row, size_t column)
+//  Purpose:
+//		Returns the move of one cell
+unsigned char PackedTraceback::getMove(size_t row, size_t column) const {
+	const uint64_t* groupWords = &words[(row * groupsPerRow + column / cellsPerGroup) * 3];
+	size_t t = column % cellsPerGroup;
+
+	return (unsigned char) (
+		((groupWords[0] >> t) & 1) |
+		(((groupWords[1] >> t) & 1) << 1) |
+		(((groupWords[2] >> t) & 1) << 2));
+}
+
+// Public Accessors
+// =============================================
+size_t PackedTraceback::getBytesUsed() const {
+	return rowCount * groupsPerRow * 3 * sizeof(uint64_t);
+}
@@ -0,0 +1,88 @@
+/*
+ * PackedTraceback.h
+ *
+ *	This is the header file for the PackedTraceback object. The
+ *  PackedTraceback stores the move used to reach each cell of an edit
+ *  graph tensor in 3 bits, so the seven move types (1 to 7) and the start
+ *  of a path (0) fit in less than half a byte per cell.
+ *
+ *  The cells are stored in rows (for the 3-way aligner a row is the cells
+ *  along fasta3 for one (i,j)).  Each row is split into groups of
+ *  cellsPerGroup cells, and a group is held in three 64 bit words: word b
+ *  holds bit b of the move of each cell of the group.  Rows start on a new
+ *  group, so rows (and groups within a row) can be filled in by different
+ *  threads at the same time.
+ *
+ *  Typical Use:
+ *		PackedTraceback traceback;
+ *		traceback.resize(rowCount, rowLength);
+ *		traceback.setRow(row, 0, rowMoves, rowLength);
+ *		...
+ *		unsigned char move = traceback.getMove(row, column);
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef PACKEDTRACEBACK_H
+#define PACKEDTRACEBACK_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+using namespace std;
+
+class PackedTraceback
+{
+public:
+
+	// Cells held in each group of three words
+	static const size_t cellsPerGroup = 64;
+
+	// Constuctors
+	// ==============================================
+	PackedTraceback();
+
+	// Public Methods
+	// =============================================
+
+	// resize(size_t aRowCount, size_t aRowLength)
+	//  Purpose:
+	//		Makes room for aRowCount rows of aRowLength cells.  The moves are
+	//		not cleared, every cell has to be set before it is read.  The
+	//		memory is kept if the traceback gets smaller.
+	void resize(size_t aRowCount, size_t aRowLength);
+
+	// setRow(size_t row, size_t first, const unsigned char* moves, size_t count)
+	//  Purpose:
+	//		Sets the moves of count cells of a row, starting at column first.
+	//  Preconditions:
+	//		first is a multiple of cellsPerGroup, and the cells either fill
+	//		the last group they touch or run to the end of the row
+	void setRow(size_t row, size_t first, const unsigned char* moves, size_t count);
+
+	// setMove(size_t row, size_t column, unsigned char move)
+	//  Purpose:
+	//		Sets the move of one cell
+	void setMove(size_t row, size_t column, unsigned char move);
+
+	// unsigned char getMove(size_t row, size_t column)
+	//  Purpose:
+	//		Returns the move of one cell
+	unsigned char getMove(size_t row, size_t column) const;
+
+	// Public Accessors
+	// =============================================
+	size_t getBytesUsed() const;  // bytes of the packed moves
+
+private:
+
+	// Attributes
+	// =============================================
+	size_t rowCount;
+	size_t rowLength;  // cells in each row
+	size_t groupsPerRow;
+	vector<uint64_t> words;  // three words for each group, row after row
+};
+
+#endif // PACKEDTRACEBACK_H
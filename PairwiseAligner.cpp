@@ -0,0 +1,258 @@
+/*
+ * PairwiseAligner.cpp
+ *
+ *	This is the cpp file for the PairwiseAligner object. The
+ *  PairwiseAligner runs the 2D version of the ThreeWayAligner's dynamic
+ *  program: it finds the weight of the highest weight path through the
+ *  edit graph for two sequences, where vertex (i,j) has incoming edges
+ *  from (i-1,j-1), (i-1,j) and (i,j-1), the columns are scored with the
+ *  scoring matrix and paths can start at any vertex with weight 0.
+ *
+ *  The AVX2 version of globalScores() is compiled with a target attribute,
+ *  so no special compiler flags are needed, and is only called if
+ *  ScoreRowKernel picked an instruction set with AVX2.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "PairwiseAligner.h"
+#include "ScoreRowKernel.h"
+#include <algorithm>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PAIRWISEALIGNER_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Class Attribute Initialization
+// ==============================================
+const int PairwiseAligner::laneCount;
+
+// Constuctors
+// ==============================================
+PairwiseAligner::PairwiseAligner() {
+	matrix = &ScoringMatrix::blosum62();
+}
+
+// Destructor
+// =============================================
+PairwiseAligner::~PairwiseAligner() {
+}
+
+// Public Methods
+// =============================================
+
+// int highestWeightScore(const string& sequence1, const string& sequence2)
+//  Purpose:
+//		Returns the weight of the highest weight path through the edit
+//		graph for the two sequences (0 if no path is better than the
+//		trivial path).  Throws out_of_range if a sequence has a char
+//		that is not a residue of the matrix.
+int PairwiseAligner::highestWeightScore(const string& sequence1, const string& sequence2) {
+	encode(sequence1, seq1Indexes);
+	encode(sequence2, seq2Indexes);
+
+	int seq1Length = seq1Indexes.size();
+	int seq2Length = seq2Indexes.size();
+	int gapIndex = matrix->getGapIndex();
+	const int* gapRow = matrix->scoreRow(gapIndex);
+
+	// Row i = 0 only has the trivial path
+	row.assign(seq2Length + 1, 0);
+
+	int highestWeight = 0;
+	for (int seq1Loc = 1; seq1Loc <= seq1Length; seq1Loc++) {
+		const int* scores = matrix->scoreRow(seq1Indexes[seq1Loc - 1]);
+		int seq1Gap = scores[gapIndex];  // residue of sequence1 against a gap
+		int diagonal = row[0];  // score of (i-1, j-1)
+
+		row[0] = 0;
+		for (int seq2Loc = 1; seq2Loc <= seq2Length; seq2Loc++) {
+			int residue2 = seq2Indexes[seq2Loc - 1];
+
+			int weight = max(0, diagonal + scores[residue2]);
+			weight = max(weight, row[seq2Loc] + seq1Gap);
+			weight = max(weight, row[seq2Loc - 1] + gapRow[residue2]);
+
+			diagonal = row[seq2Loc];
+			row[seq2Loc] = weight;
+			highestWeight = max(highestWeight, weight);
+		}
+	}
+
+	return highestWeight;
+}
+
+// int globalScore(const string& sequence1, const string& sequence2)
+//  Purpose:
+//		Returns the weight of the highest weight path from the first to
+//		the last vertex of the edit graph for the two sequences (the
+//		Needleman-Wunsch score).  Throws out_of_range if a sequence has a
+//		char that is not a residue of the matrix.
+int PairwiseAligner::globalScore(const string& sequence1, const string& sequence2) {
+	encode(sequence1, seq1Indexes);
+	encode(sequence2, seq2Indexes);
+
+	return globalScoreByIndex(seq1Indexes, seq2Indexes);
+}
+
+// globalScores(const vector<unsigned char>& indexes1,
+//		const vector<unsigned char>* const* indexes2, int count, int* scores)
+//  Purpose:
+//		Finds the global score of indexes1 against each of the count
+//		encoded sequences indexes2[0 .. count-1], scores[t] is the
+//		score for indexes2[t].
+//  Preconditions:
+//		count <= laneCount, and the sequences were encoded with encode()
+void PairwiseAligner::globalScores(const vector<unsigned char>& indexes1,
+	const vector<unsigned char>* const* indexes2, int count, int* scores) {
+
+#ifdef PAIRWISEALIGNER_X86
+	if (ScoreRowKernel::getInstructionSet() != ScoreRowKernel::scalar) {
+		globalScoresAvx2(indexes1, indexes2, count, scores);
+		return;
+	}
+#endif
+
+	for (int lane = 0; lane < count; lane++)
+		scores[lane] = globalScoreByIndex(indexes1, *indexes2[lane]);
+}
+
+// encode(const string& sequence, vector<unsigned char>& indexes)
+//  Purpose:
+//		Looks up the matrix index of each residue of the sequence.
+//		Throws out_of_range if it has a char that is not a residue.
+void PairwiseAligner::encode(const string& sequence, vector<unsigned char>& indexes) {
+	indexes.resize(sequence.length());
+	for (size_t loc = 0; loc < sequence.length(); loc++)
+		indexes[loc] = matrix->residueIndex(sequence[loc]);
+}
+
+// Public Accessors
+// =============================================
+void PairwiseAligner::setScoringMatrix(const ScoringMatrix* aMatrix) {
+	matrix = (aMatrix != NULL) ? aMatrix : &ScoringMatrix::blosum62();
+}
+
+// Private Methods
+// =============================================
+
+// int globalScoreByIndex(const vector<unsigned char>& indexes1, const vector<unsigned char>& indexes2)
+//  Purpose:
+//		Returns the global score of the two encoded sequences
+int PairwiseAligner::globalScoreByIndex(const vector<unsigned char>& indexes1, const vector<unsigned char>& indexes2) {
+	int seq1Length = indexes1.size();
+	int seq2Length = indexes2.size();
+	int gapIndex = matrix->getGapIndex();
+	const int* gapRow = matrix->scoreRow(gapIndex);
+
+	// Row i = 0 is all gaps in sequence1
+	row.resize(seq2Length + 1);
+	row[0] = 0;
+	for (int seq2Loc = 1; seq2Loc <= seq2Length; seq2Loc++)
+		row[seq2Loc] = row[seq2Loc - 1] + gapRow[indexes2[seq2Loc - 1]];
+
+	for (int seq1Loc = 1; seq1Loc <= seq1Length; seq1Loc++) {
+		const int* scores = matrix->scoreRow(indexes1[seq1Loc - 1]);
+		int seq1Gap = scores[gapIndex];  // residue of sequence1 against a gap
+		int diagonal = row[0];  // score of (i-1, j-1)
+
+		row[0] += seq1Gap;
+		for (int seq2Loc = 1; seq2Loc <= seq2Length; seq2Loc++) {
+			int residue2 = indexes2[seq2Loc - 1];
+
+			int weight = diagonal + scores[residue2];
+			weight = max(weight, row[seq2Loc] + seq1Gap);
+			weight = max(weight, row[seq2Loc - 1] + gapRow[residue2]);
+
+			diagonal = row[seq2Loc];
+			row[seq2Loc] = weight;
+		}
+	}
+
+	return row[seq2Length];
+}
+
+#ifdef PAIRWISEALIGNER_X86
+
+// globalScoresAvx2(const vector<unsigned char>& indexes1,
+//		const vector<unsigned char>* const* indexes2, int count, int* scores)
+//  Purpose:
+//		globalScores() with one pair in each lane of AVX2 vectors
+__attribute__((target("avx2")))
+void PairwiseAligner::globalScoresAvx2(const vector<unsigned char>& indexes1,
+	const vector<unsigned char>* const* indexes2, int count, int* scores) {
+
+	int seq1Length = indexes1.size();
+	int gapIndex = matrix->getGapIndex();
+	const int* gapRow = matrix->scoreRow(gapIndex);
+
+	// Lay the lanes' sequences out side by side, lanes past the end of
+	// their sequence (or past count) see gaps, which never change the
+	// cells before the end
+	int seq2Length = 0;
+	for (int lane = 0; lane < count; lane++)
+		seq2Length = max(seq2Length, (int) indexes2[lane]->size());
+
+	laneIndexes.assign((size_t) seq2Length * laneCount, gapIndex);
+	laneGaps.assign((size_t) seq2Length * laneCount, 0);
+	for (int lane = 0; lane < count; lane++) {
+		const vector<unsigned char>& sequence = *indexes2[lane];
+		for (size_t loc = 0; loc < sequence.size(); loc++) {
+			laneIndexes[loc * laneCount + lane] = sequence[loc];
+			laneGaps[loc * laneCount + lane] = gapRow[sequence[loc]];
+		}
+	}
+
+	// Row i = 0 is all gaps in sequence1
+	laneRow.resize((size_t) (seq2Length + 1) * laneCount);
+	int* rowScores = laneRow.data();
+	__m256i left = _mm256_setzero_si256();
+	_mm256_storeu_si256((__m256i*) rowScores, left);
+	for (int seq2Loc = 1; seq2Loc <= seq2Length; seq2Loc++) {
+		left = _mm256_add_epi32(left, _mm256_loadu_si256((const __m256i*) &laneGaps[(seq2Loc - 1) * laneCount]));
+		_mm256_storeu_si256((__m256i*) (rowScores + seq2Loc * laneCount), left);
+	}
+
+	for (int seq1Loc = 1; seq1Loc <= seq1Length; seq1Loc++) {
+		const int* residueScores = matrix->scoreRow(indexes1[seq1Loc - 1]);
+		const __m256i seq1Gap = _mm256_set1_epi32(residueScores[gapIndex]);
+
+		__m256i diagonal = _mm256_loadu_si256((const __m256i*) rowScores);
+		left = _mm256_add_epi32(diagonal, seq1Gap);
+		_mm256_storeu_si256((__m256i*) rowScores, left);
+
+		for (int seq2Loc = 1; seq2Loc <= seq2Length; seq2Loc++) {
+			int* cell = rowScores + seq2Loc * laneCount;
+			__m256i residues2 = _mm256_loadu_si256((const __m256i*) &laneIndexes[(seq2Loc - 1) * laneCount]);
+			__m256i gaps2 = _mm256_loadu_si256((const __m256i*) &laneGaps[(seq2Loc - 1) * laneCount]);
+			__m256i up = _mm256_loadu_si256((const __m256i*) cell);
+
+			__m256i weight = _mm256_add_epi32(diagonal, _mm256_i32gather_epi32(residueScores, residues2, 4));
+			weight = _mm256_max_epi32(weight, _mm256_add_epi32(up, seq1Gap));
+			weight = _mm256_max_epi32(weight, _mm256_add_epi32(left, gaps2));
+
+			_mm256_storeu_si256((__m256i*) cell, weight);
+			diagonal = up;
+			left = weight;
+		}
+	}
+
+	// Each lane's score is at the end of its own sequence
+	for (int lane = 0; lane < count; lane++)
+		scores[lane] = rowScores[indexes2[lane]->size() * laneCount + lane];
+}
+
+#else
+
+void PairwiseAligner::globalScoresAvx2(const vector<unsigned char>& indexes1,
+	const vector<unsigned char>* const* indexes2, int count, int* scores) {
+
+	for (int lane = 0; lane < count; lane++)
+		scores[lane] = globalScoreByIndex(indexes1, *indexes2[lane]);
+}
+
+#endif
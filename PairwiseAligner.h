@@ -0,0 +1,125 @@
+/*
+ * PairwiseAligner.h
+ *
+ *	This is the header file for the PairwiseAligner object. The
+ *  PairwiseAligner runs the 2D version of the ThreeWayAligner's dynamic
+ *  program: it finds the weight of the highest weight path through the
+ *  edit graph for two sequences, where vertex (i,j) has incoming edges
+ *  from (i-1,j-1), (i-1,j) and (i,j-1), the columns are scored with the
+ *  scoring matrix and paths can start at any vertex with weight 0.
+ *
+ *  globalScore() finds the Needleman-Wunsch score instead: the path must
+ *  start at (0,0) and end at the last vertex.  globalScores() finds the
+ *  global scores of one sequence against up to laneCount others at once,
+ *  one pair in each SIMD lane (AVX2, when ScoreRowKernel has picked an
+ *  instruction set with it), so sequences of different lengths share the
+ *  same instructions.  Each lane gives the same score as globalScore().
+ *
+ *  Only the scores are found, so only one row of scores is kept in memory.
+ *  The row and the encoded sequences are kept between calls, so an
+ *  aligner that is used for many pairs does not allocate once it has seen
+ *  its longest sequence.  An aligner is not thread safe, use one for each
+ *  thread.
+ *
+ *  Typical Use:
+ *		PairwiseAligner aligner;
+ *		int score = aligner.highestWeightScore(sequence1, sequence2);
+ *		int global = aligner.globalScore(sequence1, sequence2);
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef PAIRWISEALIGNER_H
+#define PAIRWISEALIGNER_H
+
+#include "ScoringMatrix.h"
+#include <string>
+#include <vector>
+using namespace std;
+
+class PairwiseAligner
+{
+public:
+
+	// Constuctors
+	// ==============================================
+	PairwiseAligner();
+
+	// Destructor
+	// =============================================
+	virtual ~PairwiseAligner();
+
+	// Public Methods
+	// =============================================
+
+	// int highestWeightScore(const string& sequence1, const string& sequence2)
+	//  Purpose:
+	//		Returns the weight of the highest weight path through the edit
+	//		graph for the two sequences (0 if no path is better than the
+	//		trivial path).  Throws out_of_range if a sequence has a char
+	//		that is not a residue of the matrix.
+	int highestWeightScore(const string& sequence1, const string& sequence2);
+
+	// int globalScore(const string& sequence1, const string& sequence2)
+	//  Purpose:
+	//		Returns the weight of the highest weight path from the first to
+	//		the last vertex of the edit graph for the two sequences (the
+	//		Needleman-Wunsch score).  Throws out_of_range if a sequence has a
+	//		char that is not a residue of the matrix.
+	int globalScore(const string& sequence1, const string& sequence2);
+
+	// globalScores(const vector<unsigned char>& indexes1,
+	//		const vector<unsigned char>* const* indexes2, int count, int* scores)
+	//  Purpose:
+	//		Finds the global score of indexes1 against each of the count
+	//		encoded sequences indexes2[0 .. count-1], scores[t] is the
+	//		score for indexes2[t].
+	//  Preconditions:
+	//		count <= laneCount, and the sequences were encoded with encode()
+	void globalScores(const vector<unsigned char>& indexes1,
+		const vector<unsigned char>* const* indexes2, int count, int* scores);
+
+	// encode(const string& sequence, vector<unsigned char>& indexes)
+	//  Purpose:
+	//		Looks up the matrix index of each residue of the sequence.
+	//		Throws out_of_range if it has a char that is not a residue.
+	void encode(const string& sequence, vector<unsigned char>& indexes);
+
+	// Public Accessors
+	// =============================================
+	void setScoringMatrix(const ScoringMatrix* aMatrix);  // matrix to score with (NULL = BLOSUM62)
+
+	// Public Class Attributes
+	// =============================================
+	static const int laneCount = 8;  // pairs aligned at once by globalScores()
+
+private:
+
+	// Attributes
+	// =============================================
+	const ScoringMatrix* matrix;
+	vector<unsigned char> seq1Indexes;  // matrix index of each residue of sequence1
+	vector<unsigned char> seq2Indexes;
+	vector<int> row;  // scores for the current row of cells along sequence2
+	vector<int> laneRow;  // globalScores() row, laneCount scores for each cell
+	vector<int> laneIndexes;  // residue index of each lane's sequence at each loc
+	vector<int> laneGaps;  // score of each lane's residue against a gap
+
+	// Private Methods
+	// =============================================
+
+	// int globalScoreByIndex(const vector<unsigned char>& indexes1, const vector<unsigned char>& indexes2)
+	//  Purpose:
+	//		Returns the global score of the two encoded sequences
+	int globalScoreByIndex(const vector<unsigned char>& indexes1, const vector<unsigned char>& indexes2);
+
+	// globalScoresAvx2(const vector<unsigned char>& indexes1,
+	//		const vector<unsigned char>* const* indexes2, int count, int* scores)
+	//  Purpose:
+	//		globalScores() with one pair in each lane of AVX2 vectors
+	void globalScoresAvx2(const vector<unsigned char>& indexes1,
+		const vector<unsigned char>* const* indexes2, int count, int* scores);
+};
+
+#endif // PAIRWISEALIGNER_H
@@ -0,0 +1,519 @@
+/*
+ * ProgressiveAligner.cpp
+ *
+ *	This is the cpp file for the ProgressiveAligner object. The
+ *  ProgressiveAligner builds a multiple alignment of all of the records
+ *  of a multi-record fasta file, progressively along a guide tree built
+ *  from the pairwise distances of the records.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "ProgressiveAligner.h"
+#include "PairwiseAligner.h"
+#include "ThreadPool.h"
+#include "FastaReader.h"
+#include "StringUtilities.h"
+#include <sstream>
+#include <algorithm>
+using namespace std;
+
+// Constuctors
+// ==============================================
+ProgressiveAligner::ProgressiveAligner(const string& aFastaFileName) {
+	gapChar = '-';
+	fastaFileName = aFastaFileName;
+	matrix = &ScoringMatrix::blosum62();
+	threadCount = 1;
+	score = 0;
+
+	FastaReader reader(fastaFileName);
+	FastaRecord record;
+	while (reader.nextRecord(record)) {
+		string name;
+		stringstream(record.header.substr(1)) >> name;
+		records.push_back(new FastaFile(name, record, false));
+	}
+}
+
+// Destructor
+// =============================================
+ProgressiveAligner::~ProgressiveAligner() {
+	for (size_t i = 0; i < records.size(); i++)
+		delete records[i];
+}
+
+// Public Methods
+// =============================================
+
+// align()
+//  Purpose:
+//		Builds the multiple alignment of the records (see the class
+//		header).  Throws out_of_range if a sequence has a char that is
+//		not a residue of the matrix.
+//  Postconditions:
+//		- alignment, score and guideTree will be set
+void ProgressiveAligner::align() {
+	int recordCount = records.size();
+
+	// Check the sequences here, so the worker threads do not throw
+	for (int record = 0; record < recordCount; record++) {
+		string& sequence = records[record]->getSequence();
+		for (size_t loc = 0; loc < sequence.length(); loc++)
+			matrix->residueIndex(sequence[loc]);
+	}
+
+	findDistances();
+	buildGuideTree();
+
+	// Merge the profiles up the guide tree, the children of a node are
+	// always before it
+	vector<Profile> profiles(guideTree.size());
+	for (int node = 0; node < (int) guideTree.size(); node++) {
+		if (guideTree[node].left < 0) {
+			profiles[node].members.push_back(node);
+			profiles[node].rows.push_back(records[node]->getSequence());
+			continue;
+		}
+
+		Profile& left = profiles[guideTree[node].left];
+		Profile& right = profiles[guideTree[node].right];
+		mergeProfiles(left, right, profiles[node]);
+
+		// The children are not needed any more
+		vector<string>().swap(left.rows);
+		vector<string>().swap(right.rows);
+	}
+
+	// Put the rows back in the order of the records
+	alignment.assign(recordCount, string());
+	if (recordCount > 0) {
+		Profile& root = profiles.back();
+		for (size_t row = 0; row < root.members.size(); row++)
+			alignment[root.members[row]].swap(root.rows[row]);
+	}
+
+	score = sumOfPairsScore();
+}
+
+// string resultString()
+//  Purpose:
+//		Returns an XML formatted string representing the results of the
+//		align() function.
+//
+//		format:
+//			<results type="progressive" file=" <<fastaFileName>> ">";
+//			  <result type="sequence_count"> <<number of records>> </result>
+//			  <result type="guide_tree"> <<guide tree in Newick format>> </result>
+//			  <result type="score"> <<sum of pairs score of the alignment>> </result>
+//			  <result type="alignment">
+//				<<record name>> <<aligned sequence>>
+//				...
+//			  </result>
+//			</results>
+//  Preconditions:
+//		align() has been run
+string ProgressiveAligner::resultString() {
+	stringstream ss;
+	// Results header
+	ss << "  <results type=\"progressive\" file=\"" << fastaFileName << "\">\n";
+
+	stringstream count;
+	count << records.size();
+	ss << StringUtilities::xmlResult("sequence_count", count.str());
+
+	if (records.empty())
+		ss << StringUtilities::xmlResult("alignment", "No Sequences!");
+	else {
+		stringstream scoreValue;
+		scoreValue << score;
+
+		stringstream rows;
+		for (size_t record = 0; record < records.size(); record++) {
+			if (record > 0)
+				rows << "\n      ";
+			rows << records[record]->getFileName() << " " << alignment[record];
+		}
+
+		ss
+			<< StringUtilities::xmlResult("guide_tree", newick(guideTree.size() - 1) + ";")
+			<< StringUtilities::xmlResult("score", scoreValue.str())
+			<< StringUtilities::xmlResultFormatted("alignment", rows.str());
+	}
+
+	// Results footer
+	ss << "  </results>\n";
+
+	return ss.str();
+}
+
+// Public Accessors
+// =============================================
+long long ProgressiveAligner::getScore() {
+	return score;
+}
+
+const vector<string>& ProgressiveAligner::getAlignment() {
+	return alignment;
+}
+
+void ProgressiveAligner::setScoringMatrix(const ScoringMatrix* aMatrix) {
+	matrix = (aMatrix != NULL) ? aMatrix : &ScoringMatrix::blosum62();
+}
+
+void ProgressiveAligner::setThreadCount(unsigned int aThreadCount) {
+	threadCount = (aThreadCount > 0) ? aThreadCount : 1;
+}
+
+// Private Methods
+// =============================================
+
+// findDistances()
+//  Purpose:
+//		Finds the distance between each pair of records
+//  Postconditions:
+//		- distances will be set
+void ProgressiveAligner::findDistances() {
+	int recordCount = records.size();
+
+	ThreadPool pool(threadCount);
+	vector<PairwiseAligner> aligners(pool.getThreadCount());
+	for (size_t i = 0; i < aligners.size(); i++)
+		aligners[i].setScoringMatrix(matrix);
+
+	// Self scores first, they scale the pair scores
+	vector<int> selfScores(recordCount);
+	pool.parallelFor(recordCount, [&](size_t record, unsigned int thread) {
+		string& sequence = records[record]->getSequence();
+		selfScores[record] = aligners[thread].highestWeightScore(sequence, sequence);
+	});
+
+	// Each task is a row of the upper triangle
+	distances.assign((size_t) recordCount * recordCount, 0.0);
+	pool.parallelFor(recordCount, [&](size_t record1, unsigned int thread) {
+		for (int record2 = record1 + 1; record2 < recordCount; record2++) {
+			int pairScore = aligners[thread].highestWeightScore(
+				records[record1]->getSequence(), records[record2]->getSequence());
+
+			double distance = 1.0;
+			int scale = min(selfScores[record1], selfScores[record2]);
+			if (scale > 0)
+				distance = max(0.0, min(1.0, 1.0 - (double) pairScore / scale));
+
+			distances[record1 * recordCount + record2] = distance;
+			distances[record2 * recordCount + record1] = distance;
+		}
+	});
+}
+
+// buildGuideTree()
+//  Purpose:
+//		Builds the guide tree from the distances with UPGMA, ties are
+//		broken by taking the first pair of clusters.  The closest later
+//		cluster of each cluster is kept, so finding the closest pair is a
+//		scan of the clusters, and after a merge only the clusters whose
+//		closest cluster was merged are rescanned (O(n^2) overall unless
+//		many clusters have the same closest cluster).
+//  Postconditions:
+//		- guideTree will be set, the root is its last node
+void ProgressiveAligner::buildGuideTree() {
+	int recordCount = records.size();
+
+	// Each record starts as its own cluster, a merged cluster takes the
+	// place of the first of its two clusters
+	vector<double> clusterDistances = distances;
+	vector<int> clusterNodes(recordCount);
+	vector<bool> active(recordCount, true);
+
+	// The first closest active cluster after each cluster (-1 if none)
+	vector<int> closestAfter(recordCount, -1);
+	auto findClosestAfter = [&](int cluster) {
+		closestAfter[cluster] = -1;
+		const double* row = &clusterDistances[(size_t) cluster * recordCount];
+		for (int other = cluster + 1; other < recordCount; other++) {
+			if (active[other] && (closestAfter[cluster] < 0 || row[other] < row[closestAfter[cluster]]))
+				closestAfter[cluster] = other;
+		}
+	};
+	for (int record = 0; record < recordCount; record++)
+		findClosestAfter(record);
+
+	guideTree.clear();
+	for (int record = 0; record < recordCount; record++) {
+		TreeNode leaf = { -1, -1, 1 };
+		guideTree.push_back(leaf);
+		clusterNodes[record] = record;
+	}
+
+	for (int merge = 1; merge < recordCount; merge++) {
+
+		// Find the closest pair of clusters
+		int cluster1 = -1;
+		int cluster2 = -1;
+		double closest = 0.0;
+		for (int i = 0; i < recordCount; i++) {
+			int j = closestAfter[i];
+			if (active[i] && j >= 0 && (cluster1 < 0 || clusterDistances[(size_t) i * recordCount + j] < closest)) {
+				cluster1 = i;
+				cluster2 = j;
+				closest = clusterDistances[(size_t) i * recordCount + j];
+			}
+		}
+
+		int size1 = guideTree[clusterNodes[cluster1]].size;
+		int size2 = guideTree[clusterNodes[cluster2]].size;
+		TreeNode node = { clusterNodes[cluster1], clusterNodes[cluster2], size1 + size2 };
+		guideTree.push_back(node);
+
+		// The distance to the merged cluster is the average distance to its records
+		for (int other = 0; other < recordCount; other++) {
+			if (!active[other] || other == cluster1 || other == cluster2)
+				continue;
+
+			double distance =
+				(size1 * clusterDistances[(size_t) cluster1 * recordCount + other] +
+				 size2 * clusterDistances[(size_t) cluster2 * recordCount + other]) / (size1 + size2);
+			clusterDistances[(size_t) cluster1 * recordCount + other] = distance;
+			clusterDistances[(size_t) other * recordCount + cluster1] = distance;
+		}
+
+		clusterNodes[cluster1] = guideTree.size() - 1;
+		active[cluster2] = false;
+
+		// Only the clusters before cluster1 can have it as a later cluster.
+		// A cluster whose closest was one of the merged clusters is
+		// rescanned, the others only compare with the new distance.
+		findClosestAfter(cluster1);
+		for (int other = 0; other < cluster2; other++) {
+			if (!active[other] || other == cluster1)
+				continue;
+
+			int current = closestAfter[other];
+			if (current == cluster1 || current == cluster2)
+				findClosestAfter(other);
+			else if (other < cluster1) {
+				const double* row = &clusterDistances[(size_t) other * recordCount];
+				if (current < 0 || row[cluster1] < row[current] || (row[cluster1] == row[current] && cluster1 < current))
+					closestAfter[other] = cluster1;
+			}
+		}
+	}
+}
+
+// mergeProfiles(Profile& profile1, Profile& profile2, Profile& merged)
+//  Purpose:
+//		Globally aligns the columns of the two profiles and puts the
+//		aligned rows of both in merged.  A column replaces the current
+//		best only if it is strictly better, trying the column of both
+//		profiles first, then profile1's column with gaps, then
+//		profile2's column with gaps.
+void ProgressiveAligner::mergeProfiles(Profile& profile1, Profile& profile2, Profile& merged) {
+	int indexCount = matrix->getIndexCount();
+	int gapIndex = matrix->getGapIndex();
+	int length1 = profile1.rows[0].length();
+	int length2 = profile2.rows[0].length();
+	long long rowCount1 = profile1.rows.size();
+	long long rowCount2 = profile2.rows.size();
+
+	vector<int> counts1;
+	vector<int> counts2;
+	columnCounts(profile1, counts1);
+	columnCounts(profile2, counts2);
+
+	// For each column of profile2, the score of each residue against it
+	vector<long long> weights2((size_t) length2 * indexCount, 0);
+	for (int column = 0; column < length2; column++) {
+		const int* counts = &counts2[(size_t) column * indexCount];
+		long long* weights = &weights2[(size_t) column * indexCount];
+		for (int index2 = 0; index2 < indexCount; index2++) {
+			if (counts[index2] == 0)
+				continue;
+			const int* scores = matrix->scoreRow(index2);
+			for (int index1 = 0; index1 < indexCount; index1++)
+				weights[index1] += (long long) counts[index2] * scores[index1];
+		}
+	}
+
+	// The columns of profile1 only list the indexes they have
+	vector<int> sparseStarts(length1 + 1, 0);
+	vector<int> sparseIndexes;
+	vector<int> sparseCounts;
+	vector<long long> gapWeights1(length1 + 1, 0);  // column of profile1 against gaps
+	for (int column = 0; column < length1; column++) {
+		const int* counts = &counts1[(size_t) column * indexCount];
+		for (int index1 = 0; index1 < indexCount; index1++) {
+			if (counts[index1] == 0)
+				continue;
+			sparseIndexes.push_back(index1);
+			sparseCounts.push_back(counts[index1]);
+			gapWeights1[column + 1] += (long long) counts[index1] * matrix->getScoreByIndex(index1, gapIndex) * rowCount2;
+		}
+		sparseStarts[column + 1] = sparseIndexes.size();
+	}
+
+	vector<long long> gapWeights2(length2 + 1, 0);  // column of profile2 against gaps
+	for (int column = 0; column < length2; column++)
+		gapWeights2[column + 1] = weights2[(size_t) column * indexCount + gapIndex] * rowCount1;
+
+	// Moves: 0 = both columns, 1 = column of profile1, 2 = column of profile2
+	size_t rowLength = length2 + 1;
+	vector<unsigned char> moves((size_t) (length1 + 1) * rowLength);
+	vector<long long> previous(rowLength);
+	vector<long long> current(rowLength);
+
+	previous[0] = 0;
+	for (int loc2 = 1; loc2 <= length2; loc2++) {
+		previous[loc2] = previous[loc2 - 1] + gapWeights2[loc2];
+		moves[loc2] = 2;
+	}
+
+	for (int loc1 = 1; loc1 <= length1; loc1++) {
+		unsigned char* rowMoves = &moves[loc1 * rowLength];
+		current[0] = previous[0] + gapWeights1[loc1];
+		rowMoves[0] = 1;
+
+		int sparseStart = sparseStarts[loc1 - 1];
+		int sparseEnd = sparseStarts[loc1];
+		for (int loc2 = 1; loc2 <= length2; loc2++) {
+			const long long* weights = &weights2[(size_t) (loc2 - 1) * indexCount];
+			long long columnWeight = 0;
+			for (int sparse = sparseStart; sparse < sparseEnd; sparse++)
+				columnWeight += sparseCounts[sparse] * weights[sparseIndexes[sparse]];
+
+			long long best = previous[loc2 - 1] + columnWeight;
+			unsigned char move = 0;
+
+			long long weight = previous[loc2] + gapWeights1[loc1];
+			if (weight > best) {
+				best = weight;
+				move = 1;
+			}
+
+			weight = current[loc2 - 1] + gapWeights2[loc2];
+			if (weight > best) {
+				best = weight;
+				move = 2;
+			}
+
+			current[loc2] = best;
+			rowMoves[loc2] = move;
+		}
+
+		previous.swap(current);
+	}
+
+	// Walk the moves back, building the merged rows backwards
+	merged.members = profile1.members;
+	merged.members.insert(merged.members.end(), profile2.members.begin(), profile2.members.end());
+	merged.rows.assign(rowCount1 + rowCount2, string());
+
+	int loc1 = length1;
+	int loc2 = length2;
+	while (loc1 > 0 || loc2 > 0) {
+		unsigned char move = moves[loc1 * rowLength + loc2];
+		bool takes1 = (move != 2);
+		bool takes2 = (move != 1);
+
+		for (int row = 0; row < rowCount1; row++)
+			merged.rows[row].push_back(takes1 ? profile1.rows[row][loc1 - 1] : gapChar);
+		for (int row = 0; row < rowCount2; row++)
+			merged.rows[rowCount1 + row].push_back(takes2 ? profile2.rows[row][loc2 - 1] : gapChar);
+
+		if (takes1)
+			loc1--;
+		if (takes2)
+			loc2--;
+	}
+
+	for (size_t row = 0; row < merged.rows.size(); row++)
+		reverse(merged.rows[row].begin(), merged.rows[row].end());
+}
+
+// columnCounts(Profile& profile, vector<int>& counts)
+//  Purpose:
+//		Counts the residues (and gaps) of each column of the profile,
+//		counts[column * matrix->getIndexCount() + index]
+void ProgressiveAligner::columnCounts(Profile& profile, vector<int>& counts) {
+	int indexCount = matrix->getIndexCount();
+	size_t length = profile.rows[0].length();
+
+	counts.assign(length * indexCount, 0);
+	for (size_t row = 0; row < profile.rows.size(); row++) {
+		const string& sequence = profile.rows[row];
+		for (size_t column = 0; column < length; column++)
+			counts[column * indexCount + matrix->residueIndex(sequence[column])]++;
+	}
+}
+
+// long long sumOfPairsScore()
+//  Purpose:
+//		Returns the sum of pairs score of all of the columns of alignment
+long long ProgressiveAligner::sumOfPairsScore() {
+	if (alignment.empty())
+		return 0;
+
+	Profile all;
+	all.rows = alignment;
+
+	vector<int> counts;
+	columnCounts(all, counts);
+
+	int indexCount = matrix->getIndexCount();
+	size_t length = alignment[0].length();
+
+	long long total = 0;
+	for (size_t column = 0; column < length; column++) {
+		const int* columnCounts = &counts[column * indexCount];
+		for (int index1 = 0; index1 < indexCount; index1++) {
+			long long count1 = columnCounts[index1];
+			if (count1 == 0)
+				continue;
+
+			// Pairs of the same residue, then pairs with the later residues
+			total += count1 * (count1 - 1) / 2 * matrix->getScoreByIndex(index1, index1);
+			for (int index2 = index1 + 1; index2 < indexCount; index2++)
+				total += count1 * columnCounts[index2] * matrix->getScoreByIndex(index1, index2);
+		}
+	}
+
+	return total;
+}
+
+// string newick(int node)
+//  Purpose:
+//		Returns the guide tree under node in Newick format (without the
+//		closing ';')
+string ProgressiveAligner::newick(int node) {
+	string tree;
+
+	// Walk the tree with a stack rather than recursion, as a tree built
+	// by adding one record at a time is as deep as there are records.
+	// The stage of a node is how many of its children have been started.
+	vector<pair<int, int> > stack(1, make_pair(node, 0));
+	while (!stack.empty()) {
+		int current = stack.back().first;
+		int stage = stack.back().second;
+
+		if (guideTree[current].left < 0) {
+			tree += records[current]->getFileName();
+			stack.pop_back();
+		}
+		else if (stage == 0) {
+			tree += '(';
+			stack.back().second = 1;
+			stack.push_back(make_pair(guideTree[current].left, 0));
+		}
+		else if (stage == 1) {
+			tree += ',';
+			stack.back().second = 2;
+			stack.push_back(make_pair(guideTree[current].right, 0));
+		}
+		else {
+			tree += ')';
+			stack.pop_back();
+		}
+	}
+
+	return tree;
+}
@@ -0,0 +1,184 @@
+/*
+ * ProgressiveAligner.h
+ *
+ *	This is the header file for the ProgressiveAligner object. The
+ *  ProgressiveAligner builds a multiple alignment of all of the records
+ *  of a multi-record fasta file.  The exact dynamic program grows as n^k
+ *  for k sequences, so for more than three sequences the alignment is
+ *  built progressively:
+ *
+ *	  1. The distance between each pair of sequences is found from the
+ *		 weight of their highest weight path with the PairwiseAligner (the
+ *		 2D version of the ThreeWayAligner's dynamic program):
+ *			distance = 1 - score / min(self score 1, self score 2)
+ *		 The pairs are spread over setThreadCount() threads.
+ *
+ *	  2. A guide tree is built from the distances with UPGMA.
+ *
+ *	  3. Going up the guide tree, the profiles (alignments) of the two
+ *		 children of each node are merged with a global alignment of their
+ *		 columns.  Two columns are scored with the sum of pairs score of
+ *		 all of the pairs of residues between them, the same scoring the
+ *		 edit graph uses for the columns of three sequences.
+ *
+ *  The score of the alignment is the sum of pairs score of all of its
+ *  columns.  Three records are aligned the same way (the ThreeWayAligner
+ *  finds a highest weight path, which need not cover the full sequences,
+ *  so it is not a multiple alignment).
+ *
+ *  The all pairs distances and the guide tree (UPGMA keeping the closest
+ *  cluster of each cluster) grow as the square of the number of sequences,
+ *  each merge is a 2D dynamic program over the two profiles.
+ *
+ *  Typical Use:
+ *		ProgressiveAligner aligner(fastaFileName);
+ *		aligner.setThreadCount(8);
+ *		aligner.align();
+ *		cout << aligner.resultString();
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef PROGRESSIVEALIGNER_H
+#define PROGRESSIVEALIGNER_H
+
+#include "FastaFile.h"
+#include "ScoringMatrix.h"
+#include <string>
+#include <vector>
+using namespace std;
+
+class ProgressiveAligner
+{
+public:
+
+	// Constuctors
+	// ==============================================
+
+	// Reads the records of the fasta file, each record is named by the
+	// first word of its header
+	ProgressiveAligner(const string& aFastaFileName);
+
+	// Destructor
+	// =============================================
+	virtual ~ProgressiveAligner();
+
+	// Public Methods
+	// =============================================
+
+	// align()
+	//  Purpose:
+	//		Builds the multiple alignment of the records (see the class
+	//		header).  Throws out_of_range if a sequence has a char that is
+	//		not a residue of the matrix.
+	//  Postconditions:
+	//		- alignment, score and guideTree will be set
+	void align();
+
+	// string resultString()
+	//  Purpose:
+	//		Returns an XML formatted string representing the results of the
+	//		align() function.
+	//
+	//		format:
+	//			<results type="progressive" file=" <<fastaFileName>> ">";
+	//			  <result type="sequence_count"> <<number of records>> </result>
+	//			  <result type="guide_tree"> <<guide tree in Newick format>> </result>
+	//			  <result type="score"> <<sum of pairs score of the alignment>> </result>
+	//			  <result type="alignment">
+	//				<<record name>> <<aligned sequence>>
+	//				...
+	//			  </result>
+	//			</results>
+	//  Preconditions:
+	//		align() has been run
+	string resultString();
+
+	// Public Accessors
+	// =============================================
+	long long getScore();  // sum of pairs score of the alignment
+	const vector<string>& getAlignment();  // aligned sequences, in the order of the records
+	void setScoringMatrix(const ScoringMatrix* aMatrix);  // matrix to score with (NULL = BLOSUM62)
+	void setThreadCount(unsigned int aThreadCount);  // threads used for the pairwise distances
+
+private:
+
+	// Attributes
+	// =============================================
+
+	// An alignment of some of the records, rows[r] is the aligned
+	// sequence of records[members[r]]
+	struct Profile {
+		vector<int> members;
+		vector<string> rows;
+	};
+
+	// A node of the guide tree, the first records.size() nodes are the
+	// records and the rest are merges of two earlier nodes
+	struct TreeNode {
+		int left;  // -1 for a record
+		int right;
+		int size;  // records under the node
+	};
+
+	char gapChar;
+	string fastaFileName;
+	vector<FastaFile*> records;
+	const ScoringMatrix* matrix;
+	unsigned int threadCount;
+	vector<double> distances;  // distance between records i and j at [i * records.size() + j]
+	vector<TreeNode> guideTree;
+	vector<string> alignment;
+	long long score;
+
+	// Private Methods
+	// =============================================
+
+	// findDistances()
+	//  Purpose:
+	//		Finds the distance between each pair of records
+	//  Postconditions:
+	//		- distances will be set
+	void findDistances();
+
+	// buildGuideTree()
+	//  Purpose:
+	//		Builds the guide tree from the distances with UPGMA, ties are
+	//		broken by taking the first pair of clusters.  The closest later
+	//		cluster of each cluster is kept, so finding the closest pair is a
+	//		scan of the clusters, and after a merge only the clusters whose
+	//		closest cluster was merged are rescanned (O(n^2) overall unless
+	//		many clusters have the same closest cluster).
+	//  Postconditions:
+	//		- guideTree will be set, the root is its last node
+	void buildGuideTree();
+
+	// mergeProfiles(Profile& profile1, Profile& profile2, Profile& merged)
+	//  Purpose:
+	//		Globally aligns the columns of the two profiles and puts the
+	//		aligned rows of both in merged.  A column replaces the current
+	//		best only if it is strictly better, trying the column of both
+	//		profiles first, then profile1's column with gaps, then
+	//		profile2's column with gaps.
+	void mergeProfiles(Profile& profile1, Profile& profile2, Profile& merged);
+
+	// columnCounts(Profile& profile, vector<int>& counts)
+	//  Purpose:
+	//		Counts the residues (and gaps) of each column of the profile,
+	//		counts[column * matrix->getIndexCount() + index]
+	void columnCounts(Profile& profile, vector<int>& counts);
+
+	// long long sumOfPairsScore()
+	//  Purpose:
+	//		Returns the sum of pairs score of all of the columns of alignment
+	long long sumOfPairsScore();
+
+	// string newick(int node)
+	//  Purpose:
+	//		Returns the guide tree under node in Newick format (without the
+	//		closing ';')
+	string newick(int node);
+};
+
+#endif // PROGRESSIVEALIGNER_H
@@ -0,0 +1,173 @@
+/*
+ * ResultCache.cpp
+ *
+ *	This is the cpp file for the ResultCache object. The ResultCache
+ *  keeps the results of alignments on disk, in files named by a hash of
+ *  what the results depend on (which is kept with the result and checked).
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "ResultCache.h"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+// Constuctors
+// ==============================================
+ResultCache::Key::Key() {
+	value = 14695981039346656037ULL;  // FNV-1a offset basis
+}
+
+ResultCache::ResultCache(const string& aDirectory) {
+	directory = aDirectory;
+	hits = 0;
+	misses = 0;
+	storeCount = 0;
+
+	// An existing directory is fine
+	mkdir(directory.c_str(), 0777);
+}
+
+// Destructor
+// =============================================
+ResultCache::~ResultCache() {
+}
+
+// Public Methods
+// =============================================
+
+// Key::add(...)
+//  Purpose:
+//		Adds the length and then the bytes of the value to the key
+void ResultCache::Key::add(string_view bytes) {
+	add(bytes.data(), bytes.length());
+}
+
+void ResultCache::Key::add(const void* data, size_t length) {
+	uint64_t byteCount = length;
+	addBytes(&byteCount, sizeof(byteCount));
+	addBytes(data, length);
+}
+
+void ResultCache::Key::add(long long value) {
+	add(&value, sizeof(value));
+}
+
+uint64_t ResultCache::Key::getValue() {
+	return value;
+}
+
+const string& ResultCache::Key::getMaterial() {
+	return material;
+}
+
+// bool find(Key& key, Entry& entry)
+//  Purpose:
+//		Reads the result with the key into entry.  Returns false if there
+//		is no (complete) result with the same key material.
+bool ResultCache::find(Key& key, Entry& entry) {
+	ifstream file(fileNameFor(key.getValue()), ios::binary);
+
+	// Check the header line
+	string line;
+	string magic;
+	uint64_t fileKey = 0;
+	int exact = 0;
+	size_t materialLength = 0;
+	size_t length = 0;
+	bool found = false;
+	if (file && getline(file, line)) {
+		stringstream ss(line);
+		found = (ss >> magic >> hex >> fileKey >> dec >> entry.score >> exact >> materialLength >> length) &&
+			magic == "wdaresult2" && fileKey == key.getValue() &&
+			materialLength == key.getMaterial().length();
+	}
+
+	// Check the key material, the hash alone may collide
+	if (found) {
+		string material(materialLength, '\0');
+		found = file.read(&material[0], materialLength) && material == key.getMaterial();
+	}
+
+	// Read the result text
+	if (found) {
+		entry.exact = (exact != 0);
+		entry.result.resize(length);
+		found = (bool) file.read(&entry.result[0], length);
+	}
+
+	if (found)
+		hits++;
+	else
+		misses++;
+
+	return found;
+}
+
+// store(Key& key, const Entry& entry)
+//  Purpose:
+//		Writes the result and its key material, replacing any result
+//		already in the file for the key's hash.  Nothing is written if
+//		the file can not be written.
+void ResultCache::store(Key& key, const Entry& entry) {
+	string fileName = fileNameFor(key.getValue());
+
+	// Write a temporary file (named for this process and store), then rename it into place
+	stringstream tempName;
+	tempName << fileName << ".tmp." << getpid() << "." << storeCount++;
+
+	ofstream file(tempName.str(), ios::binary);
+	file
+		<< "wdaresult2 " << hex << key.getValue() << dec << " " << entry.score << " "
+		<< (entry.exact ? 1 : 0) << " " << key.getMaterial().length() << " "
+		<< entry.result.length() << "\n"
+		<< key.getMaterial() << entry.result;
+	file.close();
+
+	if (!file || rename(tempName.str().c_str(), fileName.c_str()) != 0)
+		remove(tempName.str().c_str());
+}
+
+// Public Accessors
+// =============================================
+const string& ResultCache::getDirectory() {
+	return directory;
+}
+
+uint64_t ResultCache::getHits() {
+	return hits;
+}
+
+uint64_t ResultCache::getMisses() {
+	return misses;
+}
+
+// Private Methods
+// =============================================
+
+// Key::addBytes(const void* data, size_t length)
+//  Purpose:
+//		Adds the bytes to the key material and its FNV-1a hash
+void ResultCache::Key::addBytes(const void* data, size_t length) {
+	const unsigned char* bytes = (const unsigned char*) data;
+	material.append((const char*) data, length);
+	for (size_t byte = 0; byte < length; byte++) {
+		value ^= bytes[byte];
+		value *= 1099511628211ULL;  // FNV prime
+	}
+}
+
+// string fileNameFor(uint64_t key)
+//  Purpose:
+//		Returns the name of the file the result with the key is kept in
+string ResultCache::fileNameFor(uint64_t key) {
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", (unsigned long long) key);
+
+	return directory + "/" + name + ".result";
+}
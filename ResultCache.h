@@ -0,0 +1,142 @@
+/*
+ * ResultCache.h
+ *
+ *	This is the header file for the ResultCache object. The ResultCache
+ *  keeps the results of alignments on disk, so an alignment that has been
+ *  done before (by this or an earlier run) does not have to be done again.
+ *
+ *  The results are content addressed: the key of a result is a 64 bit
+ *  FNV-1a hash (see Key) of everything the result depends on, i.e. the
+ *  three sequences, the scores of the scoring matrix (which include the
+ *  gap cost) and the options that change the result.  File names are not
+ *  part of the key, so the same sequences read from different files share
+ *  a result.  The hash only names the file: the bytes that were hashed
+ *  (the key material) are kept with the result and compared on lookup, so
+ *  two results whose hashes collide are never mistaken for each other.
+ *
+ *  Each result is kept in a file of its own in the cache directory, named
+ *  after its key in hex:
+ *
+ *		<<directory>>/<<key>>.result
+ *
+ *  The file starts with a line holding the hash, the score, whether the
+ *  result is exact and the lengths of the key material and the result
+ *  text, followed by the key material and the result text.  A file whose
+ *  key material does not match the key, or that is cut short, is treated
+ *  as a miss (and is replaced when the result is stored).  Results are written to a temporary file and then
+ *  renamed, so threads and processes sharing a cache directory never see
+ *  a partly written result.
+ *
+ *  The cache is best effort: if the directory can not be created or a
+ *  result can not be written, the alignment is simply not cached.
+ *
+ *  Typical Use:
+ *		ResultCache cache("align_cache");
+ *		ResultCache::Key key;
+ *		key.add(sequence1);
+ *		...
+ *		if (!cache.find(key, entry)) {
+ *			... align ...
+ *			cache.store(key, entry);
+ *		}
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+using namespace std;
+
+class ResultCache
+{
+public:
+
+	// Builds the key of a result: the key material (every value added,
+	// each preceded by its length, so different splits of the same bytes
+	// give different keys) and its FNV-1a hash.
+	class Key
+	{
+	public:
+		Key();
+
+		void add(string_view bytes);
+		void add(const void* data, size_t length);
+		void add(long long value);
+
+		uint64_t getValue();  // the hash of the key material
+		const string& getMaterial();  // the bytes added
+
+	private:
+		uint64_t value;
+		string material;
+
+		void addBytes(const void* data, size_t length);
+	};
+
+	// A cached result
+	struct Entry {
+		int score;  // score of the highest weight path
+		bool exact;  // the path is known to be the highest weight path
+		string result;  // the result text (without the results header and footer)
+	};
+
+	// Constuctors
+	// ==============================================
+	ResultCache(const string& aDirectory);  // the directory is created if needed
+
+	// Destructor
+	// =============================================
+	virtual ~ResultCache();
+
+	// Public Methods
+	// =============================================
+
+	// bool find(Key& key, Entry& entry)
+	//  Purpose:
+	//		Reads the result with the key into entry.  Returns false if there
+	//		is no (complete) result with the same key material.
+	bool find(Key& key, Entry& entry);
+
+	// store(Key& key, const Entry& entry)
+	//  Purpose:
+	//		Writes the result and its key material, replacing any result
+	//		already in the file for the key's hash.  Nothing is written if
+	//		the file can not be written.
+	void store(Key& key, const Entry& entry);
+
+	// Public Accessors
+	// =============================================
+	const string& getDirectory();
+	uint64_t getHits();  // results found by find()
+	uint64_t getMisses();  // results not found by find()
+
+private:
+
+	// Attributes
+	// =============================================
+	string directory;
+	atomic<uint64_t> hits;
+	atomic<uint64_t> misses;
+	atomic<uint64_t> storeCount;  // used to name the temporary files
+
+	// A cache may be shared by threads, but not copied
+	ResultCache(const ResultCache&) = delete;
+	ResultCache& operator=(const ResultCache&) = delete;
+
+	// Private Methods
+	// =============================================
+
+	// string fileNameFor(uint64_t key)
+	//  Purpose:
+	//		Returns the name of the file the result with the key is kept in
+	string fileNameFor(uint64_t key);
+};
+
+#endif // RESULTCACHE_H
@@ -0,0 +1,265 @@
+/*
+ * ScoreRowKernel.cpp
+ *
+ *	This is the cpp file for the ScoreRowKernel object. The
+ *  ScoreRowKernel fills a row of the 3-way score tensor: the cells
+ *  (i, j, k) for a run of k with i and j fixed (and all three > 0).
+ *
+ *  The AVX2 and AVX-512 versions are compiled with target attributes, so
+ *  no special compiler flags are needed, and are only called if the CPU
+ *  supports them.  On other platforms only the scalar version is built.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "ScoreRowKernel.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SCOREROWKERNEL_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Class Attribute Initialization
+// ==============================================
+const int ScoreRowKernel::chunkSize;
+
+// Public Class Methods
+// =============================================
+
+// fillRow(const ScoreRow& row, int count)
+//  Purpose:
+//		Fills the scores and moves for count cells of the row.
+//  Preconditions:
+//		scores[-1] holds the score of the cell before the row
+void ScoreRowKernel::fillRow(const ScoreRow& row, int count) {
+	int bestScores[chunkSize];
+	int bestMoves[chunkSize];
+
+	InstructionSet instructionSet = currentInstructionSet();
+	int previousScore = row.scores[-1];
+
+	for (int first = 0; first < count; first += chunkSize) {
+		int chunkCount = (count - first < chunkSize) ? count - first : chunkSize;
+
+		// Moves 7 to 2 only depend on rows that are already filled
+		if (instructionSet == avx512)
+			bestOfPreviousRowsAvx512(row, first, chunkCount, bestScores, bestMoves);
+		else if (instructionSet == avx2)
+			bestOfPreviousRowsAvx2(row, first, chunkCount, bestScores, bestMoves);
+		else
+			bestOfPreviousRowsScalar(row, first, chunkCount, bestScores, bestMoves);
+
+		// Move 1 depends on the cell before, so walk along the row
+		for (int t = 0; t < chunkCount; t++) {
+			int pathWeight = previousScore + row.weights1[first + t];
+			int score = bestScores[t];
+			unsigned char move = (unsigned char) bestMoves[t];
+			if (pathWeight > score) {
+				score = pathWeight;
+				move = 1;
+			}
+
+			row.scores[first + t] = score;
+			row.moves[first + t] = move;
+			previousScore = score;
+		}
+	}
+}
+
+// Public Class Accessors
+// =============================================
+ScoreRowKernel::InstructionSet ScoreRowKernel::getInstructionSet() {
+	return currentInstructionSet();
+}
+
+void ScoreRowKernel::setInstructionSet(InstructionSet anInstructionSet) {
+	currentInstructionSet() = anInstructionSet;
+}
+
+string ScoreRowKernel::instructionSetName(InstructionSet anInstructionSet) {
+	switch (anInstructionSet) {
+		case avx512:
+			return "avx512";
+		case avx2:
+			return "avx2";
+		default:
+			return "scalar";
+	}
+}
+
+// Private Class Methods
+// =============================================
+
+// InstructionSet& currentInstructionSet()
+//  Purpose:
+//		Returns the instruction set in use, the first time it is called
+//		the best one the CPU supports is picked.
+ScoreRowKernel::InstructionSet& ScoreRowKernel::currentInstructionSet() {
+	static InstructionSet instructionSet = [] {
+#ifdef SCOREROWKERNEL_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f"))
+			return avx512;
+		if (__builtin_cpu_supports("avx2"))
+			return avx2;
+#endif
+		return scalar;
+	}();
+
+	return instructionSet;
+}
+
+// bestOfPreviousRows...(const ScoreRow& row, int first, int count,
+//		int* bestScores, int* bestMoves)
+//  Purpose:
+//		For count cells starting at element first of the row, finds the
+//		best of the trivial path and moves 7 to 2 (the ones that start in
+//		other rows).  One version for each instruction set.
+void ScoreRowKernel::bestOfPreviousRowsScalar(const ScoreRow& row, int first, int count,
+	int* bestScores, int* bestMoves) {
+
+	for (int t = 0; t < count; t++) {
+		int k = first + t;
+
+		// Candidate weights in the order the moves are tried
+		int pathWeights[6] = {
+			row.seq1Seq2Previous[k - 1] + row.weights7[k],
+			row.seq1Seq2Previous[k] + row.weight6,
+			row.seq1Previous[k - 1] + row.weights5[k],
+			row.seq1Previous[k] + row.weight4,
+			row.seq2Previous[k - 1] + row.weights3[k],
+			row.seq2Previous[k] + row.weight2
+		};
+
+		// Start with the trivial path of starting at this cell
+		int score = 0;
+		int move = 0;
+		for (int candidate = 0; candidate < 6; candidate++) {
+			if (pathWeights[candidate] > score) {
+				score = pathWeights[candidate];
+				move = 7 - candidate;
+			}
+		}
+
+		bestScores[t] = score;
+		bestMoves[t] = move;
+	}
+}
+
+#ifdef SCOREROWKERNEL_X86
+
+__attribute__((target("avx2")))
+void ScoreRowKernel::bestOfPreviousRowsAvx2(const ScoreRow& row, int first, int count,
+	int* bestScores, int* bestMoves) {
+
+	const __m256i weight6 = _mm256_set1_epi32(row.weight6);
+	const __m256i weight4 = _mm256_set1_epi32(row.weight4);
+	const __m256i weight2 = _mm256_set1_epi32(row.weight2);
+
+	int t = 0;
+	for (; t + 8 <= count; t += 8) {
+		int k = first + t;
+		__m256i score = _mm256_setzero_si256();
+		__m256i move = _mm256_setzero_si256();
+
+		// Take the candidate if it is strictly better (same order as scalar)
+		#define SCOREROWKERNEL_TRY_AVX2(pathWeight, moveValue) { \
+			__m256i candidate = (pathWeight); \
+			__m256i better = _mm256_cmpgt_epi32(candidate, score); \
+			score = _mm256_blendv_epi8(score, candidate, better); \
+			move = _mm256_blendv_epi8(move, _mm256_set1_epi32(moveValue), better); \
+		}
+
+		SCOREROWKERNEL_TRY_AVX2(_mm256_add_epi32(
+			_mm256_loadu_si256((const __m256i*) (row.seq1Seq2Previous + k - 1)),
+			_mm256_loadu_si256((const __m256i*) (row.weights7 + k))), 7);
+		SCOREROWKERNEL_TRY_AVX2(_mm256_add_epi32(
+			_mm256_loadu_si256((const __m256i*) (row.seq1Seq2Previous + k)), weight6), 6);
+		SCOREROWKERNEL_TRY_AVX2(_mm256_add_epi32(
+			_mm256_loadu_si256((const __m256i*) (row.seq1Previous + k - 1)),
+			_mm256_loadu_si256((const __m256i*) (row.weights5 + k))), 5);
+		SCOREROWKERNEL_TRY_AVX2(_mm256_add_epi32(
+			_mm256_loadu_si256((const __m256i*) (row.seq1Previous + k)), weight4), 4);
+		SCOREROWKERNEL_TRY_AVX2(_mm256_add_epi32(
+			_mm256_loadu_si256((const __m256i*) (row.seq2Previous + k - 1)),
+			_mm256_loadu_si256((const __m256i*) (row.weights3 + k))), 3);
+		SCOREROWKERNEL_TRY_AVX2(_mm256_add_epi32(
+			_mm256_loadu_si256((const __m256i*) (row.seq2Previous + k)), weight2), 2);
+
+		#undef SCOREROWKERNEL_TRY_AVX2
+
+		_mm256_storeu_si256((__m256i*) (bestScores + t), score);
+		_mm256_storeu_si256((__m256i*) (bestMoves + t), move);
+	}
+
+	// Finish the cells that do not fill a vector
+	if (t < count)
+		bestOfPreviousRowsScalar(row, first + t, count - t, bestScores + t, bestMoves + t);
+}
+
+__attribute__((target("avx512f")))
+void ScoreRowKernel::bestOfPreviousRowsAvx512(const ScoreRow& row, int first, int count,
+	int* bestScores, int* bestMoves) {
+
+	const __m512i weight6 = _mm512_set1_epi32(row.weight6);
+	const __m512i weight4 = _mm512_set1_epi32(row.weight4);
+	const __m512i weight2 = _mm512_set1_epi32(row.weight2);
+
+	int t = 0;
+	for (; t + 16 <= count; t += 16) {
+		int k = first + t;
+		__m512i score = _mm512_setzero_si512();
+		__m512i move = _mm512_setzero_si512();
+
+		// Take the candidate if it is strictly better (same order as scalar)
+		#define SCOREROWKERNEL_TRY_AVX512(pathWeight, moveValue) { \
+			__m512i candidate = (pathWeight); \
+			__mmask16 better = _mm512_cmpgt_epi32_mask(candidate, score); \
+			score = _mm512_mask_mov_epi32(score, better, candidate); \
+			move = _mm512_mask_mov_epi32(move, better, _mm512_set1_epi32(moveValue)); \
+		}
+
+		SCOREROWKERNEL_TRY_AVX512(_mm512_add_epi32(
+			_mm512_loadu_si512(row.seq1Seq2Previous + k - 1),
+			_mm512_loadu_si512(row.weights7 + k)), 7);
+		SCOREROWKERNEL_TRY_AVX512(_mm512_add_epi32(
+			_mm512_loadu_si512(row.seq1Seq2Previous + k), weight6), 6);
+		SCOREROWKERNEL_TRY_AVX512(_mm512_add_epi32(
+			_mm512_loadu_si512(row.seq1Previous + k - 1),
+			_mm512_loadu_si512(row.weights5 + k)), 5);
+		SCOREROWKERNEL_TRY_AVX512(_mm512_add_epi32(
+			_mm512_loadu_si512(row.seq1Previous + k), weight4), 4);
+		SCOREROWKERNEL_TRY_AVX512(_mm512_add_epi32(
+			_mm512_loadu_si512(row.seq2Previous + k - 1),
+			_mm512_loadu_si512(row.weights3 + k)), 3);
+		SCOREROWKERNEL_TRY_AVX512(_mm512_add_epi32(
+			_mm512_loadu_si512(row.seq2Previous + k), weight2), 2);
+
+		#undef SCOREROWKERNEL_TRY_AVX512
+
+		_mm512_storeu_si512(bestScores + t, score);
+		_mm512_storeu_si512(bestMoves + t, move);
+	}
+
+	// Finish the cells that do not fill a vector
+	if (t < count)
+		bestOfPreviousRowsScalar(row, first + t, count - t, bestScores + t, bestMoves + t);
+}
+
+#else
+
+// Without x86 SIMD support the vector versions are never picked
+void ScoreRowKernel::bestOfPreviousRowsAvx2(const ScoreRow& row, int first, int count,
+	int* bestScores, int* bestMoves) {
+	bestOfPreviousRowsScalar(row, first, count, bestScores, bestMoves);
+}
+
+void ScoreRowKernel::bestOfPreviousRowsAvx512(const ScoreRow& row, int first, int count,
+	int* bestScores, int* bestMoves) {
+	bestOfPreviousRowsScalar(row, first, count, bestScores, bestMoves);
+}
+
+#endif
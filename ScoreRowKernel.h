@@ -0,0 +1,110 @@
+/*
+ * ScoreRowKernel.h
+ *
+ *	This is the header file for the ScoreRowKernel object. The
+ *  ScoreRowKernel fills a row of the 3-way score tensor: the cells
+ *  (i, j, k) for a run of k with i and j fixed (and all three > 0).
+ *
+ *  Each cell takes the best of the trivial path (weight 0) and the seven
+ *  edge types of the edit graph (see WDAGraphFileBuilder), tried in the
+ *  order 7 down to 1 with an edge only winning when it is strictly better.
+ *  Six of the edges start in rows that are already filled, so they are
+ *  computed for many k at a time with SIMD instructions (AVX2 or AVX-512,
+ *  picked at run time from what the CPU supports).  The last edge type
+ *  (only seq3 advances) starts at the cell before in the same row, so it
+ *  is added in a scalar pass along the row.  Scores are 32 bit ints, the
+ *  scalar version gives exactly the same scores and moves.
+ *
+ *  Note that this class is implemented statically, so there is no need to
+ *  instantiate it.
+ *
+ *  Typical Use:
+ *		ScoreRowKernel::ScoreRow row;
+ *		row.seq1Seq2Previous = ...;
+ *		...
+ *		ScoreRowKernel::fillRow(row, count);
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef SCOREROWKERNEL_H
+#define SCOREROWKERNEL_H
+
+#include <string>
+using namespace std;
+
+class ScoreRowKernel
+{
+public:
+
+	// The inputs and outputs for a row of count cells, starting at k.
+	// Element t of each array is for the cell (i, j, k + t), and element -1
+	// of the score arrays (the cell at k - 1) must be readable.
+	struct ScoreRow {
+		const int* seq1Seq2Previous;  // scores of row (i-1, j-1)
+		const int* seq1Previous;  // scores of row (i-1, j)
+		const int* seq2Previous;  // scores of row (i, j-1)
+		const int* weights7;  // weight of the edge for move 7 (all advance) into each cell
+		const int* weights5;  // move 5 (seq1 and seq3 advance)
+		const int* weights3;  // move 3 (seq2 and seq3 advance)
+		const int* weights1;  // move 1 (seq3 advances)
+		int weight6;  // move 6 (seq1 and seq2 advance), the same for the whole row
+		int weight4;  // move 4 (seq1 advances)
+		int weight2;  // move 2 (seq2 advances)
+		int* scores;  // scores of row (i, j), filled in
+		unsigned char* moves;  // move used for each cell of row (i, j), filled in
+	};
+
+	// Instruction sets a kernel can be built for
+	enum InstructionSet { scalar, avx2, avx512 };
+
+	// Public Class Methods
+	// =============================================
+
+	// fillRow(const ScoreRow& row, int count)
+	//  Purpose:
+	//		Fills the scores and moves for count cells of the row.
+	//  Preconditions:
+	//		scores[-1] holds the score of the cell before the row
+	static void fillRow(const ScoreRow& row, int count);
+
+	// Public Class Accessors
+	// =============================================
+	static InstructionSet getInstructionSet();  // instruction set fillRow() uses
+	static void setInstructionSet(InstructionSet anInstructionSet);  // force an instruction set (must be supported by the CPU)
+	static string instructionSetName(InstructionSet anInstructionSet);
+
+private:
+
+	// Class Attributes
+	// =============================================
+
+	// Cells done in each pass of fillRow(), so the vector results fit in
+	// arrays on the stack
+	static const int chunkSize = 256;
+
+	// Private Class Methods
+	// =============================================
+
+	// InstructionSet& currentInstructionSet()
+	//  Purpose:
+	//		Returns the instruction set in use, the first time it is called
+	//		the best one the CPU supports is picked.
+	static InstructionSet& currentInstructionSet();
+
+	// bestOfPreviousRows...(const ScoreRow& row, int first, int count,
+	//		int* bestScores, int* bestMoves)
+	//  Purpose:
+	//		For count cells starting at element first of the row, finds the
+	//		best of the trivial path and moves 7 to 2 (the ones that start in
+	//		other rows).  One version for each instruction set.
+	static void bestOfPreviousRowsScalar(const ScoreRow& row, int first, int count,
+		int* bestScores, int* bestMoves);
+	static void bestOfPreviousRowsAvx2(const ScoreRow& row, int first, int count,
+		int* bestScores, int* bestMoves);
+	static void bestOfPreviousRowsAvx512(const ScoreRow& row, int first, int count,
+		int* bestScores, int* bestMoves);
+};
+
+#endif // SCOREROWKERNEL_H
@@ -0,0 +1,341 @@
+/*
+ * ScoringMatrix.cpp
+ *
+ *	This is the cpp file for the ScoringMatrix object. A ScoringMatrix
+ *  holds the scores used to weight the columns of an alignment: a
+ *  substitution score for each pair of residues and a linear gap cost.
+ *  It has the same lookups as Blosum62, but for any matrix.
+ *
+ *  The lookup tables of the built in matrices are built at compile time
+ *  by the constexpr functions below, from the matrix and the gap cost.
+ *  Matrices read from a file build the same tables when they are read.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "ScoringMatrix.h"
+#include "Blosum62.h"
+#include <array>
+#include <fstream>
+#include <sstream>
+using namespace std;
+
+// Compile Time Table Construction
+// ==============================================
+namespace {
+
+constexpr char proteinResidues[] = "ARNDCQEGHILKMFPSTWYV";
+constexpr char nucleotideResidues[] = "ACGTN";
+constexpr int builtInGapCost = -6;  // the Blosum62 gap cost
+
+constexpr int blosum45Matrix[20][20] =
+	{
+		{ 5, -2, -1, -2, -1, -1, -1,  0, -2, -1, -1, -1, -1, -2, -1,  1,  0, -2, -2,  0},
+		{-2,  7,  0, -1, -3,  1,  0, -2,  0, -3, -2,  3, -1, -2, -2, -1, -1, -2, -1, -2},
+		{-1,  0,  6,  2, -2,  0,  0,  0,  1, -2, -3,  0, -2, -2, -2,  1,  0, -4, -2, -3},
+		{-2, -1,  2,  7, -3,  0,  2, -1,  0, -4, -3,  0, -3, -4, -1,  0, -1, -4, -2, -3},
+		{-1, -3, -2, -3, 12, -3, -3, -3, -3, -3, -2, -3, -2, -2, -4, -1, -1, -5, -3, -1},
+		{-1,  1,  0,  0, -3,  6,  2, -2,  1, -2, -2,  1,  0, -4, -1,  0, -1, -2, -1, -3},
+		{-1,  0,  0,  2, -3,  2,  6, -2,  0, -3, -2,  1, -2, -3,  0,  0, -1, -3, -2, -3},
+		{ 0, -2,  0, -1, -3, -2, -2,  7, -2, -4, -3, -2, -2, -3, -2,  0, -2, -2, -3, -3},
+		{-2,  0,  1,  0, -3,  1,  0, -2, 10, -3, -2, -1,  0, -2, -2, -1, -2, -3,  2, -3},
+		{-1, -3, -2, -4, -3, -2, -3, -4, -3,  5,  2, -3,  2,  0, -2, -2, -1, -2,  0,  3},
+		{-1, -2, -3, -3, -2, -2, -2, -3, -2,  2,  5, -3,  2,  1, -3, -3, -1, -2,  0,  1},
+		{-1,  3,  0,  0, -3,  1,  1, -2, -1, -3, -3,  5, -1, -3, -1, -1, -1, -2, -1, -2},
+		{-1, -1, -2, -3, -2,  0, -2, -2,  0,  2,  2, -1,  6,  0, -2, -2, -1, -2,  0,  1},
+		{-2, -2, -2, -4, -2, -4, -3, -3, -2,  0,  1, -3,  0,  8, -3, -2, -1,  1,  3,  0},
+		{-1, -2, -2, -1, -4, -1,  0, -2, -2, -2, -3, -1, -2, -3,  9, -1, -1, -3, -3, -3},
+		{ 1, -1,  1,  0, -1,  0,  0,  0, -1, -2, -3, -1, -2, -2, -1,  4,  2, -4, -2, -1},
+		{ 0, -1,  0, -1, -1, -1, -1, -2, -2, -1, -1, -1, -1, -1, -1,  2,  5, -3, -1,  0},
+		{-2, -2, -4, -4, -5, -2, -3, -2, -3, -2, -2, -2, -2,  1, -3, -4, -3, 15,  3, -3},
+		{-2, -1, -2, -2, -3, -1, -2, -3,  2,  0,  0, -1,  0,  3, -3, -2, -1,  3,  8, -1},
+		{ 0, -2, -3, -3, -1, -3, -3, -3, -3,  3,  1, -2,  1,  0, -3, -1,  0, -3, -1,  5}
+	};
+
+constexpr int pam250Matrix[20][20] =
+	{
+		{ 2, -2,  0,  0, -2,  0,  0,  1, -1, -1, -2, -1, -1, -3,  1,  1,  1, -6, -3,  0},
+		{-2,  6,  0, -1, -4,  1, -1, -3,  2, -2, -3,  3,  0, -4,  0,  0, -1,  2, -4, -2},
+		{ 0,  0,  2,  2, -4,  1,  1,  0,  2, -2, -3,  1, -2, -3,  0,  1,  0, -4, -2, -2},
+		{ 0, -1,  2,  4, -5,  2,  3,  1,  1, -2, -4,  0, -3, -6, -1,  0,  0, -7, -4, -2},
+		{-2, -4, -4, -5, 12, -5, -5, -3, -3, -2, -6, -5, -5, -4, -3,  0, -2, -8,  0, -2},
+		{ 0,  1,  1,  2, -5,  4,  2, -1,  3, -2, -2,  1, -1, -5,  0, -1, -1, -5, -4, -2},
+		{ 0, -1,  1,  3, -5,  2,  4,  0,  1, -2, -3,  0, -2, -5, -1,  0,  0, -7, -4, -2},
+		{ 1, -3,  0,  1, -3, -1,  0,  5, -2, -3, -4, -2, -3, -5,  0,  1,  0, -7, -5, -1},
+		{-1,  2,  2,  1, -3,  3,  1, -2,  6, -2, -2,  0, -2, -2,  0, -1, -1, -3,  0, -2},
+		{-1, -2, -2, -2, -2, -2, -2, -3, -2,  5,  2, -2,  2,  1, -2, -1,  0, -5, -1,  4},
+		{-2, -3, -3, -4, -6, -2, -3, -4, -2,  2,  6, -3,  4,  2, -3, -3, -2, -2, -1,  2},
+		{-1,  3,  1,  0, -5,  1,  0, -2,  0, -2, -3,  5,  0, -5, -1,  0,  0, -3, -4, -2},
+		{-1,  0, -2, -3, -5, -1, -2, -3, -2,  2,  4,  0,  6,  0, -2, -2, -1, -4, -2,  2},
+		{-3, -4, -3, -6, -4, -5, -5, -5, -2,  1,  2, -5,  0,  9, -5, -3, -3,  0,  7, -1},
+		{ 1,  0,  0, -1, -3,  0, -1,  0,  0, -2, -3, -1, -2, -5,  6,  1,  0, -6, -5, -1},
+		{ 1,  0,  1,  0,  0, -1,  0,  1, -1, -1, -3,  0, -2, -3,  1,  2,  1, -2, -3, -1},
+		{ 1, -1,  0,  0, -2, -1,  0,  0, -1,  0, -2,  0, -1, -3,  0,  1,  3, -5, -3,  0},
+		{-6,  2, -4, -7, -8, -5, -7, -7, -3, -5, -2, -3, -4,  0, -6, -2, -5, 17,  0, -6},
+		{-3, -4, -2, -4,  0, -4, -4, -5,  0, -1, -1, -4, -2,  7, -5, -3, -3,  0, 10, -2},
+		{ 0, -2, -2, -2, -2, -2, -2, -1, -2,  4,  2, -2,  2, -1, -1, -1,  0, -6, -2,  4}
+	};
+
+// Nucleotides, with the NUC.4.4 scores for A, C, G, T and N
+constexpr int nucleotideMatrix[5][5] =
+	{
+		{ 5, -4, -4, -4, -2},
+		{-4,  5, -4, -4, -2},
+		{-4, -4,  5, -4, -2},
+		{-4, -4, -4,  5, -2},
+		{-2, -2, -2, -2, -1}
+	};
+
+// Lookup tables for a built in matrix of ResidueCount residues
+template <int ResidueCount>
+struct BuiltInTables {
+	static const int indexCount = ResidueCount + 1;  // residues plus the gap char
+
+	array<signed char, 256> indexTable;
+	array<int, indexCount * indexCount> pairTable;
+	array<int, indexCount * indexCount * indexCount> sumOfPairsTable;
+};
+
+// Score for aligning each pair of indexes (see Blosum62::getScore())
+template <int ResidueCount>
+constexpr int pairScore(const int (&matrix)[ResidueCount][ResidueCount], int gapCost, int index1, int index2) {
+	if (index1 != ResidueCount && index2 != ResidueCount)
+		return matrix[index1][index2];
+
+	if (index1 != ResidueCount || index2 != ResidueCount)
+		return gapCost;
+
+	return 0;
+}
+
+template <int ResidueCount>
+constexpr BuiltInTables<ResidueCount> buildTables(const char* residues,
+	const int (&matrix)[ResidueCount][ResidueCount], int gapCost) {
+
+	const int indexCount = ResidueCount + 1;
+	BuiltInTables<ResidueCount> tables = {};
+
+	// Index of each char: the residues in matrix order, then the gap char
+	for (int c = 0; c < 256; c++)
+		tables.indexTable[c] = ScoringMatrix::unknownIndex;
+	for (int index = 0; index < ResidueCount; index++)
+		tables.indexTable[(unsigned char) residues[index]] = index;
+	tables.indexTable[(unsigned char) '-'] = ResidueCount;
+
+	for (int index1 = 0; index1 < indexCount; index1++) {
+		for (int index2 = 0; index2 < indexCount; index2++) {
+			tables.pairTable[index1 * indexCount + index2] = pairScore(matrix, gapCost, index1, index2);
+
+			for (int index3 = 0; index3 < indexCount; index3++) {
+				tables.sumOfPairsTable[(index1 * indexCount + index2) * indexCount + index3] =
+					pairScore(matrix, gapCost, index1, index2) +
+					pairScore(matrix, gapCost, index2, index3) +
+					pairScore(matrix, gapCost, index1, index3);
+			}
+		}
+	}
+
+	return tables;
+}
+
+constexpr BuiltInTables<20> blosum45Tables = buildTables(proteinResidues, blosum45Matrix, builtInGapCost);
+constexpr BuiltInTables<20> pam250Tables = buildTables(proteinResidues, pam250Matrix, builtInGapCost);
+constexpr BuiltInTables<5> nucleotideTables = buildTables(nucleotideResidues, nucleotideMatrix, builtInGapCost);
+
+} // namespace
+
+// Class Attribute Initialization
+// ==============================================
+const int ScoringMatrix::maxResidueCount;
+const int ScoringMatrix::unknownIndex;
+
+// Constuctors
+// ==============================================
+ScoringMatrix::ScoringMatrix(const string& fileName, int aGapCost) {
+	name = fileName;
+	gap = aGapCost;
+
+	readFile(fileName);
+
+	indexTable = fileIndexTable.data();
+	pairTable = filePairTable.data();
+	sumOfPairsTable = fileSumOfPairsTable.data();
+}
+
+ScoringMatrix::ScoringMatrix(const string& aName, int aResidueCount, int aGapCost, const signed char* anIndexTable,
+	const int* aPairTable, const int* aSumOfPairsTable) {
+
+	name = aName;
+	indexCount = aResidueCount + 1;
+	gapIndex = aResidueCount;
+	gap = aGapCost;
+	indexTable = anIndexTable;
+	pairTable = aPairTable;
+	sumOfPairsTable = aSumOfPairsTable;
+}
+
+// Destructor
+// =============================================
+ScoringMatrix::~ScoringMatrix() {
+}
+
+// Public Methods
+// =============================================
+
+// getScore(char residue1, char residue2)
+//  Purpose: 
+//		Returns the score for aligning the two residues (or gap chars),
+//		as in Blosum62::getScore().
+int ScoringMatrix::getScore(char residue1, char residue2) const {
+	return pairTable[residueIndex(residue1) * indexCount + residueIndex(residue2)];
+}
+
+// residueIndex(), getScoreByIndex(), scoreRow(), sumOfPairsWeight(),
+// sumOfPairsWeightByIndex() and sumOfPairsRow() are defined inline in
+// ScoringMatrix.h
+
+// Public Accessors
+// =============================================
+const string& ScoringMatrix::getName() const {
+	return name;
+}
+
+int ScoringMatrix::gapCost() const {
+	return gap;
+}
+
+int ScoringMatrix::getIndexCount() const {
+	return indexCount;
+}
+
+// Public Class Methods
+// =============================================
+
+// const ScoringMatrix* builtIn(const string& name)
+//  Purpose: 
+//		Returns the built in matrix with the name (BLOSUM62, BLOSUM45,
+//		PAM250 or NUC), or NULL if there is none.
+const ScoringMatrix* ScoringMatrix::builtIn(const string& name) {
+	static const ScoringMatrix blosum45("BLOSUM45", 20, builtInGapCost, blosum45Tables.indexTable.data(),
+		blosum45Tables.pairTable.data(), blosum45Tables.sumOfPairsTable.data());
+	static const ScoringMatrix pam250("PAM250", 20, builtInGapCost, pam250Tables.indexTable.data(),
+		pam250Tables.pairTable.data(), pam250Tables.sumOfPairsTable.data());
+	static const ScoringMatrix nucleotide("NUC", 5, builtInGapCost, nucleotideTables.indexTable.data(),
+		nucleotideTables.pairTable.data(), nucleotideTables.sumOfPairsTable.data());
+
+	if (name == "BLOSUM62")
+		return &blosum62();
+	if (name == "BLOSUM45")
+		return &blosum45;
+	if (name == "PAM250")
+		return &pam250;
+	if (name == "NUC")
+		return &nucleotide;
+
+	return NULL;
+}
+
+// const ScoringMatrix& blosum62()
+//  Purpose: 
+//		Returns the built in BLOSUM62 matrix, the default for the aligners.
+const ScoringMatrix& ScoringMatrix::blosum62() {
+	static const ScoringMatrix matrix("BLOSUM62", Blosum62::residueCount, Blosum62::gapCost(),
+		Blosum62::indexTable.data(), Blosum62::pairTable.data(), Blosum62::sumOfPairsTable.data());
+
+	return matrix;
+}
+
+// Private Methods
+// =============================================
+
+// readFile(const string& fileName)
+//  Purpose:
+//		Reads the NCBI format file and builds the file tables
+void ScoringMatrix::readFile(const string& fileName) {
+	ifstream matrixFile(fileName);
+	if (!matrixFile)
+		throw invalid_argument("ScoringMatrix: can not read " + fileName);
+
+	string residues;  // residues of the columns, in index order
+	vector<vector<int> > rows;  // scores of each residue's row, by index
+	vector<bool> rowRead;
+
+	string line;
+	while (getline(matrixFile, line)) {
+		stringstream ss(line);
+		string token;
+		if (!(ss >> token) || token[0] == '#')
+			continue;
+
+		// The first line is the list of column residues
+		if (residues.empty()) {
+			do {
+				if (token.length() != 1 || token[0] == '-' || residues.find(token[0]) != string::npos)
+					throw invalid_argument("ScoringMatrix: invalid column " + token + " in " + fileName);
+				residues += token[0];
+			} while (ss >> token);
+
+			if ((int) residues.length() > maxResidueCount)
+				throw invalid_argument("ScoringMatrix: too many residues in " + fileName);
+
+			rows.resize(residues.length());
+			rowRead.resize(residues.length(), false);
+			continue;
+		}
+
+		// A row: the residue followed by a score for each column
+		size_t row = residues.find(token[0]);
+		if (token.length() != 1 || row == string::npos || rowRead[row])
+			throw invalid_argument("ScoringMatrix: invalid row " + token + " in " + fileName);
+
+		int score;
+		while (ss >> score)
+			rows[row].push_back(score);
+		if (rows[row].size() != residues.length() || !ss.eof())
+			throw invalid_argument("ScoringMatrix: invalid row " + token + " in " + fileName);
+		rowRead[row] = true;
+	}
+
+	for (size_t row = 0; row < residues.length(); row++) {
+		if (!rowRead[row])
+			throw invalid_argument(string("ScoringMatrix: missing row ") + residues[row] + " in " + fileName);
+	}
+	if (residues.empty())
+		throw invalid_argument("ScoringMatrix: no matrix in " + fileName);
+
+	// Build the tables, as the constexpr functions do for the built in matrices
+	int residueCount = residues.length();
+	indexCount = residueCount + 1;
+	gapIndex = residueCount;
+
+	fileIndexTable.assign(256, (signed char) unknownIndex);
+	for (int index = 0; index < residueCount; index++)
+		fileIndexTable[(unsigned char) residues[index]] = index;
+	fileIndexTable[(unsigned char) '-'] = gapIndex;
+
+	filePairTable.resize(indexCount * indexCount);
+	for (int index1 = 0; index1 < indexCount; index1++) {
+		for (int index2 = 0; index2 < indexCount; index2++) {
+			int score = 0;
+			if (index1 != gapIndex && index2 != gapIndex)
+				score = rows[index1][index2];
+			else if (index1 != gapIndex || index2 != gapIndex)
+				score = gap;
+
+			filePairTable[index1 * indexCount + index2] = score;
+		}
+	}
+
+	fileSumOfPairsTable.resize(indexCount * indexCount * indexCount);
+	for (int index1 = 0; index1 < indexCount; index1++) {
+		for (int index2 = 0; index2 < indexCount; index2++) {
+			for (int index3 = 0; index3 < indexCount; index3++) {
+				fileSumOfPairsTable[(index1 * indexCount + index2) * indexCount + index3] =
+					filePairTable[index1 * indexCount + index2] +
+					filePairTable[index2 * indexCount + index3] +
+					filePairTable[index1 * indexCount + index3];
+			}
+		}
+	}
+}
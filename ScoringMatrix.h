@@ -0,0 +1,208 @@
+/*
+ * ScoringMatrix.h
+ *
+ *	This is the header file for the ScoringMatrix object. A ScoringMatrix
+ *  holds the scores used to weight the columns of an alignment: a
+ *  substitution score for each pair of residues and a linear gap cost.
+ *  It has the same lookups as Blosum62, but for any matrix.
+ *
+ *  The built in matrices (BLOSUM62, BLOSUM45, PAM250 and NUC, a nucleotide
+ *  matrix for ACGT and N) are returned by builtIn().  Their lookup tables
+ *  are built at compile time, like the Blosum62 tables (BLOSUM62 uses the
+ *  Blosum62 tables themselves).  Other matrices can be read at runtime
+ *  from a file in the NCBI format:
+ *
+ *		# comment lines
+ *		   A  R  N ...
+ *		A  4 -1 -2 ...
+ *		R -1  5  0 ...
+ *		...
+ *
+ *  The first line that is not a comment lists the residues of the columns,
+ *  and every residue then has a row with its scores in that order.
+ *
+ *  The lookups are inline table loads through the matrix's table
+ *  pointers (there are no virtual calls), and residues are turned into
+ *  indexes once with residueIndex() so the dynamic programs only do
+ *  sum of pairs lookups by index.  The gap char always has the index
+ *  getGapIndex(), after the residues.
+ *
+ *  Typical Use:
+ *		const ScoringMatrix* matrix = ScoringMatrix::builtIn("PAM250");
+ *		ScoringMatrix loaded(matrixFileName, -6);
+ *
+ *		matrix->sumOfPairsWeight(residue1, residue2, residue3)
+ *		 - returns the sum of pairs weights for the three residues
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef SCORINGMATRIX_H
+#define SCORINGMATRIX_H
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+using namespace std;
+
+class ScoringMatrix
+{
+public:
+
+	// Constuctors
+	// ==============================================
+
+	// Reads the matrix from an NCBI format file.  Throws invalid_argument
+	// if the file can not be read or is not a square matrix.
+	ScoringMatrix(const string& fileName, int aGapCost);
+
+	// Destructor
+	// =============================================
+	virtual ~ScoringMatrix();
+
+	// Public Methods
+	// =============================================
+
+	// getScore(char residue1, char residue2)
+	//  Purpose: 
+	//		Returns the score for aligning the two residues (or gap chars),
+	//		as in Blosum62::getScore().
+	int getScore(char residue1, char residue2) const;
+
+	// residueIndex(char residue)
+	//  Purpose: 
+	//		Returns the index used for the residue in the score tables, the
+	//		gap char is getGapIndex().  Throws out_of_range if the char is
+	//		not a residue of the matrix or the gap char.
+	int residueIndex(char residue) const;
+
+	// getScoreByIndex(int index1, int index2)
+	//  Purpose: 
+	//		Returns the score for aligning the two residues with the indexes
+	//		(from residueIndex()).
+	int getScoreByIndex(int index1, int index2) const;
+
+	// scoreRow(int index1)
+	//  Purpose: 
+	//		Returns the scores for index1 with each index2, i.e. element
+	//		index2 is getScoreByIndex(index1, index2).
+	const int* scoreRow(int index1) const;
+
+	// sumOfPairsWeight(char residue1, char residue2, char residue3)
+	//  Purpose: 
+	//		Returns the sum of pairs score for aligning the three residues.
+	int sumOfPairsWeight(char residue1, char residue2, char residue3) const;
+
+	// sumOfPairsWeightByIndex(int index1, int index2, int index3)
+	//  Purpose: 
+	//		Returns the sum of pairs score for aligning the three residues
+	//		with the indexes (from residueIndex()).
+	int sumOfPairsWeightByIndex(int index1, int index2, int index3) const;
+
+	// sumOfPairsRow(int index1, int index2)
+	//  Purpose: 
+	//		Returns the sum of pairs scores for index1 and index2 with each
+	//		index3, i.e. element index3 is sumOfPairsWeightByIndex(index1,
+	//		index2, index3).  Used to build the weights for a row of cells.
+	const int* sumOfPairsRow(int index1, int index2) const;
+
+	// Public Accessors
+	// =============================================
+	const string& getName() const;  // built in name, or the file name
+	int gapCost() const;  // score for aligning a gap with a residue
+	int getGapIndex() const;  // index of the gap char
+	int getIndexCount() const;  // residues plus the gap char
+
+	// Public Class Methods
+	// =============================================
+
+	// const ScoringMatrix* builtIn(const string& name)
+	//  Purpose: 
+	//		Returns the built in matrix with the name (BLOSUM62, BLOSUM45,
+	//		PAM250 or NUC), or NULL if there is none.
+	static const ScoringMatrix* builtIn(const string& name);
+
+	// const ScoringMatrix& blosum62()
+	//  Purpose: 
+	//		Returns the built in BLOSUM62 matrix, the default for the aligners.
+	static const ScoringMatrix& blosum62();
+
+	// Public Class Attributes
+	// =============================================
+	static const int maxResidueCount = 63;  // most residues a matrix can have
+	static const int unknownIndex = -1;  // index table entry for invalid chars
+
+private:
+
+	// Attributes
+	// =============================================
+	string name;
+	int indexCount;
+	int gapIndex;
+	int gap;
+	const signed char* indexTable;  // index of each of the 256 chars (unknownIndex if not a residue)
+	const int* pairTable;  // getScore() for each pair of indexes
+	const int* sumOfPairsTable;  // sumOfPairsWeight() for each triple of indexes
+
+	// Tables of a matrix read from a file (the built in matrices point at
+	// tables built at compile time)
+	vector<signed char> fileIndexTable;
+	vector<int> filePairTable;
+	vector<int> fileSumOfPairsTable;
+
+	// The tables are pointed into, so a matrix can not be copied
+	ScoringMatrix(const ScoringMatrix&) = delete;
+	ScoringMatrix& operator=(const ScoringMatrix&) = delete;
+
+	// Constructor for the built in matrices
+	ScoringMatrix(const string& aName, int aResidueCount, int aGapCost, const signed char* anIndexTable,
+		const int* aPairTable, const int* aSumOfPairsTable);
+
+	// Private Methods
+	// =============================================
+
+	// readFile(const string& fileName)
+	//  Purpose:
+	//		Reads the NCBI format file and builds the file tables
+	void readFile(const string& fileName);
+};
+
+// Inline Methods
+// =============================================
+// These are called for every edge of the edit graph, so they are defined
+// here where the compiler can inline them.
+
+inline int ScoringMatrix::residueIndex(char residue) const {
+	int index = indexTable[(unsigned char) residue];
+	if (index == unknownIndex)
+		throw out_of_range(string("ScoringMatrix: invalid residue ") + residue);
+
+	return index;
+}
+
+inline int ScoringMatrix::getScoreByIndex(int index1, int index2) const {
+	return pairTable[index1 * indexCount + index2];
+}
+
+inline const int* ScoringMatrix::scoreRow(int index1) const {
+	return &pairTable[index1 * indexCount];
+}
+
+inline int ScoringMatrix::sumOfPairsWeightByIndex(int index1, int index2, int index3) const {
+	return sumOfPairsTable[(index1 * indexCount + index2) * indexCount + index3];
+}
+
+inline const int* ScoringMatrix::sumOfPairsRow(int index1, int index2) const {
+	return &sumOfPairsTable[(index1 * indexCount + index2) * indexCount];
+}
+
+inline int ScoringMatrix::sumOfPairsWeight(char residue1, char residue2, char residue3) const {
+	return sumOfPairsWeightByIndex(residueIndex(residue1), residueIndex(residue2), residueIndex(residue3));
+}
+
+inline int ScoringMatrix::getGapIndex() const {
+	return gapIndex;
+}
+
+#endif // SCORINGMATRIX_H
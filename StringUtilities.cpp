@@ -10,9 +10,11 @@
  */
 
 #include "StringUtilities.h"
+#include "OutputBuffer.h"
 #include <string>
 #include <sstream>
 #include <vector>
+#include <charconv>
 using namespace std;
 
 // Constuctors
@@ -43,16 +45,89 @@ vector<string>& StringUtilities::split(const string& s, char delim, vector<strin
     return elems;
 }
 
+// size_t split(string_view s, char delim, string_view* tokens, size_t maxTokens)
+//  Purpose: 
+//		Split a string into tokens seperated by delim without copying
+//		them: the tokens are views into s, stored in the caller's tokens
+//		array.  The tokens are the same as the ones the vector version
+//		finds.  Returns the number of tokens, at most maxTokens (the
+//		rest of the line is left out of the last token's count).
+//  Postconditions:
+//		tokens[0 .. returned count - 1] will be views of the tokens in s.
+size_t StringUtilities::split(string_view s, char delim, string_view* tokens, size_t maxTokens) {
+	size_t count = 0;
+	size_t start = 0;
+
+	// Like getline(), a delim at the very end does not start an empty token
+	while (start < s.length() && count < maxTokens) {
+		size_t end = s.find(delim, start);
+		if (end == string_view::npos)
+			end = s.length();
+
+		tokens[count++] = s.substr(start, end - start);
+		start = end + 1;
+	}
+
+	return count;
+}
+
+// double toDouble(string_view s)
+//  Purpose: 
+//		Returns the number at the start of s, like atof() but without
+//		needing a null terminated string (0 if s does not start with a
+//		number).
+double StringUtilities::toDouble(string_view s) {
+	const char* first = s.data();
+	const char* last = s.data() + s.length();
+
+	// from_chars() does not skip white space or a leading '+' like atof()
+	while (first < last && (*first == ' ' || *first == '\t'))
+		first++;
+	if (first < last && *first == '+')
+		first++;
+
+	double value = 0;
+	if (from_chars(first, last, value).ec != errc())
+		return 0;
+
+	return value;
+}
+
+// string xmlEscape(string_view s)
+//  Purpose: 
+//		Returns s with the characters that can not appear as is in XML
+//		text or attribute values (& < > " ') replaced by their entities
+string StringUtilities::xmlEscape(string_view s) {
+	string escaped;
+	escaped.reserve(s.length());
+	for (char c : s) {
+		switch (c) {
+		case '&': escaped += "&amp;"; break;
+		case '<': escaped += "&lt;"; break;
+		case '>': escaped += "&gt;"; break;
+		case '"': escaped += "&quot;"; break;
+		case '\'': escaped += "&apos;"; break;
+		default: escaped += c; break;
+		}
+	}
+
+	return escaped;
+}
+
 // string xmlResult(const string& type, const string& value)
 //  Purpose: 
 //		Returns an XML Result string in the following format:
 //			<result type=" <<type>> "> <<value>> <\result>
 string StringUtilities::xmlResult(const string& type, const string& value) {
-	stringstream ss;
-	ss
-		<< "    <result type =\"" << type << "\">" << value << "</result>\n";
+	string result;
+	result.reserve(type.length() + value.length() + 32);
+	result += "    <result type =\"";
+	result += type;
+	result += "\">";
+	result += value;
+	result += "</result>\n";
 
-	return ss.str();
+	return result;
 }
 
 // string xmlResult(const string& type, const double value, const int precision)
@@ -61,12 +136,10 @@ string StringUtilities::xmlResult(const string& type, const string& value) {
 //		The return string has the following format:
 //			<result type=" <<type>> "> <<value>> <\result>
 string StringUtilities::xmlResult(const string& type, const double value, const int precision){
-	stringstream ss;
-	ss.precision(precision);
-	ss
-		<< "    <result type =\"" << type << "\">" << value << "</result>\n";
+	OutputBuffer out;
+	out.xmlResult(type, value, precision);
 
-	return ss.str();
+	return out.str();
 }
 
 
@@ -77,11 +150,13 @@ string StringUtilities::xmlResult(const string& type, const double value, const
 //				<<value>>
 //			<\result>
 string StringUtilities::xmlResultFormatted(const string& type, const string& value) {
-	stringstream ss;
-	ss
-		<< "    <result type =\"" << type << "\">" << "\n"
-		<< "      " << value << "\n" 
-		<<"    </result>\n";
+	string result;
+	result.reserve(type.length() + value.length() + 40);
+	result += "    <result type =\"";
+	result += type;
+	result += "\">\n      ";
+	result += value;
+	result += "\n    </result>\n";
 
-	return ss.str();
+	return result;
 }
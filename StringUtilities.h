@@ -13,7 +13,9 @@
 #define STRINGUTILITIES_H_
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <cstddef>
 using namespace std;
 
 class StringUtilities {
@@ -38,6 +40,30 @@ public:
 	//		elems array will be populated with tokens from string.
 	static vector<string>& split(const string& s, char delim, vector<string>& elems);
 
+	// size_t split(string_view s, char delim, string_view* tokens, size_t maxTokens)
+	//  Purpose: 
+	//		Split a string into tokens seperated by delim without copying
+	//		them: the tokens are views into s, stored in the caller's tokens
+	//		array.  The tokens are the same as the ones the vector version
+	//		finds.  Returns the number of tokens, at most maxTokens (the
+	//		rest of the line is left out of the last token's count).
+	//  Postconditions:
+	//		tokens[0 .. returned count - 1] will be views of the tokens in s.
+	static size_t split(string_view s, char delim, string_view* tokens, size_t maxTokens);
+
+	// double toDouble(string_view s)
+	//  Purpose: 
+	//		Returns the number at the start of s, like atof() but without
+	//		needing a null terminated string (0 if s does not start with a
+	//		number).
+	static double toDouble(string_view s);
+
+	// string xmlEscape(string_view s)
+	//  Purpose: 
+	//		Returns s with the characters that can not appear as is in XML
+	//		text or attribute values (& < > " ') replaced by their entities
+	static string xmlEscape(string_view s);
+
 	// string xmlResult(const string& type, const string& value)
 	//  Purpose: 
 	//		Returns an XML Result string in the following format:
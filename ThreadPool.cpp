@@ -0,0 +1,142 @@
+/*
+ * ThreadPool.cpp
+ *
+ *	This is the cpp file for the ThreadPool object. The ThreadPool
+ *  keeps a fixed set of worker threads around so loops can be run in
+ *  parallel without starting new threads each time.
+ *
+ *  The tasks of a loop are handed out one by one from a shared atomic
+ *  counter, so threads that get cheap tasks simply take more of them.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "ThreadPool.h"
+using namespace std;
+
+// Constuctors
+// ==============================================
+ThreadPool::ThreadPool(unsigned int aThreadCount) {
+	threadCount = (aThreadCount > 0) ? aThreadCount : 1;
+	generation = 0;
+	busyWorkers = 0;
+	stopping = false;
+	currentTask = NULL;
+	currentCount = 0;
+	nextIndex = 0;
+
+	// Thread 0 is the thread that calls parallelFor()
+	for (unsigned int thread = 1; thread < threadCount; thread++)
+		workers.push_back(std::thread(&ThreadPool::workerLoop, this, thread));
+}
+
+// Destructor
+// =============================================
+ThreadPool::~ThreadPool() {
+	{
+		lock_guard<mutex> lock(poolMutex);
+		stopping = true;
+	}
+	workReady.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+// Public Methods
+// =============================================
+
+// parallelFor(size_t count, const function<void(size_t, unsigned int)>& task)
+//  Purpose:
+//		Runs task(index, thread) for each index in [0, count), spread
+//		over the threads of the pool.
+//  Postconditions:
+//		- all of the tasks have finished
+void ThreadPool::parallelFor(size_t count, const function<void(size_t, unsigned int)>& task) {
+
+	// Not worth waking the workers for a single task
+	if (workers.empty() || count <= 1) {
+		for (size_t index = 0; index < count; index++)
+			task(index, 0);
+		return;
+	}
+
+	// Start the loop
+	{
+		lock_guard<mutex> lock(poolMutex);
+		currentTask = &task;
+		currentCount = count;
+		nextIndex = 0;
+		busyWorkers = workers.size();
+		generation++;
+	}
+	workReady.notify_all();
+
+	// Help out, then wait for the workers to leave the loop
+	runTasks(0);
+
+	unique_lock<mutex> lock(poolMutex);
+	workDone.wait(lock, [this] { return busyWorkers == 0; });
+	currentTask = NULL;
+}
+
+// Public Accessors
+// =============================================
+unsigned int ThreadPool::getThreadCount() {
+	return threadCount;
+}
+
+// unsigned int defaultThreadCount()
+//  Purpose:
+//		Returns the number of hardware threads (at least 1)
+unsigned int ThreadPool::defaultThreadCount() {
+	unsigned int count = std::thread::hardware_concurrency();
+	return (count > 0) ? count : 1;
+}
+
+// Private Methods
+// =============================================
+
+// workerLoop(unsigned int thread)
+//  Purpose:
+//		Body of each worker thread: waits for a loop and runs its tasks
+//		until the pool stops.
+void ThreadPool::workerLoop(unsigned int thread) {
+	size_t seenGeneration = 0;
+
+	while (true) {
+		{
+			unique_lock<mutex> lock(poolMutex);
+			workReady.wait(lock, [&] { return stopping || generation != seenGeneration; });
+			if (stopping)
+				return;
+			seenGeneration = generation;
+		}
+
+		runTasks(thread);
+
+		// Let parallelFor() know when the last worker is done
+		bool lastWorker;
+		{
+			lock_guard<mutex> lock(poolMutex);
+			lastWorker = (--busyWorkers == 0);
+		}
+		if (lastWorker)
+			workDone.notify_one();
+	}
+}
+
+// runTasks(unsigned int thread)
+//  Purpose:
+//		Takes indexes from the current loop and runs them until all of
+//		them have been taken.
+void ThreadPool::runTasks(unsigned int thread) {
+	while (true) {
+		size_t index = nextIndex.fetch_add(1);
+		if (index >= currentCount)
+			return;
+
+		(*currentTask)(index, thread);
+	}
+}
@@ -0,0 +1,107 @@
+/*
+ * ThreadPool.h
+ *
+ *	This is the header file for the ThreadPool object. The ThreadPool
+ *  keeps a fixed set of worker threads around so loops can be run in
+ *  parallel without starting new threads each time.
+ *
+ *  parallelFor() runs a task for each index in [0, count) and returns when
+ *  all of them are done.  The calling thread works on the tasks too, so a
+ *  pool of n threads has n - 1 workers.  Each task is given the number of
+ *  the thread running it (0 to getThreadCount() - 1), which can be used to
+ *  pick per thread storage.
+ *
+ *  Typical Use:
+ *		ThreadPool pool(8);
+ *		pool.parallelFor(tileCount, [&](size_t tile, unsigned int thread) {
+ *			...
+ *		});
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstddef>
+using namespace std;
+
+class ThreadPool
+{
+public:
+
+	// Constuctors
+	// ==============================================
+	ThreadPool(unsigned int aThreadCount);
+
+	// Destructor
+	// =============================================
+	virtual ~ThreadPool();
+
+	// Public Methods
+	// =============================================
+
+	// parallelFor(size_t count, const function<void(size_t, unsigned int)>& task)
+	//  Purpose:
+	//		Runs task(index, thread) for each index in [0, count), spread
+	//		over the threads of the pool.
+	//  Postconditions:
+	//		- all of the tasks have finished
+	void parallelFor(size_t count, const function<void(size_t, unsigned int)>& task);
+
+	// Public Accessors
+	// =============================================
+	unsigned int getThreadCount();  // number of threads, including the calling thread
+
+	// unsigned int defaultThreadCount()
+	//  Purpose:
+	//		Returns the number of hardware threads (at least 1)
+	static unsigned int defaultThreadCount();
+
+private:
+
+	// Attributes
+	// =============================================
+	unsigned int threadCount;
+	vector<thread> workers;
+
+	mutex poolMutex;
+	condition_variable workReady;  // signaled when a new loop starts (or the pool stops)
+	condition_variable workDone;  // signaled when the last worker leaves a loop
+	size_t generation;  // number of loops started, so workers can tell a new loop from an old one
+	unsigned int busyWorkers;  // workers still inside the current loop
+	bool stopping;
+
+	// The current loop
+	const function<void(size_t, unsigned int)>* currentTask;
+	size_t currentCount;
+	atomic<size_t> nextIndex;
+
+	// The pool owns its threads, so it can not be copied
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Private Methods
+	// =============================================
+
+	// workerLoop(unsigned int thread)
+	//  Purpose:
+	//		Body of each worker thread: waits for a loop and runs its tasks
+	//		until the pool stops.
+	void workerLoop(unsigned int thread);
+
+	// runTasks(unsigned int thread)
+	//  Purpose:
+	//		Takes indexes from the current loop and runs them until all of
+	//		them have been taken.
+	void runTasks(unsigned int thread);
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,1695 @@
+/*
+ * ThreeWayAligner.cpp
+ *
+ *	This is the cpp file for the ThreeWayAligner object. The
+ *  ThreeWayAligner finds the highest weight path through the edit graph
+ *  for three fasta files without building the graph explicitly.
+ *
+ *  The edit graph that WDAGraphFileBuilder writes for three sequences is
+ *  a lattice whose structure is known in advance: vertex (i,j,k) has an
+ *  incoming edge from every (i',j',k') where i' = i or i-1, j' = j or j-1,
+ *  k' = k or k-1 (and at least one of them differs).  The ThreeWayAligner
+ *  stores the highest path weight for each vertex in a dense 3D score
+ *  tensor and enumerates the edges implicitly as it runs the dynamic
+ *  program, so no graph file has to be written or parsed.
+ *
+ *  The results are the same as the results obtained by building the
+ *  graph file with WDAGraphFileBuilder and running
+ *  WDAGraph::findHighestWeightPath() over it, including the tie breaking
+ *  between paths of equal weight.
+ *
+ *  The dense tensor needs memory for every one of the (n+1)^3 cells.  In
+ *  linear space mode (setLinearSpace(true)) only a few planes of scores are
+ *  kept: a first pass finds the end and start cells of the highest weight
+ *  path, and the path between them is then recovered by recursive
+ *  splitting (in the style of Hirschberg's algorithm).  Linear space mode
+ *  gives the same score and path as the dense tensor.
+ *
+ *  Every cell of the dense tensor on the anti-diagonal plane i+j+k = d only
+ *  depends on the planes before it, so the tensor can be filled in
+ *  parallel (setThreadCount()).  The cells are grouped into tiles that fit
+ *  in cache and a wavefront of tiles is filled at a time.  The result does
+ *  not depend on the number of threads.  Within a tile, each row along
+ *  fasta3 is filled with the SIMD ScoreRowKernel.
+ *
+ *  The dense tensor is also stored tile by tile, so the cells of a tile
+ *  are next to each other in memory rather than (n+1)^2 cells apart along
+ *  fasta1.  A tile is filled in a small buffer holding the tile and the
+ *  halo of cells before it in each direction: the halo is copied in from
+ *  the neighbouring tiles (as whole rows, since rows along fasta3 are
+ *  contiguous within a tile), the cells are filled with fixed offsets to
+ *  their predecessors, and the tile is copied back.  The moves are stored
+ *  in the same tile order, one traceback row for each (i,j) of a tile.
+ *
+ *  For closely related sequences most of the tensor can not be on a good
+ *  path.  Banded mode (setBandWidth()) only computes the cells where each
+ *  pair of coordinates is within the band width of each other, and X-drop
+ *  mode (setXDrop()) stops following paths that fall more than the X-drop
+ *  below the highest weight found so far.  Both run on one thread and
+ *  store only the cells they compute.  The results then include an
+ *  "exact" result, true only if the path is proven to be the dense
+ *  tensor's: an upper bound on every path that was pruned is below the
+ *  score found.  A pruned path is bounded by its score where it left the
+ *  computed cells plus the sum of the best pairwise scores of the rest of
+ *  each pair of sequences (a Carrillo-Lipman bound).
+ *
+ *  When only the score is needed, score only mode (setScoreOnly()) keeps
+ *  no moves and does not recover the path: the dynamic program is run
+ *  with only two i planes of scores in memory, and the results leave out
+ *  the beginning vertex and the path.
+ *
+ *  With a ResultCache (setResultCache()), the results are looked up by
+ *  the sequences, the scoring matrix and the options that change the
+ *  results, and the dynamic program is only run if they are not
+ *  there (the results found are then added to the cache).
+ *
+ *  Typical Use:
+ *		ThreeWayAligner aligner(fasta1, fasta2, fasta3);
+ *		aligner.findHighestWeightPath();
+ *		cout << aligner.resultString();
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "ThreeWayAligner.h"
+#include "ThreadPool.h"
+#include "ScoreRowKernel.h"
+#include <sstream>
+#include <set>
+#include <algorithm>
+#include <cstdlib>
+using namespace std;
+
+// Class Attribute Initialization
+// ==============================================
+const int ThreeWayAligner::unreachable;
+const size_t ThreeWayAligner::linearSpaceLeafCells;
+const int ThreeWayAligner::tileSeq1Size;
+const int ThreeWayAligner::tileSeq2Size;
+const int ThreeWayAligner::tileSeq3Size;
+const size_t ThreeWayAligner::haloTileSeq2Step;
+const size_t ThreeWayAligner::haloTileSeq1Step;
+const size_t ThreeWayAligner::haloTileCells;
+
+// Constuctors
+// ==============================================
+ThreeWayAligner::ThreeWayAligner(FastaFile* fasta1, FastaFile* fasta2, FastaFile* fasta3)
+	: encoded1(fasta1->getEncodedSequence()), encoded2(fasta2->getEncodedSequence()),
+	  encoded3(fasta3->getEncodedSequence()) {
+
+	gapChar = '-';
+	graphFileName = graphFileNameFor(fasta1, fasta2, fasta3);
+
+	seq1Length = fasta1->getSequenceLength();
+	seq2Length = fasta2->getSequenceLength();
+	seq3Length = fasta3->getSequenceLength();
+
+	matrix = &ScoringMatrix::blosum62();
+	gapIndex = matrix->getGapIndex();
+	linearSpace = false;
+	scoreOnly = false;
+	threadCount = 1;
+	workspace = &ownWorkspace;
+	bandWidth = 0;
+	xDrop = 0;
+	prunedExact = true;
+	highestWeight = 0;
+	pathStart.seq1Loc = pathStart.seq2Loc = pathStart.seq3Loc = 0;
+	pathEnd = pathStart;
+	pathFound = false;
+	cache = NULL;
+	fromCache = false;
+}
+
+// Destructor
+// =============================================
+ThreeWayAligner::~ThreeWayAligner() {
+}
+
+// Public Methods
+// =============================================
+
+// findHighestWeightPath()
+//  Purpose:
+//		Uses dynamic programming to find the highest weight path through
+//		the edit graph for the three sequences.  The cells of the score
+//		tensor are visited in the same order that WDAGraphFileBuilder
+//		lists the vertices (i, then j, then k), and the weight for each
+//		cell is the max of:
+//			1. the trivial path of starting at the cell (weight = 0)
+//		and 2. for each of the (up to) seven incoming edges
+//				  - the weight of the edge's start cell + the sum of pairs
+//					weight of the edge's column
+//
+//		Incoming edges are considered in the order of their start cell,
+//		and an edge only replaces the current best when it is strictly
+//		better, so ties are broken the same way as in WDAGraph.
+//
+//  Postconditions:
+//		- highestWeight, pathStart, pathEnd and pathMoves will be set
+void ThreeWayAligner::findHighestWeightPath() {
+
+	pathMoves.clear();
+	cachedResult.clear();
+	fromCache = false;
+	encodeSequences();
+
+	// Skip the dynamic program if the results are in the cache
+	ResultCache::Key key;
+	if (cache != NULL) {
+		key = cacheKey();
+
+		ResultCache::Entry entry;
+		if (cache->find(key, entry)) {
+			highestWeight = entry.score;
+			prunedExact = entry.exact;
+			cachedResult.swap(entry.result);
+			fromCache = true;
+			pathFound = true;
+			return;
+		}
+	}
+
+	if (isPruned())
+		findPathPruned();
+	else if (scoreOnly)
+		findScoreOnly();
+	else if (linearSpace)
+		findPathLinearSpace();
+	else
+		findPathFullTensor();
+
+	pathFound = true;
+
+	// Add the results to the cache
+	if (cache != NULL) {
+		OutputBuffer body;
+		writeResultBody(body);
+
+		ResultCache::Entry entry;
+		entry.score = highestWeight;
+		entry.exact = prunedExact;
+		entry.result = body.str();
+		cache->store(key, entry);
+	}
+}
+
+// string resultString()
+//  Purpose:
+//		Returns an XML formatted string representing the results of the
+//		findHighestWeightPath() function.  The format is the same as the
+//		one returned by WDAGraph::resultString().
+//
+//		format:
+//			<results type="part?" file=" <<graphFileName>> ">";
+//			  <result type="edge_weights"> <<weights for each edge label>> </result>
+//			  <result type="edge_histogram">  << frequencies for each edge label>> </result>
+//			  <result type="score"> <<highest weight path score>> </result>
+//			  <result type="beginning_vertex"> <<start vertex for path>> </result>
+//			  <result type="ending_vertex"> <<end vertex for path>> </result>
+//			  <result type="path"> << list of path edge labels in order>> </result>
+//			</results>
+//
+//		In score only mode the beginning_vertex and path results are left out.
+//  Preconditions:
+//		findHighestWeightPath() has been run
+string ThreeWayAligner::resultString() {
+	OutputBuffer out;
+	writeResult(out);
+
+	return out.str();
+}
+
+// writeResult(OutputBuffer& out)
+//  Purpose:
+//		Appends the string resultString() returns to out, without
+//		building a stream for it.
+//  Preconditions:
+//		findHighestWeightPath() has been run
+void ThreeWayAligner::writeResult(OutputBuffer& out) {
+	// Results header
+	out.write("  <results type=\"part?\" file=\"");
+	out.write(graphFileName);
+	out.write("\">\n");
+
+	// The results found in the cache are the same as those written below
+	if (fromCache)
+		out.write(cachedResult);
+	else
+		writeResultBody(out);
+
+	// Results footer
+	out.write("  </results>\n");
+}
+
+// Public Accessors
+// =============================================
+string& ThreeWayAligner::getGraphFileName() {
+	return graphFileName;
+}
+
+int ThreeWayAligner::getScore() {
+	return highestWeight;
+}
+
+void ThreeWayAligner::setLinearSpace(bool aLinearSpace) {
+	linearSpace = aLinearSpace;
+}
+
+void ThreeWayAligner::setThreadCount(unsigned int aThreadCount) {
+	threadCount = (aThreadCount > 0) ? aThreadCount : 1;
+}
+
+void ThreeWayAligner::setWorkspace(Workspace* aWorkspace) {
+	workspace = (aWorkspace != NULL) ? aWorkspace : &ownWorkspace;
+}
+
+void ThreeWayAligner::setBandWidth(int aBandWidth) {
+	bandWidth = aBandWidth;
+}
+
+void ThreeWayAligner::setXDrop(int anXDrop) {
+	xDrop = anXDrop;
+}
+
+bool ThreeWayAligner::isExact() {
+	return !isPruned() || prunedExact;
+}
+
+void ThreeWayAligner::setScoreOnly(bool aScoreOnly) {
+	scoreOnly = aScoreOnly;
+}
+
+void ThreeWayAligner::setScoringMatrix(const ScoringMatrix* aMatrix) {
+	matrix = (aMatrix != NULL) ? aMatrix : &ScoringMatrix::blosum62();
+}
+
+void ThreeWayAligner::setResultCache(ResultCache* aCache) {
+	cache = aCache;
+}
+
+bool ThreeWayAligner::isFromCache() {
+	return fromCache;
+}
+
+// string graphFileNameFor(FastaFile* fasta1, FastaFile* fasta2, FastaFile* fasta3)
+//  Purpose:
+//		Returns the name used for the graph file of the three fasta files
+//			<<fileName1>>_<<fileName2>>_<<fileName3>>.graph.txt
+string ThreeWayAligner::graphFileNameFor(FastaFile* fasta1, FastaFile* fasta2, FastaFile* fasta3) {
+	stringstream ss;
+	ss
+		<< fasta1->getFileName() << "_"
+		<< fasta2->getFileName() << "_"
+		<< fasta3->getFileName() << ".graph.txt";
+
+	return ss.str();
+}
+
+// Private Methods
+// =============================================
+
+// findPathFullTensor()
+//  Purpose:
+//		Runs the dynamic program over a dense tensor holding the score and
+//		packed move for every cell, then walks the moves back from the end
+//		cell.
+//		The tensor is filled a wavefront of tiles at a time, with the tiles
+//		of each wavefront spread over threadCount threads, and is stored
+//		tile by tile.
+//  Postconditions:
+//		- highestWeight, pathStart, pathEnd and pathMoves will be set
+void ThreeWayAligner::findPathFullTensor() {
+
+	// Offsets from a cell of a tile's buffer to the start cell of each
+	// possible incoming edge
+	size_t tileMoveOffset[8];
+	for (unsigned char move = 1; move <= 7; move++) {
+		tileMoveOffset[move] =
+			((move & seq1Move) ? haloTileSeq1Step : 0) +
+			((move & seq2Move) ? haloTileSeq2Step : 0) +
+			((move & seq3Move) ? 1 : 0);
+	}
+
+	// Split the tensor into tiles.  A tile only depends on the tiles before
+	// it in each direction, so all of the tiles on an anti-diagonal plane
+	// of tiles (tile1 + tile2 + tile3 = plane) can be filled at the same time
+	// once the planes before it are done.
+	int tile1Count = seq1Length / tileSeq1Size + 1;
+	int tile2Count = seq2Length / tileSeq2Size + 1;
+	int tile3Count = seq3Length / tileSeq3Size + 1;
+	int planeCount = tile1Count + tile2Count + tile3Count - 2;
+
+	// Every cell is filled before it is read, so the workspace is only
+	// resized (and keeps its memory from earlier alignments)
+	size_t cellCount = (size_t) (seq1Length + 1) * (seq2Length + 1) * (seq3Length + 1);
+	vector<int>& scores = workspace->scores;  // highest path weight to get to each cell
+	PackedTraceback& moves = workspace->moves;  // move used for the highest weight path (0 = path starts here)
+	scores.resize(cellCount);
+	moves.resize((size_t) (seq1Length + 1) * (seq2Length + 1) * tile3Count, tileSeq3Size);
+
+	ThreadPool pool(threadCount);
+	vector<vector<int>>& tileScores = workspace->tileScores;
+	if (tileScores.size() < pool.getThreadCount())
+		tileScores.resize(pool.getThreadCount());
+	for (unsigned int thread = 0; thread < pool.getThreadCount(); thread++)
+		tileScores[thread].resize(haloTileCells);
+
+	// Position of a cell in vertex order, used to break ties between tiles
+	size_t seq2Step = seq3Length + 1;
+	size_t seq1Step = seq2Step * (seq2Length + 1);
+	auto vertexNumber = [&](const Cell& cell) {
+		return cell.seq1Loc * seq1Step + cell.seq2Loc * seq2Step + cell.seq3Loc;
+	};
+
+	vector<Cell> planeTiles;
+	Cell highestWeightCell;
+	highestWeightCell.seq1Loc = 0;
+	highestWeightCell.seq2Loc = 0;
+	highestWeightCell.seq3Loc = 0;
+	int highestWeightSoFar = 0;  // the weight of (0,0,0)
+
+	for (int plane = 0; plane < planeCount; plane++) {
+
+		// Tiles on this plane, in vertex order
+		planeTiles.clear();
+		for (int tile1 = 0; tile1 < tile1Count; tile1++) {
+			for (int tile2 = 0; tile2 < tile2Count; tile2++) {
+				int tile3 = plane - tile1 - tile2;
+				if (tile3 < 0)
+					break;
+				if (tile3 >= tile3Count)
+					continue;
+
+				Cell tile;
+				tile.seq1Loc = tile1;
+				tile.seq2Loc = tile2;
+				tile.seq3Loc = tile3;
+				planeTiles.push_back(tile);
+			}
+		}
+
+		// Fill the tiles, keeping the highest weight cell of each one
+		vector<Cell> tileHighestWeightCells(planeTiles.size());
+		pool.parallelFor(planeTiles.size(), [&](size_t tileIndex, unsigned int thread) {
+			Cell& tile = planeTiles[tileIndex];
+
+			Cell tileStart;
+			tileStart.seq1Loc = tile.seq1Loc * tileSeq1Size;
+			tileStart.seq2Loc = tile.seq2Loc * tileSeq2Size;
+			tileStart.seq3Loc = tile.seq3Loc * tileSeq3Size;
+
+			Cell tileEnd;
+			tileEnd.seq1Loc = min(tileStart.seq1Loc + tileSeq1Size - 1, seq1Length);
+			tileEnd.seq2Loc = min(tileStart.seq2Loc + tileSeq2Size - 1, seq2Length);
+			tileEnd.seq3Loc = min(tileStart.seq3Loc + tileSeq3Size - 1, seq3Length);
+
+			tileHighestWeightCells[tileIndex] =
+				fillTile(tileStart, tileEnd, scores, moves, tileScores[thread].data(), tileMoveOffset);
+		});
+
+		// Set highestWeightCell (the first cell in vertex order with the
+		// highest weight, whichever tile it was found in)
+		for (size_t tileIndex = 0; tileIndex < planeTiles.size(); tileIndex++) {
+			Cell& cell = tileHighestWeightCells[tileIndex];
+			int weight = scores[tiledCellIndex(cell.seq1Loc, cell.seq2Loc, cell.seq3Loc)];
+			if (weight > highestWeightSoFar ||
+				(weight == highestWeightSoFar && vertexNumber(cell) < vertexNumber(highestWeightCell))) {
+				highestWeightCell = cell;
+				highestWeightSoFar = weight;
+			}
+		}
+	}
+
+	pathEnd = highestWeightCell;
+	highestWeight = highestWeightSoFar;
+
+	// Walk backwards until find the start cell (move is 0)
+	pathStart = pathEnd;
+	while (true) {
+		size_t row = tiledMoveRow(pathStart.seq1Loc, pathStart.seq2Loc, pathStart.seq3Loc);
+		unsigned char move = moves.getMove(row, pathStart.seq3Loc % tileSeq3Size);
+		if (move == 0)
+			break;
+
+		pathMoves.push_back(move);
+		pathStart.seq1Loc -= (move & seq1Move) ? 1 : 0;
+		pathStart.seq2Loc -= (move & seq2Move) ? 1 : 0;
+		pathStart.seq3Loc -= (move & seq3Move) ? 1 : 0;
+	}
+	reverse(pathMoves.begin(), pathMoves.end());
+}
+
+// Cell fillTile(Cell tileStart, Cell tileEnd, vector<int>& scores,
+//		PackedTraceback& moves, int* tileScores, const size_t* tileMoveOffset)
+//  Purpose:
+//		Fills the scores and moves for the cells from tileStart to tileEnd
+//		(inclusive) of the dense tensor, and returns the first cell (in
+//		vertex order) of the tile with the highest weight.  The tile is
+//		filled in tileScores (haloTileCells ints), with tileMoveOffset the
+//		offsets to the predecessors of a cell in tileScores.
+//  Preconditions:
+//		The tiles before this one in each direction have been filled
+ThreeWayAligner::Cell ThreeWayAligner::fillTile(Cell tileStart, Cell tileEnd, vector<int>& scores,
+	PackedTraceback& moves, int* tileScores, const size_t* tileMoveOffset) {
+
+	int tileSeq2Length = tileEnd.seq2Loc - tileStart.seq2Loc + 1;
+	int rowLength = tileEnd.seq3Loc - tileStart.seq3Loc + 1;
+
+	// Cell (i,j,k) is at (i - tileStart.seq1Loc + 1, j - tileStart.seq2Loc + 1,
+	// k - tileStart.seq3Loc + 1) in tileScores, so the halo is at 0
+	size_t tileOrigin = haloTileSeq1Step + haloTileSeq2Step + 1;
+	size_t tileOffset = tileOrigin -
+		tileStart.seq1Loc * haloTileSeq1Step - tileStart.seq2Loc * haloTileSeq2Step - tileStart.seq3Loc;
+
+	// Copy in the halo: whole rows (the cell before the tile and the tile's
+	// part of the row) where i or j is before the tile, otherwise just the
+	// cell before the tile.  Cells before the start of a sequence are never
+	// read.
+	for (int seq1Loc = max(tileStart.seq1Loc - 1, 0); seq1Loc <= tileEnd.seq1Loc; seq1Loc++) {
+		for (int seq2Loc = max(tileStart.seq2Loc - 1, 0); seq2Loc <= tileEnd.seq2Loc; seq2Loc++) {
+			int* haloRow = &tileScores[tileOffset + seq1Loc * haloTileSeq1Step + seq2Loc * haloTileSeq2Step + tileStart.seq3Loc];
+
+			if (tileStart.seq3Loc > 0)
+				haloRow[-1] = scores[tiledCellIndex(seq1Loc, seq2Loc, tileStart.seq3Loc - 1)];
+
+			if (seq1Loc < tileStart.seq1Loc || seq2Loc < tileStart.seq2Loc) {
+				const int* row = &scores[tiledCellIndex(seq1Loc, seq2Loc, tileStart.seq3Loc)];
+				copy(row, row + rowLength, haloRow);
+			}
+		}
+	}
+
+	// Rows with all three sequences advancing are filled by the
+	// ScoreRowKernel, starting at the first cell with seq3Loc > 0
+	int rowStart = max(tileStart.seq3Loc, 1);
+	int rowCount = tileEnd.seq3Loc - rowStart + 1;
+
+	// Weights of the moves into each cell of a row (element t is for the
+	// cell at rowStart + t), move 1 is the same for every row
+	int weights7[tileSeq3Size];
+	int weights5[tileSeq3Size];
+	int weights3[tileSeq3Size];
+	int weights1[tileSeq3Size];
+	unsigned char seq3RowIndexes[tileSeq3Size];  // matrix indexes of the residues of a row
+	if (rowCount > 0)
+		seq3Indexes.copy(rowStart - 1, rowCount, seq3RowIndexes);
+	for (int t = 0; t < rowCount; t++)
+		weights1[t] = matrix->sumOfPairsWeightByIndex(gapIndex, gapIndex, seq3RowIndexes[t]);
+
+	// Moves of a row of the tile, packed into the traceback once the row
+	// is done
+	unsigned char rowMoves[tileSeq3Size];
+
+	// The tile's cells and traceback rows are stored in the same order it
+	// is filled in
+	int* tileCells = &scores[tiledCellIndex(tileStart.seq1Loc, tileStart.seq2Loc, tileStart.seq3Loc)];
+	size_t firstMoveRow = tiledMoveRow(tileStart.seq1Loc, tileStart.seq2Loc, tileStart.seq3Loc);
+
+	Cell highestWeightCell = tileStart;
+	int tileHighestWeight = unreachable;
+	for (int seq1Loc = tileStart.seq1Loc; seq1Loc <= tileEnd.seq1Loc; seq1Loc++) {
+		for (int seq2Loc = tileStart.seq2Loc; seq2Loc <= tileEnd.seq2Loc; seq2Loc++) {
+			size_t firstCell = tileOffset + seq1Loc * haloTileSeq1Step + seq2Loc * haloTileSeq2Step + tileStart.seq3Loc;
+
+			if (seq1Loc > 0 && seq2Loc > 0 && rowCount > 0) {
+				// The cell with seq3Loc = 0 only has moves 6, 4 and 2
+				if (tileStart.seq3Loc == 0)
+					rowMoves[0] = fillCell(seq1Loc, seq2Loc, 0, firstCell, tileScores, tileMoveOffset);
+
+				// Residue profile for the row
+				int seq1Index = seq1Indexes[seq1Loc - 1];
+				int seq2Index = seq2Indexes[seq2Loc - 1];
+				const int* profile7 = matrix->sumOfPairsRow(seq1Index, seq2Index);
+				const int* profile5 = matrix->sumOfPairsRow(seq1Index, gapIndex);
+				const int* profile3 = matrix->sumOfPairsRow(gapIndex, seq2Index);
+				for (int t = 0; t < rowCount; t++) {
+					int seq3Index = seq3RowIndexes[t];
+					weights7[t] = profile7[seq3Index];
+					weights5[t] = profile5[seq3Index];
+					weights3[t] = profile3[seq3Index];
+				}
+
+				size_t rowCell = firstCell + (rowStart - tileStart.seq3Loc);
+				ScoreRowKernel::ScoreRow row;
+				row.seq1Seq2Previous = &tileScores[rowCell - tileMoveOffset[seq1Move | seq2Move]];
+				row.seq1Previous = &tileScores[rowCell - tileMoveOffset[seq1Move]];
+				row.seq2Previous = &tileScores[rowCell - tileMoveOffset[seq2Move]];
+				row.weights7 = weights7;
+				row.weights5 = weights5;
+				row.weights3 = weights3;
+				row.weights1 = weights1;
+				row.weight6 = matrix->sumOfPairsWeightByIndex(seq1Index, seq2Index, gapIndex);
+				row.weight4 = matrix->sumOfPairsWeightByIndex(seq1Index, gapIndex, gapIndex);
+				row.weight2 = matrix->sumOfPairsWeightByIndex(gapIndex, seq2Index, gapIndex);
+				row.scores = &tileScores[rowCell];
+				row.moves = &rowMoves[rowStart - tileStart.seq3Loc];
+				ScoreRowKernel::fillRow(row, rowCount);
+			}
+			else {
+				size_t cell = firstCell;
+				for (int seq3Loc = tileStart.seq3Loc; seq3Loc <= tileEnd.seq3Loc; seq3Loc++, cell++)
+					rowMoves[seq3Loc - tileStart.seq3Loc] = fillCell(seq1Loc, seq2Loc, seq3Loc, cell, tileScores, tileMoveOffset);
+			}
+
+			// Copy the row back to the tensor
+			size_t tileRow = (size_t) (seq1Loc - tileStart.seq1Loc) * tileSeq2Length + (seq2Loc - tileStart.seq2Loc);
+			const int* rowScores = &tileScores[firstCell];
+			copy(rowScores, rowScores + rowLength, tileCells + tileRow * rowLength);
+			moves.setRow(firstMoveRow + tileRow, 0, rowMoves, rowLength);
+
+			// Keep the first cell with the highest weight
+			for (int t = 0; t < rowLength; t++) {
+				if (rowScores[t] > tileHighestWeight) {
+					tileHighestWeight = rowScores[t];
+					highestWeightCell.seq1Loc = seq1Loc;
+					highestWeightCell.seq2Loc = seq2Loc;
+					highestWeightCell.seq3Loc = tileStart.seq3Loc + t;
+				}
+			}
+
+		} // seq2Loc - fasta2
+	} // seq1Loc - fasta1
+
+	return highestWeightCell;
+}
+
+// unsigned char fillCell(int seq1Loc, int seq2Loc, int seq3Loc, size_t cell,
+//		int* scores, const size_t* moveOffset)
+//  Purpose:
+//		Fills the score for one cell of a tile and returns its move, used
+//		for the cells the ScoreRowKernel does not handle.
+unsigned char ThreeWayAligner::fillCell(int seq1Loc, int seq2Loc, int seq3Loc, size_t cell,
+	int* scores, const size_t* moveOffset) {
+	// Moves that are possible from the cell's location
+	unsigned char available =
+		((seq1Loc > 0) ? seq1Move : 0) |
+		((seq2Loc > 0) ? seq2Move : 0) |
+		((seq3Loc > 0) ? seq3Move : 0);
+
+	// Start with the trivial path of starting at this cell
+	int weight = 0;
+	unsigned char bestMove = 0;
+
+	for (unsigned char move = 7; move >= 1; move--) {
+		if ((move & available) != move)
+			continue;
+
+		int pathWeight = scores[cell - moveOffset[move]] +
+			moveWeight(move, seq1Loc, seq2Loc, seq3Loc);
+
+		if (pathWeight > weight) {
+			weight = pathWeight;
+			bestMove = move;
+		}
+	}
+
+	scores[cell] = weight;
+	return bestMove;
+}
+
+// size_t tiledCellIndex(int seq1Loc, int seq2Loc, int seq3Loc)
+//  Purpose:
+//		Returns the position of a cell in the tiled score tensor.  The
+//		tiles are in vertex order, each tile holds its cells in vertex
+//		order, and the tiles at the end of each sequence are cut short
+//		(so there are no unused cells).
+size_t ThreeWayAligner::tiledCellIndex(int seq1Loc, int seq2Loc, int seq3Loc) {
+	size_t seq2Count = seq2Length + 1;
+	size_t seq3Count = seq3Length + 1;
+
+	// First cell and size of the tile in each direction
+	int seq1First = seq1Loc - seq1Loc % tileSeq1Size;
+	int seq2First = seq2Loc - seq2Loc % tileSeq2Size;
+	int seq3First = seq3Loc - seq3Loc % tileSeq3Size;
+	size_t seq1Size = min(tileSeq1Size, seq1Length + 1 - seq1First);
+	size_t seq2Size = min(tileSeq2Size, seq2Length + 1 - seq2First);
+	size_t seq3Size = min(tileSeq3Size, seq3Length + 1 - seq3First);
+
+	// The tiles of each tileSeq1Size slab of i planes, then the tiles of
+	// each column along fasta3 within the slab, then the cells of the tile
+	size_t tileFirstCell =
+		seq1First * seq2Count * seq3Count +
+		seq1Size * (seq2First * seq3Count + seq2Size * seq3First);
+
+	return tileFirstCell +
+		((seq1Loc - seq1First) * seq2Size + (seq2Loc - seq2First)) * seq3Size + (seq3Loc - seq3First);
+}
+
+// size_t tiledMoveRow(int seq1Loc, int seq2Loc, int seq3Loc)
+//  Purpose:
+//		Returns the traceback row holding the move of a cell.  Each row is
+//		the cells of one (i,j) of a tile, in the same order as the scores,
+//		and the move of the cell is at column seq3Loc % tileSeq3Size.
+size_t ThreeWayAligner::tiledMoveRow(int seq1Loc, int seq2Loc, int seq3Loc) {
+	size_t seq2Count = seq2Length + 1;
+	size_t tile3Count = seq3Length / tileSeq3Size + 1;
+
+	// Same order as tiledCellIndex(), with one row in place of each tile's
+	// part of a row
+	int seq1First = seq1Loc - seq1Loc % tileSeq1Size;
+	int seq2First = seq2Loc - seq2Loc % tileSeq2Size;
+	size_t tile3 = seq3Loc / tileSeq3Size;
+	size_t seq1Size = min(tileSeq1Size, seq1Length + 1 - seq1First);
+	size_t seq2Size = min(tileSeq2Size, seq2Length + 1 - seq2First);
+
+	size_t tileFirstRow =
+		seq1First * seq2Count * tile3Count +
+		seq1Size * (seq2First * tile3Count + seq2Size * tile3);
+
+	return tileFirstRow + (seq1Loc - seq1First) * seq2Size + (seq2Loc - seq2First);
+}
+
+// findScoreOnly()
+//  Purpose:
+//		Runs the dynamic program keeping only two i planes of scores and
+//		no moves, filling each row along fasta3 with the ScoreRowKernel.
+//  Postconditions:
+//		- highestWeight and pathEnd will be set
+void ThreeWayAligner::findScoreOnly() {
+
+	// Offsets within a plane to the start cell of each incoming edge
+	size_t seq2Step = seq3Length + 1;
+	size_t planeSize = seq2Step * (seq2Length + 1);
+	size_t moveOffset[8];
+	for (unsigned char move = 1; move <= 7; move++) {
+		moveOffset[move] =
+			((move & seq2Move) ? seq2Step : 0) +
+			((move & seq3Move) ? 1 : 0);
+	}
+
+	// The two planes of scores are kept in the workspace, and the moves
+	// the ScoreRowKernel fills in only need room for one row
+	vector<int>& scores = workspace->scores;
+	vector<unsigned char> moves(seq2Step);
+	scores.resize(2 * planeSize);
+
+	// Weights of the moves into each cell of a row (element t is for the
+	// cell at seq3Loc = t + 1), move 1 is the same for every row
+	vector<int> weights7(seq3Length), weights5(seq3Length), weights3(seq3Length), weights1(seq3Length);
+	vector<unsigned char> seq3RowIndexes(seq3Length);  // matrix indexes of the residues of a row
+	seq3Indexes.copy(0, seq3Length, seq3RowIndexes.data());
+	for (int t = 0; t < seq3Length; t++)
+		weights1[t] = matrix->sumOfPairsWeightByIndex(gapIndex, gapIndex, seq3RowIndexes[t]);
+
+	highestWeight = 0;
+	pathEnd.seq1Loc = pathEnd.seq2Loc = pathEnd.seq3Loc = 0;
+	pathStart = pathEnd;
+
+	for (int seq1Loc = 0; seq1Loc <= seq1Length; seq1Loc++) {
+		int* currentPlane = &scores[(seq1Loc % 2) * planeSize];
+		const int* previousPlane = &scores[((seq1Loc + 1) % 2) * planeSize];
+
+		for (int seq2Loc = 0; seq2Loc <= seq2Length; seq2Loc++) {
+			size_t firstCell = seq2Loc * seq2Step;
+
+			if (seq1Loc > 0 && seq2Loc > 0 && seq3Length > 0) {
+				// The cell with seq3Loc = 0 only has moves 6, 4 and 2
+				currentPlane[firstCell] =
+					planeCellScore(seq1Loc, seq2Loc, 0, previousPlane, currentPlane, firstCell, moveOffset);
+
+				// Residue profile for the row
+				int seq1Index = seq1Indexes[seq1Loc - 1];
+				int seq2Index = seq2Indexes[seq2Loc - 1];
+				const int* profile7 = matrix->sumOfPairsRow(seq1Index, seq2Index);
+				const int* profile5 = matrix->sumOfPairsRow(seq1Index, gapIndex);
+				const int* profile3 = matrix->sumOfPairsRow(gapIndex, seq2Index);
+				for (int t = 0; t < seq3Length; t++) {
+					int seq3Index = seq3RowIndexes[t];
+					weights7[t] = profile7[seq3Index];
+					weights5[t] = profile5[seq3Index];
+					weights3[t] = profile3[seq3Index];
+				}
+
+				size_t rowCell = firstCell + 1;
+				ScoreRowKernel::ScoreRow row;
+				row.seq1Seq2Previous = &previousPlane[rowCell - seq2Step];
+				row.seq1Previous = &previousPlane[rowCell];
+				row.seq2Previous = &currentPlane[rowCell - seq2Step];
+				row.weights7 = weights7.data();
+				row.weights5 = weights5.data();
+				row.weights3 = weights3.data();
+				row.weights1 = weights1.data();
+				row.weight6 = matrix->sumOfPairsWeightByIndex(seq1Index, seq2Index, gapIndex);
+				row.weight4 = matrix->sumOfPairsWeightByIndex(seq1Index, gapIndex, gapIndex);
+				row.weight2 = matrix->sumOfPairsWeightByIndex(gapIndex, seq2Index, gapIndex);
+				row.scores = &currentPlane[rowCell];
+				row.moves = moves.data();
+				ScoreRowKernel::fillRow(row, seq3Length);
+			}
+			else {
+				size_t cell = firstCell;
+				for (int seq3Loc = 0; seq3Loc <= seq3Length; seq3Loc++, cell++)
+					currentPlane[cell] =
+						planeCellScore(seq1Loc, seq2Loc, seq3Loc, previousPlane, currentPlane, cell, moveOffset);
+			}
+
+			// Set the end of the highest weight path (the first cell in
+			// vertex order with the highest weight)
+			size_t cell = firstCell;
+			for (int seq3Loc = 0; seq3Loc <= seq3Length; seq3Loc++, cell++) {
+				if (currentPlane[cell] > highestWeight) {
+					highestWeight = currentPlane[cell];
+					pathEnd.seq1Loc = seq1Loc;
+					pathEnd.seq2Loc = seq2Loc;
+					pathEnd.seq3Loc = seq3Loc;
+				}
+			}
+
+		} // seq2Loc - fasta2
+	} // seq1Loc - fasta1
+}
+
+// int planeCellScore(int seq1Loc, int seq2Loc, int seq3Loc, const int* previousPlane,
+//		const int* currentPlane, size_t cell, const size_t* moveOffset)
+//  Purpose:
+//		Returns the score of one cell for findScoreOnly(), used for the
+//		cells the ScoreRowKernel does not handle.  cell is the position of
+//		the cell within its i plane.
+int ThreeWayAligner::planeCellScore(int seq1Loc, int seq2Loc, int seq3Loc, const int* previousPlane,
+	const int* currentPlane, size_t cell, const size_t* moveOffset) {
+
+	// Moves that are possible from the cell's location
+	unsigned char available =
+		((seq1Loc > 0) ? seq1Move : 0) |
+		((seq2Loc > 0) ? seq2Move : 0) |
+		((seq3Loc > 0) ? seq3Move : 0);
+
+	// Start with the trivial path of starting at this cell
+	int weight = 0;
+
+	for (unsigned char move = 7; move >= 1; move--) {
+		if ((move & available) != move)
+			continue;
+
+		const int* predecessorPlane = (move & seq1Move) ? previousPlane : currentPlane;
+		int pathWeight = predecessorPlane[cell - moveOffset[move]] +
+			moveWeight(move, seq1Loc, seq2Loc, seq3Loc);
+
+		if (pathWeight > weight)
+			weight = pathWeight;
+	}
+
+	return weight;
+}
+
+// findPathLinearSpace()
+//  Purpose:
+//		Finds the same path as findPathFullTensor() keeping only O(n^2)
+//		cells in memory.  findPathEnds() finds the start and end cells of
+//		the path, and alignBox() recovers the moves between them.
+//  Postconditions:
+//		- highestWeight, pathStart, pathEnd and pathMoves will be set
+void ThreeWayAligner::findPathLinearSpace() {
+	findPathEnds();
+	alignBox(pathStart, pathEnd);
+}
+
+// findPathEnds()
+//  Purpose:
+//		Runs the dynamic program keeping only two i planes of scores.  With
+//		each score the start cell of its path is carried along, so the
+//		start of the highest weight path is known once its end is found.
+//  Postconditions:
+//		- highestWeight, pathStart and pathEnd will be set
+void ThreeWayAligner::findPathEnds() {
+
+	// Offsets within a plane to the start cell of each incoming edge
+	size_t planeSize = (size_t) (seq2Length + 1) * (seq3Length + 1);
+	size_t moveOffset[8];
+	for (unsigned char move = 1; move <= 7; move++) {
+		moveOffset[move] =
+			((move & seq2Move) ? seq3Length + 1 : 0) +
+			((move & seq3Move) ? 1 : 0);
+	}
+
+	// Scores and path start cells for the previous and current i plane
+	vector<int> previousScores(planeSize), currentScores(planeSize);
+	vector<Cell> previousStarts(planeSize), currentStarts(planeSize);
+
+	highestWeight = 0;
+	pathEnd.seq1Loc = pathEnd.seq2Loc = pathEnd.seq3Loc = 0;
+	pathStart = pathEnd;
+
+	for (int seq1Loc = 0; seq1Loc <= seq1Length; seq1Loc++) {
+		size_t cell = 0;
+		for (int seq2Loc = 0; seq2Loc <= seq2Length; seq2Loc++) {
+			for (int seq3Loc = 0; seq3Loc <= seq3Length; seq3Loc++, cell++) {
+
+				unsigned char available =
+					((seq1Loc > 0) ? seq1Move : 0) |
+					((seq2Loc > 0) ? seq2Move : 0) |
+					((seq3Loc > 0) ? seq3Move : 0);
+
+				// Start with the trivial path of starting at this cell
+				int weight = 0;
+				unsigned char bestMove = 0;
+
+				int weights[8];
+				cellMoveWeights(seq1Loc, seq2Loc, seq3Loc, weights);
+				for (unsigned char move = 7; move >= 1; move--) {
+					if ((move & available) != move)
+						continue;
+
+					vector<int>& predecessorScores = (move & seq1Move) ? previousScores : currentScores;
+					int pathWeight = predecessorScores[cell - moveOffset[move]] + weights[move];
+
+					if (pathWeight > weight) {
+						weight = pathWeight;
+						bestMove = move;
+					}
+				}
+
+				currentScores[cell] = weight;
+				if (bestMove == 0) {
+					currentStarts[cell].seq1Loc = seq1Loc;
+					currentStarts[cell].seq2Loc = seq2Loc;
+					currentStarts[cell].seq3Loc = seq3Loc;
+				}
+				else {
+					vector<Cell>& predecessorStarts = (bestMove & seq1Move) ? previousStarts : currentStarts;
+					currentStarts[cell] = predecessorStarts[cell - moveOffset[bestMove]];
+				}
+
+				// Set the end of the highest weight path
+				if (weight > highestWeight) {
+					highestWeight = weight;
+					pathEnd.seq1Loc = seq1Loc;
+					pathEnd.seq2Loc = seq2Loc;
+					pathEnd.seq3Loc = seq3Loc;
+					pathStart = currentStarts[cell];
+				}
+
+			} // seq3Loc - fasta3
+		} // seq2Loc - fasta2
+
+		previousScores.swap(currentScores);
+		previousStarts.swap(currentStarts);
+	} // seq1Loc - fasta1
+}
+
+// alignBox(Cell from, Cell to)
+//  Purpose:
+//		Appends the moves of the highest weight path from cell from to
+//		cell to (both on the path) to pathMoves.
+//
+//		Within the box between two cells of the path, the path is the one
+//		found by the dynamic program over the box alone, where from is the
+//		only place a path can start.  The box is split at a middle i plane:
+//		the dynamic program is run over the box with every cell on or after
+//		the middle plane carrying the first cell where its path enters the
+//		middle plane.  The path of the to cell enters at cell C, so the
+//		boxes (from, C - move) and (C, to) are solved next.  Small boxes
+//		are solved with a full tensor (alignBoxFullTensor()).
+//  Postconditions:
+//		- the moves from from to to are appended to pathMoves
+void ThreeWayAligner::alignBox(Cell from, Cell to) {
+
+	int seq1Span = to.seq1Loc - from.seq1Loc;
+	int seq2Span = to.seq2Loc - from.seq2Loc;
+	int seq3Span = to.seq3Loc - from.seq3Loc;
+
+	size_t planeSize = (size_t) (seq2Span + 1) * (seq3Span + 1);
+	if (seq1Span <= 1 || planeSize * (seq1Span + 1) <= linearSpaceLeafCells) {
+		alignBoxFullTensor(from, to);
+		return;
+	}
+
+	// Offsets within a plane of the box to the start cell of each incoming edge
+	size_t moveOffset[8];
+	for (unsigned char move = 1; move <= 7; move++) {
+		moveOffset[move] =
+			((move & seq2Move) ? seq3Span + 1 : 0) +
+			((move & seq3Move) ? 1 : 0);
+	}
+
+	// Scores for the previous and current i plane, and for the cells on or
+	// after the middle plane, the cell (within the plane) and move where the
+	// path entered the middle plane
+	int middle = from.seq1Loc + (seq1Span + 1) / 2;
+	vector<int> previousScores(planeSize), currentScores(planeSize);
+	vector<size_t> previousEntries(planeSize), currentEntries(planeSize);
+
+	for (int seq1Loc = from.seq1Loc; seq1Loc <= to.seq1Loc; seq1Loc++) {
+		size_t cell = 0;
+		for (int seq2Loc = from.seq2Loc; seq2Loc <= to.seq2Loc; seq2Loc++) {
+			for (int seq3Loc = from.seq3Loc; seq3Loc <= to.seq3Loc; seq3Loc++, cell++) {
+
+				// Only moves that start inside the box
+				unsigned char available =
+					((seq1Loc > from.seq1Loc) ? seq1Move : 0) |
+					((seq2Loc > from.seq2Loc) ? seq2Move : 0) |
+					((seq3Loc > from.seq3Loc) ? seq3Move : 0);
+
+				// Paths can only start at from
+				int weight = (available == 0) ? 0 : unreachable;
+				unsigned char bestMove = 0;
+
+				int weights[8];
+				cellMoveWeights(seq1Loc, seq2Loc, seq3Loc, weights);
+				for (unsigned char move = 7; move >= 1; move--) {
+					if ((move & available) != move)
+						continue;
+
+					vector<int>& predecessorScores = (move & seq1Move) ? previousScores : currentScores;
+					int pathWeight = predecessorScores[cell - moveOffset[move]] + weights[move];
+
+					if (pathWeight > weight) {
+						weight = pathWeight;
+						bestMove = move;
+					}
+				}
+
+				currentScores[cell] = weight;
+
+				// Carry the entry into the middle plane along (cell * 8 + move)
+				if (seq1Loc == middle && (bestMove & seq1Move))
+					currentEntries[cell] = cell * 8 + bestMove;
+				else if (seq1Loc >= middle) {
+					vector<size_t>& predecessorEntries = (bestMove & seq1Move) ? previousEntries : currentEntries;
+					currentEntries[cell] = predecessorEntries[cell - moveOffset[bestMove]];
+				}
+
+			} // seq3Loc - fasta3
+		} // seq2Loc - fasta2
+
+		if (seq1Loc < to.seq1Loc) {
+			previousScores.swap(currentScores);
+			previousEntries.swap(currentEntries);
+		}
+	} // seq1Loc - fasta1
+
+	// Cell where the path to the to cell enters the middle plane
+	size_t entry = currentEntries[planeSize - 1];
+	unsigned char entryMove = entry % 8;
+	size_t entryCell = entry / 8;
+
+	Cell middleCell;
+	middleCell.seq1Loc = middle;
+	middleCell.seq2Loc = from.seq2Loc + entryCell / (seq3Span + 1);
+	middleCell.seq3Loc = from.seq3Loc + entryCell % (seq3Span + 1);
+
+	Cell beforeMiddleCell;
+	beforeMiddleCell.seq1Loc = middle - 1;
+	beforeMiddleCell.seq2Loc = middleCell.seq2Loc - ((entryMove & seq2Move) ? 1 : 0);
+	beforeMiddleCell.seq3Loc = middleCell.seq3Loc - ((entryMove & seq3Move) ? 1 : 0);
+
+	// Solve the two halves
+	alignBox(from, beforeMiddleCell);
+	pathMoves.push_back(entryMove);
+	alignBox(middleCell, to);
+}
+
+// alignBoxFullTensor(Cell from, Cell to)
+//  Purpose:
+//		Solves alignBox() with the move for every cell of the box in memory.
+//  Postconditions:
+//		- the moves from from to to are appended to pathMoves
+void ThreeWayAligner::alignBoxFullTensor(Cell from, Cell to) {
+
+	int seq1Span = to.seq1Loc - from.seq1Loc;
+	int seq2Span = to.seq2Loc - from.seq2Loc;
+	int seq3Span = to.seq3Loc - from.seq3Loc;
+
+	// Offsets within the box to the start cell of each incoming edge
+	size_t seq3Step = 1;
+	size_t seq2Step = seq3Span + 1;
+	size_t seq1Step = seq2Step * (seq2Span + 1);
+	size_t moveOffset[8];
+	for (unsigned char move = 1; move <= 7; move++) {
+		moveOffset[move] =
+			((move & seq1Move) ? seq1Step : 0) +
+			((move & seq2Move) ? seq2Step : 0) +
+			((move & seq3Move) ? seq3Step : 0);
+	}
+
+	size_t cellCount = seq1Step * (seq1Span + 1);
+	vector<int>& scores = workspace->scores;
+	PackedTraceback& moves = workspace->moves;
+	scores.resize(cellCount);
+	moves.resize((size_t) (seq1Span + 1) * (seq2Span + 1), seq3Span + 1);
+	vector<unsigned char> rowMoves(seq3Span + 1);
+
+	size_t cell = 0;
+	size_t row = 0;
+	for (int seq1Loc = from.seq1Loc; seq1Loc <= to.seq1Loc; seq1Loc++) {
+		for (int seq2Loc = from.seq2Loc; seq2Loc <= to.seq2Loc; seq2Loc++, row++) {
+			for (int seq3Loc = from.seq3Loc; seq3Loc <= to.seq3Loc; seq3Loc++, cell++) {
+
+				// Only moves that start inside the box
+				unsigned char available =
+					((seq1Loc > from.seq1Loc) ? seq1Move : 0) |
+					((seq2Loc > from.seq2Loc) ? seq2Move : 0) |
+					((seq3Loc > from.seq3Loc) ? seq3Move : 0);
+
+				// Paths can only start at from
+				int weight = (available == 0) ? 0 : unreachable;
+				unsigned char bestMove = 0;
+
+				int weights[8];
+				cellMoveWeights(seq1Loc, seq2Loc, seq3Loc, weights);
+				for (unsigned char move = 7; move >= 1; move--) {
+					if ((move & available) != move)
+						continue;
+
+					int pathWeight = scores[cell - moveOffset[move]] + weights[move];
+
+					if (pathWeight > weight) {
+						weight = pathWeight;
+						bestMove = move;
+					}
+				}
+
+				scores[cell] = weight;
+				rowMoves[seq3Loc - from.seq3Loc] = bestMove;
+
+			} // seq3Loc - fasta3
+
+			moves.setRow(row, 0, rowMoves.data(), seq3Span + 1);
+		} // seq2Loc - fasta2
+	} // seq1Loc - fasta1
+
+	// Walk backwards from the to cell to the from cell
+	size_t firstMove = pathMoves.size();
+	Cell boxCell = { seq1Span, seq2Span, seq3Span };
+	while (true) {
+		unsigned char move = moves.getMove((size_t) boxCell.seq1Loc * (seq2Span + 1) + boxCell.seq2Loc, boxCell.seq3Loc);
+		if (move == 0)
+			break;
+
+		pathMoves.push_back(move);
+		boxCell.seq1Loc -= (move & seq1Move) ? 1 : 0;
+		boxCell.seq2Loc -= (move & seq2Move) ? 1 : 0;
+		boxCell.seq3Loc -= (move & seq3Move) ? 1 : 0;
+	}
+	reverse(pathMoves.begin() + firstMove, pathMoves.end());
+}
+
+// bool isPruned()
+//  Purpose:
+//		Returns true if banded or X-drop mode is on
+bool ThreeWayAligner::isPruned() {
+	return bandWidth > 0 || xDrop > 0;
+}
+
+// findPathPruned()
+//  Purpose:
+//		Runs the dynamic program over only the cells that can still be on a
+//		good path.  The cells of each (i,j) row along fasta3 that are
+//		computed form one run of k, and the rows are stored packed one
+//		after the other, so the memory used is about the number of cells
+//		computed.
+//
+//		Banded mode leaves out the cells where two of the coordinates are
+//		more than bandWidth apart.  X-drop mode leaves out the cells that
+//		can only be reached through cells whose score is more than xDrop
+//		below the highest weight found so far: each row is computed from
+//		the first cell a live cell of an earlier row leads to, and the dead
+//		cells at either end of the row are then dropped.  Once the highest
+//		weight is more than xDrop, a path starting in a cell that is not
+//		computed could never catch up, so the trivial paths there are lost
+//		too.
+//
+//		The cells are computed in vertex order on one thread, with the same
+//		tie breaking as the dense tensor, so if nothing on or near the path
+//		was pruned the result is the same.  prunedExact is only set when
+//		that is proven: every path that does not stay in the live cells is
+//		bounded below the highest weight, using the score where it left
+//		them plus the pairwise suffix scores of the cell it left from (see
+//		pairSuffixScores()).
+//  Postconditions:
+//		- highestWeight, pathStart, pathEnd, pathMoves and prunedExact will be set
+void ThreeWayAligner::findPathPruned() {
+
+	int width = (bandWidth > 0) ? bandWidth : max(seq1Length, max(seq2Length, seq3Length));
+	size_t rowCount = (size_t) (seq1Length + 1) * (seq2Length + 1);
+
+	// For each row, where its cells are in the packed arrays, the k of its
+	// first stored cell and the range of k of its live cells (empty if
+	// rowLiveLow > rowLiveHigh)
+	vector<size_t> rowFirstCell(rowCount, 0);
+	vector<int> rowStoredLow(rowCount, 0);
+	vector<int> rowStoredHigh(rowCount, -1);
+	vector<int> rowLiveLow(rowCount, 1);
+	vector<int> rowLiveHigh(rowCount, 0);
+	vector<int> prunedScores;
+	vector<unsigned char> prunedMoves;
+
+	// Score of a cell for the cells after it (unreachable if it was pruned)
+	auto liveScore = [&](int seq1Loc, int seq2Loc, int seq3Loc) {
+		size_t row = (size_t) seq1Loc * (seq2Length + 1) + seq2Loc;
+		if (seq3Loc < rowLiveLow[row] || seq3Loc > rowLiveHigh[row])
+			return unreachable;
+		return prunedScores[rowFirstCell[row] + seq3Loc - rowStoredLow[row]];
+	};
+
+	highestWeight = 0;
+	pathEnd.seq1Loc = pathEnd.seq2Loc = pathEnd.seq3Loc = 0;
+
+	for (int seq1Loc = 0; seq1Loc <= seq1Length; seq1Loc++) {
+		for (int seq2Loc = 0; seq2Loc <= seq2Length; seq2Loc++) {
+			size_t row = (size_t) seq1Loc * (seq2Length + 1) + seq2Loc;
+			if (abs(seq1Loc - seq2Loc) > width)
+				continue;
+
+			// Cells of the row inside the band
+			int bandLow = max(0, max(seq1Loc, seq2Loc) - width);
+			int bandHigh = min(seq3Length, min(seq1Loc, seq2Loc) + width);
+			int low = bandLow;
+			int high = bandHigh;
+
+			// With X-drop, only start at the first cell a live cell leads to
+			int threshold = highestWeight - xDrop;
+			bool dropping = xDrop > 0 && threshold > 0;
+			int reachHigh = bandHigh;  // last cell an earlier row leads to
+			if (dropping) {
+				low = bandHigh + 1;
+				reachHigh = -1;
+				for (unsigned char move = seq2Move; move <= (seq1Move | seq2Move); move += seq2Move) {
+					int previous1Loc = seq1Loc - ((move & seq1Move) ? 1 : 0);
+					int previous2Loc = seq2Loc - ((move & seq2Move) ? 1 : 0);
+					if (previous1Loc < 0 || previous2Loc < 0)
+						continue;
+
+					size_t previousRow = (size_t) previous1Loc * (seq2Length + 1) + previous2Loc;
+					if (rowLiveLow[previousRow] <= rowLiveHigh[previousRow]) {
+						low = min(low, rowLiveLow[previousRow]);
+						reachHigh = max(reachHigh, rowLiveHigh[previousRow] + 1);
+					}
+				}
+				low = max(low, bandLow);
+			}
+			if (low > high)
+				continue;
+
+			rowFirstCell[row] = prunedScores.size();
+			rowStoredLow[row] = low;
+
+			for (int seq3Loc = low; seq3Loc <= high; seq3Loc++) {
+
+				// Moves that are possible from the cell's location
+				unsigned char available =
+					((seq1Loc > 0) ? seq1Move : 0) |
+					((seq2Loc > 0) ? seq2Move : 0) |
+					((seq3Loc > 0) ? seq3Move : 0);
+
+				// Start with the trivial path of starting at this cell
+				int weight = 0;
+				unsigned char bestMove = 0;
+
+				int weights[8];
+				cellMoveWeights(seq1Loc, seq2Loc, seq3Loc, weights);
+				for (unsigned char move = 7; move >= 1; move--) {
+					if ((move & available) != move)
+						continue;
+
+					// The cell before in this row is not live until the row
+					// is done, so it is read directly
+					int startScore;
+					if (move == seq3Move) {
+						if (seq3Loc == low)
+							continue;  // the cell before was pruned
+						startScore = prunedScores.back();
+					}
+					else {
+						startScore = liveScore(
+							seq1Loc - ((move & seq1Move) ? 1 : 0),
+							seq2Loc - ((move & seq2Move) ? 1 : 0),
+							seq3Loc - ((move & seq3Move) ? 1 : 0));
+					}
+
+					int pathWeight = startScore + weights[move];
+					if (pathWeight > weight) {
+						weight = pathWeight;
+						bestMove = move;
+					}
+				}
+
+				prunedScores.push_back(weight);
+				prunedMoves.push_back(bestMove);
+
+				// Set the end of the highest weight path
+				if (weight > highestWeight) {
+					highestWeight = weight;
+					pathEnd.seq1Loc = seq1Loc;
+					pathEnd.seq2Loc = seq2Loc;
+					pathEnd.seq3Loc = seq3Loc;
+				}
+
+				// Past the cells earlier rows lead to, a dead cell can only
+				// be followed by dead cells (the move 1 weights are gaps)
+				if (dropping && seq3Loc > reachHigh && weight < threshold) {
+					high = seq3Loc;
+					break;
+				}
+			} // seq3Loc - fasta3
+
+			// Drop the dead cells at either end of the row
+			int liveLow = low;
+			int liveHigh = high;
+			if (dropping) {
+				const int* rowScores = &prunedScores[rowFirstCell[row]];
+				while (liveLow <= liveHigh && rowScores[liveLow - low] < threshold)
+					liveLow++;
+				while (liveHigh >= liveLow && rowScores[liveHigh - low] < threshold)
+					liveHigh--;
+			}
+			rowStoredHigh[row] = high;
+			rowLiveLow[row] = liveLow;
+			rowLiveHigh[row] = liveHigh;
+
+		} // seq2Loc - fasta2
+	} // seq1Loc - fasta1
+
+	// Walk backwards until find the start cell (move is 0)
+	pathStart = pathEnd;
+	while (true) {
+		int seq1Loc = pathStart.seq1Loc;
+		int seq2Loc = pathStart.seq2Loc;
+		int seq3Loc = pathStart.seq3Loc;
+
+		size_t row = (size_t) seq1Loc * (seq2Length + 1) + seq2Loc;
+		unsigned char move = prunedMoves[rowFirstCell[row] + seq3Loc - rowStoredLow[row]];
+		if (move == 0)
+			break;
+
+		pathMoves.push_back(move);
+		pathStart.seq1Loc -= (move & seq1Move) ? 1 : 0;
+		pathStart.seq2Loc -= (move & seq2Move) ? 1 : 0;
+		pathStart.seq3Loc -= (move & seq3Move) ? 1 : 0;
+	}
+	reverse(pathMoves.begin(), pathMoves.end());
+
+	// Each pair of sequences bounds what the rest of a path can add (see
+	// pairSuffixScores()), and the column of a move of only the third
+	// sequence adds the gap-gap score to the pair
+	vector<int> suffix12, suffix13, suffix23;
+	pairSuffixScores(seq1Indexes, seq2Indexes, suffix12);
+	pairSuffixScores(seq1Indexes, seq3Indexes, suffix13);
+	pairSuffixScores(seq2Indexes, seq3Indexes, suffix23);
+	long long gapGapGain = max(0, matrix->scoreRow(gapIndex)[gapIndex]);
+	size_t stride2 = seq2Length + 1;
+	size_t stride3 = seq3Length + 1;
+
+	auto suffixBound = [&](int seq1Loc, int seq2Loc, int seq3Loc) {
+		return (long long) suffix12[seq1Loc * stride2 + seq2Loc] +
+			suffix13[seq1Loc * stride3 + seq3Loc] + suffix23[seq2Loc * stride3 + seq3Loc] +
+			gapGapGain * ((seq1Length - seq1Loc) + (seq2Length - seq2Loc) + (seq3Length - seq3Loc));
+	};
+	auto computed = [&](int seq1Loc, int seq2Loc, int seq3Loc) {
+		size_t row = (size_t) seq1Loc * stride2 + seq2Loc;
+		return seq3Loc >= rowStoredLow[row] && seq3Loc <= rowStoredHigh[row];
+	};
+
+	// A path that is not all live cells either reaches a computed cell
+	// that is not live through live cells (so it weighs at most the cell's
+	// score plus its suffix bound), leaves the live cells for a cell that
+	// was not computed (at most the last live cell's score plus its bound),
+	// or starts at a cell that was not computed (at most that cell's bound).
+	long long prunedBound = LLONG_MIN;
+	for (int seq1Loc = 0; seq1Loc <= seq1Length; seq1Loc++) {
+		for (int seq2Loc = 0; seq2Loc <= seq2Length; seq2Loc++) {
+			size_t row = (size_t) seq1Loc * stride2 + seq2Loc;
+			for (int seq3Loc = rowStoredLow[row]; seq3Loc <= rowStoredHigh[row]; seq3Loc++) {
+				bool bounded = seq3Loc < rowLiveLow[row] || seq3Loc > rowLiveHigh[row];
+				for (unsigned char move = 1; move <= 7 && !bounded; move++) {
+					int next1Loc = seq1Loc + ((move & seq1Move) ? 1 : 0);
+					int next2Loc = seq2Loc + ((move & seq2Move) ? 1 : 0);
+					int next3Loc = seq3Loc + ((move & seq3Move) ? 1 : 0);
+					if (next1Loc <= seq1Length && next2Loc <= seq2Length && next3Loc <= seq3Length)
+						bounded = !computed(next1Loc, next2Loc, next3Loc);
+				}
+
+				if (bounded) {
+					int weight = prunedScores[rowFirstCell[row] + seq3Loc - rowStoredLow[row]];
+					prunedBound = max(prunedBound, weight + suffixBound(seq1Loc, seq2Loc, seq3Loc));
+				}
+			}
+		}
+	}
+
+	// The cells of a row that were not computed are the k below and above
+	// its stored run, bounded with the best pair suffix scores over those k
+	vector<int> below23, above23;
+	prefixSuffixMaxima(suffix23, seq2Length, seq3Length, below23, above23);
+	vector<int> below13, above13;
+	prefixSuffixMaxima(suffix13, seq1Length, seq3Length, below13, above13);
+	long long gapGapRest = gapGapGain * ((long long) seq1Length + seq2Length + seq3Length);
+	for (int seq1Loc = 0; seq1Loc <= seq1Length; seq1Loc++) {
+		for (int seq2Loc = 0; seq2Loc <= seq2Length; seq2Loc++) {
+			size_t row = (size_t) seq1Loc * stride2 + seq2Loc;
+			size_t first13 = seq1Loc * stride3;
+			size_t first23 = seq2Loc * stride3;
+			long long rowBound = suffix12[row] + gapGapRest;
+
+			int storedLow = rowStoredLow[row];
+			int storedHigh = rowStoredHigh[row];
+			if (storedLow > storedHigh)
+				prunedBound = max(prunedBound, rowBound + below13[first13 + seq3Length] + below23[first23 + seq3Length]);
+			else {
+				if (storedLow > 0)
+					prunedBound = max(prunedBound, rowBound + below13[first13 + storedLow - 1] + below23[first23 + storedLow - 1]);
+				if (storedHigh < seq3Length)
+					prunedBound = max(prunedBound, rowBound + above13[first13 + storedHigh + 1] + above23[first23 + storedHigh + 1]);
+			}
+		}
+	}
+
+	// A pruned path that only ties the highest weight could still come
+	// first in vertex order, so the bound has to be strictly lower
+	prunedExact = prunedBound < highestWeight;
+}
+
+// pairSuffixScores(const EncodedSequence::MatrixIndexes& indexesA, const EncodedSequence::MatrixIndexes& indexesB, vector<int>& scores)
+//  Purpose:
+//		Sets scores[a * (lengthB + 1) + b] to the highest weight of a
+//		pairwise path from (a,b) forward (at least 0, the empty path),
+//		scored with the matrix's pair scores.  The columns of a 3-way path
+//		from (i,j,k) give a pairwise path for each pair of sequences (less
+//		the columns with a gap in both), so the sum of the three pair
+//		scores bounds the rest of the 3-way path (Carrillo-Lipman).
+void ThreeWayAligner::pairSuffixScores(const EncodedSequence::MatrixIndexes& indexesA,
+	const EncodedSequence::MatrixIndexes& indexesB, vector<int>& scores) {
+
+	int lengthA = indexesA.size();
+	int lengthB = indexesB.size();
+	size_t stride = lengthB + 1;
+	scores.assign((size_t) (lengthA + 1) * stride, 0);
+	const int* gapScores = matrix->scoreRow(gapIndex);
+
+	for (int locA = lengthA; locA >= 0; locA--) {
+		const int* residueScores = (locA < lengthA) ? matrix->scoreRow(indexesA[locA]) : NULL;
+		int* current = &scores[locA * stride];
+		const int* next = (locA < lengthA) ? &scores[(locA + 1) * stride] : NULL;
+
+		for (int locB = lengthB; locB >= 0; locB--) {
+			int best = 0;
+			if (locB < lengthB)
+				best = max(best, gapScores[indexesB[locB]] + current[locB + 1]);
+			if (next != NULL) {
+				best = max(best, residueScores[gapIndex] + next[locB]);
+				if (locB < lengthB)
+					best = max(best, residueScores[indexesB[locB]] + next[locB + 1]);
+			}
+			current[locB] = best;
+		}
+	}
+}
+
+// prefixSuffixMaxima(const vector<int>& scores, int lengthA, int lengthB, vector<int>& below, vector<int>& above)
+//  Purpose:
+//		For each row a of the (lengthA + 1) x (lengthB + 1) scores, sets
+//		below[a, b] to the highest score of the row at b or before, and
+//		above[a, b] to the highest at b or after.
+void ThreeWayAligner::prefixSuffixMaxima(const vector<int>& scores, int lengthA, int lengthB,
+	vector<int>& below, vector<int>& above) {
+
+	size_t stride = lengthB + 1;
+	below.resize(scores.size());
+	above.resize(scores.size());
+
+	for (int locA = 0; locA <= lengthA; locA++) {
+		size_t first = locA * stride;
+		below[first] = scores[first];
+		for (int locB = 1; locB <= lengthB; locB++)
+			below[first + locB] = max(below[first + locB - 1], scores[first + locB]);
+
+		above[first + lengthB] = scores[first + lengthB];
+		for (int locB = lengthB - 1; locB >= 0; locB--)
+			above[first + locB] = max(above[first + locB + 1], scores[first + locB]);
+	}
+}
+
+// int moveWeight(unsigned char move, int seq1Loc, int seq2Loc, int seq3Loc)
+//  Purpose:
+//		Returns the weight of the edge that ends at (i,j,k) using move,
+//		i.e. the sum of pairs weight of the column for the move.
+int ThreeWayAligner::moveWeight(unsigned char move, int seq1Loc, int seq2Loc, int seq3Loc) {
+	return matrix->sumOfPairsWeightByIndex(
+		(move & seq1Move) ? seq1Indexes[seq1Loc - 1] : gapIndex,
+		(move & seq2Move) ? seq2Indexes[seq2Loc - 1] : gapIndex,
+		(move & seq3Move) ? seq3Indexes[seq3Loc - 1] : gapIndex);
+}
+
+// cellMoveWeights(int seq1Loc, int seq2Loc, int seq3Loc, int weights[8])
+//  Purpose:
+//		Sets weights[move] to moveWeight(move, i, j, k) for moves 1 to 7
+//		(moves that would start outside the tensor get gap weights).
+//		The index of each residue is only read from its code once.
+void ThreeWayAligner::cellMoveWeights(int seq1Loc, int seq2Loc, int seq3Loc, int weights[8]) {
+	int index1 = (seq1Loc > 0) ? seq1Indexes[seq1Loc - 1] : gapIndex;
+	int index2 = (seq2Loc > 0) ? seq2Indexes[seq2Loc - 1] : gapIndex;
+	int index3 = (seq3Loc > 0) ? seq3Indexes[seq3Loc - 1] : gapIndex;
+
+	for (unsigned char move = 1; move <= 7; move++) {
+		weights[move] = matrix->sumOfPairsWeightByIndex(
+			(move & seq1Move) ? index1 : gapIndex,
+			(move & seq2Move) ? index2 : gapIndex,
+			(move & seq3Move) ? index3 : gapIndex);
+	}
+}
+
+// encodeSequences()
+//  Purpose:
+//		Looks up the matrix index of each residue code of the sequences
+//		(see EncodedSequence::MatrixIndexes), so the index of a residue is
+//		read from its code and only each code is looked up in the matrix.
+//		Throws out_of_range if a sequence has a char that is not a residue.
+//  Postconditions:
+//		seq1Indexes, seq2Indexes, seq3Indexes and gapIndex will be set
+void ThreeWayAligner::encodeSequences() {
+	gapIndex = matrix->getGapIndex();
+
+	// The codes of each sequence are only looked up once in the matrix
+	seq1Indexes = EncodedSequence::MatrixIndexes(encoded1, *matrix);
+	seq2Indexes = EncodedSequence::MatrixIndexes(encoded2, *matrix);
+	seq3Indexes = EncodedSequence::MatrixIndexes(encoded3, *matrix);
+}
+
+// ResultCache::Key cacheKey()
+//  Purpose:
+//		Returns the key of the results in a ResultCache: the
+//		sequences, their matrix indexes, the sum of pairs scores of the
+//		matrix, and the score only, banded and X-drop options (linear
+//		space mode and the number of threads do not change the results).
+ResultCache::Key ThreeWayAligner::cacheKey() {
+	ResultCache::Key key;
+	key.add("ThreeWayAligner 2");
+
+	// The sequences (the labels of the results) and their indexes, a
+	// block of residues at a time
+	const EncodedSequence* sequences[3] = { &encoded1, &encoded2, &encoded3 };
+	const EncodedSequence::MatrixIndexes* indexes[3] = { &seq1Indexes, &seq2Indexes, &seq3Indexes };
+	for (int seq = 0; seq < 3; seq++) {
+		int length = sequences[seq]->getLength();
+		key.add((long long) length);
+
+		char residues[4096];
+		unsigned char residueIndexes[4096];
+		for (int first = 0; first < length; first += 4096) {
+			int count = min(4096, length - first);
+			for (int t = 0; t < count; t++)
+				residues[t] = sequences[seq]->at(first + t);
+			indexes[seq]->copy(first, count, residueIndexes);
+			key.add(residues, count);
+			key.add(residueIndexes, count);
+		}
+	}
+	key.add((long long) gapChar);
+
+	// The scores of the matrix (including the gap cost)
+	int indexCount = matrix->getIndexCount();
+	key.add((long long) indexCount);
+	key.add((long long) gapIndex);
+	for (int index1 = 0; index1 < indexCount; index1++) {
+		for (int index2 = 0; index2 < indexCount; index2++)
+			key.add(matrix->sumOfPairsRow(index1, index2), indexCount * sizeof(int));
+	}
+
+	// The options that change the results
+	key.add((long long) (scoreOnly ? 1 : 0));
+	key.add((long long) max(bandWidth, 0));
+	key.add((long long) max(xDrop, 0));
+
+	return key;
+}
+
+// writeResultBody(OutputBuffer& out)
+//  Purpose:
+//		Writes the results between the results header and footer of
+//		writeResult(), which is what is kept in a ResultCache.
+void ThreeWayAligner::writeResultBody(OutputBuffer& out) {
+	// Edge Info (Weights and Histogram)
+	vector<string> labels = getEdgeLabels();
+	out.beginResult("edge_weights");
+	writeEdgeWeights(out, labels);
+	out.endResult();
+	out.beginResult("edge_histogram");
+	writeEdgeFrequencies(out, labels);
+	out.endResult();
+
+	// Path Info
+	if (!pathFound)
+		out.xmlResult("path", "No Path Found!");
+	else {
+		out.xmlResult("score", (double) highestWeight, 6);
+
+		// The path is not known in score only mode
+		if (scoreOnly) {
+			out.beginResult("end_vertex");
+			writeCellLabel(out, pathEnd);
+			out.endResult();
+		}
+		else {
+			out.beginResult("beginning_vertex");
+			writeCellLabel(out, pathStart);
+			out.endResult();
+			out.beginResult("end_vertex");
+			writeCellLabel(out, pathEnd);
+			out.endResult();
+			out.beginResult("path");
+			writePath(out);
+			out.endResult();
+		}
+
+		// Whether pruning could have changed the path
+		if (isPruned())
+			out.xmlResult("exact", prunedExact ? "true" : "false");
+	}
+}
+
+// writeCellLabel(OutputBuffer& out, Cell& cell)
+//  Purpose:
+//		Writes the label WDAGraphFileBuilder uses for the vertex (i,j,k)
+//			<<i>>,<<j>>,<<k>>
+void ThreeWayAligner::writeCellLabel(OutputBuffer& out, Cell& cell) {
+	out.write(cell.seq1Loc);
+	out.write(',');
+	out.write(cell.seq2Loc);
+	out.write(',');
+	out.write(cell.seq3Loc);
+}
+
+// string moveLabel(unsigned char move, int seq1Loc, int seq2Loc, int seq3Loc)
+//  Purpose:
+//		Returns the label of the edge that ends at (i,j,k) using move, i.e.
+//		the column of aligned residues & gap characters for the move.
+string ThreeWayAligner::moveLabel(unsigned char move, int seq1Loc, int seq2Loc, int seq3Loc) {
+	string label(3, gapChar);
+
+	if (move & seq1Move)
+		label[0] = encoded1.at(seq1Loc - 1);
+	if (move & seq2Move)
+		label[1] = encoded2.at(seq2Loc - 1);
+	if (move & seq3Move)
+		label[2] = encoded3.at(seq3Loc - 1);
+
+	return label;
+}
+
+// writeEdgeWeights(OutputBuffer& out, vector<string>& labels)
+//  Purpose:
+//		Writes a comma delimited string describing each of the edge labels
+//		in the edit graph (from getEdgeLabels()) and its correpsonding weight.
+//
+//		Format:		<edge label> = <edge weight>
+void ThreeWayAligner::writeEdgeWeights(OutputBuffer& out, vector<string>& labels) {
+
+	// Weights are printed as doubles to match the WDAGraph output
+	for (size_t label = 0; label < labels.size(); label++) {
+		if (label > 0)
+			out.write(", ");
+
+		double weight = matrix->sumOfPairsWeight(labels[label][0], labels[label][1], labels[label][2]);
+		out.write(labels[label]);
+		out.write('=');
+		out.write(weight, 3);
+	}
+}
+
+// writeEdgeFrequencies(OutputBuffer& out, vector<string>& labels)
+//  Purpose:
+//		Writes a comma delimited string describing each of the edge labels
+//		in the edit graph and its frequency, as reported by WDAGraph for the
+//		builder's graph file.
+//
+//		Format:		<edge label> = <edge frequency>
+void ThreeWayAligner::writeEdgeFrequencies(OutputBuffer& out, vector<string>& labels) {
+
+	// WDAGraph reports each label of the builder's graph file once
+	for (size_t label = 0; label < labels.size(); label++) {
+		if (label > 0)
+			out.write(", ");
+
+		out.write(labels[label]);
+		out.write("=1");
+	}
+}
+
+// vector<string> getEdgeLabels()
+//  Purpose:
+//		Returns the distinct edge labels of the edit graph in sorted order.
+//		The label of a move is present once for every combination of the
+//		residues in the sequences that advance on the move.
+vector<string> ThreeWayAligner::getEdgeLabels() {
+
+	// Residues used in each sequence, the gap char stands in for
+	// a sequence that does not advance
+	set<char> residues1, residues2, residues3;
+	for (int loc = 0; loc < seq1Length; loc++)
+		residues1.insert(encoded1.at(loc));
+	for (int loc = 0; loc < seq2Length; loc++)
+		residues2.insert(encoded2.at(loc));
+	for (int loc = 0; loc < seq3Length; loc++)
+		residues3.insert(encoded3.at(loc));
+	set<char> gapOnly;
+	gapOnly.insert(gapChar);
+
+	set<string> labels;
+	for (unsigned char move = 1; move <= 7; move++) {
+		set<char>& column1 = (move & seq1Move) ? residues1 : gapOnly;
+		set<char>& column2 = (move & seq2Move) ? residues2 : gapOnly;
+		set<char>& column3 = (move & seq3Move) ? residues3 : gapOnly;
+
+		for (char residue1 : column1) {
+			for (char residue2 : column2) {
+				for (char residue3 : column3) {
+					string label;
+					label += residue1;
+					label += residue2;
+					label += residue3;
+					labels.insert(label);
+				}
+			}
+		}
+	}
+
+	return vector<string>(labels.begin(), labels.end());
+}
+
+// writePath(OutputBuffer& out)
+//  Purpose:
+//		Writes a string representing the edge labels for the highest weight
+//		path in the same form as WDAGraph::writePath().
+void ThreeWayAligner::writePath(OutputBuffer& out) {
+
+	// Walk path backwards and build string
+	size_t pathStart = out.getSize();
+	Cell cell = pathEnd;
+	for (size_t moveIndex = pathMoves.size(); moveIndex > 0; moveIndex--) {
+		unsigned char move = pathMoves[moveIndex - 1];
+
+		// Add the label for the move to the buffer
+		out.write(moveLabel(move, cell.seq1Loc, cell.seq2Loc, cell.seq3Loc));
+		out.write('\n');
+
+		// Walk backwards one cell
+		cell.seq1Loc -= (move & seq1Move) ? 1 : 0;
+		cell.seq2Loc -= (move & seq2Move) ? 1 : 0;
+		cell.seq3Loc -= (move & seq3Move) ? 1 : 0;
+	}
+
+	// Reverse what was written (since we built the string backwards)
+	out.reverse(pathStart);
+}
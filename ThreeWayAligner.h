@@ -0,0 +1,485 @@
+/*
+ * ThreeWayAligner.h
+ *
+ *	This is the header file for the ThreeWayAligner object. The
+ *  ThreeWayAligner finds the highest weight path through the edit graph
+ *  for three fasta files without building the graph explicitly.
+ *
+ *  The edit graph that WDAGraphFileBuilder writes for three sequences is
+ *  a lattice whose structure is known in advance: vertex (i,j,k) has an
+ *  incoming edge from every (i',j',k') where i' = i or i-1, j' = j or j-1,
+ *  k' = k or k-1 (and at least one of them differs).  The ThreeWayAligner
+ *  stores the highest path weight for each vertex in a dense 3D score
+ *  tensor and enumerates the edges implicitly as it runs the dynamic
+ *  program, so no graph file has to be written or parsed.
+ *
+ *  The results are the same as the results obtained by building the
+ *  graph file with WDAGraphFileBuilder and running
+ *  WDAGraph::findHighestWeightPath() over it, including the tie breaking
+ *  between paths of equal weight.
+ *
+ *  The dense tensor needs memory for every one of the (n+1)^3 cells.  In
+ *  linear space mode (setLinearSpace(true)) only a few planes of scores are
+ *  kept: a first pass finds the end and start cells of the highest weight
+ *  path, and the path between them is then recovered by recursive
+ *  splitting (in the style of Hirschberg's algorithm).  Linear space mode
+ *  gives the same score and path as the dense tensor.
+ *
+ *  Every cell of the dense tensor on the anti-diagonal plane i+j+k = d only
+ *  depends on the planes before it, so the tensor can be filled in
+ *  parallel (setThreadCount()).  The cells are grouped into tiles that fit
+ *  in cache and a wavefront of tiles is filled at a time.  The result does
+ *  not depend on the number of threads.  Within a tile, each row along
+ *  fasta3 is filled with the SIMD ScoreRowKernel.
+ *
+ *  The dense tensor is also stored tile by tile, so the cells of a tile
+ *  are next to each other in memory rather than (n+1)^2 cells apart along
+ *  fasta1.  A tile is filled in a small buffer holding the tile and the
+ *  halo of cells before it in each direction: the halo is copied in from
+ *  the neighbouring tiles (as whole rows, since rows along fasta3 are
+ *  contiguous within a tile), the cells are filled with fixed offsets to
+ *  their predecessors, and the tile is copied back.  The moves are stored
+ *  in the same tile order, one traceback row for each (i,j) of a tile.
+ *
+ *  For closely related sequences most of the tensor can not be on a good
+ *  path.  Banded mode (setBandWidth()) only computes the cells where each
+ *  pair of coordinates is within the band width of each other, and X-drop
+ *  mode (setXDrop()) stops following paths that fall more than the X-drop
+ *  below the highest weight found so far.  Both run on one thread and
+ *  store only the cells they compute.  The results then include an
+ *  "exact" result, true only if the path is proven to be the dense
+ *  tensor's: an upper bound on every path that was pruned is below the
+ *  score found.  A pruned path is bounded by its score where it left the
+ *  computed cells plus the sum of the best pairwise scores of the rest of
+ *  each pair of sequences (a Carrillo-Lipman bound).
+ *
+ *  When only the score is needed, score only mode (setScoreOnly()) keeps
+ *  no moves and does not recover the path: the dynamic program is run
+ *  with only two i planes of scores in memory, and the results leave out
+ *  the beginning vertex and the path.
+ *
+ *  With a ResultCache (setResultCache()), the results are looked up by
+ *  the sequences, the scoring matrix and the options that change the
+ *  results, and the dynamic program is only run if they are not
+ *  there (the results found are then added to the cache).
+ *
+ *  Typical Use:
+ *		ThreeWayAligner aligner(fasta1, fasta2, fasta3);
+ *		aligner.findHighestWeightPath();
+ *		cout << aligner.resultString();
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef THREEWAYALIGNER_H
+#define THREEWAYALIGNER_H
+
+#include "FastaFile.h"
+#include "PackedTraceback.h"
+#include "ScoringMatrix.h"
+#include "OutputBuffer.h"
+#include "ResultCache.h"
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <climits>
+using namespace std;
+
+class ThreeWayAligner
+{
+public:
+
+	// Buffers for the dense tensor.  An aligner uses its own workspace, but
+	// one can be shared by aligners that run one after the other so the
+	// memory is reused (see setWorkspace()).
+	struct Workspace {
+		vector<int> scores;  // in tile order (see tiledCellIndex())
+		PackedTraceback moves;  // one row for each (i,j) of each tile (see tiledMoveRow())
+		vector<vector<int>> tileScores;  // the tile (and its halo) each thread is filling
+	};
+
+	// Constuctors
+	// ==============================================
+	ThreeWayAligner(FastaFile* fasta1, FastaFile* fasta2, FastaFile* fasta3);
+
+	// Destructor
+	// =============================================
+	virtual ~ThreeWayAligner();
+
+	// Public Methods
+	// =============================================
+
+	// findHighestWeightPath()
+	//  Purpose:
+	//		Uses dynamic programming to find the highest weight path through
+	//		the edit graph for the three sequences.  The cells of the score
+	//		tensor are visited in the same order that WDAGraphFileBuilder
+	//		lists the vertices (i, then j, then k), and the weight for each
+	//		cell is the max of:
+	//			1. the trivial path of starting at the cell (weight = 0)
+	//		and 2. for each of the (up to) seven incoming edges
+	//				  - the weight of the edge's start cell + the sum of pairs
+	//					weight of the edge's column
+	//
+	//		Incoming edges are considered in the order of their start cell,
+	//		and an edge only replaces the current best when it is strictly
+	//		better, so ties are broken the same way as in WDAGraph.
+	//
+	//  Postconditions:
+	//		- highestWeight, pathStart, pathEnd and pathMoves will be set
+	void findHighestWeightPath();
+
+	// string resultString()
+	//  Purpose:
+	//		Returns an XML formatted string representing the results of the
+	//		findHighestWeightPath() function.  The format is the same as the
+	//		one returned by WDAGraph::resultString().
+	//
+	//		format:
+	//			<results type="part?" file=" <<graphFileName>> ">";
+	//			  <result type="edge_weights"> <<weights for each edge label>> </result>
+	//			  <result type="edge_histogram">  << frequencies for each edge label>> </result>
+	//			  <result type="score"> <<highest weight path score>> </result>
+	//			  <result type="beginning_vertex"> <<start vertex for path>> </result>
+	//			  <result type="ending_vertex"> <<end vertex for path>> </result>
+	//			  <result type="path"> << list of path edge labels in order>> </result>
+	//			</results>
+	//
+	//		In score only mode the beginning_vertex and path results are left out.
+	//  Preconditions:
+	//		findHighestWeightPath() has been run
+	string resultString();
+
+	// writeResult(OutputBuffer& out)
+	//  Purpose:
+	//		Appends the string resultString() returns to out, without
+	//		building a stream for it.
+	//  Preconditions:
+	//		findHighestWeightPath() has been run
+	void writeResult(OutputBuffer& out);
+
+	// Public Accessors
+	// =============================================
+	string& getGraphFileName();  // name of the graph file the builder would have written
+	int getScore();  // weight of the highest weight path
+	void setLinearSpace(bool aLinearSpace);  // keep only O(n^2) cells in memory
+	void setThreadCount(unsigned int aThreadCount);  // threads used to fill the dense tensor
+	void setWorkspace(Workspace* aWorkspace);  // buffers to use for the dense tensor (NULL = own buffers)
+	void setBandWidth(int aBandWidth);  // banded mode if > 0
+	void setXDrop(int anXDrop);  // X-drop mode if > 0
+	bool isExact();  // false if banded or X-drop mode may have changed the path
+	void setScoreOnly(bool aScoreOnly);  // find only the score and end cell (no path)
+	void setScoringMatrix(const ScoringMatrix* aMatrix);  // matrix to score with (NULL = BLOSUM62)
+	void setResultCache(ResultCache* aCache);  // cache of earlier results (NULL = no cache)
+	bool isFromCache();  // the results were found in the cache
+
+	// string graphFileNameFor(FastaFile* fasta1, FastaFile* fasta2, FastaFile* fasta3)
+	//  Purpose:
+	//		Returns the name used for the graph file of the three fasta files
+	//			<<fileName1>>_<<fileName2>>_<<fileName3>>.graph.txt
+	static string graphFileNameFor(FastaFile* fasta1, FastaFile* fasta2, FastaFile* fasta3);
+
+private:
+
+	// Attributes
+	// =============================================
+
+	// A location in the edit graph, (i,j,k)
+	struct Cell {
+		int seq1Loc;
+		int seq2Loc;
+		int seq3Loc;
+	};
+
+	char gapChar;
+	string graphFileName;  // name reported in the results header
+	const EncodedSequence& encoded1;  // the sequences as residue codes
+	const EncodedSequence& encoded2;
+	const EncodedSequence& encoded3;
+	int seq1Length;
+	int seq2Length;
+	int seq3Length;
+	const ScoringMatrix* matrix;  // scores for the columns of the alignment
+	int gapIndex;  // index of the gap char in matrix
+	EncodedSequence::MatrixIndexes seq1Indexes;  // matrix index of each residue of seq1
+	EncodedSequence::MatrixIndexes seq2Indexes;
+	EncodedSequence::MatrixIndexes seq3Indexes;
+	bool linearSpace;  // find the path with linear space mode
+	bool scoreOnly;  // find only the score and end cell
+	unsigned int threadCount;  // threads used to fill the dense tensor
+	Workspace ownWorkspace;
+	Workspace* workspace;  // buffers used for the dense tensor
+	int bandWidth;  // largest difference allowed between two coordinates (0 = no band)
+	int xDrop;  // largest drop below the highest weight allowed (0 = no X-drop)
+	bool prunedExact;  // banded / X-drop path is known to be the same as the dense one
+	int highestWeight;  // weight of the highest weight path
+	Cell pathStart;  // starting cell of the highest weight path
+	Cell pathEnd;  // ending cell of the highest weight path
+	vector<unsigned char> pathMoves;  // moves of the highest weight path, from start to end
+	bool pathFound;
+	ResultCache* cache;  // cache of earlier results (NULL = no cache)
+	bool fromCache;  // the results were found in the cache
+	string cachedResult;  // the results text found in the cache
+
+	// Moves are encoded as a bit mask of the sequences that advance:
+	//		4 = fasta1, 2 = fasta2, 1 = fasta3
+	// so the seven edge types of the edit graph are the values 1 to 7.
+	// Taking the moves from 7 down to 1 visits the start cells of the
+	// incoming edges in vertex order.
+	static const unsigned char seq1Move = 4;
+	static const unsigned char seq2Move = 2;
+	static const unsigned char seq3Move = 1;
+
+	// Score used for cells that can not be reached
+	static const int unreachable = INT_MIN / 2;
+
+	// Boxes with fewer cells than this are solved with a full tensor
+	// in linear space mode
+	static const size_t linearSpaceLeafCells = 1 << 20;
+
+	// Size of the tiles the dense tensor is filled in (a tile of ints and
+	// moves is about 70KB, which fits in the L2 cache).  tileSeq3Size is a
+	// multiple of PackedTraceback::cellsPerGroup, so tiles filled at the
+	// same time never share words of the traceback.
+	static const int tileSeq1Size = 16;
+	static const int tileSeq2Size = 16;
+	static const int tileSeq3Size = 64;
+
+	// Size of a tile with its halo, the cells before it in each direction
+	static const size_t haloTileSeq2Step = tileSeq3Size + 1;
+	static const size_t haloTileSeq1Step = (tileSeq2Size + 1) * haloTileSeq2Step;
+	static const size_t haloTileCells = (tileSeq1Size + 1) * haloTileSeq1Step;
+
+	// Private Methods
+	// =============================================
+
+	// findPathFullTensor()
+	//  Purpose:
+	//		Runs the dynamic program over a dense tensor holding the score and
+	//		packed move for every cell, then walks the moves back from the end
+	//		cell.
+	//		The tensor is filled a wavefront of tiles at a time, with the tiles
+	//		of each wavefront spread over threadCount threads, and is stored
+	//		tile by tile.
+	//  Postconditions:
+	//		- highestWeight, pathStart, pathEnd and pathMoves will be set
+	void findPathFullTensor();
+
+	// Cell fillTile(Cell tileStart, Cell tileEnd, vector<int>& scores,
+	//		PackedTraceback& moves, int* tileScores, const size_t* tileMoveOffset)
+	//  Purpose:
+	//		Fills the scores and moves for the cells from tileStart to tileEnd
+	//		(inclusive) of the dense tensor, and returns the first cell (in
+	//		vertex order) of the tile with the highest weight.  The tile is
+	//		filled in tileScores (haloTileCells ints), with tileMoveOffset the
+	//		offsets to the predecessors of a cell in tileScores.
+	//  Preconditions:
+	//		The tiles before this one in each direction have been filled
+	Cell fillTile(Cell tileStart, Cell tileEnd, vector<int>& scores,
+		PackedTraceback& moves, int* tileScores, const size_t* tileMoveOffset);
+
+	// unsigned char fillCell(int seq1Loc, int seq2Loc, int seq3Loc, size_t cell,
+	//		int* scores, const size_t* moveOffset)
+	//  Purpose:
+	//		Fills the score for one cell of a tile and returns its move, used
+	//		for the cells the ScoreRowKernel does not handle.
+	unsigned char fillCell(int seq1Loc, int seq2Loc, int seq3Loc, size_t cell,
+		int* scores, const size_t* moveOffset);
+
+	// size_t tiledCellIndex(int seq1Loc, int seq2Loc, int seq3Loc)
+	//  Purpose:
+	//		Returns the position of a cell in the tiled score tensor.  The
+	//		tiles are in vertex order, each tile holds its cells in vertex
+	//		order, and the tiles at the end of each sequence are cut short
+	//		(so there are no unused cells).
+	size_t tiledCellIndex(int seq1Loc, int seq2Loc, int seq3Loc);
+
+	// size_t tiledMoveRow(int seq1Loc, int seq2Loc, int seq3Loc)
+	//  Purpose:
+	//		Returns the traceback row holding the move of a cell.  Each row is
+	//		the cells of one (i,j) of a tile, in the same order as the scores,
+	//		and the move of the cell is at column seq3Loc % tileSeq3Size.
+	size_t tiledMoveRow(int seq1Loc, int seq2Loc, int seq3Loc);
+
+	// findScoreOnly()
+	//  Purpose:
+	//		Runs the dynamic program keeping only two i planes of scores and
+	//		no moves, filling each row along fasta3 with the ScoreRowKernel.
+	//  Postconditions:
+	//		- highestWeight and pathEnd will be set
+	void findScoreOnly();
+
+	// int planeCellScore(int seq1Loc, int seq2Loc, int seq3Loc, const int* previousPlane,
+	//		const int* currentPlane, size_t cell, const size_t* moveOffset)
+	//  Purpose:
+	//		Returns the score of one cell for findScoreOnly(), used for the
+	//		cells the ScoreRowKernel does not handle.  cell is the position of
+	//		the cell within its i plane.
+	int planeCellScore(int seq1Loc, int seq2Loc, int seq3Loc, const int* previousPlane,
+		const int* currentPlane, size_t cell, const size_t* moveOffset);
+
+	// findPathLinearSpace()
+	//  Purpose:
+	//		Finds the same path as findPathFullTensor() keeping only O(n^2)
+	//		cells in memory.  findPathEnds() finds the start and end cells of
+	//		the path, and alignBox() recovers the moves between them.
+	//  Postconditions:
+	//		- highestWeight, pathStart, pathEnd and pathMoves will be set
+	void findPathLinearSpace();
+
+	// findPathEnds()
+	//  Purpose:
+	//		Runs the dynamic program keeping only two i planes of scores.  With
+	//		each score the start cell of its path is carried along, so the
+	//		start of the highest weight path is known once its end is found.
+	//  Postconditions:
+	//		- highestWeight, pathStart and pathEnd will be set
+	void findPathEnds();
+
+	// alignBox(Cell from, Cell to)
+	//  Purpose:
+	//		Appends the moves of the highest weight path from cell from to
+	//		cell to (both on the path) to pathMoves.
+	//
+	//		Within the box between two cells of the path, the path is the one
+	//		found by the dynamic program over the box alone, where from is the
+	//		only place a path can start.  The box is split at a middle i plane:
+	//		the dynamic program is run over the box with every cell on or after
+	//		the middle plane carrying the first cell where its path enters the
+	//		middle plane.  The path of the to cell enters at cell C, so the
+	//		boxes (from, C - move) and (C, to) are solved next.  Small boxes
+	//		are solved with a full tensor (alignBoxFullTensor()).
+	//  Postconditions:
+	//		- the moves from from to to are appended to pathMoves
+	void alignBox(Cell from, Cell to);
+
+	// alignBoxFullTensor(Cell from, Cell to)
+	//  Purpose:
+	//		Solves alignBox() with the move for every cell of the box in memory.
+	//  Postconditions:
+	//		- the moves from from to to are appended to pathMoves
+	void alignBoxFullTensor(Cell from, Cell to);
+
+	// bool isPruned()
+	//  Purpose:
+	//		Returns true if banded or X-drop mode is on
+	bool isPruned();
+
+	// findPathPruned()
+	//  Purpose:
+	//		Runs the dynamic program over only the cells that can still be on a
+	//		good path.  The cells of each (i,j) row along fasta3 that are
+	//		computed form one run of k, and the rows are stored packed one
+	//		after the other, so the memory used is about the number of cells
+	//		computed.
+	//
+	//		Banded mode leaves out the cells where two of the coordinates are
+	//		more than bandWidth apart.  X-drop mode leaves out the cells that
+	//		can only be reached through cells whose score is more than xDrop
+	//		below the highest weight found so far.  prunedExact is set if
+	//		every pruned path is bounded below the highest weight.
+	//  Postconditions:
+	//		- highestWeight, pathStart, pathEnd, pathMoves and prunedExact will be set
+	void findPathPruned();
+
+	// pairSuffixScores(const EncodedSequence::MatrixIndexes& indexesA, const EncodedSequence::MatrixIndexes& indexesB, vector<int>& scores)
+	//  Purpose:
+	//		Sets scores[a * (lengthB + 1) + b] to the highest weight of a
+	//		pairwise path from (a,b) forward (at least 0, the empty path),
+	//		scored with the matrix's pair scores.  The sum of the three pair
+	//		scores of a cell bounds the rest of a 3-way path from the cell.
+	void pairSuffixScores(const EncodedSequence::MatrixIndexes& indexesA,
+		const EncodedSequence::MatrixIndexes& indexesB, vector<int>& scores);
+
+	// prefixSuffixMaxima(const vector<int>& scores, int lengthA, int lengthB, vector<int>& below, vector<int>& above)
+	//  Purpose:
+	//		For each row a of the (lengthA + 1) x (lengthB + 1) scores, sets
+	//		below[a, b] to the highest score of the row at b or before, and
+	//		above[a, b] to the highest at b or after.
+	void prefixSuffixMaxima(const vector<int>& scores, int lengthA, int lengthB,
+		vector<int>& below, vector<int>& above);
+
+	// int moveWeight(unsigned char move, int seq1Loc, int seq2Loc, int seq3Loc)
+	//  Purpose:
+	//		Returns the weight of the edge that ends at (i,j,k) using move,
+	//		i.e. the sum of pairs weight of the column for the move.
+	int moveWeight(unsigned char move, int seq1Loc, int seq2Loc, int seq3Loc);
+
+	// cellMoveWeights(int seq1Loc, int seq2Loc, int seq3Loc, int weights[8])
+	//  Purpose:
+	//		Sets weights[move] to moveWeight(move, i, j, k) for moves 1 to 7
+	//		(moves that would start outside the tensor get gap weights).
+	//		The index of each residue is only read from its code once.
+	void cellMoveWeights(int seq1Loc, int seq2Loc, int seq3Loc, int weights[8]);
+
+	// encodeSequences()
+	//  Purpose:
+	//		Looks up the matrix index of each residue code of the sequences
+	//		(see EncodedSequence::MatrixIndexes), so the index of a residue is
+	//		read from its code and only each code is looked up in the matrix.
+	//		Throws out_of_range if a sequence has a char that is not a residue.
+	//  Postconditions:
+	//		seq1Indexes, seq2Indexes, seq3Indexes and gapIndex will be set
+	void encodeSequences();
+
+	// ResultCache::Key cacheKey()
+	//  Purpose:
+	//		Returns the key of the results in a ResultCache: the
+	//		sequences, their matrix indexes, the sum of pairs scores of the
+	//		matrix, and the score only, banded and X-drop options (linear
+	//		space mode and the number of threads do not change the results).
+	//  Preconditions:
+	//		encodeSequences() has been run
+	ResultCache::Key cacheKey();
+
+	// writeResultBody(OutputBuffer& out)
+	//  Purpose:
+	//		Writes the results between the results header and footer of
+	//		writeResult(), which is what is kept in a ResultCache.
+	void writeResultBody(OutputBuffer& out);
+
+	// writeCellLabel(OutputBuffer& out, Cell& cell)
+	//  Purpose:
+	//		Writes the label WDAGraphFileBuilder uses for the vertex (i,j,k)
+	//			<<i>>,<<j>>,<<k>>
+	void writeCellLabel(OutputBuffer& out, Cell& cell);
+
+	// string moveLabel(unsigned char move, int seq1Loc, int seq2Loc, int seq3Loc)
+	//  Purpose:
+	//		Returns the label of the edge that ends at (i,j,k) using move, i.e.
+	//		the column of aligned residues & gap characters for the move.
+	string moveLabel(unsigned char move, int seq1Loc, int seq2Loc, int seq3Loc);
+
+	// writeEdgeWeights(OutputBuffer& out, vector<string>& labels)
+	//  Purpose:
+	//		Writes a comma delimited string describing each of the edge labels
+	//		in the edit graph (from getEdgeLabels()) and its correpsonding weight.
+	//
+	//		Format:		<edge label> = <edge weight>
+	void writeEdgeWeights(OutputBuffer& out, vector<string>& labels);
+
+	// writeEdgeFrequencies(OutputBuffer& out, vector<string>& labels)
+	//  Purpose:
+	//		Writes a comma delimited string describing each of the edge labels
+	//		in the edit graph and its frequency, as reported by WDAGraph for the
+	//		builder's graph file.
+	//
+	//		Format:		<edge label> = <edge frequency>
+	void writeEdgeFrequencies(OutputBuffer& out, vector<string>& labels);
+
+	// vector<string> getEdgeLabels()
+	//  Purpose:
+	//		Returns the distinct edge labels of the edit graph in sorted order.
+	//		The label of a move is present once for every combination of the
+	//		residues in the sequences that advance on the move.
+	vector<string> getEdgeLabels();
+
+	// writePath(OutputBuffer& out)
+	//  Purpose:
+	//		Writes a string representing the edge labels for the highest weight
+	//		path in the same form as WDAGraph::writePath().
+	void writePath(OutputBuffer& out);
+};
+
+#endif // THREEWAYALIGNER_H
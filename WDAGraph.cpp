@@ -6,20 +6,14 @@
  *  as the typical expected use is a sparsely connected graph (e.g. a sequence
  *  graph).
  *
- *  ************* WARNING ***********************************
- *  *  There is no error handling in place for this object! *
- *  *  This means that if the file does not exist or is     *
- *  *  formatted incorrectly, you will get an error and     *
- *  *  will not be able to use this object.                 *
- *  *                                                       *
- *  *  If this code gets moved to a production setting      *
- *  *  appropriate error handling should be implemented!    *
- *  *********************************************************
- *
  *  Typical use for the file would be to use the WDAGraph(graphFileName)
  *  constructor to create the object.  This will automatically open the
  *  graph describer file specified by graphfileName, and read its contents
- *  storing them in the vertices vector and edges map.
+ *  storing the edges ending at each vertex in one contiguous array
+ *  (compressed sparse row form) so the dynamic program can walk them
+ *  without any lookups by label.  The labels and edges are allocated from
+ *  an arena owned by the graph, and are freed in one step when the graph
+ *  is destroyed.
  *
  *  The file is expected to be formatted as follows:
  *
@@ -54,8 +48,23 @@
  *		  - end_verex is the label of the edge's ending vertex
  *		  - weight is the numerical weight attached to the edge
  *
+ *	  The vertices of an edge have to be on vertex lines before the edge.  A
+ *	  line that is empty, is missing fields, repeats a vertex label or names
+ *	  an unknown vertex makes the constructor throw out_of_range with the
+ *	  line number (for any number of threads).
+ *
+ *  The graph file can also be a binary graph file (see WDAGraphBinaryFormat.h)
+ *  as written by WDAGraphBinaryWriter.  Binary files are recognized by their
+ *  magic bytes and are memory mapped rather than read, the dynamic program
+ *  runs directly over the edges in the mapped file.
+ *
  *  After creating the object, typical use would be to call the findHighestWeightPath()
  *  which will find the path with the highest weight using dynamic programming.
+ *  If the edge weights are changed afterwards (setEdgeWeights()), the
+ *  rescoreHighestWeightPath() method finds the new path by relaxing only
+ *  the vertices downstream of the changed edges.  If setPathCount() is
+ *  given more than one path, that many of the highest weight paths are
+ *  found in one pass.
  *
  *  Finally one would typically call the resultString() method to get a formatted set
  *	of results indicating the path with the highest weight.
@@ -66,6 +75,8 @@
 
 #include "WDAGraph.h"
 #include "StringUtilities.h"
+#include "ThreadPool.h"
+#include "Instrumentation.h"
 #include <limits>
 #include <iostream>
 #include <fstream>
@@ -73,21 +84,94 @@
 #include <vector>
 #include <cstddef>
 #include <sstream>
+#include <string_view>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 using namespace std;
 
+// Class Attribute Initialization
+// ==============================================
+const uint32_t WDAGraph::noVertex;
+const uint32_t WDAGraph::noEdge;
+const size_t WDAGraph::levelChunkSize;
+const size_t WDAGraph::parseChunkSize;
 
 // Constuctors
 // ==============================================
 WDAGraph::WDAGraph() {
-	
+
+	// Initialize ids
+	vertexCount = 0;
+	edgeCount = 0;
+	incomingOffsets = NULL;
+	incomingEdges = NULL;
+	ownedEdges = NULL;
+	mappedFile = NULL;
+	mappedFileSize = 0;
+	mappedVertices = NULL;
+	mappedVertexLabels = NULL;
+	startNode = noVertex;
+	endNode = noVertex;
+	highestWeightNode = noVertex;
+	threadCount = 1;
+	scoreOnly = false;
+	pathWeightsKnown = false;
+	pathCount = 1;
 }
 
 WDAGraph::WDAGraph(string& aGraphFileName) {
 
-	// Initialize pointers
-	startNode = NULL;
-	endNode = NULL;
-	highestWeightNode = NULL;
+	// Initialize ids
+	vertexCount = 0;
+	edgeCount = 0;
+	incomingOffsets = NULL;
+	incomingEdges = NULL;
+	ownedEdges = NULL;
+	mappedFile = NULL;
+	mappedFileSize = 0;
+	mappedVertices = NULL;
+	mappedVertexLabels = NULL;
+	startNode = noVertex;
+	endNode = noVertex;
+	highestWeightNode = noVertex;
+	threadCount = 1;
+	scoreOnly = false;
+	pathWeightsKnown = false;
+	pathCount = 1;
+
+	//  Set file name
+	graphFileName = aGraphFileName;
+	
+	// Build the graph
+	buildGraph();
+}
+
+WDAGraph::WDAGraph(string& aGraphFileName, unsigned int aThreadCount) {
+
+	// Initialize ids
+	vertexCount = 0;
+	edgeCount = 0;
+	incomingOffsets = NULL;
+	incomingEdges = NULL;
+	ownedEdges = NULL;
+	mappedFile = NULL;
+	mappedFileSize = 0;
+	mappedVertices = NULL;
+	mappedVertexLabels = NULL;
+	startNode = noVertex;
+	endNode = noVertex;
+	highestWeightNode = noVertex;
+	threadCount = (aThreadCount > 0) ? aThreadCount : 1;
+	scoreOnly = false;
+	pathWeightsKnown = false;
+	pathCount = 1;
 
 	//  Set file name
 	graphFileName = aGraphFileName;
@@ -99,42 +183,19 @@ WDAGraph::WDAGraph(string& aGraphFileName) {
 // Destructor
 // =============================================
 WDAGraph::~WDAGraph(){
-	// Remove start,end and highest
-	startNode = NULL;
-	endNode = NULL;
-	highestWeightNode = NULL;
-
-	// Remove edges from vertex
-	for (Vertex* vertex : vertices) {
-		vertex->edgeForHWPath = NULL;
-	}
-
-	// Remove vertices from edges
-	for (auto theEdges : edges) {
-		vector<Edge*>& vertexEdges = theEdges.second;
-		for (Edge* edge : vertexEdges) {
-			edge->start = NULL;
-			edge->end = NULL;
-		}
-	}
-
-	// Remove vertices
-	for (Vertex* vertex : vertices) {
-		vertex = NULL;
-	}
-	for (auto vertexEntry : verticeMap) {
-		vertexEntry.second = NULL;
-	}
-
-	// Remove  edges
-	for (auto theEdges : edges) {
-		vector<Edge*>& vertexEdges = theEdges.second;
-		for (Edge* edge : vertexEdges) {
-			edge = NULL;
-		}
-	}
-
-
+	// Free the labels and edges
+	incomingOffsets = NULL;
+	incomingEdges = NULL;
+	ownedEdges = NULL;
+	vertexLabels.clear();
+	arena.release();
+
+	// Unmap a binary graph file
+	if (mappedFile != NULL)
+		munmap(mappedFile, mappedFileSize);
+	mappedFile = NULL;
+	mappedVertices = NULL;
+	mappedVertexLabels = NULL;
 }
 
 // Public Methods
@@ -164,21 +225,53 @@ WDAGraph::~WDAGraph(){
 //							  weight path
 //
 //  Postconditions:
-//		- vertex objects in the vertices collection will have their weight 
-//		  and edgeForHWPAth set
+//		- vertexWeights and edgeForHWPath (unless in score only mode) will be set for the vertices
 //		- highestWeightPath attribute will be set
 void WDAGraph::findHighestWeightPath() {
+	INSTRUMENT_TIMER(findPath);
+
+	// Keep more than one path to each vertex if more than one path is wanted
+	if (pathCount > 1) {
+		findTopPaths();
+		return;
+	}
 
 	bool startFound = false;
+	uint32_t firstRelaxed = noVertex;  // vertices firstRelaxed .. lastRelaxed are relaxed
+	uint32_t lastRelaxed = noVertex;
+
+	// Initialize the path weights
+	vertexWeights.assign(vertexCount, INT_MIN);
+	if (scoreOnly)
+		vector<uint32_t>().swap(edgeForHWPath);
+	else
+		edgeForHWPath.assign(vertexCount, noEdge);
+	highestWeightNode = noVertex;
+
+	// The weights found can be rescored when edge weights change
+	pathWeightsKnown = true;
+	changedVertices.clear();
+
+	// Relax the vertices a topological level at a time if more than one
+	// thread is to be used (and the graph has no cycles)
+	if (threadCount > 1) {
+		if (levelOffsets.empty())
+			buildLevels();
+
+		if (levelOffsets.size() > 1) {
+			findHighestWeightPathByLevel();
+			return;
+		}
+	}
 
 	// Iterate through the vertices
-	for (Vertex* vertex : vertices) {
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++) {
 		// Check to for start constraints
 		if (isStartConstrained()) {
 			if (!startFound ) {
-				if (vertex->label == startNode->label) {
+				if (vertex == startNode) {
 					startFound = true;
-					vertex->weight = 0;
+					vertexWeights[vertex] = 0;
 					highestWeightNode = vertex;
 				}
 				else // start not found yet
@@ -187,36 +280,21 @@ void WDAGraph::findHighestWeightPath() {
 		}
 		else {
 			// Start not constrained - so consider the trivial path of starting here
-			vertex->weight = 0;
+			vertexWeights[vertex] = 0;
 		}
 
 
 		// Find the path with the highest weight to this vertex
-		vector<Edge*> vertexEdges = edges.find(vertex->label)->second;
-		for (Edge* edge : vertexEdges) {
-			// Find edges where this vertex is the end node
-			if (edge->end->label == vertex->label) {
-				// If start constrained make sure edge start is from a valid path
-				if  (isStartConstrained()) {
-					if (edge->start->weight == INT_MIN)
-						continue;
-				}
-				// Calculate weight (parent node weight plus edge weight)
-				double pathWeight = edge->start->weight + edge->weight;
-
-				// If path weight bigger than any other found so far then
-				// it becomes the new weight for the vertex
-				if (pathWeight > vertex->weight) {
-					vertex->weight = pathWeight;
-					vertex->edgeForHWPath = edge;
-				}
-			}
-		}
+		relaxVertex(vertex);
+		if (firstRelaxed == noVertex)
+			firstRelaxed = vertex;
+		lastRelaxed = vertex;
+		double vertexWeight = vertexWeights[vertex];
 
 		// Check for end constraint
 		if (isEndConstrained()) {
 			// Is this the end node?
-			if (vertex->label == endNode->label) {
+			if (vertex == endNode) {
 				// Found end node, so set it as highest and exit vertex for loop
 				highestWeightNode = vertex;
 				break;
@@ -226,11 +304,182 @@ void WDAGraph::findHighestWeightPath() {
 		}
 
 		// Set highestWeightNode (for non end constrained paths)
-		if (highestWeightNode == NULL || vertex->weight > highestWeightNode->weight)
+		if (highestWeightNode == noVertex || vertexWeight > vertexWeights[highestWeightNode])
 			highestWeightNode = vertex;
 
 	}  // end vertices for loop
-	
+
+	if (firstRelaxed != noVertex) {
+		INSTRUMENT_COUNT(cellsRelaxed, lastRelaxed - firstRelaxed + 1);
+		INSTRUMENT_COUNT(edgesRelaxed, incomingOffsets[lastRelaxed + 1] - incomingOffsets[firstRelaxed]);
+	}
+}
+
+// setEdgeWeights(const map<string, double>& newWeights)
+//  Purpose:
+//		Changes the weight of every edge with a label in newWeights to the
+//		weight given for the label.  Labels that are not in the graph are
+//		ignored.  The vertices that the changed edges end at are remembered,
+//		so rescoreHighestWeightPath() only has to relax the vertices from
+//		there on.
+//
+//		The edges of a binary graph file are in the read only mapping, so
+//		the first change copies them into the arena.
+//  Postconditions:
+//		incomingEdges, edgeWeights - weights changed
+//		changedVertices - end vertices of the changed edges added
+void WDAGraph::setEdgeWeights(const map<string, double>& newWeights) {
+
+	// Look up the label id of each new weight
+	unordered_map<string_view, uint32_t> labelIds;
+	for (uint32_t label = 0; label < edgeLabels.size(); label++)
+		labelIds.emplace(edgeLabels[label], label);
+
+	vector<char> labelChanged(edgeLabels.size(), 0);
+	vector<double> labelWeights(edgeLabels.size(), 0);
+	bool anyLabel = false;
+	for (auto& newWeight : newWeights) {
+		unordered_map<string_view, uint32_t>::iterator labelIter = labelIds.find(newWeight.first);
+		if (labelIter == labelIds.end())
+			continue;
+
+		labelChanged[labelIter->second] = 1;
+		labelWeights[labelIter->second] = newWeight.second;
+		edgeWeights[newWeight.first] = newWeight.second;
+		anyLabel = true;
+	}
+
+	if (!anyLabel)
+		return;
+
+	// Copy the edges out of a binary graph file mapping
+	if (ownedEdges == NULL) {
+		ownedEdges = arena.allocateArray<Edge>(edgeCount);
+		copy(incomingEdges, incomingEdges + edgeCount, ownedEdges);
+		incomingEdges = ownedEdges;
+	}
+
+	// Change the weights, noting the vertices whose incoming edges changed
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++) {
+		bool vertexChanged = false;
+		for (uint32_t edgeIndex = incomingOffsets[vertex]; edgeIndex < incomingOffsets[vertex + 1]; edgeIndex++) {
+			Edge& edge = ownedEdges[edgeIndex];
+			if (labelChanged[edge.label] && edge.weight != labelWeights[edge.label]) {
+				edge.weight = labelWeights[edge.label];
+				vertexChanged = true;
+			}
+		}
+
+		if (vertexChanged)
+			changedVertices.push_back(vertex);
+	}
+}
+
+// rescoreHighestWeightPath()
+//  Purpose:
+//		Finds the highest weight path again after setEdgeWeights(), reusing
+//		the weights of the last findHighestWeightPath().  Only the vertices
+//		with changed incoming edges are relaxed again, and then the vertices
+//		they have edges to if their weight changed, and so on.  The vertices
+//		are relaxed in depth order (smallest first), so each vertex is
+//		relaxed after all of the vertices it has edges from.  The path found
+//		is the same as findHighestWeightPath() would find.
+//
+//		If findHighestWeightPath() has not been run (or score only mode or
+//		the path count has changed since), or more than one path is wanted,
+//		it is simply run.
+//  Postconditions:
+//		- vertexWeights and edgeForHWPath (unless in score only mode) will be set for the vertices
+//		- highestWeightPath attribute will be set
+void WDAGraph::rescoreHighestWeightPath() {
+	if (!pathWeightsKnown || pathCount > 1 || vertexWeights.size() != vertexCount) {
+		findHighestWeightPath();
+		return;
+	}
+
+	if (vertexCount == 0) {
+		changedVertices.clear();
+		return;
+	}
+
+	INSTRUMENT_TIMER(findPath);
+
+	if (outgoingOffsets.empty())
+		buildOutgoingEdges();
+
+	// Range of vertices (in depth order) that findHighestWeightPath() relaxes
+	uint32_t firstVertex = isStartConstrained() ? startNode : 0;
+	uint32_t lastVertex = vertexCount - 1;
+	if (isEndConstrained() && endNode >= firstVertex)
+		lastVertex = endNode;
+
+	// Vertices to relax again, smallest first
+	priority_queue<uint32_t, vector<uint32_t>, greater<uint32_t> > pending;
+	vector<char> queued(vertexCount, 0);
+	for (uint32_t vertex : changedVertices) {
+		queued[vertex] = 1;
+		pending.push(vertex);
+	}
+	changedVertices.clear();
+
+	uint64_t cells = 0;
+	uint64_t edges = 0;
+	while (!pending.empty()) {
+		uint32_t vertex = pending.top();
+		pending.pop();
+
+		// Vertices outside the range are not part of any path
+		if (vertex < firstVertex || vertex > lastVertex)
+			continue;
+
+		// Start again from the trivial path (if it is allowed)
+		double oldWeight = vertexWeights[vertex];
+		vertexWeights[vertex] = (isStartConstrained() && vertex != startNode) ? INT_MIN : 0;
+		relaxVertex(vertex);
+		cells++;
+		edges += incomingOffsets[vertex + 1] - incomingOffsets[vertex];
+
+		if (vertexWeights[vertex] == oldWeight)
+			continue;
+
+		// The vertices it has edges to may change too
+		for (uint32_t outgoing = outgoingOffsets[vertex]; outgoing < outgoingOffsets[vertex + 1]; outgoing++) {
+			uint32_t nextVertex = outgoingVertices[outgoing];
+			if (!queued[nextVertex]) {
+				queued[nextVertex] = 1;
+				pending.push(nextVertex);
+			}
+		}
+	}
+
+	INSTRUMENT_COUNT(cellsRelaxed, cells);
+	INSTRUMENT_COUNT(edgesRelaxed, edges);
+
+	findHighestWeightNode(firstVertex, lastVertex);
+}
+
+// Public Accessors
+// =============================================
+void WDAGraph::setThreadCount(unsigned int aThreadCount) {
+	threadCount = (aThreadCount > 0) ? aThreadCount : 1;
+}
+
+void WDAGraph::setPathCount(unsigned int aPathCount) {
+	aPathCount = (aPathCount > 0) ? aPathCount : 1;
+
+	// The weights kept for rescoring are only for a single path
+	if (aPathCount != pathCount)
+		pathWeightsKnown = false;
+
+	pathCount = aPathCount;
+}
+
+void WDAGraph::setScoreOnly(bool aScoreOnly) {
+	// Rescoring needs edgeForHWPath to be kept the same way
+	if (aScoreOnly != scoreOnly)
+		pathWeightsKnown = false;
+
+	scoreOnly = aScoreOnly;
 }
 
 // string resultString()
@@ -246,34 +495,69 @@ void WDAGraph::findHighestWeightPath() {
 //			  <result type="beginning_vertex"> <<start vertex for path>> </result>
 //			  <result type="ending_vertex"> <<end vertex for path>> </result>
 //			  <result type="path"> << list of path edge labels in order>> </result>
+//			  <result type="instrumentation"> <<counters and timers>> </result>
 //			</results>
+//
+//		In score only mode the beginning_vertex and path results are left out.
+//		If more than one path is found (setPathCount()), the score through
+//		path results are repeated for each path, highest weight first.
+//		The instrumentation result is only there if built with
+//		-DWDA_INSTRUMENTATION (see Instrumentation.h).
 //  Preconditions:
 //		findHighestWeightPath() has been run
 string WDAGraph::resultString() {
-	stringstream ss;
+	OutputBuffer out;
+	writeResult(out);
+
+	return out.str();
+}
+
+// writeResult(OutputBuffer& out)
+//  Purpose:
+//		Appends the string resultString() returns to out, without
+//		building any strings along the way.
+//  Preconditions:
+//		findHighestWeightPath() has been run
+void WDAGraph::writeResult(OutputBuffer& out) {
 	// Results header
-	ss << "  <results type=\"part?\" file=\"" << graphFileName << "\">\n";
+	out.write("  <results type=\"part?\" file=\"");
+	out.write(graphFileName);
+	out.write("\">\n");
 
 	// Edge Info (Weights and Histogram)
-	ss << StringUtilities::xmlResult("edge_weights", getEdgeWeights());
-	ss << StringUtilities::xmlResult("edge_histogram", getEdgeFrequencies());
+	out.beginResult("edge_weights");
+	writeEdgeWeights(out);
+	out.endResult();
+	out.beginResult("edge_histogram");
+	writeEdgeFrequencies(out);
+	out.endResult();
 
 	// Path Info
-	if (highestWeightNode == NULL)
-		ss << StringUtilities::xmlResult("path", "No Path Found!");
+	if (pathCount > 1)
+		writeTopPaths(out);
+	else if (highestWeightNode == noVertex)
+		out.xmlResult("path", "No Path Found!");
 	else {
-		ss
-			<< StringUtilities::xmlResult("score",  highestWeightNode->weight, 6)
-			<< StringUtilities::xmlResult("beginning_vertex",  getPathStartNodeLabel())
-			<< StringUtilities::xmlResult("end_vertex", highestWeightNode->label)
-			<< StringUtilities::xmlResult("path", getPath());
-	}
+		out.xmlResult("score", vertexWeights[highestWeightNode], 6);
 
-	// Results footer
-	ss << "  </results>\n";
+		// The path is not known in score only mode
+		if (scoreOnly)
+			out.xmlResult("end_vertex", vertexLabel(highestWeightNode));
+		else {
+			out.xmlResult("beginning_vertex", getPathStartNodeLabel());
+			out.xmlResult("end_vertex", vertexLabel(highestWeightNode));
+			out.beginResult("path");
+			writePath(out);
+			out.endResult();
+		}
+	}
 
+	// Counters and timers (only kept if built with -DWDA_INSTRUMENTATION)
+	if (Instrumentation::isEnabled())
+		out.write(Instrumentation::resultString());
 
-	return ss.str();
+	// Results footer
+	out.write("  </results>\n");
 }
 
 // Private Methods
@@ -287,199 +571,1173 @@ string WDAGraph::resultString() {
 //		collection, if the the first char is an E then an edge is added
 //		to the edges collection. See class header for description of file
 //		contents. 
+//
+//		Vertex and edge labels are interned to integer ids as the file is
+//		read, and once the whole file is read the edges are grouped by
+//		their end vertex (see buildIncomingEdges()).
 //  Postconditions:
 //		The following attirbutes will be populated:
-//			vertices, verticeMap, startNode, endNode,
-//			edges, edgeWeights, edgeFrequencies
+//			vertexCount, vertexLabels, startNode, endNode, edgeLabels,
+//			incomingOffsets, incomingEdges, edgeWeights, edgeFrequencies
 void WDAGraph::buildGraph() {
+	INSTRUMENT_TIMER(graphBuild);
+
+	// Binary graph files are mapped instead of read
+	if (isBinaryGraphFile()) {
+		mapBinaryGraph();
+		INSTRUMENT_COUNT(bytesRead, mappedFileSize);
+		INSTRUMENT_COUNT(verticesParsed, vertexCount);
+		INSTRUMENT_COUNT(edgesParsed, edgeCount);
+		return;
+	}
+
+	// Large text files are parsed on several threads
+	if (threadCount > 1) {
+		buildGraphInParallel();
+		return;
+	}
 
 	ifstream graphFile(graphFileName);
 	string line;
+	uint64_t bytesParsed = 0;
+	size_t lineNumber = 0;
+
+	// The line and the tokens are reused, so nothing is allocated per line
+	static const size_t maxTokens = 8;
+	string_view tokens[maxTokens];
 
 	while(getline(graphFile, line)) {
-		vector<string> tokens;
-		StringUtilities::split(line, ' ', tokens);
+		bytesParsed += line.length() + 1;
+		lineNumber++;
+
+		size_t tokenCount = StringUtilities::split(line, ' ', tokens, maxTokens);
+		if (tokenCount == 0)
+			throw out_of_range(lineError("empty line", lineNumber));
 
 		// Add vertices
-		if (tokens.at(0) == "V") 
-			addVertex(tokens);
+		if (tokens[0] == "V") 
+			addVertex(tokens, tokenCount, lineNumber);
 		// Add Edges
-		else if (tokens.at(0) == "E") 
-			addEdge(tokens);
+		else if (tokens[0] == "E") 
+			addEdge(tokens, tokenCount, lineNumber);
 	}
 
 	graphFile.close();
 
+	buildIncomingEdges();
+
+	INSTRUMENT_COUNT(bytesRead, bytesParsed);
+	INSTRUMENT_COUNT(verticesParsed, vertexCount);
+	INSTRUMENT_COUNT(edgesParsed, edgeCount);
 }
 
-// addVertex(vector<string>& tokens)
+// buildGraphInParallel()
 //  Purpose:
-//		Adds a new vertex from the line read in from the graph file.
+//		Builds the graph from a text graph file with threadCount threads.
+//		The file is mapped and cut into chunks at line breaks, the chunks
+//		are parsed in parallel (see parseChunk()), the vertices are added
+//		in file order, and then the edges of the chunks are resolved to
+//		vertex ids in parallel and put in file order.  Throws
+//		out_of_range for the first bad line in the file, with the same
+//		rules as a single thread (an edge can only use vertices on
+//		earlier lines).
 //  Postconditions:
-//		vertices - vertex added
-//		veritceMap - vertex added
-//		edges - entry for vertex initialized
-void WDAGraph::addVertex(vector<string>& tokens) {
+//		The same attributes as buildGraph() are populated, with the same
+//		values
+void WDAGraph::buildGraphInParallel() {
+
+	// Map the whole file (a missing or empty file is an empty graph, as
+	// for a single thread)
+	int fd = open(graphFileName.c_str(), O_RDONLY);
+	struct stat fileStat;
+	if (fd < 0 || fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+		if (fd >= 0)
+			::close(fd);
+		buildIncomingEdges();
+		return;
+	}
+
+	size_t fileSize = fileStat.st_size;
+	void* mapping = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapping == MAP_FAILED)
+		throw runtime_error("can not map graph file " + graphFileName);
+	madvise(mapping, fileSize, MADV_SEQUENTIAL);
+	const char* chars = static_cast<const char*>(mapping);
+
+	// Cut the file into chunks that start at the beginning of a line
+	size_t chunkCount = max((size_t) threadCount, (fileSize + parseChunkSize - 1) / parseChunkSize);
+	vector<size_t> chunkStarts(chunkCount + 1, fileSize);
+	chunkStarts[0] = 0;
+	for (size_t chunk = 1; chunk < chunkCount; chunk++) {
+		size_t start = max(chunkStarts[chunk - 1], fileSize / chunkCount * chunk);
+		if (start > 0 && start < fileSize && chars[start - 1] != '\n') {
+			const char* newline = static_cast<const char*>(memchr(chars + start, '\n', fileSize - start));
+			start = (newline != NULL) ? newline - chars + 1 : fileSize;
+		}
+		chunkStarts[chunk] = start;
+	}
+
+	ThreadPool pool(threadCount);
+	vector<ParsedChunk> chunks(chunkCount);
+	pool.parallelFor(chunkCount, [&](size_t chunk, unsigned int) {
+		parseChunk(chars + chunkStarts[chunk], chunkStarts[chunk + 1] - chunkStarts[chunk], chunks[chunk]);
+	});
+
+	// Only the chunks up to the first one with a bad line are used, an
+	// edge before the bad line could still be the first error in the file
+	size_t usedChunks = 0;
+	while (usedChunks < chunkCount && chunks[usedChunks++].error.empty())
+		;
+
+	// The line and the vertex count each chunk starts at
+	vector<size_t> lineStarts(usedChunks + 1, 0);
+	vector<size_t> vertexStarts(usedChunks + 1, 0);
+	for (size_t chunk = 0; chunk < usedChunks; chunk++) {
+		lineStarts[chunk + 1] = lineStarts[chunk] + chunks[chunk].lineCount;
+		vertexStarts[chunk + 1] = vertexStarts[chunk] + chunks[chunk].vertices.size();
+	}
+
+	// Add the vertices in file order, so they keep their depth order ids
+	vertexLabels.reserve(vertexStarts[usedChunks]);
+
+	for (size_t chunk = 0; chunk < usedChunks; chunk++) {
+		for (ChunkVertex& chunkVertex : chunks[chunk].vertices) {
+			uint32_t vertex = insertVertex(chunkVertex.label);
+
+			// A repeated label is a bad line, the rest of the file is not used
+			if (vertex == noVertex) {
+				chunks[chunk].error = "duplicate vertex " + string(chunkVertex.label);
+				chunks[chunk].lineCount = chunkVertex.line;
+				usedChunks = chunk + 1;
+				break;
+			}
 
-	// Create vetex and intialize 
-	Vertex* vertex =  new Vertex();
-	vertex->weight = INT_MIN;
-	vertex->edgeForHWPath = NULL;
+			if (chunkVertex.start)
+				startNode = vertex;
+			else if (chunkVertex.end)
+				endNode = vertex;
+		}
+	}
+
+	// Give the edge labels their ids in the order they are first seen in
+	// the file, and find where each chunk's edges go in fileEdges
+	vector<vector<uint32_t> > labelIds(usedChunks);
+	vector<size_t> edgeStarts(usedChunks + 1, 0);
+	for (size_t chunk = 0; chunk < usedChunks; chunk++) {
+		ParsedChunk& parsed = chunks[chunk];
+		labelIds[chunk].resize(parsed.labels.size());
+
+		for (size_t label = 0; label < parsed.labels.size(); label++) {
+			labelKey.assign(parsed.labels[label].data(), parsed.labels[label].length());
+			unordered_map<string, uint32_t>::iterator labelIter = edgeLabelIds.find(labelKey);
+			if (labelIter != edgeLabelIds.end())
+				labelIds[chunk][label] = labelIter->second;
+			else {
+				labelIds[chunk][label] = edgeLabels.size();
+				edgeLabels.push_back(labelKey);
+				edgeLabelIds[labelKey] = labelIds[chunk][label];
+				edgeWeights[labelKey] = parsed.labelWeights[label];
+				edgeFrequencies[labelKey] = 1;
+			}
+		}
+
+		edgeStarts[chunk + 1] = edgeStarts[chunk] + parsed.edges.size();
+	}
+
+	// Resolve the edges' vertex labels (the id table is only read now).  As
+	// for a single thread, the vertices have to be on earlier lines, which
+	// are the ones with a lower id than the vertices before the edge.
+	fileEdges.resize(edgeStarts[usedChunks]);
+	pool.parallelFor(usedChunks, [&](size_t chunk, unsigned int) {
+		ParsedChunk& parsed = chunks[chunk];
+		FileEdge* edges = fileEdges.data() + edgeStarts[chunk];
+
+		for (size_t edge = 0; edge < parsed.edges.size(); edge++) {
+			const ChunkEdge& chunkEdge = parsed.edges[edge];
+			if (!parsed.error.empty() && chunkEdge.line > parsed.lineCount)
+				break;
+
+			size_t verticesBefore = vertexStarts[chunk] + chunkEdge.verticesBefore;
+			edges[edge].start = findVertex(chunkEdge.startLabel);
+			edges[edge].end = findVertex(chunkEdge.endLabel);
+			edges[edge].label = labelIds[chunk][chunkEdge.label];
+			edges[edge].weight = chunkEdge.weight;
+
+			if (edges[edge].start == noVertex || edges[edge].start >= verticesBefore)
+				parsed.edgeError = "edge from unknown vertex " + string(chunkEdge.startLabel);
+			else if (edges[edge].end == noVertex || edges[edge].end >= verticesBefore)
+				parsed.edgeError = "edge to unknown vertex " + string(chunkEdge.endLabel);
+			if (!parsed.edgeError.empty()) {
+				parsed.edgeErrorLine = chunkEdge.line;
+				break;
+			}
+		}
+
+		vector<ChunkEdge>().swap(parsed.edges);
+	});
+
+	// Report the first bad line in the file
+	for (size_t chunk = 0; chunk < usedChunks; chunk++) {
+		string error;
+		size_t line = 0;
+		if (!chunks[chunk].edgeError.empty()) {
+			error = chunks[chunk].edgeError;
+			line = chunks[chunk].edgeErrorLine;
+		}
+		else if (!chunks[chunk].error.empty()) {
+			error = chunks[chunk].error;
+			line = chunks[chunk].lineCount;
+		}
+
+		if (!error.empty()) {
+			munmap(mapping, fileSize);
+			throw out_of_range(lineError(error, lineStarts[chunk] + line));
+		}
+	}
+
+	vector<ParsedChunk>().swap(chunks);
+	munmap(mapping, fileSize);
+
+	buildIncomingEdges();
+
+	INSTRUMENT_COUNT(bytesRead, fileSize);
+	INSTRUMENT_COUNT(verticesParsed, vertexCount);
+	INSTRUMENT_COUNT(edgesParsed, edgeCount);
+}
+
+// parseChunk(const char* chars, size_t length, ParsedChunk& chunk)
+//  Purpose:
+//		Splits the lines of a chunk of a text graph file into its
+//		vertices, edges and edge labels.  A bad line is recorded in
+//		chunk.error rather than thrown, as it runs on a worker thread, and
+//		ends the chunk.
+void WDAGraph::parseChunk(const char* chars, size_t length, ParsedChunk& chunk) {
+	static const size_t maxTokens = 8;
+	string_view tokens[maxTokens];
+	unordered_map<string_view, uint32_t> labelIds;  // index of each label in chunk.labels
+	chunk.lineCount = 0;
+
+	size_t position = 0;
+	while (position < length) {
+		const char* newline = static_cast<const char*>(memchr(chars + position, '\n', length - position));
+		size_t lineEnd = (newline != NULL) ? newline - chars : length;
+		string_view line(chars + position, lineEnd - position);
+		position = lineEnd + 1;
+		chunk.lineCount++;
+
+		size_t tokenCount = StringUtilities::split(line, ' ', tokens, maxTokens);
+		if (tokenCount == 0) {
+			chunk.error = "empty line";
+			return;
+		}
+
+		// Vertices
+		if (tokens[0] == "V") {
+			if (tokenCount < 2) {
+				chunk.error = "vertex line with no label";
+				return;
+			}
+
+			ChunkVertex vertex;
+			vertex.label = tokens[1];
+			vertex.line = chunk.lineCount;
+			vertex.start = (tokenCount > 2 && tokens[2] == "START");
+			vertex.end = (tokenCount > 2 && tokens[2] == "END");
+			chunk.vertices.push_back(vertex);
+		}
+		// Edges
+		else if (tokens[0] == "E") {
+			if (tokenCount < 5) {
+				chunk.error = "edge line with missing fields";
+				return;
+			}
+
+			ChunkEdge edge;
+			edge.startLabel = tokens[2];
+			edge.endLabel = tokens[3];
+			edge.verticesBefore = chunk.vertices.size();
+			edge.line = chunk.lineCount;
+			edge.weight = StringUtilities::toDouble(tokens[4]);
+
+			unordered_map<string_view, uint32_t>::iterator labelIter = labelIds.find(tokens[1]);
+			if (labelIter != labelIds.end())
+				edge.label = labelIter->second;
+			else {
+				edge.label = chunk.labels.size();
+				labelIds[tokens[1]] = edge.label;
+				chunk.labels.push_back(tokens[1]);
+				chunk.labelWeights.push_back(edge.weight);
+			}
+
+			chunk.edges.push_back(edge);
+		}
+	}
+}
+
+// bool isBinaryGraphFile()
+//  Purpose:
+//		Returns true if the graph file starts with the magic bytes of a
+//		binary graph file.
+bool WDAGraph::isBinaryGraphFile() {
+	ifstream graphFile(graphFileName, ios::in | ios::binary);
+	char magic[sizeof(wdaGraphBinaryMagic)];
+
+	if (!graphFile.read(magic, sizeof(magic)))
+		return false;
+
+	return memcmp(magic, wdaGraphBinaryMagic, sizeof(magic)) == 0;
+}
+
+// mapBinaryGraph()
+//  Purpose:
+//		Memory maps a binary graph file (see WDAGraphBinaryFormat.h).  The
+//		incoming edge arrays point directly into the mapping, only the edge
+//		label maps are built.  Throws runtime_error if the file can not
+//		be mapped, and out_of_range if it is not a valid binary graph
+//		file of this version (see checkBinaryGraph()).
+//  Postconditions:
+//		The following attirbutes will be populated:
+//			mappedFile, mappedVertices, mappedVertexLabels, vertexCount,
+//			startNode, endNode, edgeLabels, incomingOffsets, incomingEdges,
+//			edgeWeights, edgeFrequencies
+void WDAGraph::mapBinaryGraph() {
+
+	// The edges in the file are used in place
+	static_assert(sizeof(Edge) == sizeof(WDAGraphBinaryEdge), "Edge must match the binary edge layout");
+
+	// Map the whole file
+	int fd = open(graphFileName.c_str(), O_RDONLY);
+	struct stat fileStat;
+	if (fd < 0 || fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+		if (fd >= 0)
+			::close(fd);
+		throw runtime_error("can not map graph file " + graphFileName);
+	}
+
+	size_t fileSize = fileStat.st_size;
+	void* mapping = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapping == MAP_FAILED)
+		throw runtime_error("can not map graph file " + graphFileName);
+
+	// Nothing in the file is used until all of it has been checked
+	string error = checkBinaryGraph(static_cast<const char*>(mapping), fileSize);
+	if (!error.empty()) {
+		munmap(mapping, fileSize);
+		throw out_of_range(error + " in binary graph file " + graphFileName);
+	}
+
+	mappedFile = mapping;
+	mappedFileSize = fileSize;
+	const char* base = static_cast<const char*>(mappedFile);
+	const WDAGraphBinaryHeader* header = reinterpret_cast<const WDAGraphBinaryHeader*>(base);
+
+	// Vertices
+	vertexCount = header->vertexCount;
+	startNode = header->startVertex;
+	endNode = header->endVertex;
+	mappedVertices = reinterpret_cast<const WDAGraphBinaryVertex*>(base + header->vertexTableOffset);
+	mappedVertexLabels = base + header->vertexLabelPoolOffset;
+
+	// Edges
+	edgeCount = header->edgeCount;
+	incomingOffsets = reinterpret_cast<const uint32_t*>(base + header->incomingOffsetsOffset);
+	incomingEdges = reinterpret_cast<const Edge*>(base + header->edgesOffset);
+
+	// Edge labels, each entry in the table is the first use of the label
+	const WDAGraphBinaryEdgeLabel* labelTable =
+		reinterpret_cast<const WDAGraphBinaryEdgeLabel*>(base + header->edgeLabelTableOffset);
+	const char* labelPool = base + header->edgeLabelPoolOffset;
+	for (uint32_t label = 0; label < header->edgeLabelCount; label++) {
+		string labelString(labelPool + labelTable[label].labelOffset);
+		edgeLabels.push_back(labelString);
+		edgeWeights[labelString] = labelTable[label].weight;
+		edgeFrequencies[labelString] = 1;
+	}
+}
+
+// string checkBinaryGraph(const char* base, size_t fileSize)
+//  Purpose:
+//		Checks that the fileSize bytes at base are a binary graph file that
+//		can be used in place: the header is of this version and matches the
+//		file size, every section fits in the file, the incoming edge offsets
+//		run from 0 to edgeCount without going down, and every vertex id,
+//		label id and label offset is in range (with the label terminated
+//		inside the file).  Returns what is wrong, or an empty string if the
+//		file is valid.
+string WDAGraph::checkBinaryGraph(const char* base, size_t fileSize) {
+	if (fileSize < sizeof(WDAGraphBinaryHeader))
+		return "truncated header";
+
+	const WDAGraphBinaryHeader* header = reinterpret_cast<const WDAGraphBinaryHeader*>(base);
+	if (memcmp(header->magic, wdaGraphBinaryMagic, sizeof(wdaGraphBinaryMagic)) != 0)
+		return "bad magic bytes";
+	if (header->version != wdaGraphBinaryVersion)
+		return "unsupported version " + to_string(header->version);
+	if (header->fileSize != fileSize)
+		return "file size " + to_string(fileSize) + " not the " + to_string(header->fileSize) + " in the header";
+
+	// Each table has to be aligned and fit in the file
+	auto sectionFits = [&](uint64_t offset, uint64_t count, uint64_t entrySize) {
+		return offset % 8 == 0 && offset <= fileSize && count * entrySize <= fileSize - offset;
+	};
+	if (!sectionFits(header->edgesOffset, header->edgeCount, sizeof(WDAGraphBinaryEdge)))
+		return "edges past the end of the file";
+	if (!sectionFits(header->incomingOffsetsOffset, (uint64_t) header->vertexCount + 1, sizeof(uint32_t)))
+		return "incoming edge offsets past the end of the file";
+	if (!sectionFits(header->vertexTableOffset, header->vertexCount, sizeof(WDAGraphBinaryVertex)))
+		return "vertex table past the end of the file";
+	if (!sectionFits(header->edgeLabelTableOffset, header->edgeLabelCount, sizeof(WDAGraphBinaryEdgeLabel)))
+		return "edge label table past the end of the file";
+	if (header->vertexLabelPoolOffset > fileSize || header->edgeLabelPoolOffset > fileSize)
+		return "label pool past the end of the file";
+
+	// A label has to start in the file and end before the file does
+	auto labelFits = [&](uint64_t poolOffset, uint64_t labelOffset) {
+		uint64_t start = poolOffset + labelOffset;
+		return labelOffset < fileSize && start < fileSize && memchr(base + start, '\0', fileSize - start) != NULL;
+	};
+
+	if (header->startVertex != wdaGraphNoVertex && header->startVertex >= header->vertexCount)
+		return "bad START vertex";
+	if (header->endVertex != wdaGraphNoVertex && header->endVertex >= header->vertexCount)
+		return "bad END vertex";
+
+	const WDAGraphBinaryVertex* vertices = reinterpret_cast<const WDAGraphBinaryVertex*>(base + header->vertexTableOffset);
+	for (uint32_t vertex = 0; vertex < header->vertexCount; vertex++) {
+		if (!labelFits(header->vertexLabelPoolOffset, vertices[vertex].labelOffset))
+			return "bad label of vertex " + to_string(vertex);
+	}
+
+	const uint32_t* offsets = reinterpret_cast<const uint32_t*>(base + header->incomingOffsetsOffset);
+	if (offsets[0] != 0 || offsets[header->vertexCount] != header->edgeCount)
+		return "incoming edge offsets do not cover the edges";
+	for (uint32_t vertex = 0; vertex < header->vertexCount; vertex++) {
+		if (offsets[vertex] > offsets[vertex + 1])
+			return "incoming edge offsets out of order at vertex " + to_string(vertex);
+	}
+
+	const WDAGraphBinaryEdge* edges = reinterpret_cast<const WDAGraphBinaryEdge*>(base + header->edgesOffset);
+	for (uint32_t edge = 0; edge < header->edgeCount; edge++) {
+		if (edges[edge].start >= header->vertexCount || edges[edge].label >= header->edgeLabelCount)
+			return "bad start vertex or label of edge " + to_string(edge);
+	}
+
+	const WDAGraphBinaryEdgeLabel* labels = reinterpret_cast<const WDAGraphBinaryEdgeLabel*>(base + header->edgeLabelTableOffset);
+	for (uint32_t label = 0; label < header->edgeLabelCount; label++) {
+		if (!labelFits(header->edgeLabelPoolOffset, labels[label].labelOffset))
+			return "bad edge label " + to_string(label);
+	}
+
+	return "";
+}
+
+// const char* vertexLabel(uint32_t vertex)
+//  Purpose:
+//		Returns the label of the vertex
+const char* WDAGraph::vertexLabel(uint32_t vertex) {
+	if (mappedVertices != NULL)
+		return mappedVertexLabels + mappedVertices[vertex].labelOffset;
+
+	return vertexLabels[vertex];
+}
+
+// addVertex(const string_view* tokens, size_t tokenCount, size_t lineNumber)
+//  Purpose:
+//		Adds a new vertex from the tokens of a line read in from the
+//		graph file.  Throws out_of_range if the line has no label or
+//		repeats the label of another vertex.
+//  Postconditions:
+//		vertexLabels - vertex added
+//		vertexIdSlots - vertex added
+void WDAGraph::addVertex(const string_view* tokens, size_t tokenCount, size_t lineNumber) {
+	if (tokenCount < 2)
+		throw out_of_range(lineError("vertex line with no label", lineNumber));
+
+	// Add to collections, vertex ids are assigned in depth order
+	uint32_t vertex = insertVertex(tokens[1]);
+	if (vertex == noVertex)
+		throw out_of_range(lineError("duplicate vertex " + string(tokens[1]), lineNumber));
 
 	// Populate from tokens
-	vertex->label = tokens.at(1);
-	if (tokens.size() > 2) {
-		if (tokens.at(2) == "START")
+	if (tokenCount > 2) {
+		if (tokens[2] == "START")
 			startNode = vertex;
-		else if (tokens.at(2) == "END")
+		else if (tokens[2] == "END")
 			endNode = vertex;
 	}
+}
+
+// uint32_t insertVertex(string_view label)
+//  Purpose:
+//		Gives the next vertex id to the label and returns it, or returns
+//		noVertex (and adds nothing) if there already is a vertex with the
+//		label
+//  Postconditions:
+//		vertexLabels - vertex added
+//		vertexIdSlots - vertex added
+uint32_t WDAGraph::insertVertex(string_view label) {
+	if (findVertex(label) != noVertex)
+		return noVertex;
+
+	// Vertex ids are assigned in depth order
+	uint32_t vertex = vertexCount++;
+	vertexLabels.push_back(arena.copyString(label.data(), label.length()));
+
+	if (2 * (size_t) vertexCount > vertexIdSlots.size())
+		growVertexIdSlots();
+	vertexIdSlot(label) = vertex;
+
+	return vertex;
+}
 
-	// Add to collections
-	vertices.push_back(vertex);
-	verticeMap[vertex->label] = vertex;
+// uint32_t& vertexIdSlot(string_view label)
+//  Purpose:
+//		Returns the slot of vertexIdSlots that holds the id for label.  If
+//		there is no vertex with the label, the slot returned is empty
+//		(noVertex) and is where the id for the label should be stored.
+uint32_t& WDAGraph::vertexIdSlot(string_view label) {
+	size_t mask = vertexIdSlots.size() - 1;
+	size_t slot = hash<string_view>()(label) & mask;
+
+	// Linear probe until the label or an empty slot is found
+	while (vertexIdSlots[slot] != noVertex && label != vertexLabels[vertexIdSlots[slot]])
+		slot = (slot + 1) & mask;
+
+	return vertexIdSlots[slot];
+}
 
-	// initialize edges entry for this vertex
-	edges[vertex->label] = vector<Edge*>();
+// uint32_t findVertex(string_view label)
+//  Purpose:
+//		Returns the id of the vertex with the label, or noVertex if no
+//		vertex with the label has been added yet
+uint32_t WDAGraph::findVertex(string_view label) {
+	if (vertexIdSlots.empty())
+		return noVertex;
+
+	return vertexIdSlot(label);
+}
 
+// growVertexIdSlots()
+//  Purpose:
+//		Doubles the size of vertexIdSlots and rehashes the vertex ids
+void WDAGraph::growVertexIdSlots() {
+	size_t slotCount = vertexIdSlots.empty() ? 1024 : 2 * vertexIdSlots.size();
+	vertexIdSlots.assign(slotCount, noVertex);
+
+	size_t mask = slotCount - 1;
+	for (uint32_t vertex = 0; vertex < vertexCount - 1; vertex++) {
+		size_t slot = hash<string_view>()(string_view(vertexLabels[vertex])) & mask;
+		while (vertexIdSlots[slot] != noVertex)
+			slot = (slot + 1) & mask;
+		vertexIdSlots[slot] = vertex;
+	}
 }
 
-// addEdge(vector<string>& tokens)
+// addEdge(const string_view* tokens, size_t tokenCount, size_t lineNumber)
 //  Purpose:
-//		Adds a new edge from the line read in from the graph file.
+//		Adds a new edge from the tokens of a line read in from the
+//		graph file.  Throws out_of_range if the line is too short or
+//		names a vertex that has not been added yet (a vertex line has to
+//		come before the edges that use it).
 //  Postconditions:
-//		edges - edge added to start and end vertex vectors
+//		fileEdges - edge added
+//		edgeLabels, edgeLabelIds - entry added for edge (first time label encountered)
 //		edgeWeights - entry added for edge (first time label encountered)
 //		edgeFrequencies - entry for edge label incremented by 1
-void WDAGraph::addEdge(vector<string>& tokens) {
+void WDAGraph::addEdge(const string_view* tokens, size_t tokenCount, size_t lineNumber) {
+	if (tokenCount < 5)
+		throw out_of_range(lineError("edge line with missing fields", lineNumber));
 
 	// Create Edge and populate from tokens
-	Edge* edge = new Edge();
-	edge->label = tokens.at(1);
-	edge->start = verticeMap.find(tokens.at(2))->second;
-	edge->end = verticeMap.find(tokens.at(3))->second;
-	edge->weight = atof(tokens.at(4).c_str());
-
+	FileEdge edge;
+	edge.start = findVertex(tokens[2]);
+	edge.end = findVertex(tokens[3]);
+	if (edge.start == noVertex)
+		throw out_of_range(lineError("edge from unknown vertex " + string(tokens[2]), lineNumber));
+	if (edge.end == noVertex)
+		throw out_of_range(lineError("edge to unknown vertex " + string(tokens[3]), lineNumber));
+
+	labelKey.assign(tokens[1].data(), tokens[1].length());
+	string& label = labelKey;
+	edge.weight = StringUtilities::toDouble(tokens[4]);
+
+	// Intern the label, adding it to edgeWeights the first time it is seen
+	unordered_map<string, uint32_t>::iterator labelIter = edgeLabelIds.find(label);
+	if (labelIter != edgeLabelIds.end())
+		edge.label = labelIter->second;
+	else {
+		edge.label = edgeLabels.size();
+		edgeLabels.push_back(label);
+		edgeLabelIds[label] = edge.label;
+		edgeWeights[label] = edge.weight;
+	}
 
 	// Add to edges collection
-	vector<Edge*>& startEdges = edges.find((edge->start)->label)->second;
-	startEdges.push_back(edge);
-	vector<Edge*>& endEdges = edges.find((edge->end)->label)->second;
-	endEdges.push_back(edge);
-
-	// Add to edgeWeights if not already in map ]
-	map<string, double>::iterator weightsIter = edgeWeights.find(edge->label);
-	if (weightsIter == edgeWeights.end()) 
-		edgeWeights[edge->label] = edge->weight;
+	fileEdges.push_back(edge);
 
 	// Increment edgeFrequencies
-	map<string, int>::iterator freqIter = edgeFrequencies.find(edge->label);
+	map<string, int>::iterator freqIter = edgeFrequencies.find(label);
 	if (freqIter != edgeFrequencies.end()) 
-		edgeFrequencies[edge->label] = freqIter->second++;
+		edgeFrequencies[label] = freqIter->second++;
 	else
-		edgeFrequencies[edge->label] = 1;
+		edgeFrequencies[label] = 1;
+
+}
+
+// string lineError(const string& problem, size_t lineNumber)
+//  Purpose:
+//		Returns the error message for a bad line of the graph file
+string WDAGraph::lineError(const string& problem, size_t lineNumber) {
+	return problem + " on line " + to_string(lineNumber) + " of graph file " + graphFileName;
+}
+
+// buildIncomingEdges()
+//  Purpose:
+//		Groups the edges read from the graph file by their end vertex.
+//		The edges ending at a vertex keep the order they had in the file,
+//		which is the order findHighestWeightPath() considers them in.
+//  Postconditions:
+//		incomingOffsets, incomingEdges - populated from fileEdges
+//		fileEdges, vertexIdSlots and edgeLabelIds - released
+void WDAGraph::buildIncomingEdges() {
+
+	edgeCount = fileEdges.size();
+	uint32_t* offsets = arena.allocateArray<uint32_t>((size_t) vertexCount + 1);
+	Edge* edges = arena.allocateArray<Edge>(edgeCount);
+
+	// Count the edges ending at each vertex
+	fill(offsets, offsets + vertexCount + 1, 0);
+	for (FileEdge& edge : fileEdges)
+		offsets[edge.end + 1]++;
+
+	// Turn the counts into offsets
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+		offsets[vertex + 1] += offsets[vertex];
+
+	// Place the edges in file order
+	vector<uint32_t> nextEdge(offsets, offsets + vertexCount);
+	for (FileEdge& fileEdge : fileEdges) {
+		Edge& edge = edges[nextEdge[fileEdge.end]++];
+		edge.start = fileEdge.start;
+		edge.label = fileEdge.label;
+		edge.weight = fileEdge.weight;
+	}
 
+	incomingOffsets = offsets;
+	incomingEdges = edges;
+	ownedEdges = edges;
+
+	// Release the collections only needed while reading the file
+	vector<FileEdge>().swap(fileEdges);
+	vector<uint32_t>().swap(vertexIdSlots);
+	unordered_map<string, uint32_t>().swap(edgeLabelIds);
+}
+
+// relaxVertex(uint32_t vertex)
+//  Purpose:
+//		Finds the highest weight path to the vertex over its incoming edges,
+//		starting from the weight already in vertexWeights (0 if the trivial
+//		path of starting at the vertex is allowed, INT_MIN if not).  If the
+//		path is start constrained, edges from vertices that can not be
+//		reached from the start vertex are skipped.
+//  Preconditions:
+//		The start vertices of the incoming edges have been relaxed
+//  Postconditions:
+//		vertexWeights and edgeForHWPath (unless in score only mode) will be set for the vertex
+void WDAGraph::relaxVertex(uint32_t vertex) {
+	double vertexWeight = vertexWeights[vertex];
+	uint32_t vertexEdge = noEdge;
+	uint32_t edgesEnd = incomingOffsets[vertex + 1];
+	for (uint32_t edgeIndex = incomingOffsets[vertex]; edgeIndex < edgesEnd; edgeIndex++) {
+		const Edge& edge = incomingEdges[edgeIndex];
+		double startWeight = vertexWeights[edge.start];
+
+		// If start constrained make sure edge start is from a valid path
+		if  (isStartConstrained()) {
+			if (startWeight == INT_MIN)
+				continue;
+		}
+		// Calculate weight (parent node weight plus edge weight)
+		double pathWeight = startWeight + edge.weight;
+
+		// If path weight bigger than any other found so far then
+		// it becomes the new weight for the vertex
+		if (pathWeight > vertexWeight) {
+			vertexWeight = pathWeight;
+			vertexEdge = edgeIndex;
+		}
+	}
+	vertexWeights[vertex] = vertexWeight;
+	if (!scoreOnly)
+		edgeForHWPath[vertex] = vertexEdge;
+}
+
+// buildOutgoingEdges()
+//  Purpose:
+//		Groups the edges by their start vertex, so each vertex can find the
+//		vertices it has edges to.
+//  Postconditions:
+//		outgoingOffsets, outgoingVertices - populated
+void WDAGraph::buildOutgoingEdges() {
+	outgoingOffsets.assign(vertexCount + 1, 0);
+	for (uint32_t edgeIndex = 0; edgeIndex < incomingOffsets[vertexCount]; edgeIndex++)
+		outgoingOffsets[incomingEdges[edgeIndex].start + 1]++;
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+		outgoingOffsets[vertex + 1] += outgoingOffsets[vertex];
+
+	outgoingVertices.assign(outgoingOffsets[vertexCount], 0);
+	vector<uint32_t> nextOutgoing(outgoingOffsets.begin(), outgoingOffsets.end() - 1);
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++) {
+		for (uint32_t edgeIndex = incomingOffsets[vertex]; edgeIndex < incomingOffsets[vertex + 1]; edgeIndex++)
+			outgoingVertices[nextOutgoing[incomingEdges[edgeIndex].start]++] = vertex;
+	}
+}
+
+// buildLevels()
+//  Purpose:
+//		Groups the vertices into topological levels with Kahn's algorithm:
+//		level 0 holds the vertices with no incoming edges, and each later
+//		level holds the vertices whose incoming edges all start in earlier
+//		levels.  The vertices of a level are kept in depth order.  If the
+//		graph has a cycle, no levels are built.
+//  Postconditions:
+//		levelOffsets, levelVertices - populated (levelOffsets is left with
+//		a single entry if the graph has a cycle)
+void WDAGraph::buildLevels() {
+
+	// Each vertex needs to find the vertices it has edges to
+	if (outgoingOffsets.empty())
+		buildOutgoingEdges();
+
+	// Number of incoming edges of each vertex from vertices not yet levelled
+	vector<uint32_t> remainingEdges(vertexCount);
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+		remainingEdges[vertex] = incomingOffsets[vertex + 1] - incomingOffsets[vertex];
+
+	levelOffsets.assign(1, 0);
+	levelVertices.clear();
+	levelVertices.reserve(vertexCount);
+
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++) {
+		if (remainingEdges[vertex] == 0)
+			levelVertices.push_back(vertex);
+	}
+
+	// Each level frees up the vertices of the next one
+	size_t levelStart = 0;
+	while (levelStart < levelVertices.size()) {
+		size_t levelEnd = levelVertices.size();
+		levelOffsets.push_back(levelEnd);
+
+		for (size_t levelIndex = levelStart; levelIndex < levelEnd; levelIndex++) {
+			uint32_t vertex = levelVertices[levelIndex];
+			for (uint32_t outgoing = outgoingOffsets[vertex]; outgoing < outgoingOffsets[vertex + 1]; outgoing++) {
+				if (--remainingEdges[outgoingVertices[outgoing]] == 0)
+					levelVertices.push_back(outgoingVertices[outgoing]);
+			}
+		}
+
+		sort(levelVertices.begin() + levelEnd, levelVertices.end());
+		levelStart = levelEnd;
+	}
+
+	// A cycle leaves some vertices without a level
+	if (levelVertices.size() != vertexCount) {
+		levelOffsets.assign(1, 0);
+		levelVertices.clear();
+	}
+}
+
+// findHighestWeightPathByLevel()
+//  Purpose:
+//		Does the same as findHighestWeightPath(), but relaxes the vertices
+//		a topological level at a time with the vertices of each level spread
+//		over threadCount threads.  Each vertex only reads the weights of
+//		vertices in earlier levels, and the highest weight node is picked
+//		in depth order afterwards, so the path found does not depend on
+//		the number of threads.
+//
+//		As in findHighestWeightPath(), vertices before the start vertex
+//		(in depth order) are not part of any path if the path is start
+//		constrained, and vertices after the end vertex are not relaxed if
+//		it is end constrained.
+//  Preconditions:
+//		buildLevels() has been run and the graph has no cycles
+//		vertexWeights and edgeForHWPath have been initialized
+//  Postconditions:
+//		- vertexWeights and edgeForHWPath (unless in score only mode) will be set for the vertices
+//		- highestWeightPath attribute will be set
+void WDAGraph::findHighestWeightPathByLevel() {
+
+	// Range of vertices (in depth order) that are relaxed
+	uint32_t firstVertex = isStartConstrained() ? startNode : 0;
+	uint32_t lastVertex = vertexCount - 1;
+	if (isEndConstrained() && endNode >= firstVertex)
+		lastVertex = endNode;
+
+	// Consider the trivial path of starting at each vertex (or only at the
+	// start vertex if start constrained)
+	if (isStartConstrained())
+		vertexWeights[startNode] = 0;
+	else
+		fill(vertexWeights.begin(), vertexWeights.end(), 0);
+
+	ThreadPool pool(threadCount);
+	for (size_t level = 0; level + 1 < levelOffsets.size(); level++) {
+		size_t levelStart = levelOffsets[level];
+		size_t levelSize = levelOffsets[level + 1] - levelStart;
+		size_t chunkCount = (levelSize + levelChunkSize - 1) / levelChunkSize;
+
+		pool.parallelFor(chunkCount, [&](size_t chunk, unsigned int) {
+			size_t chunkStart = levelStart + chunk * levelChunkSize;
+			size_t chunkEnd = min(chunkStart + levelChunkSize, levelStart + levelSize);
+
+			for (size_t levelIndex = chunkStart; levelIndex < chunkEnd; levelIndex++) {
+				uint32_t vertex = levelVertices[levelIndex];
+				if (vertex >= firstVertex && vertex <= lastVertex)
+					relaxVertex(vertex);
+			}
+		});
+	}
+
+	INSTRUMENT_COUNT(cellsRelaxed, lastVertex - firstVertex + 1);
+	INSTRUMENT_COUNT(edgesRelaxed, incomingOffsets[lastVertex + 1] - incomingOffsets[firstVertex]);
+
+	findHighestWeightNode(firstVertex, lastVertex);
+}
+
+// findHighestWeightNode(uint32_t firstVertex, uint32_t lastVertex)
+//  Purpose:
+//		Sets highestWeightNode from the weights of the relaxed vertices
+//		firstVertex to lastVertex, the same way findHighestWeightPath() does:
+//		the end vertex if the path is end constrained, otherwise the first
+//		vertex in depth order with the highest weight.
+//  Preconditions:
+//		vertexWeights has been set for firstVertex to lastVertex
+//  Postconditions:
+//		highestWeightNode will be set
+void WDAGraph::findHighestWeightNode(uint32_t firstVertex, uint32_t lastVertex) {
+	highestWeightNode = noVertex;
+
+	// Check for end constraint
+	if (isEndConstrained()) {
+		if (endNode >= firstVertex)
+			highestWeightNode = endNode;
+		else
+			highestWeightNode = startNode;  // the end vertex comes before the start vertex
+		return;
+	}
+
+	// Set highestWeightNode (the first vertex in depth order with the highest weight)
+	for (uint32_t vertex = firstVertex; vertex <= lastVertex; vertex++) {
+		if (highestWeightNode == noVertex || vertexWeights[vertex] > vertexWeights[highestWeightNode])
+			highestWeightNode = vertex;
+	}
+}
+
+// findTopPaths()
+//  Purpose:
+//		Does the same as findHighestWeightPath(), but keeps the pathCount
+//		highest weight paths to each vertex rather than only the highest
+//		one, so the pathCount highest weight paths through the graph are
+//		found in one pass.  The paths to a vertex are made from the trivial
+//		path of starting at the vertex (if allowed) and, for each edge that
+//		ends at the vertex, each of the paths kept for the edge's start
+//		vertex plus the edge weight.
+//
+//		The paths of each vertex are kept highest weight first in a fixed
+//		size slot of topWeights, topEdges and topRanks, and a path only
+//		moves ahead of those that are strictly lower, so the highest weight
+//		path is the one findHighestWeightPath() finds.  The paths of the
+//		graph are those of the end vertex if the path is end constrained,
+//		otherwise the highest of all of the vertices' paths (the first
+//		vertex in depth order first if the weights are equal).
+//  Postconditions:
+//		topWeights, topEdges, topRanks, topCounts - set for the vertices
+//		pathEnds, pathEndRanks - the highest weight paths found
+void WDAGraph::findTopPaths() {
+	size_t slotCount = (size_t) vertexCount * pathCount;
+	topWeights.assign(slotCount, 0);
+	topEdges.assign(slotCount, noEdge);
+	topRanks.assign(slotCount, 0);
+	topCounts.assign(vertexCount, 0);
+	pathEnds.clear();
+	pathEndRanks.clear();
+	highestWeightNode = noVertex;
+
+	// The weights found can not be rescored a vertex at a time
+	pathWeightsKnown = false;
+	vector<double>().swap(vertexWeights);
+	vector<uint32_t>().swap(edgeForHWPath);
+
+	if (vertexCount == 0)
+		return;
+
+	// Range of vertices (in depth order) that are relaxed
+	uint32_t firstVertex = isStartConstrained() ? startNode : 0;
+	uint32_t lastVertex = vertexCount - 1;
+	if (isEndConstrained() && endNode >= firstVertex)
+		lastVertex = endNode;
+
+	for (uint32_t vertex = firstVertex; vertex <= lastVertex; vertex++) {
+		// Consider the trivial path of starting here (only at the start
+		// vertex if start constrained)
+		if (!isStartConstrained() || vertex == startNode)
+			insertTopPath(vertex, 0, noEdge, 0);
+
+		for (uint32_t edgeIndex = incomingOffsets[vertex]; edgeIndex < incomingOffsets[vertex + 1]; edgeIndex++) {
+			const Edge& edge = incomingEdges[edgeIndex];
+			size_t startSlot = (size_t) edge.start * pathCount;
+			for (uint32_t rank = 0; rank < topCounts[edge.start]; rank++) {
+				// The later paths of the start vertex are no higher
+				if (!insertTopPath(vertex, topWeights[startSlot + rank] + edge.weight, edgeIndex, rank))
+					break;
+			}
+		}
+	}
+
+	INSTRUMENT_COUNT(cellsRelaxed, lastVertex - firstVertex + 1);
+	INSTRUMENT_COUNT(edgesRelaxed, incomingOffsets[lastVertex + 1] - incomingOffsets[firstVertex]);
+
+	// Check for end constraint
+	if (isEndConstrained()) {
+		uint32_t pathEnd = (endNode >= firstVertex) ? endNode : startNode;
+		for (uint32_t rank = 0; rank < topCounts[pathEnd]; rank++) {
+			pathEnds.push_back(pathEnd);
+			pathEndRanks.push_back(rank);
+		}
+	}
+	else {
+		// Merge the paths of the vertices, highest weight first
+		vector<double> pathWeights;
+		for (uint32_t vertex = firstVertex; vertex <= lastVertex; vertex++) {
+			size_t slot = (size_t) vertex * pathCount;
+			for (uint32_t rank = 0; rank < topCounts[vertex]; rank++) {
+				double weight = topWeights[slot + rank];
+				if (pathWeights.size() == pathCount && weight <= pathWeights.back())
+					break;
+
+				size_t position = upper_bound(pathWeights.begin(), pathWeights.end(), weight, greater<double>()) - pathWeights.begin();
+				pathWeights.insert(pathWeights.begin() + position, weight);
+				pathEnds.insert(pathEnds.begin() + position, vertex);
+				pathEndRanks.insert(pathEndRanks.begin() + position, rank);
+				if (pathWeights.size() > pathCount) {
+					pathWeights.pop_back();
+					pathEnds.pop_back();
+					pathEndRanks.pop_back();
+				}
+			}
+		}
+	}
+
+	if (!pathEnds.empty())
+		highestWeightNode = pathEnds[0];
+}
+
+// bool insertTopPath(uint32_t vertex, double weight, uint32_t edge, uint32_t rank)
+//  Purpose:
+//		Adds a path to the paths kept for the vertex if it is one of the
+//		pathCount highest, after any paths with the same weight.  edge is
+//		the last edge of the path (noEdge for the trivial path) and rank is
+//		which of the paths of the edge's start vertex it continues.  Returns
+//		false if the path was not high enough to be kept.
+//  Postconditions:
+//		topWeights, topEdges, topRanks, topCounts - path added for the vertex
+bool WDAGraph::insertTopPath(uint32_t vertex, double weight, uint32_t edge, uint32_t rank) {
+	size_t slot = (size_t) vertex * pathCount;
+	uint32_t count = topCounts[vertex];
+	if (count == pathCount && weight <= topWeights[slot + count - 1])
+		return false;
+
+	// Shift the lower paths down one (dropping the lowest if full)
+	uint32_t position = (count < pathCount) ? count : count - 1;
+	while (position > 0 && topWeights[slot + position - 1] < weight) {
+		topWeights[slot + position] = topWeights[slot + position - 1];
+		topEdges[slot + position] = topEdges[slot + position - 1];
+		topRanks[slot + position] = topRanks[slot + position - 1];
+		position--;
+	}
+
+	topWeights[slot + position] = weight;
+	topEdges[slot + position] = edge;
+	topRanks[slot + position] = rank;
+	if (count < pathCount)
+		topCounts[vertex] = count + 1;
+
+	return true;
 }
 
 // bool isStartConstrained()
 //  Purpose:
 //		Returns true if a start vertex is designated in the graph file
 bool WDAGraph::isStartConstrained() {
-	return startNode != NULL;
+	return startNode != noVertex;
 }
 
 // bool isEndConstrained()
 //  Purpose:
 //		Returns true if an end vertex is designated in the graph file
 bool WDAGraph::isEndConstrained() {
-	return endNode != NULL;
+	return endNode != noVertex;
 }
 
-// string getEdgeWeights()
+// writeEdgeWeights(OutputBuffer& out)
 //  Purpose:
-//		Returns a comma delimited string describing each of the edge labels
+//		Writes a comma delimited string describing each of the edge labels
 //		and its correpsonding weight.
 //
 //		Format:		<edge label> = <edge weight>
-string WDAGraph::getEdgeWeights() {
-	stringstream ss;
-	ss.precision(3);
-
-	// Iterate throght edge weights map
-	for (auto edgeWeight : edgeWeights) {
-		ss << edgeWeight.first << "=" << edgeWeight.second << ", ";
+void WDAGraph::writeEdgeWeights(OutputBuffer& out) {
+
+	// Iterate throght edge weights map (", " goes between the labels)
+	bool first = true;
+	for (auto& edgeWeight : edgeWeights) {
+		if (!first)
+			out.write(", ");
+		first = false;
+
+		out.write(edgeWeight.first);
+		out.write('=');
+		out.write(edgeWeight.second, 3);
 	}
-
-	// Return all but last 2 char (as there will be an extra ,<space> at end)
-	string temp = ss.str();
-	return temp.substr(0, temp.length() -2);
 }
 
-// string getEdgeFrequenciess()
+// writeEdgeFrequencies(OutputBuffer& out)
 //  Purpose:
-//		Returns a comma delimited string describing each of the edge labels
+//		Writes a comma delimited string describing each of the edge labels
 //		and its correpsonding frequency (the number of edges in the graph
 //		that use that label).
 //
 //		Format:		<edge label> = <edge frequency>
-string WDAGraph::getEdgeFrequencies() {
-	stringstream ss;
-
-	// Iterate throght edge weights map
-	for (auto edgeFrequency : edgeFrequencies) {
-		ss << edgeFrequency.first << "=" << edgeFrequency.second << ", ";
+void WDAGraph::writeEdgeFrequencies(OutputBuffer& out) {
+
+	// Iterate throght edge frequencies map (", " goes between the labels)
+	bool first = true;
+	for (auto& edgeFrequency : edgeFrequencies) {
+		if (!first)
+			out.write(", ");
+		first = false;
+
+		out.write(edgeFrequency.first);
+		out.write('=');
+		out.write(edgeFrequency.second);
 	}
-
-	// Return all but last 2 char (as there will be an extra ,<space> at end)
-	string temp = ss.str();
-	return temp.substr(0, temp.length() -2);
 }
 
-// string getPathStartNodeLabel()
+// const char* getPathStartNodeLabel()
 //  Purpose:
 //		Returns the label for the start node from the highest weight path.
-string WDAGraph::getPathStartNodeLabel() {
+const char* WDAGraph::getPathStartNodeLabel() {
 
 	// Base Case
-	if (highestWeightNode == NULL)
+	if (highestWeightNode == noVertex)
 		return "";
 
-	// Search for start node (previous is NULL)
-	Vertex* aNode = highestWeightNode;
-	while (aNode->edgeForHWPath != NULL) {
+	// Search for start node (previous is noEdge)
+	uint32_t aNode = highestWeightNode;
+	while (edgeForHWPath[aNode] != noEdge) {
 		// Walk backwards until find the start node
-		Edge* anEdge = aNode->edgeForHWPath;
-		aNode = anEdge->start;
+		const Edge& anEdge = incomingEdges[edgeForHWPath[aNode]];
+		aNode = anEdge.start;
 	}
 
-	return aNode->label;
+	return vertexLabel(aNode);
 }
 
-// string getPath()
+// writePath(OutputBuffer& out)
 //  Purpose:
-//		Returns a string representing the edge labels for the highest weight
+//		Writes a string representing the edge labels for the highest weight
 //		path.  The edge labels are listed from the start to the end of the path.
-string WDAGraph::getPath() {
+void WDAGraph::writePath(OutputBuffer& out) {
 
 	// Base Case
-	if (highestWeightNode == NULL)
-		return "";
-
-	stringstream ss;
+	if (highestWeightNode == noVertex)
+		return;
 
 	// Walk path backwards and build string
-	Vertex* aNode = highestWeightNode;
-	while (aNode->edgeForHWPath != NULL) {
-		// Add the label from the edge to the string stream
-		Edge* anEdge = aNode->edgeForHWPath;
-		ss << anEdge->label << "\n";
+	size_t pathStart = out.getSize();
+	uint32_t aNode = highestWeightNode;
+	while (edgeForHWPath[aNode] != noEdge) {
+		// Add the label from the edge to the buffer
+		const Edge& anEdge = incomingEdges[edgeForHWPath[aNode]];
+		out.write(edgeLabels[anEdge.label]);
+		out.write('\n');
 
 		// Walk backwards one node
-		aNode = anEdge->start;
+		aNode = anEdge.start;
 	}
 
-	// Return reverse of stringstream (since we built the string backwards)
-	string reversePath = ss.str();
-	return string(reversePath.rbegin(), reversePath.rend());
+	// Reverse what was written (since we built the string backwards)
+	out.reverse(pathStart);
+}
 
+// writeTopPaths(OutputBuffer& out)
+//  Purpose:
+//		Writes the results of each of the paths found by findTopPaths(),
+//		highest weight first, in the same format as the single highest
+//		weight path.
+void WDAGraph::writeTopPaths(OutputBuffer& out) {
+	if (pathEnds.empty()) {
+		out.xmlResult("path", "No Path Found!");
+		return;
+	}
+
+	for (size_t path = 0; path < pathEnds.size(); path++) {
+		uint32_t vertex = pathEnds[path];
+		uint32_t rank = pathEndRanks[path];
+		out.xmlResult("score", topWeights[(size_t) vertex * pathCount + rank], 6);
+
+		// The path is not reported in score only mode
+		if (scoreOnly)
+			out.xmlResult("end_vertex", vertexLabel(vertex));
+		else {
+			out.xmlResult("beginning_vertex", getTopPathStartNodeLabel(vertex, rank));
+			out.xmlResult("end_vertex", vertexLabel(vertex));
+			out.beginResult("path");
+			writeTopPath(out, vertex, rank);
+			out.endResult();
+		}
+	}
 }
+
+// const char* getTopPathStartNodeLabel(uint32_t vertex, uint32_t rank)
+//  Purpose:
+//		Returns the label for the start node of the rank'th path kept for
+//		the vertex by findTopPaths().
+const char* WDAGraph::getTopPathStartNodeLabel(uint32_t vertex, uint32_t rank) {
+
+	// Walk backwards until find the start node (previous is noEdge)
+	size_t slot = (size_t) vertex * pathCount + rank;
+	while (topEdges[slot] != noEdge) {
+		vertex = incomingEdges[topEdges[slot]].start;
+		slot = (size_t) vertex * pathCount + topRanks[slot];
+	}
+
+	return vertexLabel(vertex);
+}
+
+// writeTopPath(OutputBuffer& out, uint32_t vertex, uint32_t rank)
+//  Purpose:
+//		Writes a string representing the edge labels for the rank'th path
+//		kept for the vertex by findTopPaths().  The edge labels are listed
+//		from the start to the end of the path.
+void WDAGraph::writeTopPath(OutputBuffer& out, uint32_t vertex, uint32_t rank) {
+
+	// Walk path backwards and build string
+	size_t pathStart = out.getSize();
+	size_t slot = (size_t) vertex * pathCount + rank;
+	while (topEdges[slot] != noEdge) {
+		// Add the label from the edge to the buffer
+		const Edge& anEdge = incomingEdges[topEdges[slot]];
+		out.write(edgeLabels[anEdge.label]);
+		out.write('\n');
+
+		// Walk backwards one node
+		slot = (size_t) anEdge.start * pathCount + topRanks[slot];
+	}
+
+	// Reverse what was written (since we built the string backwards)
+	out.reverse(pathStart);
+}
\ No newline at end of file
@@ -6,20 +6,14 @@
  *  as the typical expected use is a sparsely connected graph (e.g. a sequence
  *  graph).
  *
- *  ************* WARNING ***********************************
- *  *  There is no error handling in place for this object! *
- *  *  This means that if the file does not exist or is     *
- *  *  formatted incorrectly, you will get an error and     *
- *  *  will not be able to use this object.                 *
- *  *                                                       *
- *  *  If this code gets moved to a production setting      *
- *  *  appropriate error handling should be implemented!    *
- *  *********************************************************
- *
  *  Typical use for the file would be to use the WDAGraph(graphFileName)
  *  constructor to create the object.  This will automatically open the
  *  graph describer file specified by graphfileName, and read its contents
- *  storing them in the vertices vector and edges map.
+ *  storing the edges ending at each vertex in one contiguous array
+ *  (compressed sparse row form) so the dynamic program can walk them
+ *  without any lookups by label.  The labels and edges are allocated from
+ *  an arena owned by the graph, and are freed in one step when the graph
+ *  is destroyed.
  *
  *  The file is expected to be formatted as follows:
  *
@@ -54,8 +48,39 @@
  *		  - end_verex is the label of the edge's ending vertex
  *		  - weight is the numerical weight attached to the edge
  *
+ *	  The vertices of an edge have to be on vertex lines before the edge.  A
+ *	  line that is empty, is missing fields, repeats a vertex label or names
+ *	  an unknown vertex makes the constructor throw out_of_range with the
+ *	  line number (for any number of threads).
+ *
+ *  If the graph is created with more than one thread, a text graph file is
+ *  memory mapped and cut into chunks at line breaks, the chunks are parsed
+ *  on the threads into buffers of their own, and the buffers are merged in
+ *  file order.  The vertex ids (depth order), the edge order and the edge
+ *  label ids are the same as for a single thread.
+ *
+ *  The graph file can also be a binary graph file (see WDAGraphBinaryFormat.h)
+ *  as written by WDAGraphBinaryWriter.  Binary files are recognized by their
+ *  magic bytes and are memory mapped rather than read, the dynamic program
+ *  runs directly over the edges in the mapped file.
+ *
  *  After creating the object, typical use would be to call the findHighestWeightPath()
  *  which will find the path with the highest weight using dynamic programming.
+ *  If setThreadCount() is given more than one thread, the vertices are grouped
+ *  into topological levels and the vertices of each level are relaxed in
+ *  parallel.  The path found is the same for any number of threads.
+ *  In score only mode (setScoreOnly()) the edge used to reach each vertex
+ *  is not kept, so only the score and end vertex of the path are found.
+ *
+ *  If setPathCount() is given more than one path, the highest weight paths
+ *  to each vertex are kept rather than only the highest one, and that many
+ *  of the highest weight paths through the graph are found in one pass and
+ *  each reported in resultString().
+ *
+ *  To try other edge weights on the same graph, setEdgeWeights() changes
+ *  the weights by label and rescoreHighestWeightPath() then relaxes only
+ *  the vertices downstream of the changed edges, keeping the weights of
+ *  the rest from the last findHighestWeightPath().
  *
  *  Finally one would typically call the resultString() method to get a formatted set
  *	of results indicating the path with the highest weight.
@@ -66,11 +91,17 @@
 
 #ifndef WDAGraph_H
 #define WDAGraph_H
+#include "Arena.h"
+#include "WDAGraphBinaryFormat.h"
+#include "OutputBuffer.h"
 #include <iostream>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <string>
+#include <string_view>
 #include <climits>
+#include <cstdint>
 using namespace std;
 
 class WDAGraph {
@@ -81,6 +112,7 @@ public:
 	// ==============================================
 	WDAGraph();
 	WDAGraph(string& aGraphFileName);
+	WDAGraph(string& aGraphFileName, unsigned int aThreadCount);  // more than 1 parses a text graph file in parallel
 
 	// Destructor
 	// =============================================
@@ -113,11 +145,43 @@ public:
 	//							  weight path
 	//
 	//  Postconditions:
-	//		- vertex objects in the vertices collection will have their weight 
-	//		  and edgeForHWPAth set
+	//		- vertexWeights and edgeForHWPath (unless in score only mode) will be set for the vertices
 	//		- highestWeightPath attribute will be set
 	void findHighestWeightPath();
 
+	// setEdgeWeights(const map<string, double>& newWeights)
+	//  Purpose:
+	//		Changes the weight of every edge with a label in newWeights to the
+	//		weight given for the label.  Labels that are not in the graph are
+	//		ignored.  The vertices that the changed edges end at are remembered,
+	//		so rescoreHighestWeightPath() only has to relax the vertices from
+	//		there on.
+	//
+	//		The edges of a binary graph file are in the read only mapping, so
+	//		the first change copies them into the arena.
+	//  Postconditions:
+	//		incomingEdges, edgeWeights - weights changed
+	//		changedVertices - end vertices of the changed edges added
+	void setEdgeWeights(const map<string, double>& newWeights);
+
+	// rescoreHighestWeightPath()
+	//  Purpose:
+	//		Finds the highest weight path again after setEdgeWeights(), reusing
+	//		the weights of the last findHighestWeightPath().  Only the vertices
+	//		with changed incoming edges are relaxed again, and then the vertices
+	//		they have edges to if their weight changed, and so on.  The vertices
+	//		are relaxed in depth order (smallest first), so each vertex is
+	//		relaxed after all of the vertices it has edges from.  The path found
+	//		is the same as findHighestWeightPath() would find.
+	//
+	//		If findHighestWeightPath() has not been run (or score only mode or
+	//		the path count has changed since), or more than one path is wanted,
+	//		it is simply run.
+	//  Postconditions:
+	//		- vertexWeights and edgeForHWPath (unless in score only mode) will be set for the vertices
+	//		- highestWeightPath attribute will be set
+	void rescoreHighestWeightPath();
+
 	// string resultString()
 	//  Purpose:
 	//		Returns an XML formatted string representing the results of the
@@ -131,44 +195,153 @@ public:
 	//			  <result type="beginning_vertex"> <<start vertex for path>> </result>
 	//			  <result type="ending_vertex"> <<end vertex for path>> </result>
 	//			  <result type="path"> << list of path edge labels in order>> </result>
+	//			  <result type="instrumentation"> <<counters and timers>> </result>
 	//			</results>
+	//
+	//		In score only mode the beginning_vertex and path results are left out.
+	//		If more than one path is found (setPathCount()), the score through
+	//		path results are repeated for each path, highest weight first.
+	//		The instrumentation result is only there if built with
+	//		-DWDA_INSTRUMENTATION (see Instrumentation.h).
 	//  Preconditions:
 	//		findHighestWeightPath() has been run
 	string resultString();
 
+	// writeResult(OutputBuffer& out)
+	//  Purpose:
+	//		Appends the string resultString() returns to out, without
+	//		building any strings along the way.
+	//  Preconditions:
+	//		findHighestWeightPath() has been run
+	void writeResult(OutputBuffer& out);
+
+	// Public Accessors
+	// =============================================
+	void setThreadCount(unsigned int aThreadCount);  // more than 1 relaxes the vertices by topological level
+	void setScoreOnly(bool aScoreOnly);  // find only the score and end vertex (no path)
+	void setPathCount(unsigned int aPathCount);  // find the aPathCount highest weight paths (default 1)
+
 private:
 
 	// Attributes
 	// =============================================
 
-	// Forward delcaration of edge so it can be used as an attribute in the
-	// Vertex object
-	struct Edge;
+	// Vertices are identified by their position in the depth ordering of
+	// the graph file (0 to vertexCount - 1).  noVertex marks a missing vertex
+	// and noEdge a missing edge.
+	static const uint32_t noVertex = UINT32_MAX;
+	static const uint32_t noEdge = UINT32_MAX;
 
-	// An object for holding informatoin related to a vertex
-	struct Vertex {
-		string label;  // name of vertex (must be unique)
-		double weight; // highest path weight to get to the vertex
-		Edge* edgeForHWPath; // edge that was used for the highest weight path
+	// An object for holding information related to an edge.  Edges are
+	// stored with the vertex they end at, so the end vertex is implied by
+	// the position of the edge in incomingEdges.
+	struct Edge {
+		uint32_t start;  // id of the start vertex of the edge
+		uint32_t label;  // id of the name of the edge
+		double weight;  // cost to have path us this edge
 	};
 
-	// An object for holding information related to an edge
-	struct Edge {
-		string label;  // name of edge
+	// An object for holding an edge while the graph file is read
+	struct FileEdge {
+		uint32_t start;  // id of the start vertex of the edge
+		uint32_t end;  // id of the end vertex of the edge
+		uint32_t label;  // id of the name of the edge
 		double weight;  // cost to have path us this edge
-		Vertex* start;  // start vertex of the edge
-		Vertex* end;  // end vertex of the edge
 	};
 
 	string graphFileName;  // name of file defining the graph
-	vector<Vertex*> vertices; // depth odering of vertices
-	map<string, Vertex*> verticeMap;  // map of vertex by name, used for quick lookup of vertices
-	map<string, vector<Edge*>> edges; // Collection of edges
-	Vertex* startNode; // start node designated in graph file (if any)
-	Vertex* endNode; // end node designated in graph file (if any)
-	Vertex* highestWeightNode; // Ending node of the highest weight path
+	Arena arena;  // storage for the vertex labels and edges
+	uint32_t vertexCount;  // number of vertices in the graph
+	uint32_t edgeCount;  // number of edges in the graph
+	vector<const char*> vertexLabels; // name of each vertex, in depth ordering of vertices
+	vector<string> edgeLabels;  // name of each edge label id
+	const uint32_t* incomingOffsets;  // incoming edges of vertex v are incomingEdges[incomingOffsets[v]] to incomingEdges[incomingOffsets[v+1] - 1]
+	const Edge* incomingEdges;  // edges grouped by end vertex, in graph file order for each vertex
+	Edge* ownedEdges;  // incomingEdges if they are in the arena (NULL while they are in a binary graph file mapping)
+	vector<double> vertexWeights;  // highest path weight to get to each vertex
+	vector<uint32_t> edgeForHWPath;  // incoming edge used for the highest weight path to each vertex (empty in score only mode)
+	bool scoreOnly;  // do not keep edgeForHWPath
+	uint32_t startNode; // start node designated in graph file (if any)
+	uint32_t endNode; // end node designated in graph file (if any)
+	uint32_t highestWeightNode; // Ending node of the highest weight path
 	map<string, double> edgeWeights;  // map of weights for each edge label
 	map<string, int> edgeFrequencies;  // map of frequencies for each edge label
+	unsigned int threadCount;  // threads used by findHighestWeightPath()
+
+	// Used by rescoreHighestWeightPath()
+	bool pathWeightsKnown;  // vertexWeights and edgeForHWPath are from findHighestWeightPath()
+	vector<uint32_t> changedVertices;  // end vertices of the edges changed since (in depth order)
+
+	// Edges grouped by start vertex (see buildOutgoingEdges()), the edges
+	// from vertex v go to outgoingVertices[outgoingOffsets[v]] to
+	// outgoingVertices[outgoingOffsets[v+1] - 1]
+	vector<uint32_t> outgoingOffsets;
+	vector<uint32_t> outgoingVertices;
+
+	// Used when more than one path is found (see findTopPaths()).  The paths
+	// to vertex v are kept, highest weight first, in slots v * pathCount to
+	// v * pathCount + topCounts[v] - 1 of topWeights, topEdges and topRanks.
+	unsigned int pathCount;  // number of highest weight paths to find
+	vector<double> topWeights;  // weight of each path
+	vector<uint32_t> topEdges;  // last edge of each path (noEdge for the trivial path)
+	vector<uint32_t> topRanks;  // which path of the last edge's start vertex each path continues
+	vector<uint32_t> topCounts;  // number of paths kept for each vertex
+	vector<uint32_t> pathEnds;  // end vertex of each path found, highest weight first
+	vector<uint32_t> pathEndRanks;  // which path of its end vertex each path found is
+
+	// Topological levels (see buildLevels()), the vertices of level l are
+	// levelVertices[levelOffsets[l]] to levelVertices[levelOffsets[l+1] - 1]
+	vector<size_t> levelOffsets;
+	vector<uint32_t> levelVertices;
+
+	// Number of vertices of a level relaxed by a thread at a time
+	static const size_t levelChunkSize = 1024;
+
+	// Only used for a memory mapped binary graph file
+	void* mappedFile;  // start of the mapping (NULL for a text graph file)
+	size_t mappedFileSize;
+	const WDAGraphBinaryVertex* mappedVertices;  // vertex table in the mapping
+	const char* mappedVertexLabels;  // vertex label pool in the mapping
+
+	// Only used while the graph file is read
+	vector<uint32_t> vertexIdSlots;  // open addressing table of vertex ids, hashed by label
+	unordered_map<string, uint32_t> edgeLabelIds;  // id of each edge label
+	string labelKey;  // edge label being looked up (reused, so it is not allocated for each edge)
+	vector<FileEdge> fileEdges;  // edges in graph file order
+
+	// The lines of a chunk of a text graph file parsed by one thread (see
+	// buildGraphInParallel()).  The labels are views into the mapped file.
+	struct ChunkVertex {
+		string_view label;
+		size_t line;  // line of the vertex in the chunk (from 1)
+		bool start;  // designated the START vertex
+		bool end;  // designated the END vertex
+	};
+	struct ChunkEdge {
+		string_view startLabel;
+		string_view endLabel;
+		uint32_t label;  // index of the label in the chunk's labels
+		uint32_t verticesBefore;  // vertices of the chunk on lines before the edge
+		size_t line;  // line of the edge in the chunk (from 1)
+		double weight;
+	};
+	struct ParsedChunk {
+		vector<ChunkVertex> vertices;
+		vector<ChunkEdge> edges;
+		vector<string_view> labels;  // edge labels in the order first seen in the chunk
+		vector<double> labelWeights;  // weight of the first edge with each label
+		size_t lineCount;  // lines parsed (up to and including a bad line)
+		string error;  // first bad line of the chunk (empty if none), the last line parsed
+		string edgeError;  // first edge of the chunk with an unknown vertex (empty if none)
+		size_t edgeErrorLine;  // line of that edge in the chunk
+	};
+
+	// Bytes of a text graph file parsed by a thread at a time
+	static const size_t parseChunkSize = 1 << 22;
+
+	// The graph owns the memory of its arena, so it can not be copied
+	WDAGraph(const WDAGraph&) = delete;
+	WDAGraph& operator=(const WDAGraph&) = delete;
 
 	// Private Methods
 	// =============================================
@@ -181,29 +354,239 @@ private:
 	//		collection, if the the first char is an E then an edge is added
 	//		to the edges collection. See class header for description of file
 	//		contents. 
+	//
+	//		Vertex and edge labels are interned to integer ids as the file is
+	//		read, and once the whole file is read the edges are grouped by
+	//		their end vertex (see buildIncomingEdges()).
 	//  Postconditions:
 	//		The following attirbutes will be populated:
-	//			vertices, verticeMap, startNode, endNode,
-	//			edges, edgeWeights, edgeFrequencies
+	//			vertexCount, vertexLabels, startNode, endNode, edgeLabels,
+	//			incomingOffsets, incomingEdges, edgeWeights, edgeFrequencies
 	void buildGraph();
 
-	// addVertex(vector<string>& tokens)
+	// bool isBinaryGraphFile()
 	//  Purpose:
-	//		Adds a new vertex from the line read in from the graph file.
+	//		Returns true if the graph file starts with the magic bytes of a
+	//		binary graph file.
+	bool isBinaryGraphFile();
+
+	// mapBinaryGraph()
+	//  Purpose:
+	//		Memory maps a binary graph file (see WDAGraphBinaryFormat.h).  The
+	//		incoming edge arrays point directly into the mapping, only the edge
+	//		label maps are built.  Throws runtime_error if the file can not
+	//		be mapped, and out_of_range if it is not a valid binary graph
+	//		file of this version (see checkBinaryGraph()).
+	//  Postconditions:
+	//		The following attirbutes will be populated:
+	//			mappedFile, mappedVertices, mappedVertexLabels, vertexCount,
+	//			startNode, endNode, edgeLabels, incomingOffsets, incomingEdges,
+	//			edgeWeights, edgeFrequencies
+	void mapBinaryGraph();
+
+	// string checkBinaryGraph(const char* base, size_t fileSize)
+	//  Purpose:
+	//		Checks that the fileSize bytes at base are a binary graph file that
+	//		can be used in place: the header is of this version and matches the
+	//		file size, every section fits in the file, the incoming edge offsets
+	//		run from 0 to edgeCount without going down, and every vertex id,
+	//		label id and label offset is in range (with the label terminated
+	//		inside the file).  Returns what is wrong, or an empty string if the
+	//		file is valid.
+	string checkBinaryGraph(const char* base, size_t fileSize);
+
+	// const char* vertexLabel(uint32_t vertex)
+	//  Purpose:
+	//		Returns the label of the vertex
+	const char* vertexLabel(uint32_t vertex);
+
+	// buildGraphInParallel()
+	//  Purpose:
+	//		Builds the graph from a text graph file with threadCount threads.
+	//		The file is mapped and cut into chunks at line breaks, the chunks
+	//		are parsed in parallel (see parseChunk()), the vertices are added
+	//		in file order, and then the edges of the chunks are resolved to
+	//		vertex ids in parallel and put in file order.  Throws
+	//		out_of_range for the first bad line in the file, with the same
+	//		rules as a single thread (an edge can only use vertices on
+	//		earlier lines).
 	//  Postconditions:
-	//		vertices - vertex added
-	//		veritceMap - vertex added
-	//		edges - entry for vertex initialized
-	void addVertex(vector<string>& tokens);
+	//		The same attributes as buildGraph() are populated, with the same
+	//		values
+	void buildGraphInParallel();
+
+	// parseChunk(const char* chars, size_t length, ParsedChunk& chunk)
+	//  Purpose:
+	//		Splits the lines of a chunk of a text graph file into its
+	//		vertices, edges and edge labels.  A bad line is recorded in
+	//		chunk.error rather than thrown, as it runs on a worker thread, and
+	//		ends the chunk.
+	void parseChunk(const char* chars, size_t length, ParsedChunk& chunk);
 
-	// addEdge(vector<string>& tokens)
+	// addVertex(const string_view* tokens, size_t tokenCount, size_t lineNumber)
 	//  Purpose:
-	//		Adds a new edge from the line read in from the graph file.
+	//		Adds a new vertex from the tokens of a line read in from the
+	//		graph file.  Throws out_of_range if the line has no label or
+	//		repeats the label of another vertex.
 	//  Postconditions:
-	//		edges - edge added to start and end vertex vectors
+	//		vertexLabels - vertex added
+	//		vertexIdSlots - vertex added
+	void addVertex(const string_view* tokens, size_t tokenCount, size_t lineNumber);
+
+	// uint32_t insertVertex(string_view label)
+	//  Purpose:
+	//		Gives the next vertex id to the label and returns it, or returns
+	//		noVertex (and adds nothing) if there already is a vertex with the
+	//		label
+	//  Postconditions:
+	//		vertexLabels - vertex added
+	//		vertexIdSlots - vertex added
+	uint32_t insertVertex(string_view label);
+
+	// uint32_t& vertexIdSlot(string_view label)
+	//  Purpose:
+	//		Returns the slot of vertexIdSlots that holds the id for label.  If
+	//		there is no vertex with the label, the slot returned is empty
+	//		(noVertex) and is where the id for the label should be stored.
+	uint32_t& vertexIdSlot(string_view label);
+
+	// uint32_t findVertex(string_view label)
+	//  Purpose:
+	//		Returns the id of the vertex with the label, or noVertex if no
+	//		vertex with the label has been added yet
+	uint32_t findVertex(string_view label);
+
+	// growVertexIdSlots()
+	//  Purpose:
+	//		Doubles the size of vertexIdSlots and rehashes the vertex ids
+	void growVertexIdSlots();
+
+	// addEdge(const string_view* tokens, size_t tokenCount, size_t lineNumber)
+	//  Purpose:
+	//		Adds a new edge from the tokens of a line read in from the
+	//		graph file.  Throws out_of_range if the line is too short or
+	//		names a vertex that has not been added yet (a vertex line has to
+	//		come before the edges that use it).
+	//  Postconditions:
+	//		fileEdges - edge added
+	//		edgeLabels, edgeLabelIds - entry added for edge (first time label encountered)
 	//		edgeWeights - entry added for edge (first time label encountered)
 	//		edgeFrequencies - entry for edge label incremented by 1
-	void addEdge(vector<string>& tokens);
+	void addEdge(const string_view* tokens, size_t tokenCount, size_t lineNumber);
+
+	// string lineError(const string& problem, size_t lineNumber)
+	//  Purpose:
+	//		Returns the error message for a bad line of the graph file
+	string lineError(const string& problem, size_t lineNumber);
+
+	// buildIncomingEdges()
+	//  Purpose:
+	//		Groups the edges read from the graph file by their end vertex.
+	//		The edges ending at a vertex keep the order they had in the file,
+	//		which is the order findHighestWeightPath() considers them in.
+	//  Postconditions:
+	//		incomingOffsets, incomingEdges - populated from fileEdges
+	//		fileEdges, vertexIdSlots and edgeLabelIds - released
+	void buildIncomingEdges();
+
+	// relaxVertex(uint32_t vertex)
+	//  Purpose:
+	//		Finds the highest weight path to the vertex over its incoming edges,
+	//		starting from the weight already in vertexWeights (0 if the trivial
+	//		path of starting at the vertex is allowed, INT_MIN if not).  If the
+	//		path is start constrained, edges from vertices that can not be
+	//		reached from the start vertex are skipped.
+	//  Preconditions:
+	//		The start vertices of the incoming edges have been relaxed
+	//  Postconditions:
+	//		vertexWeights and edgeForHWPath (unless in score only mode) will be set for the vertex
+	void relaxVertex(uint32_t vertex);
+
+	// buildOutgoingEdges()
+	//  Purpose:
+	//		Groups the edges by their start vertex, so each vertex can find the
+	//		vertices it has edges to.
+	//  Postconditions:
+	//		outgoingOffsets, outgoingVertices - populated
+	void buildOutgoingEdges();
+
+	// buildLevels()
+	//  Purpose:
+	//		Groups the vertices into topological levels with Kahn's algorithm:
+	//		level 0 holds the vertices with no incoming edges, and each later
+	//		level holds the vertices whose incoming edges all start in earlier
+	//		levels.  The vertices of a level are kept in depth order.  If the
+	//		graph has a cycle, no levels are built.
+	//  Postconditions:
+	//		levelOffsets, levelVertices - populated (levelOffsets is left with
+	//		a single entry if the graph has a cycle)
+	void buildLevels();
+
+	// findHighestWeightPathByLevel()
+	//  Purpose:
+	//		Does the same as findHighestWeightPath(), but relaxes the vertices
+	//		a topological level at a time with the vertices of each level spread
+	//		over threadCount threads.  Each vertex only reads the weights of
+	//		vertices in earlier levels, and the highest weight node is picked
+	//		in depth order afterwards, so the path found does not depend on
+	//		the number of threads.
+	//
+	//		As in findHighestWeightPath(), vertices before the start vertex
+	//		(in depth order) are not part of any path if the path is start
+	//		constrained, and vertices after the end vertex are not relaxed if
+	//		it is end constrained.
+	//  Preconditions:
+	//		buildLevels() has been run and the graph has no cycles
+	//		vertexWeights and edgeForHWPath have been initialized
+	//  Postconditions:
+	//		- vertexWeights and edgeForHWPath (unless in score only mode) will be set for the vertices
+	//		- highestWeightPath attribute will be set
+	void findHighestWeightPathByLevel();
+
+	// findHighestWeightNode(uint32_t firstVertex, uint32_t lastVertex)
+	//  Purpose:
+	//		Sets highestWeightNode from the weights of the relaxed vertices
+	//		firstVertex to lastVertex, the same way findHighestWeightPath() does:
+	//		the end vertex if the path is end constrained, otherwise the first
+	//		vertex in depth order with the highest weight.
+	//  Preconditions:
+	//		vertexWeights has been set for firstVertex to lastVertex
+	//  Postconditions:
+	//		highestWeightNode will be set
+	void findHighestWeightNode(uint32_t firstVertex, uint32_t lastVertex);
+
+	// findTopPaths()
+	//  Purpose:
+	//		Does the same as findHighestWeightPath(), but keeps the pathCount
+	//		highest weight paths to each vertex rather than only the highest
+	//		one, so the pathCount highest weight paths through the graph are
+	//		found in one pass.  The paths to a vertex are made from the trivial
+	//		path of starting at the vertex (if allowed) and, for each edge that
+	//		ends at the vertex, each of the paths kept for the edge's start
+	//		vertex plus the edge weight.
+	//
+	//		The paths of each vertex are kept highest weight first in a fixed
+	//		size slot of topWeights, topEdges and topRanks, and a path only
+	//		moves ahead of those that are strictly lower, so the highest weight
+	//		path is the one findHighestWeightPath() finds.  The paths of the
+	//		graph are those of the end vertex if the path is end constrained,
+	//		otherwise the highest of all of the vertices' paths (the first
+	//		vertex in depth order first if the weights are equal).
+	//  Postconditions:
+	//		topWeights, topEdges, topRanks, topCounts - set for the vertices
+	//		pathEnds, pathEndRanks - the highest weight paths found
+	void findTopPaths();
+
+	// bool insertTopPath(uint32_t vertex, double weight, uint32_t edge, uint32_t rank)
+	//  Purpose:
+	//		Adds a path to the paths kept for the vertex if it is one of the
+	//		pathCount highest, after any paths with the same weight.  edge is
+	//		the last edge of the path (noEdge for the trivial path) and rank is
+	//		which of the paths of the edge's start vertex it continues.  Returns
+	//		false if the path was not high enough to be kept.
+	//  Postconditions:
+	//		topWeights, topEdges, topRanks, topCounts - path added for the vertex
+	bool insertTopPath(uint32_t vertex, double weight, uint32_t edge, uint32_t rank);
 
 	// bool isStartConstrained()
 	//  Purpose:
@@ -215,33 +598,53 @@ private:
 	//		Returns true if an end vertex is designated in the graph file
 	bool isEndConstrained();
 
-	// string getEdgeWeights()
+	// writeEdgeWeights(OutputBuffer& out)
 	//  Purpose:
-	//		Returns a comma delimited string describing each of the edge labels
+	//		Writes a comma delimited string describing each of the edge labels
 	//		and its correpsonding weight.
 	//
 	//		Format:		<edge label> = <edge weight>
-	string getEdgeWeights();
+	void writeEdgeWeights(OutputBuffer& out);
 
-	// string getEdgeFrequenciess()
+	// writeEdgeFrequencies(OutputBuffer& out)
 	//  Purpose:
-	//		Returns a comma delimited string describing each of the edge labels
+	//		Writes a comma delimited string describing each of the edge labels
 	//		and its correpsonding frequency (the number of edges in the graph
 	//		that use that label).
 	//
 	//		Format:		<edge label> = <edge frequency>
-	string getEdgeFrequencies();
+	void writeEdgeFrequencies(OutputBuffer& out);
 
-	// string getPathStartNodeLabel()
+	// const char* getPathStartNodeLabel()
 	//  Purpose:
 	//		Returns the label for the start node from the highest weight path.
-	string getPathStartNodeLabel();
+	const char* getPathStartNodeLabel();
 
-	// string getPath()
+	// writePath(OutputBuffer& out)
 	//  Purpose:
-	//		Returns a string representing the edge labels for the highest weight
+	//		Writes a string representing the edge labels for the highest weight
 	//		path.  The edge labels are listed from the start to the end of the path.
-	string getPath();
+	void writePath(OutputBuffer& out);
+
+	// writeTopPaths(OutputBuffer& out)
+	//  Purpose:
+	//		Writes the results of each of the paths found by findTopPaths(),
+	//		highest weight first, in the same format as the single highest
+	//		weight path.
+	void writeTopPaths(OutputBuffer& out);
+
+	// const char* getTopPathStartNodeLabel(uint32_t vertex, uint32_t rank)
+	//  Purpose:
+	//		Returns the label for the start node of the rank'th path kept for
+	//		the vertex by findTopPaths().
+	const char* getTopPathStartNodeLabel(uint32_t vertex, uint32_t rank);
+
+	// writeTopPath(OutputBuffer& out, uint32_t vertex, uint32_t rank)
+	//  Purpose:
+	//		Writes a string representing the edge labels for the rank'th path
+	//		kept for the vertex by findTopPaths().  The edge labels are listed
+	//		from the start to the end of the path.
+	void writeTopPath(OutputBuffer& out, uint32_t vertex, uint32_t rank);
 
 };
 #endif
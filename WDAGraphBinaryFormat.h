@@ -0,0 +1,95 @@
+/*
+ * WDAGraphBinaryFormat.h
+ *
+ *	This header describes the binary graph file format that can be
+ *  memory mapped by the WDAGraph object.  It holds the same information as
+ *  the text (V / E line) format, laid out so that WDAGraph can run
+ *  findHighestWeightPath() straight from the mapped file without parsing.
+ *
+ *  All values are stored in the byte order of the machine that wrote the
+ *  file.  The file is made up of the following sections, each starting at
+ *  the offset given in the header (aligned to 8 bytes).  The edges come
+ *  first so that a writer can stream them out as they are generated.
+ *
+ *	  1. Header (WDAGraphBinaryHeader)
+ *
+ *	  2. Edges - one WDAGraphBinaryEdge per edge, grouped by end vertex
+ *		 (vertices in depth order)
+ *
+ *	  3. Incoming edge offsets - vertexCount + 1 uint32_t values.  The edges
+ *		 ending at vertex v are edges[offsets[v]] to edges[offsets[v+1] - 1]
+ *
+ *	  4. Vertex table - one WDAGraphBinaryVertex per vertex in depth order
+ *		 (parents preced children).  The vertex id used by the edges is the
+ *		 position of the vertex in this table.
+ *
+ *	  5. Vertex label pool - the null terminated vertex labels
+ *
+ *	  6. Edge label table - one WDAGraphBinaryEdgeLabel per distinct edge
+ *		 label, in the order the labels were first used
+ *
+ *	  7. Edge label pool - the null terminated edge labels
+ *
+ *  The vertex ids, edge counts and incoming edge offsets are 32 bits, so a
+ *  file holds fewer than 2^32 vertices and at most 2^32 - 1 edges.  The
+ *  label offsets are 64 bits, as the label pools of a large edit graph
+ *  pass 4 GB well before the vertex ids run out (version 2, version 1 had
+ *  32 bit label offsets).
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef WDAGRAPHBINARYFORMAT_H
+#define WDAGRAPHBINARYFORMAT_H
+
+#include <cstdint>
+
+// Magic bytes at the start of every binary graph file
+static const char wdaGraphBinaryMagic[8] = { 'W', 'D', 'A', 'G', 'B', 'I', 'N', '\0' };
+
+// Version of the format written by WDAGraphBinaryWriter
+static const uint32_t wdaGraphBinaryVersion = 2;
+
+// Vertex flags
+static const uint32_t wdaGraphStartVertex = 1;  // path is constrained to start here
+static const uint32_t wdaGraphEndVertex = 2;  // path is constrained to end here
+
+// Marks a missing start or end vertex in the header
+static const uint32_t wdaGraphNoVertex = UINT32_MAX;
+
+struct WDAGraphBinaryHeader {
+	char magic[8];  // wdaGraphBinaryMagic
+	uint32_t version;  // wdaGraphBinaryVersion
+	uint32_t vertexCount;
+	uint32_t edgeCount;
+	uint32_t edgeLabelCount;
+	uint32_t startVertex;  // id of the START vertex (or wdaGraphNoVertex)
+	uint32_t endVertex;  // id of the END vertex (or wdaGraphNoVertex)
+	uint64_t edgesOffset;
+	uint64_t incomingOffsetsOffset;
+	uint64_t vertexTableOffset;
+	uint64_t vertexLabelPoolOffset;
+	uint64_t edgeLabelTableOffset;
+	uint64_t edgeLabelPoolOffset;
+	uint64_t fileSize;
+};
+
+struct WDAGraphBinaryVertex {
+	uint64_t labelOffset;  // offset of the label in the vertex label pool
+	uint32_t flags;  // wdaGraphStartVertex and/or wdaGraphEndVertex
+	uint32_t reserved;
+};
+
+struct WDAGraphBinaryEdgeLabel {
+	uint64_t labelOffset;  // offset of the label in the edge label pool
+	double weight;  // weight of the first edge using the label
+};
+
+struct WDAGraphBinaryEdge {
+	uint32_t start;  // id of the start vertex
+	uint32_t label;  // id of the edge label
+	double weight;
+};
+
+#endif // WDAGRAPHBINARYFORMAT_H
@@ -0,0 +1,268 @@
+/*
+ * WDAGraphBinaryWriter.cpp
+ *
+ *	This is the cpp file for the WDAGraphBinaryWriter object. The
+ *  WDAGraphBinaryWriter writes a graph file in the binary format described
+ *  in WDAGraphBinaryFormat.h, which can be memory mapped by WDAGraph.
+ *
+ *  The vertices must be added in depth order (parents preced children).
+ *  The edges are added with the vertex they end at: after a vertex is added,
+ *  each of its incoming edges is added (in the order findHighestWeightPath()
+ *  should consider them).  The edges are streamed out to the file as they
+ *  are added.  The incoming edge offsets, vertex table and vertex labels
+ *  are streamed out to side files next to it (<<graphFileName>>.offsets.tmp,
+ *  .vertices.tmp and .labels.tmp), which are appended to the file and
+ *  removed when it is closed, so memory does not grow with the number of
+ *  vertices.  Only the edge labels, one per distinct label, are held in
+ *  memory.
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#include "WDAGraphBinaryWriter.h"
+#include <cstring>
+#include <cstdio>
+using namespace std;
+
+// Constuctors
+// ==============================================
+WDAGraphBinaryWriter::WDAGraphBinaryWriter(string& graphFileName)
+	: fileName(graphFileName), graphFile(graphFileName, ios::out | ios::binary | ios::trunc) {
+
+	closed = false;
+	vertexLabelPoolSize = 0;
+	if (!graphFile.is_open())
+		throw runtime_error("can not open file " + fileName);
+
+	offsetsFile.open(sideFileName("offsets"), ios::out | ios::binary | ios::trunc);
+	vertexTableFile.open(sideFileName("vertices"), ios::out | ios::binary | ios::trunc);
+	vertexLabelFile.open(sideFileName("labels"), ios::out | ios::binary | ios::trunc);
+	if (!offsetsFile.is_open() || !vertexTableFile.is_open() || !vertexLabelFile.is_open()) {
+		removeSideFiles();
+		throw runtime_error("can not open side files of file " + fileName);
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, wdaGraphBinaryMagic, sizeof(header.magic));
+	header.version = wdaGraphBinaryVersion;
+	header.startVertex = wdaGraphNoVertex;
+	header.endVertex = wdaGraphNoVertex;
+
+	// Reserve room for the header, the edges follow it
+	graphFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	checkStream();
+	header.edgesOffset = sizeof(header);
+}
+
+// Destructor
+// =============================================
+WDAGraphBinaryWriter::~WDAGraphBinaryWriter() {
+
+	// A destructor can not throw, callers that need to know the file was
+	// written call close() themselves
+	if (!closed) {
+		try {
+			close();
+		}
+		catch (const exception&) {
+		}
+	}
+
+	removeSideFiles();
+}
+
+// Public Methods
+// =============================================
+
+// uint32_t addVertex(const string& label, uint32_t flags)
+//  Purpose:
+//		Adds the next vertex in depth order, flags is a combination of
+//		wdaGraphStartVertex and wdaGraphEndVertex (or 0).  Returns the
+//		id of the vertex.  Throws runtime_error if the vertex can not be
+//		written and out_of_range if the vertex ids have run out.
+uint32_t WDAGraphBinaryWriter::addVertex(const string& label, uint32_t flags) {
+
+	// The last id marks a missing START or END vertex
+	if (header.vertexCount == wdaGraphNoVertex)
+		throw out_of_range("too many vertices for binary graph file " + fileName);
+
+	uint32_t vertex = header.vertexCount++;
+
+	// The edges of the new vertex start after all of the edges so far
+	uint32_t incomingOffset = header.edgeCount;
+	offsetsFile.write(reinterpret_cast<const char*>(&incomingOffset), sizeof(incomingOffset));
+
+	WDAGraphBinaryVertex entry;
+	entry.labelOffset = vertexLabelPoolSize;
+	entry.flags = flags;
+	entry.reserved = 0;
+	vertexTableFile.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+
+	vertexLabelFile.write(label.c_str(), label.length() + 1);
+	vertexLabelPoolSize += label.length() + 1;
+
+	if (!offsetsFile || !vertexTableFile || !vertexLabelFile)
+		throw runtime_error("can not write side files of file " + fileName);
+
+	if (flags & wdaGraphStartVertex)
+		header.startVertex = vertex;
+	if (flags & wdaGraphEndVertex)
+		header.endVertex = vertex;
+
+	return vertex;
+}
+
+// addIncomingEdge(const string& label, uint32_t startVertex, double weight)
+//  Purpose:
+//		Adds an edge from startVertex to the vertex that was added last.
+//		Throws runtime_error if the edge can not be written and
+//		out_of_range if the edge count has run out.
+void WDAGraphBinaryWriter::addIncomingEdge(const string& label, uint32_t startVertex, double weight) {
+	if (header.edgeCount == UINT32_MAX)
+		throw out_of_range("too many edges for binary graph file " + fileName);
+
+	WDAGraphBinaryEdge edge;
+	edge.start = startVertex;
+	edge.weight = weight;
+
+	// Look up the label, adding it to the label table the first time it is seen
+	unordered_map<string, uint32_t>::iterator labelIter = edgeLabelIds.find(label);
+	if (labelIter != edgeLabelIds.end())
+		edge.label = labelIter->second;
+	else {
+		edge.label = edgeLabelTable.size();
+		edgeLabelIds[label] = edge.label;
+
+		WDAGraphBinaryEdgeLabel entry;
+		entry.labelOffset = addLabel(edgeLabelPool, label);
+		entry.weight = weight;
+		edgeLabelTable.push_back(entry);
+	}
+
+	graphFile.write(reinterpret_cast<const char*>(&edge), sizeof(edge));
+	checkStream();
+	header.edgeCount++;
+}
+
+// close()
+//  Purpose:
+//		Appends the side files, writes the edge labels and header and
+//		closes the file.  Called by the destructor if it has not been
+//		called (which does not report errors).  Throws runtime_error if the
+//		file can not be written.
+void WDAGraphBinaryWriter::close() {
+	closed = true;
+
+	header.edgeLabelCount = edgeLabelTable.size();
+
+	// The offset after the edges of the last vertex ends the offsets
+	uint32_t endOffset = header.edgeCount;
+	offsetsFile.write(reinterpret_cast<const char*>(&endOffset), sizeof(endOffset));
+
+	// Write the sections that follow the edges
+	header.incomingOffsetsOffset = appendSideFile(offsetsFile, "offsets");
+	header.vertexTableOffset = appendSideFile(vertexTableFile, "vertices");
+	header.vertexLabelPoolOffset = appendSideFile(vertexLabelFile, "labels");
+	header.edgeLabelTableOffset =
+		writeSection(edgeLabelTable.data(), edgeLabelTable.size() * sizeof(WDAGraphBinaryEdgeLabel));
+	header.edgeLabelPoolOffset =
+		writeSection(edgeLabelPool.data(), edgeLabelPool.size());
+	header.fileSize = graphFile.tellp();
+
+	// Fill in the header
+	graphFile.seekp(0);
+	graphFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	checkStream();
+
+	// Closing flushes what is still buffered
+	graphFile.close();
+	checkStream();
+}
+
+// Private Methods
+// =============================================
+
+// uint64_t writeSection(const void* data, size_t size)
+//  Purpose:
+//		Pads the file to 8 bytes, writes size bytes of data and returns the
+//		offset the data was written at.
+uint64_t WDAGraphBinaryWriter::writeSection(const void* data, size_t size) {
+	static const char padding[8] = { 0 };
+
+	uint64_t offset = graphFile.tellp();
+	uint64_t paddedOffset = (offset + 7) & ~(uint64_t) 7;
+	graphFile.write(padding, paddedOffset - offset);
+	graphFile.write(static_cast<const char*>(data), size);
+
+	return paddedOffset;
+}
+
+// string sideFileName(const string& section)
+//  Purpose:
+//		Returns the name of the side file a section is streamed to
+string WDAGraphBinaryWriter::sideFileName(const string& section) {
+	return fileName + "." + section + ".tmp";
+}
+
+// uint64_t appendSideFile(ofstream& sideFile, const string& section)
+//  Purpose:
+//		Closes the side file of a section, pads the file to 8 bytes,
+//		copies the side file to it and removes the side file.  Returns
+//		the offset the section was written at.
+uint64_t WDAGraphBinaryWriter::appendSideFile(ofstream& sideFile, const string& section) {
+	string sideName = sideFileName(section);
+
+	sideFile.close();
+	if (!sideFile)
+		throw runtime_error("can not write file " + sideName);
+
+	uint64_t offset = writeSection(NULL, 0);
+
+	ifstream copyFile(sideName, ios::in | ios::binary);
+	vector<char> buffer(1 << 16);
+	while (copyFile.read(buffer.data(), buffer.size()) || copyFile.gcount() > 0)
+		graphFile.write(buffer.data(), copyFile.gcount());
+	if (!copyFile.eof())
+		throw runtime_error("can not read file " + sideName);
+	checkStream();
+
+	copyFile.close();
+	remove(sideName.c_str());
+
+	return offset;
+}
+
+// removeSideFiles()
+//  Purpose:
+//		Closes and removes any side files that are left (after an error,
+//		close() removes them as they are appended)
+void WDAGraphBinaryWriter::removeSideFiles() {
+	ofstream* sideFiles[3] = { &offsetsFile, &vertexTableFile, &vertexLabelFile };
+	const char* sections[3] = { "offsets", "vertices", "labels" };
+	for (int side = 0; side < 3; side++) {
+		if (sideFiles[side]->is_open())
+			sideFiles[side]->close();
+		remove(sideFileName(sections[side]).c_str());
+	}
+}
+
+// uint64_t addLabel(vector<char>& pool, const string& label)
+//  Purpose:
+//		Appends a null terminated label to a label pool and returns the
+//		offset of the label in the pool.
+uint64_t WDAGraphBinaryWriter::addLabel(vector<char>& pool, const string& label) {
+	uint64_t offset = pool.size();
+	pool.insert(pool.end(), label.begin(), label.end());
+	pool.push_back('\0');
+
+	return offset;
+}
+
+// checkStream()
+//  Purpose:
+//		Throws runtime_error if a write to the file has failed
+void WDAGraphBinaryWriter::checkStream() {
+	if (!graphFile)
+		throw runtime_error("can not write file " + fileName);
+}
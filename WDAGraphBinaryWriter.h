@@ -0,0 +1,143 @@
+/*
+ * WDAGraphBinaryWriter.h
+ *
+ *	This is the header file for the WDAGraphBinaryWriter object. The
+ *  WDAGraphBinaryWriter writes a graph file in the binary format described
+ *  in WDAGraphBinaryFormat.h, which can be memory mapped by WDAGraph.
+ *
+ *  The vertices must be added in depth order (parents preced children).
+ *  The edges are added with the vertex they end at: after a vertex is added,
+ *  each of its incoming edges is added (in the order findHighestWeightPath()
+ *  should consider them).  The edges are streamed out to the file as they
+ *  are added.  The incoming edge offsets, vertex table and vertex labels
+ *  are streamed out to side files next to it (<<graphFileName>>.offsets.tmp,
+ *  .vertices.tmp and .labels.tmp), which are appended to the file and
+ *  removed when it is closed, so memory does not grow with the number of
+ *  vertices.  Only the edge labels, one per distinct label, are held in
+ *  memory.
+ *
+ *  Throws runtime_error if the file can not be opened or written, and
+ *  out_of_range if the graph has more vertices or edges than the format
+ *  can hold.  The
+ *  destructor closes the file without reporting errors, so close() should
+ *  be called to find out that all of the file was written.
+ *
+ *  Typical Use:
+ *		WDAGraphBinaryWriter writer(graphFileName);
+ *		writer.addVertex("0", wdaGraphStartVertex);
+ *		writer.addVertex("1", 0);
+ *		writer.addIncomingEdge("A", 0, 1.5);
+ *		...
+ *		writer.close();
+ *
+ *  Created on: 10-14-26
+ *      Author: tomkolar
+ */
+
+#ifndef WDAGRAPHBINARYWRITER_H
+#define WDAGRAPHBINARYWRITER_H
+
+#include "WDAGraphBinaryFormat.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+#include <cstdint>
+#include <stdexcept>
+using namespace std;
+
+class WDAGraphBinaryWriter
+{
+public:
+
+	// Constuctors
+	// ==============================================
+	WDAGraphBinaryWriter(string& graphFileName);
+
+	// Destructor
+	// =============================================
+	virtual ~WDAGraphBinaryWriter();
+
+	// Public Methods
+	// =============================================
+
+	// uint32_t addVertex(const string& label, uint32_t flags)
+	//  Purpose:
+	//		Adds the next vertex in depth order, flags is a combination of
+	//		wdaGraphStartVertex and wdaGraphEndVertex (or 0).  Returns the
+	//		id of the vertex.  Throws runtime_error if the vertex can not be
+	//		written and out_of_range if the vertex ids have run out.
+	uint32_t addVertex(const string& label, uint32_t flags);
+
+	// addIncomingEdge(const string& label, uint32_t startVertex, double weight)
+	//  Purpose:
+	//		Adds an edge from startVertex to the vertex that was added last.
+	//		Throws runtime_error if the edge can not be written and
+	//		out_of_range if the edge count has run out.
+	void addIncomingEdge(const string& label, uint32_t startVertex, double weight);
+
+	// close()
+	//  Purpose:
+	//		Appends the side files, writes the edge labels and header and
+	//		closes the file.
+	//		Called by the destructor if it has not been called (which does
+	//		not report errors).  Throws runtime_error if the file can not be
+	//		written.
+	void close();
+
+private:
+
+	// Attributes
+	// =============================================
+	string fileName;
+	ofstream graphFile;
+	bool closed;
+	WDAGraphBinaryHeader header;
+	ofstream offsetsFile;  // incoming edge offsets of the vertices added
+	ofstream vertexTableFile;  // vertex table entries of the vertices added
+	ofstream vertexLabelFile;  // vertex label pool
+	uint64_t vertexLabelPoolSize;
+	vector<WDAGraphBinaryEdgeLabel> edgeLabelTable;
+	vector<char> edgeLabelPool;
+	unordered_map<string, uint32_t> edgeLabelIds;
+
+	// Private Methods
+	// =============================================
+
+	// uint64_t writeSection(const void* data, size_t size)
+	//  Purpose:
+	//		Pads the file to 8 bytes, writes size bytes of data and returns the
+	//		offset the data was written at.
+	uint64_t writeSection(const void* data, size_t size);
+
+	// string sideFileName(const string& section)
+	//  Purpose:
+	//		Returns the name of the side file a section is streamed to
+	string sideFileName(const string& section);
+
+	// uint64_t appendSideFile(ofstream& sideFile, const string& section)
+	//  Purpose:
+	//		Closes the side file of a section, pads the file to 8 bytes,
+	//		copies the side file to it and removes the side file.  Returns
+	//		the offset the section was written at.
+	uint64_t appendSideFile(ofstream& sideFile, const string& section);
+
+	// removeSideFiles()
+	//  Purpose:
+	//		Closes and removes any side files that are left (after an error,
+	//		close() removes them as they are appended)
+	void removeSideFiles();
+
+	// uint64_t addLabel(vector<char>& pool, const string& label)
+	//  Purpose:
+	//		Appends a null terminated label to a label pool and returns the
+	//		offset of the label in the pool.
+	uint64_t addLabel(vector<char>& pool, const string& label);
+
+	// checkStream()
+	//  Purpose:
+	//		Throws runtime_error if a write to the file has failed
+	void checkStream();
+};
+
+#endif // WDAGRAPHBINARYWRITER_H
@@ -12,13 +12,19 @@
  *
  *  Typical Use:
  *		buildGraphFile(fast1, fasta2, fasta3, graphFileName)
+ *		 - builds the graph file in the text (V / E line) format
  *
- *  Created on: 1-29-13
+ *		buildBinaryGraphFile(fast1, fasta2, fasta3, graphFileName)
+ *		 - builds the graph file in the binary format (see WDAGraphBinaryFormat.h)
+ * *  Created on: 1-29-13
  *      Author: tomkolar
  */
 
 #include "WDAGraphFileBuilder.h"
-#include "Blosum62.h"
+#include "ScoringMatrix.h"
+#include "WDAGraphBinaryWriter.h"
+#include "BufferedFileWriter.h"
+#include "Instrumentation.h"
 #include <sstream>
 #include <iostream>
 #include <fstream>
@@ -27,6 +33,7 @@
 // ==============================================
 WDAGraphFileBuilder::WDAGraphFileBuilder() {
 	gapChar = '-';
+	matrix = &ScoringMatrix::blosum62();
 }
 
 // Destructor
@@ -44,7 +51,7 @@ WDAGraphFileBuilder::~WDAGraphFileBuilder() {
 //		position of the sequence in fasta1, j - fasta2, and k - fasta3.  Edges
 //		are labeled with the appropriate residue (or gap char) for the starting
 //		position.  Edge weights are the sum of pairs for the 3 residues/gaps using
-//		the Blosum62 scoring matrix.
+//		the scoring matrix (BLOSUM62 unless setScoringMatrix() is called).
 //
 //		Further details on graph construction:
 //			0 <= i <= n1, 0 <= j <= n2, and 0 <= k <= n3
@@ -60,7 +67,9 @@ WDAGraphFileBuilder::~WDAGraphFileBuilder() {
 //			in the first sequence and C is the 6th residue in the third sequence.
 //
 //		The file will be created such that all verticies are listed first
-//		followed by all edges.
+//		followed by all edges.  The file is streamed out through a fixed
+//		size buffer (vertices in a first pass over the lattice and edges
+//		in a second), so memory use does not depend on the sequence lengths.
 //
 //		Vertex format: 
 //
@@ -76,10 +85,12 @@ WDAGraphFileBuilder::~WDAGraphFileBuilder() {
 //		File named aGraphFileName will be populated with the edit graph 
 //		associated with the sequences from the fasta files.
 void WDAGraphFileBuilder::buildGraphFile(FastaFile*  fasta1, FastaFile* fasta2, FastaFile*  fasta3, string& graphFileName) {
+	INSTRUMENT_TIMER(graphFileBuild);
 
-	// Create the vertices and edges
-	stringstream vertices;
-	stringstream edges;
+	// The graph is streamed out to the file, vertices in a first pass over
+	// the lattice and edges in a second pass, so memory stays constant no
+	// matter the sequence lengths
+	BufferedFileWriter graphFile(graphFileName);
 
 	string& seq1 = fasta1->getSequence();
 	string& seq2 = fasta2->getSequence();
@@ -89,122 +100,218 @@ void WDAGraphFileBuilder::buildGraphFile(FastaFile*  fasta1, FastaFile* fasta2,
 	int seq2Length = fasta2->getSequenceLength();
 	int seq3Length = fasta3->getSequenceLength();
 
+	// Write the vertices
 	for (int seq1Loc = 0; seq1Loc <= seq1Length; seq1Loc++) {
-		char residue1;
-		if (seq1Loc < seq1Length)
-			residue1 = seq1.at(seq1Loc);
 		for (int seq2Loc = 0; seq2Loc <= seq2Length; seq2Loc++) {
-			char residue2;
-			if (seq2Loc < seq2Length)
-				residue2 = seq2.at(seq2Loc);
 			for (int seq3Loc = 0; seq3Loc <= seq3Length; seq3Loc++) {
-				char residue3;
-				if (seq3Loc < seq3Length)
-					residue3 = seq3.at(seq3Loc);
 
-				// Add vertex info to vertices stream
-				vertices << "V " << seq1Loc << "," << seq2Loc << "," << seq3Loc;
+				// Add vertex info to the file
+				graphFile.write("V ");
+				graphFile.write(seq1Loc);
+				graphFile.write(',');
+				graphFile.write(seq2Loc);
+				graphFile.write(',');
+				graphFile.write(seq3Loc);
 
 /*				// Insert start or end if needed
 				if (seq1Loc == 0 && seq2Loc == 0 && seq3Loc == 0)
-					vertices << " START";
+					graphFile.write(" START");
 
 				if (seq1Loc == seq1Length && seq2Loc == seq2Length && seq3Loc == seq3Length)
-					vertices << " END";
+					graphFile.write(" END");
 */				
 				// Add new line char for vertex
-				vertices << "\n";
+				graphFile.write('\n');
 
+			} // seq3Loc - fasta3
+		} // seq2Loc - fasta2
+	} // seq1Loc - fasta1
 
-				// Add edge info to edges stream
+	// Write the edges
+	for (int seq1Loc = 0; seq1Loc <= seq1Length; seq1Loc++) {
+		char residue1 = gapChar;
+		if (seq1Loc < seq1Length)
+			residue1 = seq1.at(seq1Loc);
+		for (int seq2Loc = 0; seq2Loc <= seq2Length; seq2Loc++) {
+			char residue2 = gapChar;
+			if (seq2Loc < seq2Length)
+				residue2 = seq2.at(seq2Loc);
+			for (int seq3Loc = 0; seq3Loc <= seq3Length; seq3Loc++) {
+				char residue3 = gapChar;
+				if (seq3Loc < seq3Length)
+					residue3 = seq3.at(seq3Loc);
+				// Add edge info to the file
 				// If not at end of any of the sequences then add all edges
 				if (seq1Loc < seq1Length && seq2Loc < seq2Length && seq3Loc < seq3Length) {
 
 					// Edges for single residue change
-					addEdge(edges, residue1, gapChar, gapChar, seq1Loc, seq2Loc, seq3Loc);
-					addEdge(edges, gapChar, residue2, gapChar, seq1Loc, seq2Loc, seq3Loc);
-					addEdge(edges, gapChar, gapChar, residue3, seq1Loc, seq2Loc, seq3Loc);
+					addEdge(graphFile, residue1, gapChar, gapChar, seq1Loc, seq2Loc, seq3Loc);
+					addEdge(graphFile, gapChar, residue2, gapChar, seq1Loc, seq2Loc, seq3Loc);
+					addEdge(graphFile, gapChar, gapChar, residue3, seq1Loc, seq2Loc, seq3Loc);
 
 					// Edges for two resiedue change
-					addEdge(edges, residue1, residue2, gapChar, seq1Loc, seq2Loc, seq3Loc);
-					addEdge(edges, gapChar, residue2, residue3, seq1Loc, seq2Loc, seq3Loc);
-					addEdge(edges, residue1, gapChar, residue3, seq1Loc, seq2Loc, seq3Loc);
+					addEdge(graphFile, residue1, residue2, gapChar, seq1Loc, seq2Loc, seq3Loc);
+					addEdge(graphFile, gapChar, residue2, residue3, seq1Loc, seq2Loc, seq3Loc);
+					addEdge(graphFile, residue1, gapChar, residue3, seq1Loc, seq2Loc, seq3Loc);
 
 					// Edges for three residue change
-					addEdge(edges, residue1, residue2, residue3, seq1Loc, seq2Loc, seq3Loc);
+					addEdge(graphFile, residue1, residue2, residue3, seq1Loc, seq2Loc, seq3Loc);
 				}
 				// End of first sequence
 				else if (seq1Loc == seq1Length) {
 					if (seq2Loc < seq2Length)
-						addEdge(edges, gapChar, residue2, gapChar, seq1Loc, seq2Loc, seq3Loc);
+						addEdge(graphFile, gapChar, residue2, gapChar, seq1Loc, seq2Loc, seq3Loc);
 					if (seq3Loc < seq3Length)
-						addEdge(edges, gapChar, gapChar, residue3, seq1Loc, seq2Loc, seq3Loc);
+						addEdge(graphFile, gapChar, gapChar, residue3, seq1Loc, seq2Loc, seq3Loc);
 					if (seq2Loc < seq2Length && seq3Loc < seq3Length)
-						addEdge(edges, gapChar, residue2, residue3, seq1Loc, seq2Loc, seq3Loc);
+						addEdge(graphFile, gapChar, residue2, residue3, seq1Loc, seq2Loc, seq3Loc);
 				}
 				// End of second sequence
 				else if (seq2Loc == seq2Length) {
 					if (seq1Loc < seq1Length)
-						addEdge(edges, residue1, gapChar, gapChar, seq1Loc, seq2Loc, seq3Loc);
+						addEdge(graphFile, residue1, gapChar, gapChar, seq1Loc, seq2Loc, seq3Loc);
 					if (seq3Loc < seq3Length)
-						addEdge(edges, gapChar, gapChar, residue3, seq1Loc, seq2Loc, seq3Loc);
+						addEdge(graphFile, gapChar, gapChar, residue3, seq1Loc, seq2Loc, seq3Loc);
 					if (seq1Loc < seq1Length && seq3Loc < seq3Length)
-						addEdge(edges, residue1, gapChar, residue3, seq1Loc, seq2Loc, seq3Loc);
+						addEdge(graphFile, residue1, gapChar, residue3, seq1Loc, seq2Loc, seq3Loc);
 				}
 				// End of third sequence
 				else if (seq3Loc == seq3Length) {
 					if (seq1Loc < seq1Length)
-						addEdge(edges, residue1, gapChar, gapChar, seq1Loc, seq2Loc, seq3Loc);
+						addEdge(graphFile, residue1, gapChar, gapChar, seq1Loc, seq2Loc, seq3Loc);
 					if (seq2Loc < seq2Length)
-						addEdge(edges, gapChar, residue2, gapChar, seq1Loc, seq2Loc, seq3Loc);
+						addEdge(graphFile, gapChar, residue2, gapChar, seq1Loc, seq2Loc, seq3Loc);
 					if (seq1Loc < seq1Length && seq2Loc < seq2Length)
-						addEdge(edges, residue1, residue2, gapChar, seq1Loc, seq2Loc, seq3Loc);
+						addEdge(graphFile, residue1, residue2, gapChar, seq1Loc, seq2Loc, seq3Loc);
 				}
 
 			} // seq3Loc - fasta3
 		} // seq2Loc - fasta2
 	} // seq1Loc - fasta1
 
-	// Write vertices and edges to file
-	ofstream graphFile(graphFileName);
-	graphFile << vertices.rdbuf();
-	graphFile << edges.rdbuf();
-
 	graphFile.close();
+	INSTRUMENT_COUNT(bytesWritten, graphFile.getBytesWritten());
+}
+
+// buildBinaryGraphFile(FastaFile*  fasta1, FastaFile* fasta2, FastaFile*  fasta3, string& graphFileName)
+//  Purpose: 
+//		Builds a binary graph file (see WDAGraphBinaryFormat.h) for the same
+//		edit graph that buildGraphFile() builds.  The vertices are in the
+//		same order, and the edges ending at each vertex are listed in the
+//		order of their start vertex, which is the order WDAGraph reads them
+//		from the text graph file.
+//
+//  Preconditions:
+//		Fasta Files have been read and sequence has been populated
+//  Postconditions:
+//		File named aGraphFileName will be populated with the edit graph 
+//		associated with the sequences from the fasta files.
+void WDAGraphFileBuilder::buildBinaryGraphFile(FastaFile*  fasta1, FastaFile* fasta2, FastaFile*  fasta3, string& graphFileName) {
+
+	WDAGraphBinaryWriter writer(graphFileName);
+
+	string& seq1 = fasta1->getSequence();
+	string& seq2 = fasta2->getSequence();
+	string& seq3 = fasta3->getSequence();
+
+	int seq1Length = fasta1->getSequenceLength();
+	int seq2Length = fasta2->getSequenceLength();
+	int seq3Length = fasta3->getSequenceLength();
+
+	// Vertex ids are assigned in the order the vertices are added
+	uint32_t seq3Step = 1;
+	uint32_t seq2Step = seq3Length + 1;
+	uint32_t seq1Step = seq2Step * (seq2Length + 1);
+
+	string label(3, gapChar);
+	for (int seq1Loc = 0; seq1Loc <= seq1Length; seq1Loc++) {
+		for (int seq2Loc = 0; seq2Loc <= seq2Length; seq2Loc++) {
+			for (int seq3Loc = 0; seq3Loc <= seq3Length; seq3Loc++) {
+
+				uint32_t vertex = writer.addVertex(
+					to_string(seq1Loc) + "," + to_string(seq2Loc) + "," + to_string(seq3Loc), 0);
+
+				// Incoming edges, in the order of their start vertex.  Each bit
+				// of the move is set if the sequence advances on the edge
+				// (4 = fasta1, 2 = fasta2, 1 = fasta3).
+				for (int move = 7; move >= 1; move--) {
+					if ((move & 4) && seq1Loc == 0)
+						continue;
+					if ((move & 2) && seq2Loc == 0)
+						continue;
+					if ((move & 1) && seq3Loc == 0)
+						continue;
+
+					label[0] = (move & 4) ? seq1.at(seq1Loc - 1) : gapChar;
+					label[1] = (move & 2) ? seq2.at(seq2Loc - 1) : gapChar;
+					label[2] = (move & 1) ? seq3.at(seq3Loc - 1) : gapChar;
+
+					uint32_t startVertex = vertex
+						- ((move & 4) ? seq1Step : 0)
+						- ((move & 2) ? seq2Step : 0)
+						- ((move & 1) ? seq3Step : 0);
+
+					writer.addIncomingEdge(label, startVertex,
+						matrix->sumOfPairsWeight(label[0], label[1], label[2]));
+				}
+
+			} // seq3Loc - fasta3
+		} // seq2Loc - fasta2
+	} // seq1Loc - fasta1
+
+	writer.close();
+}
+
+// Public Accessors
+// =============================================
+void WDAGraphFileBuilder::setScoringMatrix(const ScoringMatrix* aMatrix) {
+	matrix = (aMatrix != NULL) ? aMatrix : &ScoringMatrix::blosum62();
 }
 
 // Private Methods
 // =============================================
 
-// addEdge(stringstream& edges, char residue1, char residue2, char residu3)
+// addEdge(BufferedFileWriter& graphFile, char residue1, char residue2, char residu3)
 //          int residue1StartLoc, int residue2StartLoc, int residue3StartLoc)
 //  Purpose: 
-//	  Add an edge to the edges string stream.
+//	  Add an edge to the graph file.
 //
 //	  Format:
 //
 //			E <fasta1Residue/gap fasta2Residue/gap fasta3Residue/gap> <start vertex id> <end vertex id> <weight>
 //
 //  Postconditions:
-//		edges string stream will have the edge information for the residues appended
-void WDAGraphFileBuilder::addEdge(stringstream& edges, char residue1, char residue2, char residue3,
+//		graph file will have the edge information for the residues appended
+void WDAGraphFileBuilder::addEdge(BufferedFileWriter& graphFile, char residue1, char residue2, char residue3,
 			 int residue1StartLoc, int residue2StartLoc, int residue3StartLoc) {
 
 		// Edge Identifier
-		edges << "E ";
+		graphFile.write("E ");
 
 		// Label
-		edges << residue1 << residue2 << residue3 << " ";
+		graphFile.write(residue1);
+		graphFile.write(residue2);
+		graphFile.write(residue3);
+		graphFile.write(' ');
 
 		// Starting Vertex
-		edges << residue1StartLoc << "," << residue2StartLoc << "," << residue3StartLoc << " ";
+		graphFile.write(residue1StartLoc);
+		graphFile.write(',');
+		graphFile.write(residue2StartLoc);
+		graphFile.write(',');
+		graphFile.write(residue3StartLoc);
+		graphFile.write(' ');
 
 		// Ending Vertex  -- Add 1 to start location if there is an actual residue
-		edges << ((residue1==gapChar)?residue1StartLoc:residue1StartLoc+1) << ",";
-		edges << ((residue2==gapChar)?residue2StartLoc:residue2StartLoc+1) << ",";
-		edges << ((residue3==gapChar)?residue3StartLoc:residue3StartLoc+1) << " ";
+		graphFile.write((residue1==gapChar)?residue1StartLoc:residue1StartLoc+1);
+		graphFile.write(',');
+		graphFile.write((residue2==gapChar)?residue2StartLoc:residue2StartLoc+1);
+		graphFile.write(',');
+		graphFile.write((residue3==gapChar)?residue3StartLoc:residue3StartLoc+1);
+		graphFile.write(' ');
 
 		// Weight
-		edges << Blosum62::sumOfPairsWeight(residue1, residue2, residue3) << "\n";
+		graphFile.write(matrix->sumOfPairsWeight(residue1, residue2, residue3));
+		graphFile.write('\n');
 
 }
@@ -12,8 +12,11 @@
  *
  *  Typical Use:
  *		buildGraphFile(fast1, fasta2, fasta3, graphFileName)
+ *		 - builds the graph file in the text (V / E line) format
  *
- *
+ *		buildBinaryGraphFile(fast1, fasta2, fasta3, graphFileName)
+ *		 - builds the graph file in the binary format (see WDAGraphBinaryFormat.h)
+ * *
  *  Created on: 1-29-13
  *      Author: tomkolar
  */
@@ -22,6 +25,8 @@
 #define WDAGRAPHFILEBUILDER_H
 
 #include "FastaFile.h"
+#include "BufferedFileWriter.h"
+#include "ScoringMatrix.h"
 #include <string>
 #include <vector>
 using namespace std;
@@ -48,7 +53,7 @@ public:
 	//		position of the sequence in fasta1, j - fasta2, and k - fasta3.  Edges
 	//		are labeled with the appropriate residue (or gap char) for the starting
 	//		position.  Edge weights are the sum of pairs for the 3 residues/gaps using
-	//		the Blosum62 scoring matrix.
+	//		the scoring matrix (BLOSUM62 unless setScoringMatrix() is called).
 	//
 	//		Further details on graph construction:
 	//			0 <= i <= n1, 0 <= j <= n2, and 0 <= k <= n3
@@ -64,7 +69,9 @@ public:
 	//			in the first sequence and C is the 6th residue in the third sequence.
 	//
 	//		The file will be created such that all verticies are listed first
-	//		followed by all edges.
+	//		followed by all edges.  The file is streamed out through a fixed
+	//		size buffer (vertices in a first pass over the lattice and edges
+	//		in a second), so memory use does not depend on the sequence lengths.
 	//
 	//		Vertex format: 
 	//
@@ -81,27 +88,47 @@ public:
 	//		associated with the sequences from the fasta files.
 	void buildGraphFile(FastaFile*  fasta1, FastaFile* fasta2, FastaFile*  fasta3, string& graphFileName);
 
+	// buildBinaryGraphFile(FastaFile*  fasta1, FastaFile* fasta2, FastaFile*  fasta3, string& graphFileName)
+	//  Purpose: 
+	//		Builds a binary graph file (see WDAGraphBinaryFormat.h) for the same
+	//		edit graph that buildGraphFile() builds.  The vertices are in the
+	//		same order, and the edges ending at each vertex are listed in the
+	//		order of their start vertex, which is the order WDAGraph reads them
+	//		from the text graph file.
+	//
+	//  Preconditions:
+	//		Fasta Files have been read and sequence has been populated
+	//  Postconditions:
+	//		File named aGraphFileName will be populated with the edit graph 
+	//		associated with the sequences from the fasta files.
+	void buildBinaryGraphFile(FastaFile*  fasta1, FastaFile* fasta2, FastaFile*  fasta3, string& graphFileName);
+
+	// Public Accessors
+	// =============================================
+	void setScoringMatrix(const ScoringMatrix* aMatrix);  // matrix for the edge weights (NULL = BLOSUM62)
+
 private:
 
 	// Attributes
 	// =============================================
 	char gapChar;
+	const ScoringMatrix* matrix;  // scores for the edge weights
 
 	// Private Methods
 	// =============================================
 
-	// addEdge(stringstream& edges, char residue1, char residue2, char residu3)
+	// addEdge(BufferedFileWriter& graphFile, char residue1, char residue2, char residu3)
 	//          int residue1StartLoc, int residue2StartLoc, int residue3StartLoc)
 	//  Purpose: 
-	//	  Add an edge to the edges string stream.
+	//	  Add an edge to the graph file.
 	//
 	//	  Format:
 	//
 	//			E <fasta1Residue/gap fasta2Residue/gap fasta3Residue/gap> <start vertex id> <end vertex id> <weight>
 	//
 	//  Postconditions:
-	//		edges string stream will have the edge information for the residues appended
-	void addEdge(stringstream& edges, char residue1, char residue2, char residu3,
+	//		graph file will have the edge information for the residues appended
+	void addEdge(BufferedFileWriter& graphFile, char residue1, char residue2, char residu3,
 		int residue1StartLoc, int residue2StartLoc, int residue3StartLoc);
 };
 
@@ -4,8 +4,63 @@
  *	This is the driver file for creating an alignment for 3 fasta
  *  files using a weighted directed acyclic edit graph.
  *
+ *  By default the alignment is found with the ThreeWayAligner, which runs
+ *  the dynamic program directly over the edit graph without a graph file.
+ *  The -graphFile option writes the edit graph to a graph file with the
+ *  WDAGraphFileBuilder and reads it back in with WDAGraph instead, and the
+ *  -binaryGraphFile option does the same with a binary graph file.  The
+ *  -linearSpace option has the ThreeWayAligner keep only a few planes of
+ *  the score tensor in memory.  The -threads option sets the number of
+ *  threads used to fill the score tensor or to read and relax the graph
+ *  (default 1, 0 = one per hardware thread).  The -band and -xdrop options turn on the
+ *  ThreeWayAligner's banded and X-drop modes (-linearSpace, -band,
+ *  -xdrop and -cache can not be used with the graph files, and only one of the two
+ *  graph files can be asked for).  The -scoreOnly option finds
+ *  only the score and end vertex of the path, without keeping what is
+ *  needed to recover the path.  With -graphFile or -binaryGraphFile, the
+ *  -paths option reports the k highest weight paths through the graph
+ *  rather than only the highest one.  The -affine option aligns with the
+ *  AffineGapAligner instead, with affine gap costs (gap open and gap
+ *  extend) in place of the linear gap cost (only -matrix, -packed and
+ *  -stats can be used with it).  The -matrix option scores
+ *  the residues with a built-in matrix (BLOSUM62, BLOSUM45, PAM250 or NUC)
+ *  or a matrix file in the NCBI format in place of BLOSUM62.  The -cache
+ *  option keeps the ThreeWayAligner's results in a ResultCache directory,
+ *  so triples with the same sequences and options are not aligned again
+ *  (also for -batch and -batchFasta).  The -packed option keeps only the
+ *  packed residue codes of the sequences (see FastaFile::packSequence()),
+ *  a quarter of the memory of the chars for DNA (also for -batch and
+ *  -batchFasta).  The -stats
+ *  option prints the Instrumentation counters and timers as JSON at the
+ *  end (they are only kept if built with -DWDA_INSTRUMENTATION).
+ *
+ *  The -batch option aligns every triple of fasta files listed in a
+ *  manifest file, and the -batchFasta option aligns every combination of
+ *  three records of a multi-record fasta file.  The triples are aligned
+ *  with the BatchAligner by -threads workers, and only the result strings
+ *  are printed (in the order of the triples).  The fasta files are read
+ *  ahead of the workers by -loadThreads threads (default 1), with at most
+ *  -inFlight triples between being read and being printed.
+ *
+ *  The -progressive option builds a multiple alignment of all of the
+ *  records of a multi-record fasta file with the ProgressiveAligner.  The
+ *  -allVsAll option writes the global alignment distances (or, with
+ *  -scores, the scores) of every pair of records of a multi-record fasta
+ *  file to a binary distance matrix file with the AllVsAllAligner.
+ *
+ *  The -benchmark option times each stage of the pipeline with the
+ *  Benchmark on random triples of the -lengths given (default 20,40,80)
+ *  and on the regression triples of a -manifest file, and writes the
+ *  times as CSV (to cout, or to the -out file).
+ *
  *	Typical use:
- *		align fastaFile1 fastaFile2 fastaFile3
+ *		align fastaFile1 fastaFile2 fastaFile3 [-graphFile | -binaryGraphFile | -linearSpace] [-threads n] [-band width (no graph file)] [-xdrop x (no graph file)] [-scoreOnly] [-paths k (graph files only)] [-matrix name] [-cache directory (no graph file)] [-packed] [-stats]
+ *		align fastaFile1 fastaFile2 fastaFile3 -affine gapOpen gapExtend [-matrix name] [-packed] [-stats] (no other options)
+ *		align -batch manifestFile [-linearSpace] [-threads n] [-band width] [-xdrop x] [-scoreOnly] [-matrix name] [-cache directory] [-loadThreads n] [-inFlight n] [-packed]
+ *		align -batchFasta fastaFile [-linearSpace] [-threads n] [-band width] [-xdrop x] [-scoreOnly] [-matrix name] [-cache directory] [-loadThreads n] [-inFlight n] [-packed]
+ *		align -progressive fastaFile [-threads n] [-matrix name]
+ *		align -allVsAll fastaFile matrixFile [-threads n] [-matrix name] [-scores]
+ *		align -benchmark [-lengths n,n,...] [-manifest manifestFile] [-repeat n] [-threads n] [-out csvFile]
  *
  *  Created on: 1-29-13
  *      Author: tomkolar
@@ -13,20 +68,468 @@
 #include "FastaFile.h"
 #include "WDAGraph.h"
 #include "WDAGraphFileBuilder.h"
+#include "ThreeWayAligner.h"
+#include "AffineGapAligner.h"
+#include "ThreadPool.h"
+#include "BatchAligner.h"
+#include "ProgressiveAligner.h"
+#include "AllVsAllAligner.h"
+#include "Benchmark.h"
+#include "StringUtilities.h"
+#include "ScoringMatrix.h"
+#include "Blosum62.h"
+#include "Instrumentation.h"
+#include "OutputBuffer.h"
+#include "ResultCache.h"
 #include <string>
 #include <sstream>
+#include <fstream>
 #include <iostream>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <unistd.h>
 using namespace std;
 
+// const ScoringMatrix* loadScoringMatrix(const string& nameOrFile, unique_ptr<ScoringMatrix>& loaded)
+//  Purpose:
+//		Returns the built-in matrix with the name, or reads the matrix from
+//		the file with the name (kept in loaded).  Returns NULL and prints the
+//		error if the file can not be read.
+const ScoringMatrix* loadScoringMatrix(const string& nameOrFile, unique_ptr<ScoringMatrix>& loaded) {
+	const ScoringMatrix* matrix = ScoringMatrix::builtIn(nameOrFile);
+	if (matrix != NULL)
+		return matrix;
+
+	try {
+		loaded.reset(new ScoringMatrix(nameOrFile, Blosum62::gapCost()));
+	}
+	catch (const exception& e) {
+		cout << "Invalid matrix " << nameOrFile << ": " << e.what() << "\n";
+		return NULL;
+	}
+
+	return loaded.get();
+}
+
+// printStats()
+//  Purpose:
+//		Prints the Instrumentation counters and timers as JSON
+void printStats() {
+	if (!Instrumentation::isEnabled()) {
+		cout << "No stats: built without -DWDA_INSTRUMENTATION\n";
+		return;
+	}
+
+	cout << Instrumentation::jsonString();
+}
+
+// writeResult(Aligner& aligner)
+//  Purpose:
+//		Writes the result string of a ThreeWayAligner, AffineGapAligner or
+//		WDAGraph straight to stdout, after anything already sent to cout.
+//		Returns false (and reports the error on stderr) if stdout can not
+//		be written.
+template <class Aligner>
+bool writeResult(Aligner& aligner) {
+	cout.flush();
+
+	OutputBuffer out(STDOUT_FILENO);
+	aligner.writeResult(out);
+	try {
+		out.flush();
+	}
+	catch (const exception& e) {
+		cerr << e.what() << "\n";
+		return false;
+	}
+
+	return true;
+}
+
+// bool writeText(const string& text)
+//  Purpose:
+//		Writes a result string that is already built (the -progressive and
+//		-allVsAll results) straight to stdout, after anything already sent
+//		to cout.  Returns false (and reports the error on stderr) if stdout
+//		can not be written.
+bool writeText(const string& text) {
+	cout.flush();
+
+	OutputBuffer out(STDOUT_FILENO);
+	out.write(text);
+	try {
+		out.flush();
+	}
+	catch (const exception& e) {
+		cerr << e.what() << "\n";
+		return false;
+	}
+
+	return true;
+}
+
+// bool invalidCombination(bool given, const string& option, const string& reason)
+//  Purpose:
+//		Prints that the option can not be used and why if it was given.
+//		Returns whether it was given.
+bool invalidCombination(bool given, const string& option, const string& reason) {
+	if (given)
+		cout << "Invalid option " << option << ": " << reason << "\n";
+
+	return given;
+}
+
+// batchMain(int argc, char *argv[])
+//  Purpose:
+//		Runs the -batch and -batchFasta modes
+int batchMain(int argc, char *argv[]) {
+
+	// Check for options
+	bool useLinearSpace = false;
+	bool useScoreOnly = false;
+	int threadCount = 1;
+	int bandWidth = 0;
+	int xDrop = 0;
+	int loadThreadCount = 1;
+	int inFlightCount = 0;
+	bool usePacked = false;
+	const ScoringMatrix* matrix = NULL;
+	unique_ptr<ScoringMatrix> loadedMatrix;
+	unique_ptr<ResultCache> cache;
+	for (int i = 3; i < argc; i++) {
+		string option = argv[i];
+		if (option == "-linearSpace")
+			useLinearSpace = true;
+		else if (option == "-scoreOnly")
+			useScoreOnly = true;
+		else if (option == "-threads" && i + 1 < argc)
+			threadCount = atoi(argv[++i]);
+		else if (option == "-band" && i + 1 < argc)
+			bandWidth = atoi(argv[++i]);
+		else if (option == "-xdrop" && i + 1 < argc)
+			xDrop = atoi(argv[++i]);
+		else if (option == "-matrix" && i + 1 < argc) {
+			matrix = loadScoringMatrix(argv[++i], loadedMatrix);
+			if (matrix == NULL)
+				return -1;
+		}
+		else if (option == "-cache" && i + 1 < argc)
+			cache.reset(new ResultCache(argv[++i]));
+		else if (option == "-loadThreads" && i + 1 < argc)
+			loadThreadCount = atoi(argv[++i]);
+		else if (option == "-inFlight" && i + 1 < argc)
+			inFlightCount = atoi(argv[++i]);
+		else if (option == "-packed")
+			usePacked = true;
+		else {
+			cout << "Invalid option " << option << "\n";
+			cout << "usage: align -batch manifestFile | -batchFasta fastaFile [-linearSpace] [-threads n] [-band width] [-xdrop x] [-scoreOnly] [-matrix name] [-cache directory] [-loadThreads n] [-inFlight n] [-packed]\n";
+			return -1;
+		}
+	}
+
+	BatchAligner batch((threadCount > 0) ? threadCount : ThreadPool::defaultThreadCount());
+	batch.setLinearSpace(useLinearSpace);
+	batch.setScoreOnly(useScoreOnly);
+	batch.setBandWidth(bandWidth);
+	batch.setXDrop(xDrop);
+	batch.setScoringMatrix(matrix);
+	batch.setResultCache(cache.get());
+	batch.setLoadThreadCount((loadThreadCount > 0) ? loadThreadCount : 1);
+	batch.setInFlightCount((inFlightCount > 0) ? inFlightCount : 0);
+	batch.setPackedSequences(usePacked);
+
+	// The results are written straight to stdout, so a read or write
+	// error is reported on stderr
+	OutputBuffer out(STDOUT_FILENO);
+	try {
+		string mode = argv[1];
+		if (mode == "-batch")
+			batch.readManifest(argv[2]);
+		else
+			batch.readCombinations(argv[2]);
+
+		batch.run(out);
+	}
+	catch (const exception& e) {
+		cerr << e.what() << "\n";
+		return -1;
+	}
+
+	return 0;
+}
+
+// progressiveMain(int argc, char *argv[])
+//  Purpose:
+//		Runs the -progressive mode
+int progressiveMain(int argc, char *argv[]) {
+
+	// Check for options
+	int threadCount = 1;
+	const ScoringMatrix* matrix = NULL;
+	unique_ptr<ScoringMatrix> loadedMatrix;
+	for (int i = 3; i < argc; i++) {
+		string option = argv[i];
+		if (option == "-threads" && i + 1 < argc)
+			threadCount = atoi(argv[++i]);
+		else if (option == "-matrix" && i + 1 < argc) {
+			matrix = loadScoringMatrix(argv[++i], loadedMatrix);
+			if (matrix == NULL)
+				return -1;
+		}
+		else {
+			cout << "Invalid option " << option << "\n";
+			cout << "usage: align -progressive fastaFile [-threads n] [-matrix name]\n";
+			return -1;
+		}
+	}
+
+	ProgressiveAligner aligner(argv[2]);
+	aligner.setScoringMatrix(matrix);
+	aligner.setThreadCount((threadCount > 0) ? threadCount : ThreadPool::defaultThreadCount());
+	aligner.align();
+
+	return writeText(aligner.resultString()) ? 0 : -1;
+}
+
+// allVsAllMain(int argc, char *argv[])
+//  Purpose:
+//		Runs the -allVsAll mode
+int allVsAllMain(int argc, char *argv[]) {
+
+	// Check for options
+	bool useScores = false;
+	int threadCount = 1;
+	const ScoringMatrix* matrix = NULL;
+	unique_ptr<ScoringMatrix> loadedMatrix;
+	for (int i = 4; i < argc; i++) {
+		string option = argv[i];
+		if (option == "-scores")
+			useScores = true;
+		else if (option == "-threads" && i + 1 < argc)
+			threadCount = atoi(argv[++i]);
+		else if (option == "-matrix" && i + 1 < argc) {
+			matrix = loadScoringMatrix(argv[++i], loadedMatrix);
+			if (matrix == NULL)
+				return -1;
+		}
+		else {
+			cout << "Invalid option " << option << "\n";
+			cout << "usage: align -allVsAll fastaFile matrixFile [-threads n] [-matrix name] [-scores]\n";
+			return -1;
+		}
+	}
+
+	AllVsAllAligner allVsAll(argv[2]);
+	allVsAll.setScoringMatrix(matrix);
+	allVsAll.setWriteScores(useScores);
+	allVsAll.setThreadCount((threadCount > 0) ? threadCount : ThreadPool::defaultThreadCount());
+	try {
+		allVsAll.run(argv[3]);
+	}
+	catch (const exception& e) {
+		cerr << e.what() << "\n";
+		return -1;
+	}
+
+	return writeText(allVsAll.resultString()) ? 0 : -1;
+}
+
+// benchmarkMain(int argc, char *argv[])
+//  Purpose:
+//		Runs the -benchmark mode
+int benchmarkMain(int argc, char *argv[]) {
+
+	// Check for options
+	Benchmark benchmark;
+	string lengths;
+	bool useManifest = false;
+	string outFileName;
+	for (int i = 2; i < argc; i++) {
+		string option = argv[i];
+		if (option == "-lengths" && i + 1 < argc)
+			lengths = argv[++i];
+		else if (option == "-manifest" && i + 1 < argc) {
+			benchmark.readManifest(argv[++i]);
+			useManifest = true;
+		}
+		else if (option == "-repeat" && i + 1 < argc)
+			benchmark.setRepeatCount(atoi(argv[++i]));
+		else if (option == "-threads" && i + 1 < argc) {
+			int threadCount = atoi(argv[++i]);
+			benchmark.setThreadCount((threadCount > 0) ? threadCount : ThreadPool::defaultThreadCount());
+		}
+		else if (option == "-out" && i + 1 < argc)
+			outFileName = argv[++i];
+		else {
+			cout << "Invalid option " << option << "\n";
+			cout << "usage: align -benchmark [-lengths n,n,...] [-manifest manifestFile] [-repeat n] [-threads n] [-out csvFile]\n";
+			return -1;
+		}
+	}
+
+	// Random triples are only run by default without a manifest
+	if (lengths.empty() && !useManifest)
+		lengths = "20,40,80";
+
+	vector<string> lengthTokens;
+	StringUtilities::split(lengths, ',', lengthTokens);
+	for (size_t i = 0; i < lengthTokens.size(); i++) {
+		if (atoi(lengthTokens[i].c_str()) > 0)
+			benchmark.addRandomTriple(atoi(lengthTokens[i].c_str()));
+	}
+
+	if (outFileName.empty())
+		benchmark.run(cout);
+	else {
+		ofstream outFile(outFileName);
+		if (!outFile.is_open()) {
+			cerr << "can not open file " << outFileName << "\n";
+			return -1;
+		}
+
+		benchmark.run(outFile);
+		outFile.close();
+		if (!outFile) {
+			cerr << "can not write file " << outFileName << "\n";
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
 int main( int argc, char *argv[] ) {
 
+	// Check for the batch modes
+	if (argc >= 3 && (string(argv[1]) == "-batch" || string(argv[1]) == "-batchFasta"))
+		return batchMain(argc, argv);
+	if (argc >= 3 && string(argv[1]) == "-progressive")
+		return progressiveMain(argc, argv);
+	if (argc >= 4 && string(argv[1]) == "-allVsAll")
+		return allVsAllMain(argc, argv);
+	if (argc >= 2 && string(argv[1]) == "-benchmark")
+		return benchmarkMain(argc, argv);
+
 	// Check that file name was  entered as argument
 	if (argc < 4) {
 		cout << "Invalid # of arguments\n";
-		cout << "usage: align fastaFile1 fastaFile2 fastaFile3\n";
+		cout << "usage: align fastaFile1 fastaFile2 fastaFile3 [-graphFile | -binaryGraphFile | -linearSpace] [-threads n] [-band width (no graph file)] [-xdrop x (no graph file)] [-scoreOnly] [-paths k (graph files only)] [-matrix name] [-cache directory (no graph file)] [-packed] [-stats]\n";
+		cout << "       align fastaFile1 fastaFile2 fastaFile3 -affine gapOpen gapExtend [-matrix name] [-packed] [-stats] (no other options)\n";
+		cout << "       align -batch manifestFile | -batchFasta fastaFile [-linearSpace] [-threads n] [-band width] [-xdrop x] [-scoreOnly] [-matrix name] [-cache directory] [-loadThreads n] [-inFlight n] [-packed]\n";
+		cout << "       align -progressive fastaFile [-threads n] [-matrix name]\n";
+		cout << "       align -allVsAll fastaFile matrixFile [-threads n] [-matrix name] [-scores]\n";
+		cout << "       align -benchmark [-lengths n,n,...] [-manifest manifestFile] [-repeat n] [-threads n] [-out csvFile]\n";
+		return -1;
+	}
+
+	// Check for options
+	bool useGraphFile = false;
+	bool useBinaryGraphFile = false;
+	bool useLinearSpace = false;
+	bool useScoreOnly = false;
+	bool useAffine = false;
+	bool useStats = false;
+	bool usePacked = false;
+	int gapOpen = AffineGapAligner::defaultGapOpen;
+	int gapExtend = AffineGapAligner::defaultGapExtend;
+	int threadCount = 1;
+	int bandWidth = 0;
+	int xDrop = 0;
+	int pathCount = 1;
+	bool threadsGiven = false;
+	bool bandGiven = false;
+	bool xDropGiven = false;
+	string cacheDirectory;
+	const ScoringMatrix* matrix = NULL;
+	unique_ptr<ScoringMatrix> loadedMatrix;
+	for (int i = 4; i < argc; i++) {
+		string option = argv[i];
+		if (option == "-graphFile")
+			useGraphFile = true;
+		else if (option == "-binaryGraphFile")
+			useBinaryGraphFile = true;
+		else if (option == "-linearSpace")
+			useLinearSpace = true;
+		else if (option == "-scoreOnly")
+			useScoreOnly = true;
+		else if (option == "-stats")
+			useStats = true;
+		else if (option == "-packed")
+			usePacked = true;
+		else if (option == "-threads" && i + 1 < argc) {
+			threadCount = atoi(argv[++i]);
+			threadsGiven = true;
+		}
+		else if (option == "-band" && i + 1 < argc) {
+			bandWidth = atoi(argv[++i]);
+			bandGiven = true;
+		}
+		else if (option == "-xdrop" && i + 1 < argc) {
+			xDrop = atoi(argv[++i]);
+			xDropGiven = true;
+		}
+		else if (option == "-paths" && i + 1 < argc)
+			pathCount = atoi(argv[++i]);
+		else if (option == "-cache" && i + 1 < argc)
+			cacheDirectory = argv[++i];
+		else if (option == "-affine" && i + 2 < argc) {
+			useAffine = true;
+			gapOpen = atoi(argv[++i]);
+			gapExtend = atoi(argv[++i]);
+		}
+		else if (option == "-matrix" && i + 1 < argc) {
+			matrix = loadScoringMatrix(argv[++i], loadedMatrix);
+			if (matrix == NULL)
+				return -1;
+		}
+		else {
+			cout << "Invalid option " << option << "\n";
+			cout << "usage: align fastaFile1 fastaFile2 fastaFile3 [-graphFile | -binaryGraphFile | -linearSpace] [-threads n] [-band width (no graph file)] [-xdrop x (no graph file)] [-scoreOnly] [-paths k (graph files only)] [-matrix name] [-cache directory (no graph file)] [-packed] [-stats]\n";
+			return -1;
+		}
+	}
+
+	// Only the graph modes find more than one path
+	if (pathCount != 1 && (useAffine || (!useGraphFile && !useBinaryGraphFile))) {
+		cout << "Invalid option -paths: only used with -graphFile or -binaryGraphFile\n";
 		return -1;
 	}
 
+	// The AffineGapAligner has none of the graph file, linear space, score
+	// only, threaded, banded or X-drop modes, and its results are not cached
+	if (useAffine) {
+		string reason = "not used with -affine";
+		if (invalidCombination(useGraphFile, "-graphFile", reason) ||
+			invalidCombination(useBinaryGraphFile, "-binaryGraphFile", reason) ||
+			invalidCombination(useLinearSpace, "-linearSpace", reason) ||
+			invalidCombination(useScoreOnly, "-scoreOnly", reason) ||
+			invalidCombination(threadsGiven, "-threads", reason) ||
+			invalidCombination(bandGiven, "-band", reason) ||
+			invalidCombination(xDropGiven, "-xdrop", reason) ||
+			invalidCombination(!cacheDirectory.empty(), "-cache", reason))
+			return -1;
+	}
+
+	// WDAGraph runs the full dynamic program over one graph file, it has
+	// no linear space, banded or X-drop modes and its results are not cached
+	if (useGraphFile || useBinaryGraphFile) {
+		string reason = "not used with -graphFile or -binaryGraphFile";
+		if (invalidCombination(useGraphFile && useBinaryGraphFile, "-binaryGraphFile", "not used with -graphFile") ||
+			invalidCombination(useLinearSpace, "-linearSpace", reason) ||
+			invalidCombination(bandGiven, "-band", reason) ||
+			invalidCombination(xDropGiven, "-xdrop", reason) ||
+			invalidCombination(!cacheDirectory.empty(), "-cache", reason))
+			return -1;
+	}
+
+	// Only the ThreeWayAligner's results are cached (the directory is
+	// created by the ResultCache)
+	unique_ptr<ResultCache> cache;
+	if (!cacheDirectory.empty())
+		cache.reset(new ResultCache(cacheDirectory));
+
 	cout << "Starting\n";
 
 	// Get Fasta File names
@@ -50,7 +553,7 @@ int main( int argc, char *argv[] ) {
 	ss 
 		<< fastaFileName1 << "_"
 		<< fastaFileName2 << "_"
-		<< fastaFileName3 << ".graph.txt";
+		<< fastaFileName3 << (useBinaryGraphFile ? ".graph.bin" : ".graph.txt");
 
 	string graphFileName = ss.str();
 
@@ -58,27 +561,101 @@ int main( int argc, char *argv[] ) {
 	FastaFile* fastaFile1 = new FastaFile(fastaFileName1, false);
 	FastaFile* fastaFile2 = new FastaFile(fastaFileName2, false);
 	FastaFile* fastaFile3 = new FastaFile(fastaFileName3, false);
+	if (usePacked) {
+		fastaFile1->packSequence();
+		fastaFile2->packSequence();
+		fastaFile3->packSequence();
+	}
 
 	cout << "Fasta's done\n";
 
-	// Create the graph file
-	WDAGraphFileBuilder builder;
-	builder.buildGraphFile(fastaFile1, fastaFile2, fastaFile3, graphFileName);
+	// Align with affine gap costs if asked for
+	if (useAffine) {
+		AffineGapAligner* aligner = new AffineGapAligner(fastaFile1, fastaFile2, fastaFile3);
+		aligner->setGapCosts(gapOpen, gapExtend);
+		aligner->setScoringMatrix(matrix);
+		aligner->findHighestWeightPath();
 
-	cout << "Graph File built\n";
+		cout << "Alignment done\n";
+
+		// Print out the result string for the highest weight path
+		bool written = writeResult(*aligner);
+		if (useStats)
+			printStats();
+
+		delete aligner;
+		delete fastaFile1;
+		delete fastaFile2;
+		delete fastaFile3;
+		return written ? 0 : -1;
+	}
+
+	// Align directly unless the graph file was asked for
+	if (!useGraphFile && !useBinaryGraphFile) {
+		ThreeWayAligner* aligner = new ThreeWayAligner(fastaFile1, fastaFile2, fastaFile3);
+		aligner->setLinearSpace(useLinearSpace);
+		aligner->setScoreOnly(useScoreOnly);
+		aligner->setBandWidth(bandWidth);
+		aligner->setXDrop(xDrop);
+		aligner->setScoringMatrix(matrix);
+		aligner->setResultCache(cache.get());
+		aligner->setThreadCount((threadCount > 0) ? threadCount : ThreadPool::defaultThreadCount());
+		aligner->findHighestWeightPath();
+
+		cout << "Alignment done\n";
+
+		// Print out the result string for the highest weight path
+		bool written = writeResult(*aligner);
+		if (useStats)
+			printStats();
+
+		delete aligner;
+		delete fastaFile1;
+		delete fastaFile2;
+		delete fastaFile3;
+		return written ? 0 : -1;
+	}
+
+	// Create the graph file and the WDAGraph, both throw if the graph file
+	// can not be written or read
+	unsigned int graphThreadCount = (threadCount > 0) ? threadCount : ThreadPool::defaultThreadCount();
+	WDAGraph* aGraph = NULL;
+	try {
+		WDAGraphFileBuilder builder;
+		builder.setScoringMatrix(matrix);
+		if (useBinaryGraphFile)
+			builder.buildBinaryGraphFile(fastaFile1, fastaFile2, fastaFile3, graphFileName);
+		else
+			builder.buildGraphFile(fastaFile1, fastaFile2, fastaFile3, graphFileName);
+
+		cout << "Graph File built\n";
+
+		aGraph = new WDAGraph(graphFileName, graphThreadCount);
+	}
+	catch (const exception& e) {
+		cerr << e.what() << "\n";
+		delete fastaFile1;
+		delete fastaFile2;
+		delete fastaFile3;
+		return -1;
+	}
 
-	// Create the WDAGraph and find the highest weight path
-	WDAGraph* aGraph =  new WDAGraph(graphFileName);
+	// Find the highest weight path
+	aGraph->setScoreOnly(useScoreOnly);
+	aGraph->setPathCount((pathCount > 0) ? pathCount : 1);
 
 	cout << "Graph built\n";
 
 	aGraph->findHighestWeightPath();
 
 	// Print out the result string for the highest weight path
-	cout << aGraph->resultString();
+	bool written = writeResult(*aGraph);
+	if (useStats)
+		printStats();
 
-	aGraph = NULL;
-	fastaFile1 = NULL;
-	fastaFile2 = NULL;
-	fastaFile3 = NULL;
+	delete aGraph;
+	delete fastaFile1;
+	delete fastaFile2;
+	delete fastaFile3;
+	return written ? 0 : -1;
 }